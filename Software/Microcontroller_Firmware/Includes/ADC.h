@@ -1,5 +1,5 @@
 /** @file ADC.h
- * Sample all needed analog channels.
+ * Sample all needed analog channels. Conversions are done by the ADC interrupt, each sample is the sum of several conversions decimated to get CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS more bits than the ADC provides.
  * @author Adrien RICCIARDI
  */
 #ifndef H_ADC_H
@@ -21,12 +21,19 @@ typedef enum
 //-------------------------------------------------------------------------------------------------
 // Functions
 //-------------------------------------------------------------------------------------------------
-/** Initialize desired analog pins and ADC module. */
+/** Initialize desired analog pins and ADC module, then sample all channels once so values are valid when the function returns. */
 void ADCInitialize(void);
 
-/** Sample all channels. Must be called periodically. */
+/** Start sampling all channels in the background. Must be called periodically. */
 void ADCTask(void);
 
+/** Get a specific channel last sampled value with the oversampling additional resolution.
+ * @param Channel_ID The channel to get value from.
+ * @return The last sampled value, in (10 + CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS)-bit raw ADC units,
+ * @return 0 if the provided channel does not exist.
+ */
+unsigned short ADCGetLastOversampledValue(TADCChannelID Channel_ID);
+
 /** Get a specific channel last sampled value.
  * @param Channel_ID The channel to get value from.
  * @return The last sampled value, in 10-bit raw ADC units,
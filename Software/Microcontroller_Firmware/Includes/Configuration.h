@@ -17,15 +17,33 @@
 #define CONFIGURATION_PROTOCOL_WIFI_SERVER_ADDRESS "192.168.1.100"
 /** The server to connect to port. */
 #define CONFIGURATION_PROTOCOL_WIFI_SERVER_PORT "1234"
+/** How many seconds to wait before retrying a failed connection step, this delay doubles after each consecutive failure. */
+#define CONFIGURATION_PROTOCOL_LINK_MINIMUM_RETRY_DELAY 1
+/** The longest delay in seconds between two connection retries. */
+#define CONFIGURATION_PROTOCOL_LINK_MAXIMUM_RETRY_DELAY 60
+/** Reconnect if no command has been received from the server during this amount of seconds (the server sends a heartbeat command every few seconds). */
+#define CONFIGURATION_PROTOCOL_LINK_INACTIVITY_TIMEOUT 30
+/** The ID announced to the server, it must be unique among all boards connected to the same server (0 is the board served when no board is selected). */
+#define CONFIGURATION_PROTOCOL_BOARD_ID 0
+/** How many received commands can wait to be executed by the main loop, it must be a power of two. One slot receives the next command, so one command less can wait. */
+#define CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE 4
+/** The UART transmission buffer size in bytes, it must be a power of two not greater than 256. */
+#define CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE 64
+/** Set to 1 when the protocol is built for the computer, where the simulator or the tests stand in for the ESP8266, to provide ProtocolSimulateConnection(). The simulator and tests rules of the makefile enable it. */
+#ifndef CONFIGURATION_PROTOCOL_LINK_SIMULATED
+	#define CONFIGURATION_PROTOCOL_LINK_SIMULATED 0
+#endif
 
 /** The current firmware version. */
-#define CONFIGURATION_FIRMWARE_VERSION 2
+#define CONFIGURATION_FIRMWARE_VERSION 3
 
 /** Mixing valve time in seconds to go from one side to the other side. */
 #define CONFIGURATION_MIXING_VALVE_MAXIMUM_MOVING_TIME (20 * 60) // Valve needs about 18 minutes to travel from one side to the other, set 20 minutes to get some margin (valve has internal limit switches)
 
 /** The reference temperature (in °C) the trimmers use when they are set to 0. */
 #define CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE 20
+/** How far (in tenths of °C) a trimmer must go past the middle of two degrees to select the next degree. A trimmer resting between two degrees would otherwise make the settings saved to the EEPROM again and again. */
+#define CONFIGURATION_TRIMMERS_HYSTERESIS 3
 
 /** Minimum temperature value (clamped after heating curve computation). */
 #define CONFIGURATION_HEATING_CURVE_MINIMUM_TEMPERATURE 10 // TODO determine a good value
@@ -38,8 +56,39 @@
 #define CONFIGURATION_GAS_BURNER_TEMPERATURE_HYSTERESIS_LOW 8
 
 /** How many ADC samples to use to compute the moving average value. */
-#define CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT 5
+#define CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT 10 // Average one second of samples
+/** How many bits of resolution to add to the ADC 10 bits by oversampling (each sample sums 4^n conversions). Maximum value is 3. */
+#define CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS 2
+
+/** The main loop scheduler tick period in milliseconds, it must be a multiple of 5ms (see Timer.c). All task periods must be multiples of this value. */
+#define CONFIGURATION_SCHEDULER_TICK_PERIOD 50 // No task needs a finer period, and a longer tick lets the CPU sleep longer
+/** How many milliseconds between two analog channels samplings. */
+#define CONFIGURATION_SCHEDULER_ADC_TASK_PERIOD 100
+/** How many milliseconds between two regulation task runs (gas burner, pump, mixing valve, telemetry and status led). Mixing valve timings and telemetry sampling count on this value being one second. */
+#define CONFIGURATION_SCHEDULER_REGULATION_TASK_PERIOD 1000
+/** How many milliseconds between two WiFi connection management runs, it is the resolution of the ESP8266 answers timeouts. */
+#define CONFIGURATION_SCHEDULER_PROTOCOL_LINK_TASK_PERIOD 100
+/** How many milliseconds between two heating curve computations. Outside temperature changes slowly, so there is no need to compute the target temperature often. */
+#define CONFIGURATION_SCHEDULER_HEATING_CURVE_TASK_PERIOD 10000
+/** How many milliseconds between two checks for modified settings to save. Several changes done meanwhile (like applying settings from the web page) are saved in a single EEPROM record. */
+#define CONFIGURATION_SCHEDULER_SETTINGS_TASK_PERIOD 5000
+
+/** The heating curve coefficient (multiplied by ten) used when no settings have been saved yet. */
+#define CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT 14
+/** The heating curve parallel shift (multiplied by ten) used when no settings have been saved yet. */
+#define CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_PARALLEL_SHIFT 150
+
+/** How many seconds between two telemetry samples (maximum value is 255). */
+#define CONFIGURATION_TELEMETRY_SAMPLING_PERIOD 60 // Same period as the server history
+/** How many 16-byte blocks the telemetry ring can hold, it must be a power of two. Each block holds from 3 (when temperatures change a lot) to 10 (when nothing changes) samples. */
+#define CONFIGURATION_TELEMETRY_BLOCKS_COUNT 32
+
+/** Set to 1 to measure how many CPU cycles the tasks and the interrupt handlers take (see Profiler.h), build with "make PROFILER=1" to enable it without modifying this file. */
+#ifndef CONFIGURATION_PROFILER_ENABLED
+	#define CONFIGURATION_PROFILER_ENABLED 0 // The instrumentation costs some cycles on each measured section and makes the scheduler timer run faster
+#endif
 
+// Older firmwares stored the heating curve at these fixed addresses, it is retrieved from them once when no settings journal is found
 /** Heating curve coefficient least significant byte address in internal EEPROM. */
 #define CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_LOW_BYTE 0
 /** Heating curve coefficient most significant byte address in internal EEPROM. */
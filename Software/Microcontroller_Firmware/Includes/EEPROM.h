@@ -1,5 +1,5 @@
 /** @file EEPROM.h
- * Simple access to device internal EEPROM memory.
+ * Simple access to device internal EEPROM memory. Writes are done by the "EEPROM ready" interrupt, so the program never waits for the slow write cycles.
  * @author Adrien RICCIARDI
  */
 #ifndef H_EEPROM_H
@@ -11,13 +11,23 @@
 /** Read an EEPROM byte value.
  * @param Address The byte address in range [0..1023].
  * @return The byte value.
+ * @warning The EEPROM can't be read while it is written, make sure EEPROMIsWriting() returns 0 first.
  */
 unsigned char EEPROMReadByte(unsigned short Address);
 
-/** Write an EEPROM byte value.
- * @param Address The byte address in range [0..1023].
- * @param Data The byte value.
+/** Start writing a buffer to the EEPROM in background. Bytes that already hold the right value are not written again.
+ * @param Address The first byte address in range [0..1023].
+ * @param Pointer_Buffer The data to write, it must stay unchanged until EEPROMIsWriting() returns 0.
+ * @param Size The data size in bytes.
+ * @note Interrupts must be enabled for the write to progress.
+ * @warning No previous write must be running, make sure EEPROMIsWriting() returns 0 first.
+ */
+void EEPROMStartWriting(unsigned short Address, const void *Pointer_Buffer, unsigned char Size);
+
+/** Tell whether a write started by EEPROMStartWriting() is still running.
+ * @return 0 if the EEPROM is idle,
+ * @return 1 if data are being written.
  */
-void EEPROMWriteByte(unsigned short Address, unsigned char Data);
+unsigned char EEPROMIsWriting(void);
 
 #endif
@@ -0,0 +1,82 @@
+/** @file Profiler.h
+ * Measure how many CPU cycles the main loop tasks and the interrupt handlers take, so the firmware hot paths can be checked on the field through the protocol.
+ * The instrumentation is removed at compile time when CONFIGURATION_PROFILER_ENABLED is 0.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_PROFILER_H
+#define H_PROFILER_H
+
+#include <Configuration.h>
+#include <Timer.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** The size in bytes of a section statistics read by ProfilerReadSection(). */
+#define PROFILER_SECTION_PAYLOAD_SIZE 15
+
+#if CONFIGURATION_PROFILER_ENABLED
+	/** Execute a statement and record how long it took.
+	 * @param Section_ID The section to account the time to.
+	 * @param Statement The measured code.
+	 */
+	#define PROFILER_MEASURE_SECTION(Section_ID, Statement) \
+		do \
+		{ \
+			TTimerTimestamp Profiler_Start_Timestamp; \
+			TimerGetTimestamp(&Profiler_Start_Timestamp); \
+			Statement; \
+			ProfilerRecordSection(Section_ID, TimerGetElapsedCounts(&Profiler_Start_Timestamp)); \
+		} while (0)
+#else
+	#define PROFILER_MEASURE_SECTION(Section_ID, Statement) Statement
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** All measured sections. The server displays them in this order, so add new sections at the end. */
+typedef enum
+{
+	PROFILER_SECTION_ID_ADC_TASK,
+	PROFILER_SECTION_ID_PROTOCOL_LINK_TASK,
+	PROFILER_SECTION_ID_TEMPERATURE_TASK,
+	PROFILER_SECTION_ID_REGULATION_TASK,
+	PROFILER_SECTION_ID_MIXING_VALVE_TASK,
+	PROFILER_SECTION_ID_TELEMETRY_TASK,
+	PROFILER_SECTION_ID_SETTINGS_TASK,
+	PROFILER_SECTION_ID_PROTOCOL_TASK,
+	PROFILER_SECTION_ID_ADC_INTERRUPT,
+	PROFILER_SECTION_ID_EEPROM_INTERRUPT,
+	PROFILER_SECTION_ID_UART_RECEPTION_INTERRUPT,
+	PROFILER_SECTION_ID_UART_TRANSMISSION_INTERRUPT,
+	PROFILER_SECTION_IDS_COUNT
+} TProfilerSectionID;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+#if CONFIGURATION_PROFILER_ENABLED
+/** Account a section execution, use PROFILER_MEASURE_SECTION() instead of calling this function directly.
+ * @param Section_ID The executed section.
+ * @param Elapsed_Counts How long the section took, in timer counts.
+ * @warning A section must always be recorded from the same context (main loop or a given interrupt handler).
+ */
+void ProfilerRecordSection(TProfilerSectionID Section_ID, unsigned long Elapsed_Counts);
+#endif
+
+/** Get a section statistics.
+ * @param Section_ID The section.
+ * @param Is_Reset_Requested Set to 1 to clear the section statistics once they have been read.
+ * @param Pointer_Buffer On output, contain PROFILER_SECTION_PAYLOAD_SIZE bytes (multi-byte values are little endian) :
+ * - the section ID,
+ * - how many sections exist (0 if profiling is disabled, all following values are zero in this case, and when the section does not exist),
+ * - how many CPU cycles a count lasts,
+ * - how many times the section has been executed (32 bits),
+ * - the shortest execution time in counts (16 bits, saturated),
+ * - the longest execution time in counts (16 bits, saturated),
+ * - the sum of all execution times in counts (32 bits).
+ */
+void ProfilerReadSection(unsigned char Section_ID, unsigned char Is_Reset_Requested, unsigned char *Pointer_Buffer);
+
+#endif
@@ -5,24 +5,39 @@
 #ifndef H_PROTOCOL_H
 #define H_PROTOCOL_H
 
-#include <avr/io.h>
+#include <Configuration.h>
 
 //-------------------------------------------------------------------------------------------------
 // Constants and macros
 //-------------------------------------------------------------------------------------------------
-/** Enable UART interrupts. */
-#define PROTOCOL_ENABLE_INTERRUPTS() UCSR0B |= 0xC0 // Enable "receive complete" and "transmit complete" interrupts
-/** Disable UART interrupts. */
-#define PROTOCOL_DISABLE_INTERRUPTS() UCSR0B &= ~0xC0 // Disable "receive complete" and "transmit complete" interrupts
+/** The magic number preceding all received and sent commands. */
+#define PROTOCOL_MAGIC_NUMBER 0xA5
+/** The code of the frame sent once to the server right after the connection is established, its single payload byte is the board ID. It is outside of the commands range, so the server can't mistake it for an answer. */
+#define PROTOCOL_BOARD_ANNOUNCEMENT_CODE 0x80
 
 //-------------------------------------------------------------------------------------------------
 // Functions
 //-------------------------------------------------------------------------------------------------
-/** Initialize the UART module used to communicate with the ESP8266 and connect the ESP8266 to the network.
- * @return 0 if the connection succeeded and WiFi is operational,
- * @return 1 if an error occurred and WiFi won't work.
+/** Initialize the UART module used to communicate with the ESP8266 and start connecting the ESP8266 to the server. The connection is done in background by ProtocolLinkTask(), so this function returns immediately. */
+void ProtocolInitialize(void);
+
+/** Connect to the server step by step, then watch the connection and reconnect when it is lost. Must be called every CONFIGURATION_SCHEDULER_PROTOCOL_LINK_TASK_PERIOD milliseconds. */
+void ProtocolLinkTask(void);
+
+/** Tell whether the server is connected.
+ * @return 0 if the board is not connected to the server (yet),
+ * @return 1 if the server can send commands.
  */
-unsigned char ProtocolInitialize(void);
+unsigned char ProtocolIsConnected(void);
+
+/** Execute the commands decoded by the reception interrupt and queue their answers. Must be called by the main loop each time it is woken up. */
+void ProtocolTask(void);
+
+/** Tell whether commands are waiting to be executed by ProtocolTask().
+ * @return 0 if there is no command to execute, or if the commands must wait for the previous answers to be sent,
+ * @return 1 if at least one command is pending.
+ */
+unsigned char ProtocolIsCommandPending(void);
 
 /** Tell whether the boiler is running or idle.
  * @return 0 if the boiler is idle,
@@ -36,4 +51,9 @@ unsigned char ProtocolIsBoilerRunning(void);
  */
 unsigned char ProtocolIsNightModeEnabled(void);
 
+#if CONFIGURATION_PROTOCOL_LINK_SIMULATED
+/** Consider the server connected without going through the ESP8266 connection sequence, the caller manages the network connection itself. Only available when the protocol is built for the computer. */
+void ProtocolSimulateConnection(void);
+#endif
+
 #endif
@@ -33,4 +33,11 @@ void RelayTurnOn(TRelayID Relay_ID);
  */
 void RelayTurnOff(TRelayID Relay_ID);
 
+/** Tell whether a relay circuit is closed.
+ * @param Relay_ID The relay to get state.
+ * @return 0 if the relay is open,
+ * @return 1 if the relay is closed.
+ */
+unsigned char RelayIsTurnedOn(TRelayID Relay_ID);
+
 #endif
@@ -0,0 +1,41 @@
+/** @file Settings.h
+ * Keep the user settings across reboots. Settings are saved to a journal of CRC-protected records rotating over the whole EEPROM, so successive saves do not wear the same cells.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_SETTINGS_H
+#define H_SETTINGS_H
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** All settings that must survive a reboot. */
+typedef struct
+{
+	unsigned short Heating_Curve_Coefficient; //!< The heating curve coefficient multiplied by ten.
+	unsigned short Heating_Curve_Parallel_Shift; //!< The heating curve parallel shift multiplied by ten.
+	signed char Desired_Day_Room_Temperature; //!< The room temperature (in °C) to reach when night mode is disabled.
+	signed char Desired_Night_Room_Temperature; //!< The room temperature (in °C) to reach when night mode is enabled.
+	unsigned char Is_Boiler_Running; //!< Tell whether the boiler is running or idle.
+	unsigned char Is_Night_Mode_Enabled; //!< Tell if this is night or day.
+} TSettings;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Load the most recent settings saved to the EEPROM. Default settings are used if no valid settings are found. */
+void SettingsInitialize(void);
+
+/** Get the current settings.
+ * @return The settings, they can't be modified through the returned pointer, use SettingsSet() instead.
+ */
+const TSettings *SettingsGet(void);
+
+/** Change the current settings. They will be saved to the EEPROM by SettingsTask() if they are different from the current ones.
+ * @param Pointer_Settings The new settings.
+ */
+void SettingsSet(const TSettings *Pointer_Settings);
+
+/** Save the settings if they have been modified since the last save. Must be called periodically. */
+void SettingsTask(void);
+
+#endif
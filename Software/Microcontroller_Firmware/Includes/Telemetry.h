@@ -0,0 +1,33 @@
+/** @file Telemetry.h
+ * Periodically record the board state in a RAM ring, so the server can retrieve the samples it missed while the network was down.
+ * Samples are delta-encoded in fixed-size blocks. Each block starts with absolute values so it can be decoded on its own, and the oldest block is dropped when the ring is full.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TELEMETRY_H
+#define H_TELEMETRY_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** The size in bytes of a block read by TelemetryReadBlock(). */
+#define TELEMETRY_BLOCK_PAYLOAD_SIZE 20
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Record a sample every CONFIGURATION_TELEMETRY_SAMPLING_PERIOD seconds. Must be called every second. */
+void TelemetryTask(void);
+
+/** Get the block holding a sample. The blocks following the returned one are retrieved by asking for the sample following the last sample of the block.
+ * @param Sample_Number The sample to find. The oldest block is returned if the sample is not stored anymore, an empty block is returned if the sample has not been taken yet.
+ * @param Pointer_Buffer On output, contain TELEMETRY_BLOCK_PAYLOAD_SIZE bytes :
+ * - the number the next sample will get (16-bit little endian),
+ * - how many seconds elapsed since the last sample,
+ * - the sampling period in seconds,
+ * - the block first sample number (16-bit little endian),
+ * - the block samples count,
+ * - the block records.
+ */
+void TelemetryReadBlock(unsigned short Sample_Number, unsigned char *Pointer_Buffer);
+
+#endif
@@ -20,7 +20,7 @@ typedef enum
 //-------------------------------------------------------------------------------------------------
 // Functions
 //-------------------------------------------------------------------------------------------------
-/** Load settings from internal EEPROM. */
+/** Remember the trimmers position, so the saved desired room temperatures are used until a trimmer is moved. SettingsInitialize() and ADCInitialize() must have been called before. */
 void TemperatureInitialize(void);
 
 /** Convert a specific sensor temperature to Celsius degrees.
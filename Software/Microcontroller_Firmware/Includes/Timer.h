@@ -0,0 +1,54 @@
+/** @file Timer.h
+ * Generate the periodic tick the main loop scheduler is based on.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TIMER_H
+#define H_TIMER_H
+
+#include <Configuration.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** How many CPU cycles a timer count lasts. The profiler needs a finer time base than the scheduler. */
+#if CONFIGURATION_PROFILER_ENABLED
+	#define TIMER_PRESCALER 8
+#else
+	#define TIMER_PRESCALER 256
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** A date precise to the timer count. */
+typedef struct
+{
+	unsigned short Ticks_Count; //!< The elapsed ticks count.
+	unsigned short Counter; //!< The timer counts elapsed since the tick started.
+} TTimerTimestamp;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Configure Timer 1 to generate an interrupt every CONFIGURATION_SCHEDULER_TICK_PERIOD milliseconds. Ticks start being counted when interrupts are enabled. */
+void TimerInitialize(void);
+
+/** Get how many ticks elapsed since the timer was initialized.
+ * @return The ticks count, it wraps around to 0 when it overflows.
+ */
+unsigned short TimerGetTicksCount(void);
+
+#if CONFIGURATION_PROFILER_ENABLED
+/** Get the current date. The function can be called from an interrupt handler.
+ * @param Pointer_Timestamp On output, contain the current date.
+ */
+void TimerGetTimestamp(TTimerTimestamp *Pointer_Timestamp);
+
+/** Tell how much time elapsed since a date.
+ * @param Pointer_Start_Timestamp The date returned by TimerGetTimestamp().
+ * @return The elapsed time in timer counts (each one lasts TIMER_PRESCALER CPU cycles). The result is wrong if more than 65535 ticks elapsed.
+ */
+unsigned long TimerGetElapsedCounts(const TTimerTimestamp *Pointer_Start_Timestamp);
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+/** @file Board.h
+ * Simulate the board hardware (sensors, relays, leds, EEPROM and UART) and the boiler it controls, so the real firmware modules can run on a computer.
+ * The firmware Protocol, Temperature and Mixing_Valve modules are built unchanged on top of this simulated hardware.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_BOARD_H
+#define H_BOARD_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** The biggest answer the firmware can send (magic number, command and payload). */
+#define BOARD_ANSWER_MAXIMUM_SIZE 22 // The telemetry block answer
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Power the simulated board on.
+ * @param Average_Outside_Temperature The outside temperature daily average in °C. Outside temperature slowly oscillates around this value.
+ */
+void BoardInitialize(double Average_Outside_Temperature);
+
+/** Make one second elapse : update the boiler physical model, then run the firmware main loop once. */
+void BoardTask(void);
+
+/** Give a byte received from the network to the firmware.
+ * @param Byte The received byte.
+ * @param Pointer_Answer On output, contain the answer if the byte terminated a command. The buffer must be BOARD_ANSWER_MAXIMUM_SIZE bytes large.
+ * @return 0 if the firmware is waiting for more bytes,
+ * @return The answer size in bytes if a command has been executed.
+ */
+int BoardReceiveByte(unsigned char Byte, unsigned char *Pointer_Answer);
+
+#endif
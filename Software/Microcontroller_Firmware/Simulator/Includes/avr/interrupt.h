@@ -0,0 +1,28 @@
+/** @file interrupt.h
+ * Turn interrupt handlers into plain functions the simulator calls when a byte is received or transmitted.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_SIMULATOR_AVR_INTERRUPT_H
+#define H_SIMULATOR_AVR_INTERRUPT_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** Declare an interrupt handler as a function named like its vector. */
+#define ISR(Vector) void Vector(void)
+
+/** The simulator calls the handlers one at a time, there is nothing to mask. */
+#define sei()
+/** The simulator calls the handlers one at a time, there is nothing to mask. */
+#define cli()
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** The UART "receive complete" interrupt handler. */
+void USART_RX_vect(void);
+
+/** The UART "data register empty" interrupt handler. */
+void USART_UDRE_vect(void);
+
+#endif
@@ -0,0 +1,28 @@
+/** @file io.h
+ * Replace the AVR registers by plain variables, so firmware modules can be built for the simulator. Only the registers used by the simulated modules are provided.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_SIMULATOR_AVR_IO_H
+#define H_SIMULATOR_AVR_IO_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** Each UART data register access gets its own storage, so the simulator can tell the byte read by the reception interrupt from the bytes written to transmit an answer. */
+#define UDR0 (*SimulatorAccessUARTDataRegister())
+
+//-------------------------------------------------------------------------------------------------
+// Variables
+//-------------------------------------------------------------------------------------------------
+/** UART registers, they are only used by the ESP8266 initialization code that the simulator never calls. */
+extern volatile unsigned char UBRR0H, UBRR0L, UCSR0A, UCSR0B, UCSR0C;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Called on each UDR0 access.
+ * @return The storage for this access.
+ */
+volatile unsigned char *SimulatorAccessUARTDataRegister(void);
+
+#endif
@@ -0,0 +1,17 @@
+/** @file pgmspace.h
+ * The simulator has a single address space, so constant data is read like any other data.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_SIMULATOR_AVR_PGMSPACE_H
+#define H_SIMULATOR_AVR_PGMSPACE_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** Data does not need to be placed in a special section. */
+#define PROGMEM
+
+/** Read a 16-bit word from constant data. */
+#define pgm_read_word(Pointer_Address) (*(const unsigned short *) (Pointer_Address))
+
+#endif
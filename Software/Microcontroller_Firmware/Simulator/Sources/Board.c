@@ -0,0 +1,321 @@
+/** @file Board.c
+ * See Board.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <ADC.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <Board.h>
+#include <Configuration.h>
+#include <EEPROM.h>
+#include <Led.h>
+#include <math.h>
+#include <Mixing_Valve.h>
+#include <Protocol.h>
+#include <Relay.h>
+#include <Settings.h>
+#include <Telemetry.h>
+#include <Temperature.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The ATmega328P EEPROM size in bytes. */
+#define BOARD_EEPROM_SIZE 1024
+
+/** The day trimmer raw value, it selects the trimmers reference temperature. */
+#define BOARD_DAY_TRIMMER_RAW_VALUE 337
+/** The night trimmer raw value, it selects the same temperature than the day trimmer. */
+#define BOARD_NIGHT_TRIMMER_RAW_VALUE 31
+
+/** The house and boiler room temperature in °C, hot water cools down to it. */
+#define BOARD_ROOM_TEMPERATURE 20.
+/** The hottest temperature the boiler water can reach in °C. */
+#define BOARD_BOILER_MAXIMUM_WATER_TEMPERATURE 90.
+/** How many °C per second the gas burner adds to the boiler water. */
+#define BOARD_GAS_BURNER_HEATING_RATE 0.25
+/** How much of the difference between boiler water and room temperatures is lost each second when radiators are closed. */
+#define BOARD_BOILER_STANDBY_LOSS_RATE 0.0005
+/** How much of the difference between boiler water and room temperatures is lost each second when radiators are fully opened. */
+#define BOARD_RADIATORS_LOSS_RATE 0.003
+/** The time constant in seconds of the radiator start pipe temperature sensor. */
+#define BOARD_START_PIPE_TIME_CONSTANT 60.
+/** How many seconds the mixing valve motor needs to travel from one side to the other (the firmware waits a bit more to be sure). */
+#define BOARD_MIXING_VALVE_TRAVEL_TIME (18 * 60)
+
+/** How much the outside temperature changes between the middle of the day and the middle of the night in °C. */
+#define BOARD_OUTSIDE_TEMPERATURE_DAILY_AMPLITUDE 4.
+
+/** How many UDR0 accesses an interrupt handler can do (the reception handler reads the received byte, the transmission handler writes a byte). */
+#define BOARD_UART_DATA_REGISTER_ACCESSES_MAXIMUM_COUNT 4
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The simulated EEPROM content. */
+static unsigned char Board_EEPROM[BOARD_EEPROM_SIZE];
+/** The relays states, each relay uses the bit of its pin number like on PORTD. */
+static unsigned char Board_Relays_States = 0;
+
+/** The outside temperature daily average. */
+static double Board_Average_Outside_Temperature;
+/** The current outside temperature. */
+static double Board_Outside_Temperature;
+/** The water temperature inside the boiler. */
+static double Board_Boiler_Water_Temperature = BOARD_ROOM_TEMPERATURE;
+/** The water temperature measured on the pipe going to the radiators. */
+static double Board_Radiator_Start_Water_Temperature = BOARD_ROOM_TEMPERATURE;
+/** How much the mixing valve lets the boiler water go to the radiators, from 0 (valve on the left side, radiators closed) to 1 (valve on the right side). */
+static double Board_Mixing_Valve_Opening = 0;
+/** How many seconds elapsed since the board was powered on. */
+static unsigned long Board_Time = 0;
+
+/** Whether the boiler was running on the previous main loop iteration. */
+static unsigned char Board_Is_Boiler_Running_Before = 0;
+
+/** The storage of each UDR0 access done by the current interrupt handler. */
+static volatile unsigned char Board_UART_Data_Register_Accesses[BOARD_UART_DATA_REGISTER_ACCESSES_MAXIMUM_COUNT];
+/** How many times UDR0 has been accessed by the current interrupt handler. */
+static unsigned char Board_UART_Data_Register_Accesses_Count;
+
+//-------------------------------------------------------------------------------------------------
+// Public variables
+//-------------------------------------------------------------------------------------------------
+volatile unsigned char UBRR0H, UBRR0L, UCSR0A, UCSR0B, UCSR0C;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Convert a temperature to the value the ADC module would provide after oversampling, using the inverse of the firmware conversion formula.
+ * @param Temperature The temperature in °C.
+ * @param Slope The firmware conversion slope, multiplied by 1000.
+ * @param Offset The firmware conversion offset, multiplied by 1000.
+ * @return The oversampled raw ADC value.
+ */
+static unsigned short BoardConvertTemperatureToRawValue(double Temperature, long Slope, long Offset)
+{
+	double Raw_Value;
+	
+	Raw_Value = round((Temperature * 1000. - Offset) * (1 << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS) / Slope);
+	if (Raw_Value < 0) return 0;
+	if (Raw_Value > (1023 << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS)) return 1023 << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS;
+	return (unsigned short) Raw_Value;
+}
+
+/** Update the boiler physical state for one second. */
+static void BoardUpdatePhysicalModel(void)
+{
+	double Loss_Rate, Target_Start_Water_Temperature;
+	
+	// The outside temperature is the lowest at midnight
+	Board_Outside_Temperature = Board_Average_Outside_Temperature - BOARD_OUTSIDE_TEMPERATURE_DAILY_AMPLITUDE / 2. * cos(2. * M_PI * (Board_Time % 86400) / 86400.);
+	
+	// The valve motor moves as long as a relay is powered, until it reaches a limit switch
+	if (Board_Relays_States & (1 << RELAY_ID_MIXING_VALVE_LEFT)) Board_Mixing_Valve_Opening -= 1. / BOARD_MIXING_VALVE_TRAVEL_TIME;
+	if (Board_Relays_States & (1 << RELAY_ID_MIXING_VALVE_RIGHT)) Board_Mixing_Valve_Opening += 1. / BOARD_MIXING_VALVE_TRAVEL_TIME;
+	if (Board_Mixing_Valve_Opening < 0) Board_Mixing_Valve_Opening = 0;
+	else if (Board_Mixing_Valve_Opening > 1) Board_Mixing_Valve_Opening = 1;
+	
+	// The burner heats the boiler water, which is cooled by the radiators when the pump makes the water flow through them
+	if (Board_Relays_States & (1 << RELAY_ID_GAS_BURNER)) Board_Boiler_Water_Temperature += BOARD_GAS_BURNER_HEATING_RATE;
+	if (Board_Relays_States & (1 << RELAY_ID_PUMP)) Loss_Rate = BOARD_BOILER_STANDBY_LOSS_RATE + BOARD_RADIATORS_LOSS_RATE * Board_Mixing_Valve_Opening;
+	else Loss_Rate = BOARD_BOILER_STANDBY_LOSS_RATE;
+	Board_Boiler_Water_Temperature -= (Board_Boiler_Water_Temperature - BOARD_ROOM_TEMPERATURE) * Loss_Rate;
+	if (Board_Boiler_Water_Temperature > BOARD_BOILER_MAXIMUM_WATER_TEMPERATURE) Board_Boiler_Water_Temperature = BOARD_BOILER_MAXIMUM_WATER_TEMPERATURE; // The boiler safety thermostat stops the burner
+	
+	// The start pipe receives boiler water mixed with the radiators return water according to the valve position, and the sensor slowly follows the pipe temperature
+	if (Board_Relays_States & (1 << RELAY_ID_PUMP)) Target_Start_Water_Temperature = BOARD_ROOM_TEMPERATURE + (Board_Boiler_Water_Temperature - BOARD_ROOM_TEMPERATURE) * Board_Mixing_Valve_Opening;
+	else Target_Start_Water_Temperature = BOARD_ROOM_TEMPERATURE;
+	Board_Radiator_Start_Water_Temperature += (Target_Start_Water_Temperature - Board_Radiator_Start_Water_Temperature) / BOARD_START_PIPE_TIME_CONSTANT;
+	
+	Board_Time++;
+}
+
+/** Run the firmware regulation tasks due this second, see the firmware Main.c for the original code (it can't be reused as is because it never returns). */
+static void BoardRunMainLoop(void)
+{
+	unsigned char Is_Boiler_Running_Now;
+	signed char Radiator_Water_Start_Temperature, Target_Start_Water_Temperature;
+	
+	// The firmware scheduler computes the heating curve less often than it runs the regulation (both tasks are run on the first tick)
+	if (Board_Time % (CONFIGURATION_SCHEDULER_HEATING_CURVE_TASK_PERIOD / CONFIGURATION_SCHEDULER_REGULATION_TASK_PERIOD) == 1) TemperatureTask();
+	
+	// Handle gas burner
+	Is_Boiler_Running_Now = ProtocolIsBoilerRunning();
+	if (Is_Boiler_Running_Now)
+	{
+		Radiator_Water_Start_Temperature = TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_RADIATOR_START);
+		Target_Start_Water_Temperature = TemperatureGetTargetStartWaterTemperature();
+		
+		if (Radiator_Water_Start_Temperature <= Target_Start_Water_Temperature - CONFIGURATION_GAS_BURNER_TEMPERATURE_HYSTERESIS_LOW) RelayTurnOn(RELAY_ID_GAS_BURNER);
+		else if (Radiator_Water_Start_Temperature >= Target_Start_Water_Temperature + CONFIGURATION_GAS_BURNER_TEMPERATURE_HYSTERESIS_HIGH) RelayTurnOff(RELAY_ID_GAS_BURNER);
+	}
+	
+	// Execute the following actions only once when running state changes
+	if (Is_Boiler_Running_Now != Board_Is_Boiler_Running_Before)
+	{
+		if (Is_Boiler_Running_Now)
+		{
+			RelayTurnOn(RELAY_ID_PUMP);
+			MixingValveSetPosition(MIXING_VALVE_POSITION_RIGHT);
+		}
+		else
+		{
+			RelayTurnOff(RELAY_ID_GAS_BURNER);
+			RelayTurnOff(RELAY_ID_PUMP);
+			MixingValveSetPosition(MIXING_VALVE_POSITION_LEFT);
+		}
+	}
+	Board_Is_Boiler_Running_Before = Is_Boiler_Running_Now;
+	
+	MixingValveTask();
+	TelemetryTask();
+	
+	// The firmware scheduler saves modified settings less often than it runs the regulation
+	if (Board_Time % (CONFIGURATION_SCHEDULER_SETTINGS_TASK_PERIOD / CONFIGURATION_SCHEDULER_REGULATION_TASK_PERIOD) == 1) SettingsTask();
+}
+
+//-------------------------------------------------------------------------------------------------
+// Simulated firmware modules
+//-------------------------------------------------------------------------------------------------
+unsigned short ADCGetLastOversampledValue(TADCChannelID Channel_ID)
+{
+	switch (Channel_ID)
+	{
+		case ADC_CHANNEL_ID_OUTSIDE_THERMISTOR:
+			return BoardConvertTemperatureToRawValue(Board_Outside_Temperature, -652, 326440);
+			
+		case ADC_CHANNEL_ID_DAY_TRIMMER:
+			return BOARD_DAY_TRIMMER_RAW_VALUE << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS;
+			
+		case ADC_CHANNEL_ID_NIGHT_TRIMMER:
+			return BOARD_NIGHT_TRIMMER_RAW_VALUE << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS;
+			
+		case ADC_CHANNEL_ID_RADIATOR_START_THERMISTOR:
+			return BoardConvertTemperatureToRawValue(Board_Radiator_Start_Water_Temperature, -857, 401375);
+			
+		default:
+			return 0;
+	}
+}
+
+unsigned short ADCGetLastSampledValue(TADCChannelID Channel_ID)
+{
+	return ADCGetLastOversampledValue(Channel_ID) >> CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS;
+}
+
+unsigned char EEPROMReadByte(unsigned short Address)
+{
+	return Board_EEPROM[Address & (BOARD_EEPROM_SIZE - 1)];
+}
+
+void EEPROMStartWriting(unsigned short Address, const void *Pointer_Buffer, unsigned char Size)
+{
+	const unsigned char *Pointer_Bytes = Pointer_Buffer;
+	
+	// Write cycles are not simulated, the data are immediately available
+	while (Size > 0)
+	{
+		Board_EEPROM[Address & (BOARD_EEPROM_SIZE - 1)] = *Pointer_Bytes;
+		Address++;
+		Pointer_Bytes++;
+		Size--;
+	}
+}
+
+unsigned char EEPROMIsWriting(void)
+{
+	return 0;
+}
+
+void LedInitialize(void) {}
+
+void LedTurnOn(TLedID __attribute__((unused)) Led_ID) {}
+
+void LedTurnOff(TLedID __attribute__((unused)) Led_ID) {}
+
+void RelayInitialize(void)
+{
+	Board_Relays_States = 0;
+}
+
+void RelayTurnOn(TRelayID Relay_ID)
+{
+	Board_Relays_States |= 1 << Relay_ID;
+}
+
+void RelayTurnOff(TRelayID Relay_ID)
+{
+	Board_Relays_States &= ~(1 << Relay_ID);
+}
+
+unsigned char RelayIsTurnedOn(TRelayID Relay_ID)
+{
+	if (Board_Relays_States & (1 << Relay_ID)) return 1;
+	return 0;
+}
+
+volatile unsigned char *SimulatorAccessUARTDataRegister(void)
+{
+	volatile unsigned char *Pointer_Register;
+	
+	Pointer_Register = &Board_UART_Data_Register_Accesses[Board_UART_Data_Register_Accesses_Count];
+	if (Board_UART_Data_Register_Accesses_Count < BOARD_UART_DATA_REGISTER_ACCESSES_MAXIMUM_COUNT - 1) Board_UART_Data_Register_Accesses_Count++;
+	return Pointer_Register;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void BoardInitialize(double Average_Outside_Temperature)
+{
+	unsigned short i;
+	
+	// A new board EEPROM is erased, so the firmware uses its default settings
+	for (i = 0; i < BOARD_EEPROM_SIZE; i++) Board_EEPROM[i] = 0xFF;
+	
+	Board_Average_Outside_Temperature = Average_Outside_Temperature;
+	BoardUpdatePhysicalModel(); // Compute the initial outside temperature
+	
+	// Initialize the firmware modules like the firmware does (the ESP8266 is not simulated, the network connection is managed by the simulator)
+	LedInitialize();
+	RelayInitialize();
+	SettingsInitialize();
+	TemperatureInitialize();
+	ProtocolSimulateConnection();
+}
+
+void BoardTask(void)
+{
+	BoardUpdatePhysicalModel();
+	BoardRunMainLoop();
+}
+
+int BoardReceiveByte(unsigned char Byte, unsigned char *Pointer_Answer)
+{
+	int Size;
+	
+	// The reception handler reads the received byte and decodes the command
+	Board_UART_Data_Register_Accesses[0] = Byte;
+	Board_UART_Data_Register_Accesses_Count = 0;
+	USART_RX_vect();
+	
+	// The firmware main loop is woken up by the interrupt and executes the command
+	ProtocolTask();
+	
+	// Simulate "data register empty" interrupts as long as the firmware keeps them enabled
+	Size = 0;
+	while (UCSR0B & 0x20)
+	{
+		Board_UART_Data_Register_Accesses_Count = 0;
+		USART_UDRE_vect();
+		if (Board_UART_Data_Register_Accesses_Count == 0) continue; // The handler disabled the interrupt because there is nothing left to send
+		if (Size < BOARD_ANSWER_MAXIMUM_SIZE)
+		{
+			Pointer_Answer[Size] = Board_UART_Data_Register_Accesses[0];
+			Size++;
+		}
+	}
+	
+	return Size;
+}
@@ -0,0 +1,398 @@
+/** @file Main.c
+ * Connect a simulated board to the web server like the real board does through the ESP8266, so the server can be run and measured without the hardware.
+ * The network link can be degraded with an answer latency, a jitter and a drop rate, all random draws come from a seeded generator so runs are reproducible.
+ * @author Adrien RICCIARDI
+ */
+#include <arpa/inet.h>
+#include <Board.h>
+#include <Configuration.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <Protocol.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many answers can wait for their sending time. */
+#define MAIN_PENDING_ANSWERS_MAXIMUM_COUNT 64
+/** How many milliseconds to wait before trying to connect again to the server. */
+#define MAIN_RECONNECTION_DELAY 1000
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** An answer waiting for the simulated link latency to elapse. */
+typedef struct
+{
+	double Sending_Time; //!< When to send the answer, in milliseconds.
+	int Size; //!< The answer size in bytes.
+	unsigned char Data[BOARD_ANSWER_MAXIMUM_SIZE]; //!< The answer content.
+} TMainPendingAnswer;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The answers waiting to be sent, in sending order (a serial link can't reorder bytes). */
+static TMainPendingAnswer Main_Pending_Answers[MAIN_PENDING_ANSWERS_MAXIMUM_COUNT];
+/** The oldest pending answer index. */
+static int Main_Pending_Answers_Read_Index = 0;
+/** How many answers are pending. */
+static int Main_Pending_Answers_Count = 0;
+
+/** Set by the signal handler to stop the simulator. */
+static volatile sig_atomic_t Main_Is_Exit_Requested = 0;
+
+/** How many commands have been executed. */
+static unsigned long Main_Executed_Commands_Count = 0;
+/** How many answers have been dropped on purpose. */
+static unsigned long Main_Dropped_Answers_Count = 0;
+/** How many times the simulator connected to the server. */
+static unsigned long Main_Connections_Count = 0;
+/** The executed commands count published in the counter file so benchmarks can read it while the simulator runs (NULL when no counter file is used). */
+static volatile unsigned long long *Main_Pointer_Shared_Executed_Commands_Count = NULL;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get a monotonic time.
+ * @return The time in milliseconds.
+ */
+static double MainGetTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return Time.tv_sec * 1000. + Time.tv_nsec / 1000000.;
+}
+
+/** Draw a random number from the seeded generator.
+ * @return A number in range [0; 1[.
+ */
+static double MainGetRandomNumber(void)
+{
+	return rand() / (RAND_MAX + 1.);
+}
+
+/** Stop the simulator main loop. */
+static void MainSignalHandler(int __attribute__((unused)) Signal_Number)
+{
+	Main_Is_Exit_Requested = 1;
+}
+
+/** Try to connect to the server, then announce the board ID like the firmware does.
+ * @param Pointer_Server_Address The server address.
+ * @param Board_ID The ID to announce.
+ * @return -1 if an error occurred,
+ * @return The connected socket on success.
+ */
+static int MainConnect(struct sockaddr_in *Pointer_Server_Address, unsigned char Board_ID)
+{
+	int Socket;
+	unsigned char Announcement[3] = {PROTOCOL_MAGIC_NUMBER, PROTOCOL_BOARD_ANNOUNCEMENT_CODE, Board_ID};
+	
+	Socket = socket(AF_INET, SOCK_STREAM, 0);
+	if (Socket == -1)
+	{
+		printf("Error : failed to create socket (%s).\n", strerror(errno));
+		return -1;
+	}
+	if (connect(Socket, (struct sockaddr *) Pointer_Server_Address, sizeof(struct sockaddr_in)) != 0)
+	{
+		close(Socket);
+		return -1;
+	}
+	if (send(Socket, Announcement, sizeof(Announcement), MSG_NOSIGNAL) != sizeof(Announcement))
+	{
+		close(Socket);
+		return -1;
+	}
+	
+	Main_Connections_Count++;
+	printf("Connected to server.\n");
+	return Socket;
+}
+
+/** Send all answers whose sending time has come.
+ * @param Socket The server socket.
+ * @param Current_Time The current time in milliseconds.
+ * @return -1 if the connection has been lost,
+ * @return 0 on success.
+ */
+static int MainSendPendingAnswers(int Socket, double Current_Time)
+{
+	TMainPendingAnswer *Pointer_Answer;
+	unsigned char Buffer[MAIN_PENDING_ANSWERS_MAXIMUM_COUNT * BOARD_ANSWER_MAXIMUM_SIZE];
+	int Size = 0;
+	
+	// Send the answers in a single segment like the ESP8266 does with the bytes it received from the UART in the meantime, sending them one by one would make the second one wait for the server to acknowledge the first one (Nagle algorithm)
+	while (Main_Pending_Answers_Count > 0)
+	{
+		Pointer_Answer = &Main_Pending_Answers[Main_Pending_Answers_Read_Index];
+		if (Pointer_Answer->Sending_Time > Current_Time) break;
+		
+		memcpy(&Buffer[Size], Pointer_Answer->Data, Pointer_Answer->Size);
+		Size += Pointer_Answer->Size;
+		Main_Pending_Answers_Read_Index = (Main_Pending_Answers_Read_Index + 1) % MAIN_PENDING_ANSWERS_MAXIMUM_COUNT;
+		Main_Pending_Answers_Count--;
+	}
+	
+	if ((Size > 0) && (send(Socket, Buffer, Size, MSG_NOSIGNAL) != Size)) return -1;
+	return 0;
+}
+
+/** Create the file publishing the executed commands count as a native unsigned long long.
+ * @param String_File_Path The counter file path.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int MainCreateCounterFile(char *String_File_Path)
+{
+	int File_Descriptor, Return_Value = -1;
+	void *Pointer_Mapping;
+	
+	File_Descriptor = open(String_File_Path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (File_Descriptor == -1)
+	{
+		printf("Error : failed to create counter file '%s' (%s).\n", String_File_Path, strerror(errno));
+		return -1;
+	}
+	if (ftruncate(File_Descriptor, sizeof(unsigned long long)) != 0)
+	{
+		printf("Error : failed to set counter file size (%s).\n", strerror(errno));
+		goto Exit;
+	}
+	
+	// The mapping stays valid once the file is closed
+	Pointer_Mapping = mmap(NULL, sizeof(unsigned long long), PROT_READ | PROT_WRITE, MAP_SHARED, File_Descriptor, 0);
+	if (Pointer_Mapping == MAP_FAILED)
+	{
+		printf("Error : failed to map counter file (%s).\n", strerror(errno));
+		goto Exit;
+	}
+	Main_Pointer_Shared_Executed_Commands_Count = Pointer_Mapping;
+	Return_Value = 0;
+	
+Exit:
+	close(File_Descriptor);
+	return Return_Value;
+}
+
+/** Give the received bytes to the firmware and schedule the resulting answers.
+ * @param Pointer_Buffer The received bytes.
+ * @param Size How many bytes were received.
+ * @param Current_Time The current time in milliseconds.
+ * @param Latency The mean answer latency in milliseconds.
+ * @param Jitter The maximum latency deviation in milliseconds.
+ * @param Drop_Rate The probability for an answer to be lost, in range [0; 1].
+ */
+static void MainProcessReceivedBytes(unsigned char *Pointer_Buffer, int Size, double Current_Time, double Latency, double Jitter, double Drop_Rate)
+{
+	TMainPendingAnswer *Pointer_Answer;
+	unsigned char Answer[BOARD_ANSWER_MAXIMUM_SIZE];
+	double Sending_Time;
+	int i, Answer_Size, Index;
+	
+	for (i = 0; i < Size; i++)
+	{
+		Answer_Size = BoardReceiveByte(Pointer_Buffer[i], Answer);
+		if (Answer_Size == 0) continue;
+		Main_Executed_Commands_Count++;
+		if (Main_Pointer_Shared_Executed_Commands_Count != NULL) *Main_Pointer_Shared_Executed_Commands_Count = Main_Executed_Commands_Count;
+		
+		// The command has been executed by the board, but its answer may be lost on the way back
+		if ((Drop_Rate > 0) && (MainGetRandomNumber() < Drop_Rate))
+		{
+			Main_Dropped_Answers_Count++;
+			continue;
+		}
+		if (Main_Pending_Answers_Count == MAIN_PENDING_ANSWERS_MAXIMUM_COUNT)
+		{
+			printf("Warning : too many pending answers, dropping the answer to command %d.\n", Answer[1]);
+			Main_Dropped_Answers_Count++;
+			continue;
+		}
+		
+		// Answers keep their order whatever their latency is
+		Sending_Time = Current_Time + Latency + (2. * MainGetRandomNumber() - 1.) * Jitter;
+		if (Main_Pending_Answers_Count > 0)
+		{
+			Index = (Main_Pending_Answers_Read_Index + Main_Pending_Answers_Count - 1) % MAIN_PENDING_ANSWERS_MAXIMUM_COUNT;
+			if (Sending_Time < Main_Pending_Answers[Index].Sending_Time) Sending_Time = Main_Pending_Answers[Index].Sending_Time;
+		}
+		
+		Pointer_Answer = &Main_Pending_Answers[(Main_Pending_Answers_Read_Index + Main_Pending_Answers_Count) % MAIN_PENDING_ANSWERS_MAXIMUM_COUNT];
+		Pointer_Answer->Sending_Time = Sending_Time;
+		Pointer_Answer->Size = Answer_Size;
+		memcpy(Pointer_Answer->Data, Answer, Answer_Size);
+		Main_Pending_Answers_Count++;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	struct sockaddr_in Server_Address;
+	struct pollfd Poll_Descriptor;
+	int Option, Is_Parameter_Bad = 0, Socket = -1, Timeout, Board_ID = CONFIGURATION_PROTOCOL_BOARD_ID;
+	unsigned int Random_Seed = 1;
+	double Latency = 0, Jitter = 0, Drop_Rate = 0, Speed_Factor = 1, Average_Outside_Temperature = 5, Current_Time, Next_Tick_Time, Next_Connection_Time, Next_Event_Time;
+	char *String_Server_Address = "127.0.0.1", *String_Counter_File_Path = NULL;
+	unsigned short Server_Port = atoi(CONFIGURATION_PROTOCOL_WIFI_SERVER_PORT);
+	unsigned char Buffer[256];
+	ssize_t Size;
+	
+	// Check parameters
+	while ((Option = getopt(argc, argv, "a:b:c:d:j:l:o:p:r:s:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'a':
+				String_Server_Address = optarg;
+				break;
+				
+			case 'b':
+				Board_ID = atoi(optarg);
+				if ((Board_ID < 0) || (Board_ID > 255)) Is_Parameter_Bad = 1;
+				break;
+				
+			case 'c':
+				String_Counter_File_Path = optarg;
+				break;
+				
+			case 'd':
+				Drop_Rate = atof(optarg) / 100.;
+				if ((Drop_Rate < 0) || (Drop_Rate > 1)) Is_Parameter_Bad = 1;
+				break;
+				
+			case 'j':
+				Jitter = atof(optarg);
+				if (Jitter < 0) Is_Parameter_Bad = 1;
+				break;
+				
+			case 'l':
+				Latency = atof(optarg);
+				if (Latency < 0) Is_Parameter_Bad = 1;
+				break;
+				
+			case 'o':
+				Average_Outside_Temperature = atof(optarg);
+				break;
+				
+			case 'p':
+				Server_Port = atoi(optarg);
+				break;
+				
+			case 'r':
+				Random_Seed = strtoul(optarg, NULL, 10);
+				break;
+				
+			case 's':
+				Speed_Factor = atof(optarg);
+				if (Speed_Factor <= 0) Is_Parameter_Bad = 1;
+				break;
+				
+			default:
+				Is_Parameter_Bad = 1;
+				break;
+		}
+	}
+	if (Is_Parameter_Bad || (optind != argc))
+	{
+		printf("Usage : %s [-a Server_Address] [-p Server_Port] [-b Board_ID] [-l Latency] [-j Jitter] [-d Drop_Rate] [-r Random_Seed] [-s Speed_Factor] [-o Outside_Temperature] [-c Counter_File]\n"
+			"  -a : the web server address (default is 127.0.0.1).\n"
+			"  -p : the port the web server waits for the board on (default is %s).\n"
+			"  -b : the ID announced to the web server, run several simulators with different IDs to simulate several heating circuits (default is %d).\n"
+			"  -l : the mean time in milliseconds between a command reception and its answer (default is 0).\n"
+			"  -j : the maximum random deviation in milliseconds added to or removed from the latency (default is 0).\n"
+			"  -d : the percentage of answers that are lost (default is 0).\n"
+			"  -r : the random generator seed, use the same seed to get the same latencies and losses (default is 1).\n"
+			"  -s : how many times faster than real time the board and the boiler run (default is 1).\n"
+			"  -o : the daily average outside temperature in Celsius degrees (default is 5).\n"
+			"  -c : a file where the executed commands count is kept up to date, so a benchmark can compute how many board round trips a request costs.\n", argv[0], CONFIGURATION_PROTOCOL_WIFI_SERVER_PORT, CONFIGURATION_PROTOCOL_BOARD_ID);
+		return EXIT_FAILURE;
+	}
+	if (Jitter > Latency) Jitter = Latency; // Answers can't be sent before the command is received
+	srand(Random_Seed);
+	
+	// Resolve the server address
+	memset(&Server_Address, 0, sizeof(Server_Address));
+	Server_Address.sin_family = AF_INET;
+	Server_Address.sin_port = htons(Server_Port);
+	if (inet_pton(AF_INET, String_Server_Address, &Server_Address.sin_addr) != 1)
+	{
+		printf("Error : bad server address '%s'.\n", String_Server_Address);
+		return EXIT_FAILURE;
+	}
+	if ((String_Counter_File_Path != NULL) && (MainCreateCounterFile(String_Counter_File_Path) != 0)) return EXIT_FAILURE;
+	
+	// Stop cleanly to display statistics
+	signal(SIGINT, MainSignalHandler);
+	signal(SIGTERM, MainSignalHandler);
+	
+	BoardInitialize(Average_Outside_Temperature);
+	Current_Time = MainGetTime();
+	Next_Tick_Time = Current_Time;
+	Next_Connection_Time = Current_Time;
+	
+	while (!Main_Is_Exit_Requested)
+	{
+		Current_Time = MainGetTime();
+		
+		// The board keeps running even when it is not connected
+		while (Current_Time >= Next_Tick_Time)
+		{
+			BoardTask();
+			Next_Tick_Time += 1000. / Speed_Factor;
+		}
+		
+		// Connect to the server like the ESP8266 does
+		if ((Socket == -1) && (Current_Time >= Next_Connection_Time))
+		{
+			Socket = MainConnect(&Server_Address, (unsigned char) Board_ID);
+			if (Socket == -1) Next_Connection_Time = Current_Time + MAIN_RECONNECTION_DELAY;
+		}
+		
+		// Send the answers whose latency has elapsed
+		if ((Socket != -1) && (MainSendPendingAnswers(Socket, Current_Time) != 0)) goto Connection_Lost;
+		
+		// Wait for the next thing to do
+		Next_Event_Time = Next_Tick_Time;
+		if ((Socket == -1) && (Next_Connection_Time < Next_Event_Time)) Next_Event_Time = Next_Connection_Time;
+		if ((Main_Pending_Answers_Count > 0) && (Main_Pending_Answers[Main_Pending_Answers_Read_Index].Sending_Time < Next_Event_Time)) Next_Event_Time = Main_Pending_Answers[Main_Pending_Answers_Read_Index].Sending_Time;
+		Timeout = (int) (Next_Event_Time - Current_Time) + 1;
+		if (Timeout < 0) Timeout = 0;
+		Poll_Descriptor.fd = Socket; // A negative descriptor is ignored by poll()
+		Poll_Descriptor.events = POLLIN;
+		if (poll(&Poll_Descriptor, 1, Timeout) <= 0) continue;
+		
+		// Execute the received commands
+		Size = read(Socket, Buffer, sizeof(Buffer));
+		if (Size <= 0) goto Connection_Lost;
+		MainProcessReceivedBytes(Buffer, Size, MainGetTime(), Latency, Jitter, Drop_Rate);
+		continue;
+		
+Connection_Lost:
+		// Bytes waiting in the ESP8266 are lost with the connection
+		printf("Connection to server lost, reconnecting.\n");
+		close(Socket);
+		Socket = -1;
+		Main_Pending_Answers_Count = 0;
+		Next_Connection_Time = Current_Time + MAIN_RECONNECTION_DELAY;
+	}
+	
+	if (Socket != -1) close(Socket);
+	printf("Executed commands : %lu, dropped answers : %lu, connections : %lu.\n", Main_Executed_Commands_Count, Main_Dropped_Answers_Count, Main_Connections_Count);
+	return EXIT_SUCCESS;
+}
@@ -3,9 +3,34 @@
  * @author Adrien RICCIARDI
  */
 #include <ADC.h>
+#include <avr/interrupt.h>
 #include <avr/io.h>
 #include <Configuration.h>
-#include <Protocol.h>
+#include <Profiler.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many conversions are summed to get a single sample (4 times more conversions are needed for each additional bit). */
+#define ADC_OVERSAMPLING_CONVERSIONS_COUNT (1 << (2 * CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS))
+
+// Sums are kept on 16 bits, so the interrupt does not need slow 32-bit computations
+#if CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS > 3
+	#error "CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS can't be greater than 3, the conversions sum would not fit in 16 bits."
+#endif
+#if CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT * (1023UL << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS) > 65535
+	#error "CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT is too big for the oversampling bits count, the moving average sum would not fit in 16 bits."
+#endif
+
+/** ADCSRA bits to keep when modifying the register. The "conversion complete" flag is cleared by writing 1 to it, so it must never be written back. The "start conversion" bit reads 1 while a conversion is running, it must only be written by ADC_START_CONVERSION(). */
+#define ADC_ADCSRA_MASK ((unsigned char) ~((1 << 6) | (1 << 4)))
+
+/** Enable "conversion complete" interrupt. */
+#define ADC_ENABLE_INTERRUPT() ADCSRA = (ADCSRA & ADC_ADCSRA_MASK) | (1 << 3)
+/** Disable "conversion complete" interrupt. */
+#define ADC_DISABLE_INTERRUPT() ADCSRA = ADCSRA & ADC_ADCSRA_MASK & ~(1 << 3)
+/** Start a conversion on the currently selected channel. */
+#define ADC_START_CONVERSION() ADCSRA = (ADCSRA & ADC_ADCSRA_MASK) | (1 << 6)
 
 //-------------------------------------------------------------------------------------------------
 // Private types
@@ -15,84 +40,152 @@ typedef struct
 {
 	unsigned short Samples[CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT]; //!< Hold all samples used to compute the average.
 	unsigned char Oldest_Sample_Index; //!< Tell which is the oldest sample value that can be replaced by a fresh one.
+	unsigned short Sum; //!< All samples sum, updated each time a sample is replaced so the average is computed without adding all samples.
 } TADCMovingAverage;
 
 //-------------------------------------------------------------------------------------------------
 // Private variables
 //-------------------------------------------------------------------------------------------------
-/** Hold all sampled values. */
+/** Hold all sampled values, with CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS more bits than the ADC provides. */
 static unsigned short ADC_Sampled_Values[ADC_CHANNEL_IDS_COUNT];
 
+/** All channels moving average. */
+static TADCMovingAverage ADC_Moving_Averages[ADC_CHANNEL_IDS_COUNT];
+
+/** The channel being sampled. */
+static unsigned char ADC_Current_Channel_ID = 0;
+/** How many conversions have been summed for the current sample. */
+static unsigned char ADC_Conversions_Count = 0;
+/** The current sample conversions sum. */
+static unsigned short ADC_Conversions_Sum = 0;
+/** Tell whether all channels are being sampled. */
+static volatile unsigned char ADC_Is_Sampling = 0;
+
+/** Set on the first sampling of all channels, which fills the moving averages with the first sample, so values are valid right after the module initialization. */
+static unsigned char ADC_Is_First_Sampling = 1;
+
 //-------------------------------------------------------------------------------------------------
-// Public functions
+// Private functions
 //-------------------------------------------------------------------------------------------------
-void ADCInitialize(void)
+/** Handle a finished conversion, then start the next one until all channels have been sampled.
+ * @return 0 if all channels have been sampled,
+ * @return 1 if a new conversion has been started.
+ */
+static unsigned char ADCHandleConversion(void)
 {
+	unsigned short Sample;
 	unsigned char i;
+	TADCMovingAverage *Pointer_Moving_Average;
 	
+	// Accumulate conversions until the sample is complete
+	ADC_Conversions_Sum += ADC; // The compiler reads the low register first, which latches the high register
+	ADC_Conversions_Count++;
+	if (ADC_Conversions_Count < ADC_OVERSAMPLING_CONVERSIONS_COUNT)
+	{
+		ADC_START_CONVERSION();
+		return 1;
+	}
+	
+	// Decimate the conversions sum to get the additional bits
+	Sample = ADC_Conversions_Sum >> CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS;
+	ADC_Conversions_Sum = 0;
+	ADC_Conversions_Count = 0;
+	
+	// Replace the oldest sample with the new one
+	Pointer_Moving_Average = &ADC_Moving_Averages[ADC_Current_Channel_ID];
+	if (ADC_Is_First_Sampling)
+	{
+		for (i = 0; i < CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT; i++) Pointer_Moving_Average->Samples[i] = Sample;
+		Pointer_Moving_Average->Sum = Sample * CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT;
+	}
+	else
+	{
+		Pointer_Moving_Average->Sum -= Pointer_Moving_Average->Samples[Pointer_Moving_Average->Oldest_Sample_Index];
+		Pointer_Moving_Average->Sum += Sample;
+		Pointer_Moving_Average->Samples[Pointer_Moving_Average->Oldest_Sample_Index] = Sample;
+		Pointer_Moving_Average->Oldest_Sample_Index++;
+		if (Pointer_Moving_Average->Oldest_Sample_Index >= CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT) Pointer_Moving_Average->Oldest_Sample_Index = 0;
+	}
+	ADC_Sampled_Values[ADC_Current_Channel_ID] = Pointer_Moving_Average->Sum / CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT;
+	
+	// Sample the next channel
+	ADC_Current_Channel_ID++;
+	if (ADC_Current_Channel_ID >= ADC_CHANNEL_IDS_COUNT)
+	{
+		ADC_Current_Channel_ID = 0;
+		ADC_Is_First_Sampling = 0;
+		ADC_Is_Sampling = 0;
+		return 0;
+	}
+	ADMUX = (ADMUX & 0xF0) | ADC_Current_Channel_ID; // The multiplexer can be safely changed because no conversion is running
+	ADC_START_CONVERSION();
+	return 1;
+}
+
+/** Handle the "conversion complete" interrupt. */
+ISR(ADC_vect)
+{
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_ADC_INTERRUPT, ADCHandleConversion());
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void ADCInitialize(void)
+{
 	// Configure pins as analog
 	DDRC &= 0xF0; // Set pins as inputs
 	PORTC &= 0xF0; // Put pins in high impedance mode, so digital push-pull stage will not perturb the analog signal even when the pin is not selected as the multiplexer analog input
 	DIDR0 = 0x0F; // Disable digital input buffer for the used analog channels
 	
 	// Configure the ADC module
-	ADMUX = 0; // Select AREF pin as voltage reference, right-adjust conversion result
-	ADCSRA = 0x85; // Enable ADC module, disable auto triggering feature, set the prescaler to 32 to get a 3686400/32 = 115200Hz ADC clock (ADC clock must be in range 50KHz to 200KHz)
+	ADMUX = 0; // Select AREF pin as voltage reference, right-adjust conversion result, select the first channel
+	ADCSRA = 0x95; // Enable ADC module, disable auto triggering feature and interrupt, clear a pending interrupt flag, set the prescaler to 32 to get a 3686400/32 = 115200Hz ADC clock (ADC clock must be in range 50KHz to 200KHz)
+	
+	// Discard the first conversion result, which may be wrong
+	ADC_START_CONVERSION();
+	while (!(ADCSRA & (1 << 4)));
+	ADCSRA |= 1 << 4; // Clear interrupt flag
+	
+	// Sample all channels once by polling (interrupts are not enabled yet), so values are valid on program start
+	ADC_START_CONVERSION();
+	do
+	{
+		while (!(ADCSRA & (1 << 4)));
+		ADCSRA |= 1 << 4; // Clear interrupt flag
+	} while (ADCHandleConversion());
 	
-	// Sample pins once to discard the first result, which may be wrong, then get as many samples as needed to compute the moving average value in order to have a valid value on program start
-	for (i = 0; i < CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT + 1; i++) ADCTask(); // The task will sample several pins (only one sampling is needed to discard the initial bad result), so there is no doubt that ADC values will be sampled fine after that
+	// Next samplings will be done by the interrupt
+	ADC_ENABLE_INTERRUPT();
 }
 
 void ADCTask(void)
 {
-	unsigned char i, j;
-	unsigned short Sampled_Value;
-	static TADCMovingAverage Moving_Averages[ADC_CHANNEL_IDS_COUNT] = {0};
-	TADCMovingAverage *Pointer_Moving_Average;
-	unsigned long Averaged_Sampled_Value;
+	// Do not disturb a sampling that is still running
+	if (ADC_Is_Sampling) return;
+	ADC_Is_Sampling = 1;
 	
-	for (i = 0; i < ADC_CHANNEL_IDS_COUNT; i++)
-	{
-		// Select the channel to sample
-		ADMUX &= 0xF0; // Reset the channel mask to 0
-		ADMUX |= i;
-		
-		// Start operation
-		ADCSRA |= 1 << 6;
-		
-		// Wait for the conversion to finish
-		while (!(ADCSRA & (1 << 4)));
-		ADCSRA &= ~(1 << 4); // Clear interrupt flag
-		
-		// Get the sampled value
-		Sampled_Value = ADCL; // Reading low register first results in latching the high register, even if it is useless here due to no other conversion started
-		Sampled_Value |= ADCH << 8;
-		
-		// Cache moving average access
-		Pointer_Moving_Average = &Moving_Averages[i];
-		
-		// Replace the oldest sample with the new one
-		Pointer_Moving_Average->Samples[Pointer_Moving_Average->Oldest_Sample_Index] = Sampled_Value;
-		Pointer_Moving_Average->Oldest_Sample_Index++;
-		if (Pointer_Moving_Average->Oldest_Sample_Index >= CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT) Pointer_Moving_Average->Oldest_Sample_Index = 0;
-		
-		// Compute the average
-		Averaged_Sampled_Value = 0;
-		for (j = 0; j < CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT; j++) Averaged_Sampled_Value += Pointer_Moving_Average->Samples[j];
-		Sampled_Value = (unsigned short) (Averaged_Sampled_Value / CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT);
-		
-		// Atomically update the sampled value (Protocol module may access to this value at any time, so disable Protocol interrupts to avoid it reading a semi-updated value)
-		PROTOCOL_DISABLE_INTERRUPTS();
-		ADC_Sampled_Values[i] = Sampled_Value;
-		PROTOCOL_ENABLE_INTERRUPTS();
-	}
+	// Start from the first channel
+	ADMUX &= 0xF0;
+	ADC_START_CONVERSION();
 }
 
-unsigned short ADCGetLastSampledValue(TADCChannelID Channel_ID)
+unsigned short ADCGetLastOversampledValue(TADCChannelID Channel_ID)
 {
+	unsigned short Value;
+	
 	// Make sure the provided channel is existing
 	if (Channel_ID >= ADC_CHANNEL_IDS_COUNT) return 0;
 	
-	// No need for a "mutex" here because the function is called by Protocol module (this call is protected by a mutex yet) or by main(), which also calls the ADC sampling task, so everything is synchronized
-	return ADC_Sampled_Values[Channel_ID];
+	// Reading a 16-bit variable takes two instructions, make sure the interrupt can't update it in the middle
+	ADC_DISABLE_INTERRUPT();
+	Value = ADC_Sampled_Values[Channel_ID];
+	ADC_ENABLE_INTERRUPT();
+	
+	return Value;
+}
+
+unsigned short ADCGetLastSampledValue(TADCChannelID Channel_ID)
+{
+	return ADCGetLastOversampledValue(Channel_ID) >> CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS;
 }
@@ -2,8 +2,59 @@
  * See EEPROM.h for description.
  * @author Adrien RICCIARDI
  */
-#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
 #include <EEPROM.h>
+#include <Profiler.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The next byte to write. */
+static const unsigned char *EEPROM_Pointer_Write_Buffer;
+/** Where to write the next byte. */
+static unsigned short EEPROM_Write_Address;
+/** How many bytes are left to write. */
+static unsigned char EEPROM_Write_Remaining_Bytes_Count = 0;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Start writing the next buffer byte that differs from the EEPROM content, or stop the interrupt when the whole buffer has been written. */
+static inline void EEPROMWriteNextByte(void)
+{
+	unsigned short Address;
+	unsigned char Data;
+
+	while (EEPROM_Write_Remaining_Bytes_Count > 0)
+	{
+		Address = EEPROM_Write_Address;
+		Data = *EEPROM_Pointer_Write_Buffer;
+		EEPROM_Write_Address++;
+		EEPROM_Pointer_Write_Buffer++;
+		EEPROM_Write_Remaining_Bytes_Count--;
+
+		// Do not wear a cell that already holds the right value (a write cycle also lasts more than 3ms, while a read is immediate)
+		if (EEPROMReadByte(Address) == Data) continue;
+
+		// Configure data to write (the address has been configured by the read)
+		EEDR = Data;
+
+		// Write byte, the interrupt will fire again when the write cycle is terminated
+		EECR = 0x0C; // Initialize write cycle by setting master write enable bit, select write and erase in a single operation, keep the interrupt enabled
+		EECR |= 0x02; // Start writing
+		return;
+	}
+
+	// Everything has been written
+	EECR &= ~0x08;
+}
+
+/** Write the next buffer byte each time the EEPROM is ready, until the whole buffer has been written. */
+ISR(EE_READY_vect)
+{
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_EEPROM_INTERRUPT, EEPROMWriteNextByte());
+}
 
 //-------------------------------------------------------------------------------------------------
 // Public functions
@@ -16,24 +67,23 @@ unsigned char EEPROMReadByte(unsigned short Address)
 	EEARL = (unsigned char) Address;
 
 	// Read byte
-	EECR = 0x01;
+	EECR |= 0x01; // Keep the "EEPROM ready" interrupt state
 	return EEDR;
 }
 
-void EEPROMWriteByte(unsigned short Address, unsigned char Data)
+void EEPROMStartWriting(unsigned short Address, const void *Pointer_Buffer, unsigned char Size)
 {
-	// Configure write address
-	Address &= 0x03FF; // Make sure address is valid, ATMEGA328P has 1KB of EEPROM space
-	EEARH = Address >> 8;
-	EEARL = (unsigned char) Address;
-
-	// Configure data to write
-	EEDR = Data;
+	EEPROM_Write_Address = Address;
+	EEPROM_Pointer_Write_Buffer = Pointer_Buffer;
+	EEPROM_Write_Remaining_Bytes_Count = Size;
 
-	// Write byte
-	EECR = 0x04; // Initialize write cycle by setting master write enable bit, select write and erase in a single operation
-	EECR |= 0x02; // Start writing
+	// The interrupt fires as soon as no write cycle is running
+	EECR |= 0x08;
+}
 
-	// Wait for write cycle to terminate
-	while (EECR & 0x02); // Wait for EEPE bit to be cleared by hardware
+unsigned char EEPROMIsWriting(void)
+{
+	// The interrupt is disabled when everything has been written
+	if (EECR & 0x08) return 1;
+	return 0;
 }
@@ -5,13 +5,40 @@
 #include <ADC.h>
 #include <avr/interrupt.h>
 #include <avr/io.h>
+#include <avr/sleep.h>
 #include <Configuration.h>
 #include <Led.h>
 #include <Mixing_Valve.h>
+#include <Profiler.h>
 #include <Protocol.h>
 #include <Relay.h>
+#include <Settings.h>
+#include <Telemetry.h>
 #include <Temperature.h>
-#include <util/delay.h>
+#include <Timer.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** Convert a period in milliseconds to scheduler ticks. */
+#define MAIN_MILLISECONDS_TO_TICKS(Milliseconds) ((Milliseconds) / CONFIGURATION_SCHEDULER_TICK_PERIOD)
+
+// MixingValveTask() and TelemetryTask() count seconds
+#if CONFIGURATION_SCHEDULER_REGULATION_TASK_PERIOD != 1000
+	#error "CONFIGURATION_SCHEDULER_REGULATION_TASK_PERIOD must be 1000 milliseconds."
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A task periodically run by the main loop. */
+typedef struct
+{
+	void (*Task)(void); //!< The function to run.
+	unsigned short Period; //!< How many ticks between two runs.
+	unsigned short Next_Run_Tick; //!< The tick the task must be run on.
+	TProfilerSectionID Profiler_Section_ID; //!< The profiler section accounting the task execution time.
+} TMainTask;
 
 //-------------------------------------------------------------------------------------------------
 // Private variables
@@ -24,98 +51,145 @@ FUSES =
 	FUSE_BODLEVEL2 // Fuses extended byte : set brown-out reset voltage to approximately 4.3V
 };
 
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Control the gas burner, the pump and the mixing valve, then blink the status led. */
+static void MainRegulationTask(void)
+{
+	static unsigned char Is_Status_Led_On = 1, Is_Boiler_Running_Before = 0; // Consider boiler as stopped on boot
+	unsigned char Is_Boiler_Running_Now;
+	signed char Radiator_Water_Start_Temperature, Target_Start_Water_Temperature;
+	
+	// Tell whether network is working
+	if (ProtocolIsConnected()) LedTurnOff(LED_ID_NETWORK_ERROR);
+	else LedTurnOn(LED_ID_NETWORK_ERROR);
+	
+	// Cache current running state as it is used several times
+	Is_Boiler_Running_Now = ProtocolIsBoilerRunning();
+	
+	// Handle gas burner
+	if (Is_Boiler_Running_Now)
+	{
+		// Cache converted temperature values (conversion computations cost a lot of cycles)
+		Radiator_Water_Start_Temperature = TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_RADIATOR_START);
+		Target_Start_Water_Temperature = TemperatureGetTargetStartWaterTemperature();
+		
+		// Gas burner control
+		if (Radiator_Water_Start_Temperature <= Target_Start_Water_Temperature - CONFIGURATION_GAS_BURNER_TEMPERATURE_HYSTERESIS_LOW) RelayTurnOn(RELAY_ID_GAS_BURNER);
+		else if (Radiator_Water_Start_Temperature >= Target_Start_Water_Temperature + CONFIGURATION_GAS_BURNER_TEMPERATURE_HYSTERESIS_HIGH) RelayTurnOff(RELAY_ID_GAS_BURNER);
+	}
+	
+	// Execute the following actions only once when running state changes
+	if (Is_Boiler_Running_Now != Is_Boiler_Running_Before)
+	{
+		if (Is_Boiler_Running_Now)
+		{
+			// Start pump
+			RelayTurnOn(RELAY_ID_PUMP);
+			
+			// Progressively send water to the radiators (assume valve is on the left position, which is set when boiler is stopped)
+			MixingValveSetPosition(MIXING_VALVE_POSITION_RIGHT);
+			
+			// Tell user boiler is running
+			LedTurnOff(LED_ID_BOILER_RUNNING_MODE);
+		}
+		else
+		{
+			// Make sure burner is stopped
+			RelayTurnOff(RELAY_ID_GAS_BURNER);
+			
+			// Stop pump
+			RelayTurnOff(RELAY_ID_PUMP);
+			
+			// Close radiators water circuit to send cold water only to the gas burner on next run
+			MixingValveSetPosition(MIXING_VALVE_POSITION_LEFT);
+			
+			// Tell user boiler is idle
+			LedTurnOn(LED_ID_BOILER_RUNNING_MODE);
+		}
+	}
+	Is_Boiler_Running_Before = Is_Boiler_Running_Now;
+	
+	// Make the mixing valve moves
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_MIXING_VALVE_TASK, MixingValveTask());
+	
+	// Record the resulting state for the server history
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_TELEMETRY_TASK, TelemetryTask());
+	
+	// Tell that controller is still alive
+	if (Is_Status_Led_On)
+	{
+		LedTurnOn(LED_ID_STATUS);
+		Is_Status_Led_On = 0;
+	}
+	else
+	{
+		LedTurnOff(LED_ID_STATUS);
+		Is_Status_Led_On = 1;
+	}
+}
+
 //-------------------------------------------------------------------------------------------------
 // Entry point
 //-------------------------------------------------------------------------------------------------
 int main(void) // Can't use void return type because it triggers a warning
 {
-	unsigned char Is_WiFi_Successfully_Initialized, Is_Status_Led_On = 1, Is_Boiler_Running_Before = 0, Is_Boiler_Running_Now; // Consider boiler as stopped on boot
-	signed char Radiator_Water_Start_Temperature, Target_Start_Water_Temperature;
+	unsigned char i;
+	unsigned short Current_Tick;
+	TMainTask *Pointer_Task;
+	static TMainTask Tasks[] = // Tasks due on the same tick are run in this order, all tasks are run on the first tick
+	{
+		// Sample all analog values first, so the following tasks use fresh values
+		{ ADCTask, MAIN_MILLISECONDS_TO_TICKS(CONFIGURATION_SCHEDULER_ADC_TASK_PERIOD), 0, PROFILER_SECTION_ID_ADC_TASK },
+		// Connect to the server in background, so the heating is controlled from power on even when the network is not available
+		{ ProtocolLinkTask, MAIN_MILLISECONDS_TO_TICKS(CONFIGURATION_SCHEDULER_PROTOCOL_LINK_TASK_PERIOD), 0, PROFILER_SECTION_ID_PROTOCOL_LINK_TASK },
+		// Compute target temperature to reach (compute it even when boiler is not running in order to report a good value through protocol commands)
+		{ TemperatureTask, MAIN_MILLISECONDS_TO_TICKS(CONFIGURATION_SCHEDULER_HEATING_CURVE_TASK_PERIOD), 0, PROFILER_SECTION_ID_TEMPERATURE_TASK },
+		{ MainRegulationTask, MAIN_MILLISECONDS_TO_TICKS(CONFIGURATION_SCHEDULER_REGULATION_TASK_PERIOD), 0, PROFILER_SECTION_ID_REGULATION_TASK },
+		// Save the settings modified by the previous tasks or by protocol commands
+		{ SettingsTask, MAIN_MILLISECONDS_TO_TICKS(CONFIGURATION_SCHEDULER_SETTINGS_TASK_PERIOD), 0, PROFILER_SECTION_ID_SETTINGS_TASK }
+	};
 	
 	// Initialize modules
 	LedInitialize();
 	LedTurnOn(LED_ID_STATUS); // Turn status led on to tell controller is booting
 	ADCInitialize();
 	RelayInitialize();
+	SettingsInitialize(); // Load settings before the modules using them
 	TemperatureInitialize();
-	Is_WiFi_Successfully_Initialized = ProtocolInitialize();
+	ProtocolInitialize();
+	TimerInitialize();
+	set_sleep_mode(SLEEP_MODE_IDLE); // Idle mode stops the CPU only, timers, ADC and UART keep running and can wake it up
 	
 	// Enable interrupts now that all modules have been configured
 	sei();
 	
-	// Tell whether network is working
-	if (!Is_WiFi_Successfully_Initialized) LedTurnOn(LED_ID_NETWORK_ERROR);
-	
 	while (1)
 	{
-		// Sample all analog values
-		ADCTask();
-		
-		// Compute target temperature to reach (compute it even when boiler is not running in order to report a good value through protocol commands)
-		TemperatureTask();
-		
-		// Cache current running state as it is used several times
-		Is_Boiler_Running_Now = ProtocolIsBoilerRunning();
-		
-		// Handle gas burner
-		if (Is_Boiler_Running_Now)
+		// Run all tasks that are due
+		Current_Tick = TimerGetTicksCount();
+		for (i = 0; i < sizeof(Tasks) / sizeof(Tasks[0]); i++)
 		{
-			// Cache converted temperature values (conversion computations cost a lot of cycles)
-			Radiator_Water_Start_Temperature = TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_RADIATOR_START);
-			Target_Start_Water_Temperature = TemperatureGetTargetStartWaterTemperature();
+			Pointer_Task = &Tasks[i];
+			if ((signed short) (Current_Tick - Pointer_Task->Next_Run_Tick) < 0) continue; // The difference is right even when the ticks count wraps around
 			
-			// Gas burner control
-			if (Radiator_Water_Start_Temperature <= Target_Start_Water_Temperature - CONFIGURATION_GAS_BURNER_TEMPERATURE_HYSTERESIS_LOW) RelayTurnOn(RELAY_ID_GAS_BURNER);
-			else if (Radiator_Water_Start_Temperature >= Target_Start_Water_Temperature + CONFIGURATION_GAS_BURNER_TEMPERATURE_HYSTERESIS_HIGH) RelayTurnOff(RELAY_ID_GAS_BURNER);
+			PROFILER_MEASURE_SECTION(Pointer_Task->Profiler_Section_ID, Pointer_Task->Task());
+			Pointer_Task->Next_Run_Tick += Pointer_Task->Period; // Compute the next run from the scheduled tick and not from the current one, so the task execution time does not make the period drift
 		}
 		
-		// Execute the following actions only once when running state changes
-		if (Is_Boiler_Running_Now != Is_Boiler_Running_Before)
-		{
-			if (Is_Boiler_Running_Now)
-			{
-				// Start pump
-				RelayTurnOn(RELAY_ID_PUMP);
-				
-				// Progressively send water to the radiators (assume valve is on the left position, which is set when boiler is stopped)
-				MixingValveSetPosition(MIXING_VALVE_POSITION_RIGHT);
-				
-				// Tell user boiler is running
-				LedTurnOff(LED_ID_BOILER_RUNNING_MODE);
-			}
-			else
-			{
-				// Make sure burner is stopped
-				RelayTurnOff(RELAY_ID_GAS_BURNER);
-				
-				// Stop pump
-				RelayTurnOff(RELAY_ID_PUMP);
-				
-				// Close radiators water circuit to send cold water only to the gas burner on next run
-				MixingValveSetPosition(MIXING_VALVE_POSITION_LEFT);
-				
-				// Tell user boiler is idle
-				LedTurnOn(LED_ID_BOILER_RUNNING_MODE);
-			}
-		}
-		Is_Boiler_Running_Before = Is_Boiler_Running_Now;
+		// Execute the commands received meanwhile
+		PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_PROTOCOL_TASK, ProtocolTask());
 		
-		// Make the mixing valve moves
-		MixingValveTask();
-		
-		// Tell that controller is still alive
-		if (Is_Status_Led_On)
+		// Sleep until an interrupt brings something to do. Check with interrupts disabled, so an interrupt happening right after the check can't be missed by going to sleep (the instruction following sei() is always executed before any interrupt, so the CPU goes to sleep before the interrupt wakes it up)
+		cli();
+		if ((TimerGetTicksCount() == Current_Tick) && !ProtocolIsCommandPending())
 		{
-			LedTurnOn(LED_ID_STATUS);
-			Is_Status_Led_On = 0;
+			sleep_enable();
+			sei();
+			sleep_cpu();
+			sleep_disable();
 		}
-		else
-		{
-			LedTurnOff(LED_ID_STATUS);
-			Is_Status_Led_On = 1;
-		}
-		
-		// This is a slow regulation process, we can safely wait some time between each loop
-		_delay_ms(1000);
+		sei();
 	}
 }
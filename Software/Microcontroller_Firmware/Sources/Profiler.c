@@ -0,0 +1,90 @@
+/** @file Profiler.c
+ * @see Profiler.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <avr/interrupt.h>
+#include <Configuration.h>
+#include <Profiler.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A section statistics. */
+typedef struct
+{
+	unsigned long Calls_Count; //!< How many times the section has been executed.
+	unsigned short Minimum_Counts; //!< The shortest execution time.
+	unsigned short Maximum_Counts; //!< The longest execution time.
+	unsigned long Total_Counts; //!< All execution times sum.
+} TProfilerSection;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+#if CONFIGURATION_PROFILER_ENABLED
+/** All sections statistics. */
+static TProfilerSection Profiler_Sections[PROFILER_SECTION_IDS_COUNT];
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+#if CONFIGURATION_PROFILER_ENABLED
+void ProfilerRecordSection(TProfilerSectionID Section_ID, unsigned long Elapsed_Counts)
+{
+	TProfilerSection *Pointer_Section = &Profiler_Sections[Section_ID];
+	unsigned short Counts;
+	
+	// A section lasting more than 65535 counts is abnormally long anyway, keep the extremes on 16 bits so interrupt handlers are not slowed down too much
+	if (Elapsed_Counts > 0xFFFF) Counts = 0xFFFF;
+	else Counts = (unsigned short) Elapsed_Counts;
+	
+	if ((Pointer_Section->Calls_Count == 0) || (Counts < Pointer_Section->Minimum_Counts)) Pointer_Section->Minimum_Counts = Counts;
+	if (Counts > Pointer_Section->Maximum_Counts) Pointer_Section->Maximum_Counts = Counts;
+	Pointer_Section->Total_Counts += Elapsed_Counts;
+	Pointer_Section->Calls_Count++;
+}
+#endif
+
+void ProfilerReadSection(unsigned char Section_ID, unsigned char Is_Reset_Requested, unsigned char *Pointer_Buffer)
+{
+	TProfilerSection Section = { 0, 0, 0, 0 };
+	
+	Pointer_Buffer[0] = Section_ID;
+#if CONFIGURATION_PROFILER_ENABLED
+	Pointer_Buffer[1] = PROFILER_SECTION_IDS_COUNT;
+	Pointer_Buffer[2] = TIMER_PRESCALER;
+	
+	// Interrupt handlers update their statistics at any time
+	if (Section_ID < PROFILER_SECTION_IDS_COUNT)
+	{
+		cli();
+		Section = Profiler_Sections[Section_ID];
+		if (Is_Reset_Requested)
+		{
+			Profiler_Sections[Section_ID].Calls_Count = 0; // The minimum is set by the next execution
+			Profiler_Sections[Section_ID].Maximum_Counts = 0;
+			Profiler_Sections[Section_ID].Total_Counts = 0;
+		}
+		sei();
+	}
+#else
+	// Nothing is measured
+	(void) Is_Reset_Requested;
+	Pointer_Buffer[1] = 0;
+	Pointer_Buffer[2] = 0;
+#endif
+	
+	Pointer_Buffer[3] = (unsigned char) Section.Calls_Count;
+	Pointer_Buffer[4] = (unsigned char) (Section.Calls_Count >> 8);
+	Pointer_Buffer[5] = (unsigned char) (Section.Calls_Count >> 16);
+	Pointer_Buffer[6] = (unsigned char) (Section.Calls_Count >> 24);
+	Pointer_Buffer[7] = (unsigned char) Section.Minimum_Counts;
+	Pointer_Buffer[8] = Section.Minimum_Counts >> 8;
+	Pointer_Buffer[9] = (unsigned char) Section.Maximum_Counts;
+	Pointer_Buffer[10] = Section.Maximum_Counts >> 8;
+	Pointer_Buffer[11] = (unsigned char) Section.Total_Counts;
+	Pointer_Buffer[12] = (unsigned char) (Section.Total_Counts >> 8);
+	Pointer_Buffer[13] = (unsigned char) (Section.Total_Counts >> 16);
+	Pointer_Buffer[14] = (unsigned char) (Section.Total_Counts >> 24);
+}
@@ -7,18 +7,49 @@
 #include <avr/interrupt.h>
 #include <Configuration.h>
 #include <Mixing_Valve.h>
+#include <Profiler.h>
 #include <Protocol.h>
+#include <Relay.h>
+#include <Settings.h>
+#include <stddef.h>
+#include <Telemetry.h>
 #include <Temperature.h>
-#include <util/delay.h>
 
 //-------------------------------------------------------------------------------------------------
 // Private constants
 //-------------------------------------------------------------------------------------------------
-/** The magic number preceding all received and sent commands. */
-#define PROTOCOL_MAGIC_NUMBER 0xA5
-
 /** The biggest command payload size. */
-#define PROTOCOL_PAYLOAD_MAXIMUM_SIZE 6 // TODO set when all commands are decided
+#define PROTOCOL_PAYLOAD_MAXIMUM_SIZE TELEMETRY_BLOCK_PAYLOAD_SIZE // The telemetry block answer is the biggest payload
+/** The biggest answer size, including the magic number and the command code. */
+#define PROTOCOL_ANSWER_MAXIMUM_SIZE (2 + PROTOCOL_PAYLOAD_MAXIMUM_SIZE)
+
+/** Enable "receive complete" interrupt. */
+#define PROTOCOL_ENABLE_RECEPTION_INTERRUPT() UCSR0B |= 0x80
+/** Disable "receive complete" interrupt. */
+#define PROTOCOL_DISABLE_RECEPTION_INTERRUPT() UCSR0B &= ~0x80
+/** Enable "data register empty" interrupt, it is triggered as long as the data register can accept a byte. */
+#define PROTOCOL_ENABLE_TRANSMISSION_INTERRUPT() UCSR0B |= 0x20
+/** Disable "data register empty" interrupt. */
+#define PROTOCOL_DISABLE_TRANSMISSION_INTERRUPT() UCSR0B &= ~0x20
+
+// Ring buffer indexes wrap around with a mask
+#if (CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE & (CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE - 1)) != 0
+	#error "CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE must be a power of two."
+#endif
+#if CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE > 256
+	#error "CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE can't be greater than 256."
+#endif
+#if (CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE & (CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE - 1)) != 0
+	#error "CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE must be a power of two."
+#endif
+
+/** Convert a duration in seconds to link task runs. */
+#define PROTOCOL_LINK_SECONDS_TO_TASK_RUNS(Seconds) ((unsigned short) ((Seconds) * 1000UL / CONFIGURATION_SCHEDULER_PROTOCOL_LINK_TASK_PERIOD))
+
+// The delay before retrying also provides the silence the ESP8266 needs before "+++"
+#if CONFIGURATION_PROTOCOL_LINK_MINIMUM_RETRY_DELAY < 1
+	#error "CONFIGURATION_PROTOCOL_LINK_MINIMUM_RETRY_DELAY must be at least 1 second."
+#endif
 
 //-------------------------------------------------------------------------------------------------
 // Private types
@@ -29,11 +60,44 @@ typedef enum
 	PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER,
 	PROTOCOL_STATE_RECEIVE_COMMAND,
 	PROTOCOL_STATE_RECEIVE_PAYLOAD,
-	PROTOCOL_STATE_TRANSMIT_COMMAND,
-	PROTOCOL_STATE_TRANSMIT_PAYLOAD,
 	PROTOCOL_STATES_COUNT
 } TProtocolState;
 
+/** All steps needed to connect the ESP8266 to the server, then to keep the connection up. */
+typedef enum
+{
+	PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RESET,
+	PROTOCOL_LINK_STEP_RESET,
+	PROTOCOL_LINK_STEP_SET_WIFI_MODE,
+	PROTOCOL_LINK_STEP_JOIN_ACCESS_POINT,
+	PROTOCOL_LINK_STEP_CONNECT_TO_SERVER,
+	PROTOCOL_LINK_STEP_SET_TRANSPARENT_MODE,
+	PROTOCOL_LINK_STEP_START_SENDING,
+	PROTOCOL_LINK_STEP_CONNECTED,
+	PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RECONNECTION,
+	PROTOCOL_LINK_STEP_CLOSE_CONNECTION,
+	PROTOCOL_LINK_STEPS_COUNT
+} TProtocolLinkStep;
+
+/** The ESP8266 answer to the current step command. */
+typedef enum
+{
+	PROTOCOL_LINK_ANSWER_NONE,
+	PROTOCOL_LINK_ANSWER_SUCCESS,
+	PROTOCOL_LINK_ANSWER_ERROR
+} TProtocolLinkAnswer;
+
+/** Describe a connection step. */
+typedef struct
+{
+	const char *String_Command; //!< The string sent to the ESP8266 when the step starts, NULL if there is nothing to send.
+	const char *String_Success_Answer; //!< The answer telling that the command succeeded, NULL if the step succeeds when its timeout expires.
+	const char *String_Error_Answer; //!< The answer telling that the command failed, NULL if there is no such answer.
+	unsigned char Timeout; //!< How many seconds to wait for an answer (the connected step has no timeout).
+	TProtocolLinkStep Next_Step_On_Success; //!< The step to go to when the command succeeded.
+	TProtocolLinkStep Next_Step_On_Failure; //!< The step to go to after a retry delay when the command failed or timed out.
+} TProtocolLinkStepDescription;
+
 /** All known commands. */
 typedef enum
 {
@@ -50,126 +114,230 @@ typedef enum
 	PROTOCOL_COMMAND_GET_TARGET_START_WATER_TEMPERATURE,
 	PROTOCOL_COMMAND_GET_HEATING_CURVE_PARAMETERS,
 	PROTOCOL_COMMAND_SET_HEATING_CURVE_PARAMETERS,
+	PROTOCOL_COMMAND_GET_STATUS,
+	PROTOCOL_COMMAND_APPLY_SETTINGS,
+	PROTOCOL_COMMAND_GET_TELEMETRY_BLOCK,
+	PROTOCOL_COMMAND_GET_TASK_PROFILE,
 	PROTOCOL_COMMANDS_COUNT
 } TProtocolCommand;
 
+/** A command decoded by the reception interrupt, waiting to be executed by the main loop. */
+typedef struct
+{
+	TProtocolCommand Command; //!< The command to execute.
+	unsigned char Payload_Buffer[PROTOCOL_PAYLOAD_MAXIMUM_SIZE]; //!< The received payload.
+} TProtocolReceivedCommand;
+
 //-------------------------------------------------------------------------------------------------
 // Private variables
 //-------------------------------------------------------------------------------------------------
-/** The current protocol state machine state. */
+/** Relays states bits in the status command answer. */
+#define PROTOCOL_STATUS_RELAY_MIXING_VALVE_LEFT 0x01
+#define PROTOCOL_STATUS_RELAY_MIXING_VALVE_RIGHT 0x02
+#define PROTOCOL_STATUS_RELAY_PUMP 0x04
+#define PROTOCOL_STATUS_RELAY_GAS_BURNER 0x08
+/** The status command answer payload size. */
+#define PROTOCOL_STATUS_PAYLOAD_SIZE 13
+
+/** Tell which settings the apply settings command changes, the other ones keep their current value. */
+#define PROTOCOL_APPLY_SETTINGS_FLAG_BOILER_RUNNING_MODE 0x01
+#define PROTOCOL_APPLY_SETTINGS_FLAG_NIGHT_MODE 0x02
+#define PROTOCOL_APPLY_SETTINGS_FLAG_DESIRED_ROOM_TEMPERATURES 0x04
+#define PROTOCOL_APPLY_SETTINGS_FLAG_HEATING_CURVE_PARAMETERS 0x08
+
+/** The current reception state machine state. */
 static TProtocolState Protocol_State = PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
 
-/** The last received command, or the command to transmit. */
+/** All connection steps. Answers strings must not start with a repeated pattern, because the matching restarts from their first character on a mismatch. */
+static const TProtocolLinkStepDescription Protocol_Link_Steps[PROTOCOL_LINK_STEPS_COUNT] =
+{
+	// PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RESET : the microcontroller may have rebooted (due to firmware programming) while the ESP8266 was in "transparent bridge" mode, wait at least 1 second for the "+++" sequence to be validated (see https://en.wikipedia.org/wiki/Hayes_command_set)
+	{ "+++", NULL, NULL, 2, PROTOCOL_LINK_STEP_RESET, PROTOCOL_LINK_STEP_RESET },
+	// PROTOCOL_LINK_STEP_RESET : ESP8266 will send a lot of data with a bad baud rate followed by the string "ready". This reset sequence does not harm if the ESP8266 is powered at the same time the microcontroller is, WiFi will just take some more seconds to connect
+	{ "AT+RST\r\n", "ready", NULL, 10, PROTOCOL_LINK_STEP_SET_WIFI_MODE, PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RESET },
+	// PROTOCOL_LINK_STEP_SET_WIFI_MODE : access point + station mode is mandatory for the transparent mode to work
+	{ "AT+CWMODE_CUR=3\r\n", "\r\nOK\r\n", "ERROR\r\n", 5, PROTOCOL_LINK_STEP_JOIN_ACCESS_POINT, PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RESET },
+	// PROTOCOL_LINK_STEP_JOIN_ACCESS_POINT
+	{ "AT+CWJAP_CUR=\"" CONFIGURATION_PROTOCOL_WIFI_ACCESS_POINT_SSID "\",\"" CONFIGURATION_PROTOCOL_WIFI_ACCESS_POINT_PASSWORD "\"\r\n", "\r\nOK\r\n", "FAIL\r\n", 20, PROTOCOL_LINK_STEP_CONNECT_TO_SERVER, PROTOCOL_LINK_STEP_JOIN_ACCESS_POINT },
+	// PROTOCOL_LINK_STEP_CONNECT_TO_SERVER : join the access point again on failure, as it may have been lost too
+	{ "AT+CIPSTART=\"TCP\",\"" CONFIGURATION_PROTOCOL_WIFI_SERVER_ADDRESS "\"," CONFIGURATION_PROTOCOL_WIFI_SERVER_PORT "\r\n", "\r\nOK\r\n", "ERROR\r\n", 10, PROTOCOL_LINK_STEP_SET_TRANSPARENT_MODE, PROTOCOL_LINK_STEP_JOIN_ACCESS_POINT },
+	// PROTOCOL_LINK_STEP_SET_TRANSPARENT_MODE : directly transmit what is written to the ESP8266 UART
+	{ "AT+CIPMODE=1\r\n", "\r\nOK\r\n", "ERROR\r\n", 5, PROTOCOL_LINK_STEP_START_SENDING, PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RESET },
+	// PROTOCOL_LINK_STEP_START_SENDING
+	{ "AT+CIPSEND\r\n", "\r\nOK\r\n", "ERROR\r\n", 5, PROTOCOL_LINK_STEP_CONNECTED, PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RESET },
+	// PROTOCOL_LINK_STEP_CONNECTED : the ESP8266 tells when the server closed the connection, a silent server is detected by the link task
+	{ NULL, NULL, "CLOSED\r\n", 0, PROTOCOL_LINK_STEP_CONNECTED, PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RECONNECTION },
+	// PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RECONNECTION : the retry delay provided the silence needed before "+++"
+	{ "+++", NULL, NULL, 2, PROTOCOL_LINK_STEP_CLOSE_CONNECTION, PROTOCOL_LINK_STEP_CLOSE_CONNECTION },
+	// PROTOCOL_LINK_STEP_CLOSE_CONNECTION : the ESP8266 may still consider the connection as opened, its answer does not matter
+	{ "AT+CIPCLOSE\r\n", NULL, NULL, 2, PROTOCOL_LINK_STEP_CONNECT_TO_SERVER, PROTOCOL_LINK_STEP_CONNECT_TO_SERVER }
+};
+
+/** The current connection step. */
+static volatile TProtocolLinkStep Protocol_Link_Step = PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RESET;
+/** The current step answer, set by the reception interrupt. */
+static volatile TProtocolLinkAnswer Protocol_Link_Answer = PROTOCOL_LINK_ANSWER_NONE;
+/** How many success answer characters have been matched. */
+static unsigned char Protocol_Link_Success_Answer_Index = 0;
+/** How many error answer characters have been matched. */
+static unsigned char Protocol_Link_Error_Answer_Index = 0;
+/** The command characters that have not been queued for transmission yet. */
+static const char *Protocol_Link_Pointer_String_Command = NULL;
+/** How many link task runs to wait before sending the step command. */
+static unsigned short Protocol_Link_Delay = 0;
+/** How many link task runs are left to receive the step answer. */
+static unsigned short Protocol_Link_Timeout = 0;
+/** How many seconds to wait before retrying a failed step, it doubles after each failure. */
+static unsigned char Protocol_Link_Retry_Delay = CONFIGURATION_PROTOCOL_LINK_MINIMUM_RETRY_DELAY;
+/** Set by the reception interrupt each time a command is received, so the link task knows the server is alive. */
+static volatile unsigned char Protocol_Link_Is_Command_Received = 0;
+/** How many link task runs elapsed since the last received command. */
+static unsigned short Protocol_Link_Inactivity_Time = 0;
+
+/** The commands received by the interrupt and not executed yet. The command at the write index is the one being received, so one slot is always left free. */
+static TProtocolReceivedCommand Protocol_Received_Commands[CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE];
+/** Where the reception interrupt stores the next command (only modified by the interrupt). */
+static volatile unsigned char Protocol_Received_Commands_Write_Index = 0;
+/** The next command to execute (only modified by the main loop). */
+static volatile unsigned char Protocol_Received_Commands_Read_Index = 0;
+/** The index where to store the next received payload byte. */
+static unsigned char Protocol_Received_Payload_Index;
+/** The size of the payload being received. */
+static unsigned char Protocol_Received_Payload_Size;
+
+/** The bytes waiting to be sent. */
+static unsigned char Protocol_Transmission_Buffer[CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE];
+/** Where to store the next byte to send (only modified by the main loop). */
+static volatile unsigned char Protocol_Transmission_Buffer_Write_Index = 0;
+/** The next byte to send (only modified by the transmission interrupt). */
+static volatile unsigned char Protocol_Transmission_Buffer_Read_Index = 0;
+/** Set by the main loop when the biggest answer does not fit in the transmission buffer, cleared by the transmission interrupt when it does again. The pending commands are not reported meanwhile, so the main loop can sleep. */
+static volatile unsigned char Protocol_Is_Waiting_For_Transmission_Room = 0;
+
+/** The command being executed. */
 static TProtocolCommand Protocol_Command;
-/** The command payload content. */
+/** The command payload content, the command answer replaces it. */
 static unsigned char Protocol_Command_Payload_Buffer[PROTOCOL_PAYLOAD_MAXIMUM_SIZE];
-/** The command payload index, indicating where to store the next received byte or what byte to transmit next. */
-static unsigned char Protocol_Command_Payload_Index;
-/** The command payload size in bytes (as well in reception as in transmission mode). */
+/** The command answer payload size in bytes. */
 static unsigned char Protocol_Command_Payload_Size;
 
-/** Tell whether the boiler is currently running or idle. */
-static unsigned char Protocol_Is_Boiler_Running = 1; // Automatically enable the boiler on power on
-
-/** Tell if this is night or day. */
-static unsigned char Protocol_Is_Night_Mode_Enabled = 0;
-
 //-------------------------------------------------------------------------------------------------
 // Private functions
 //-------------------------------------------------------------------------------------------------
-/** Read a byte from the serial port without relying on interrupt handler.
- * @return The read value.
+/** Append a byte to the transmission buffer. The caller must make sure there is enough room.
+ * @param Byte The byte to send.
  */
-static unsigned char ProtocolUARTReadByteNoInterrupt(void)
+static void ProtocolQueueByte(unsigned char Byte)
 {
-	// Wait for a byte to be received
-	while (!(UCSR0A & 0x80));
-	
-	// Get the byte
-	return UDR0;
+	Protocol_Transmission_Buffer[Protocol_Transmission_Buffer_Write_Index] = Byte;
+	Protocol_Transmission_Buffer_Write_Index = (Protocol_Transmission_Buffer_Write_Index + 1) & (CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE - 1);
 }
 
-/** Write a byte to the serial port without relying on interrupt handler.
- * @param Byte The byte value.
+/** Tell how many bytes can be appended to the transmission buffer.
+ * @return The free room in bytes.
  */
-static void ProtocolUARTWriteByteNoInterrupt(unsigned char Byte)
+static unsigned char ProtocolGetTransmissionBufferFreeSize(void)
 {
-	// Send the byte
-	UDR0 = Byte;
+	return (Protocol_Transmission_Buffer_Read_Index - Protocol_Transmission_Buffer_Write_Index - 1) & (CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE - 1);
+}
+
+/** Update a string matching with a received character.
+ * @param String The string to find, it can be NULL.
+ * @param Pointer_Index On input, contain how many characters have already been matched. On output, contain the updated count.
+ * @param Byte The received character.
+ * @return 0 if the string has not been fully received yet,
+ * @return 1 if the string has just been fully received.
+ */
+static inline unsigned char ProtocolLinkMatchString(const char *String, unsigned char *Pointer_Index, unsigned char Byte)
+{
+	if (String == NULL) return 0;
 	
-	// Wait for the byte to be transmitted
-	while (!(UCSR0A & 0x40));
-	UCSR0A |= 0x40; // Clear "transmit complete" flag
+	// Restart the matching on a mismatch, the character can still be the string first one
+	if (Byte != String[*Pointer_Index]) *Pointer_Index = 0;
+	if (Byte != String[*Pointer_Index]) return 0;
+	
+	(*Pointer_Index)++;
+	if (String[*Pointer_Index] != 0) return 0;
+	*Pointer_Index = 0;
+	return 1;
 }
 
-/** Write a zero-terminated string to the serial port without relying on interrupt handler.
- * @param String The string to write (terminating zero is not written).
+/** Forget the answers received so far, so only the answer to the next command is considered. */
+static void ProtocolLinkResetAnswer(void)
+{
+	PROTOCOL_DISABLE_RECEPTION_INTERRUPT();
+	Protocol_Link_Success_Answer_Index = 0;
+	Protocol_Link_Error_Answer_Index = 0;
+	Protocol_Link_Answer = PROTOCOL_LINK_ANSWER_NONE;
+	PROTOCOL_ENABLE_RECEPTION_INTERRUPT();
+}
+
+/** Go to a connection step.
+ * @param Step The step to go to.
+ * @param Delay How many link task runs to wait before sending the step command.
  */
-static void ProtocolUARTWriteStringNoInterrupt(char *String)
+static void ProtocolLinkEnterStep(TProtocolLinkStep Step, unsigned short Delay)
 {
-	while (*String != 0)
+	// Forget the command that was being received when the link goes up or down, so the first bytes sent by the server on the new connection are not taken for its end
+	if ((Step == PROTOCOL_LINK_STEP_CONNECTED) || (Protocol_Link_Step == PROTOCOL_LINK_STEP_CONNECTED))
 	{
-		ProtocolUARTWriteByteNoInterrupt(*String);
-		String++;
+		PROTOCOL_DISABLE_RECEPTION_INTERRUPT();
+		Protocol_State = PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
+		PROTOCOL_ENABLE_RECEPTION_INTERRUPT();
 	}
+	
+	Protocol_Link_Step = Step;
+	ProtocolLinkResetAnswer();
+	Protocol_Link_Pointer_String_Command = Protocol_Link_Steps[Step].String_Command;
+	Protocol_Link_Delay = Delay;
+	Protocol_Link_Timeout = PROTOCOL_LINK_SECONDS_TO_TASK_RUNS(Protocol_Link_Steps[Step].Timeout);
 }
 
-/** Wait for a specific string from the ESP8266 module (terminating "\r\n" are automatically added, no need to provide them in string).
- * @param String_Success_Answer The expected string in case of success.
- * @param String_Error_Answer The expected string in case of error.
- * @return 0 if the error string was received,
- * @return 1 if the success string was received.
- * @warning This function never returns if none of the strings are received.
- */
-static unsigned char ProtocolESP8266IsCommandSuccessful(char *String_Success_Answer, char *String_Error_Answer)
+/** Handle the current step failure, the next step is delayed longer after each consecutive failure so a missing access point or server is not flooded with requests. */
+static void ProtocolLinkHandleFailure(void)
 {
-	unsigned char Received_Byte, Success_String_Index = 0, Error_String_Index = 0, Is_Success_String_Found = 0;
+	TProtocolLinkStep Step;
 	
-	// Receive characters until one of the two strings is fully detected
-	while (1)
+	// Drop the answers that were waiting to be sent to the server, they would be taken as commands by the ESP8266
+	if (Protocol_Link_Step == PROTOCOL_LINK_STEP_CONNECTED)
 	{
-		Received_Byte = ProtocolUARTReadByteNoInterrupt();
-		
-		// Is this character matching the success string current character ?
-		if (Received_Byte != String_Success_Answer[Success_String_Index]) Success_String_Index = 0;
-		else
-		{
-			Success_String_Index++;
-			
-			// Is the success string fully received ?
-			if (String_Success_Answer[Success_String_Index] == 0)
-			{
-				Is_Success_String_Found = 1;
-				break;
-			}
-		}
-		
-		// Is this character matching the error string current character ?
-		if (Received_Byte != String_Error_Answer[Error_String_Index]) Error_String_Index = 0;
-		else
-		{
-			Error_String_Index++;
-			
-			// Is the error string fully received ?
-			if (String_Error_Answer[Error_String_Index] == 0)
-			{
-				Is_Success_String_Found = 0;
-				break;
-			}
-		}
+		PROTOCOL_DISABLE_TRANSMISSION_INTERRUPT();
+		Protocol_Transmission_Buffer_Write_Index = Protocol_Transmission_Buffer_Read_Index;
+		Protocol_Is_Waiting_For_Transmission_Room = 0; // The interrupt that would have cleared it is stopped
 	}
 	
-	// Wait for terminating "\r\n"
-	while (ProtocolUARTReadByteNoInterrupt() != '\r');
-	while (ProtocolUARTReadByteNoInterrupt() != '\n');
+	Step = Protocol_Link_Steps[Protocol_Link_Step].Next_Step_On_Failure;
+	ProtocolLinkEnterStep(Step, PROTOCOL_LINK_SECONDS_TO_TASK_RUNS(Protocol_Link_Retry_Delay));
 	
-	return Is_Success_String_Found;
+	if (Protocol_Link_Retry_Delay < CONFIGURATION_PROTOCOL_LINK_MAXIMUM_RETRY_DELAY / 2) Protocol_Link_Retry_Delay *= 2;
+	else Protocol_Link_Retry_Delay = CONFIGURATION_PROTOCOL_LINK_MAXIMUM_RETRY_DELAY;
 }
 
-/** Execute a fully received command. */
+/** Fill the payload buffer with all values a monitoring client needs. */
+static void ProtocolFillStatusPayload(void)
+{
+	Protocol_Command_Payload_Buffer[0] = (unsigned char) TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_OUTSIDE);
+	Protocol_Command_Payload_Buffer[1] = (unsigned char) TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_RADIATOR_START);
+	Protocol_Command_Payload_Buffer[2] = TemperatureGetTargetStartWaterTemperature();
+	TemperatureGetDesiredRoomTemperatures((signed char *) &Protocol_Command_Payload_Buffer[3], (signed char *) &Protocol_Command_Payload_Buffer[4]);
+	Protocol_Command_Payload_Buffer[5] = ProtocolIsBoilerRunning();
+	Protocol_Command_Payload_Buffer[6] = ProtocolIsNightModeEnabled();
+	Protocol_Command_Payload_Buffer[7] = MixingValveGetPosition();
+	Protocol_Command_Payload_Buffer[8] = 0;
+	if (RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_LEFT)) Protocol_Command_Payload_Buffer[8] |= PROTOCOL_STATUS_RELAY_MIXING_VALVE_LEFT;
+	if (RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_RIGHT)) Protocol_Command_Payload_Buffer[8] |= PROTOCOL_STATUS_RELAY_MIXING_VALVE_RIGHT;
+	if (RelayIsTurnedOn(RELAY_ID_PUMP)) Protocol_Command_Payload_Buffer[8] |= PROTOCOL_STATUS_RELAY_PUMP;
+	if (RelayIsTurnedOn(RELAY_ID_GAS_BURNER)) Protocol_Command_Payload_Buffer[8] |= PROTOCOL_STATUS_RELAY_GAS_BURNER;
+	TemperatureGetHeatingCurveParameters((unsigned short *) &Protocol_Command_Payload_Buffer[9], (unsigned short *) &Protocol_Command_Payload_Buffer[11]);
+	Protocol_Command_Payload_Size = PROTOCOL_STATUS_PAYLOAD_SIZE;
+}
+
+/** Execute a fully received command, then queue its answer. */
 static void ProtocolExecuteCommand(void)
 {
 	unsigned short *Pointer_Word;
+	unsigned char Flags, i;
+	TSettings Settings;
 	
 	switch (Protocol_Command)
 	{
@@ -198,7 +366,9 @@ static void ProtocolExecuteCommand(void)
 			break;
 			
 		case PROTOCOL_COMMAND_SET_NIGHT_MODE:
-			Protocol_Is_Night_Mode_Enabled = Protocol_Command_Payload_Buffer[0];
+			Settings = *SettingsGet();
+			Settings.Is_Night_Mode_Enabled = Protocol_Command_Payload_Buffer[0];
+			SettingsSet(&Settings);
 			Protocol_Command_Payload_Size = 0;
 			break;
 			
@@ -221,12 +391,14 @@ static void ProtocolExecuteCommand(void)
 			break;
 			
 		case PROTOCOL_COMMAND_GET_BOILER_RUNNING_MODE:
-			Protocol_Command_Payload_Buffer[0] = Protocol_Is_Boiler_Running;
+			Protocol_Command_Payload_Buffer[0] = ProtocolIsBoilerRunning();
 			Protocol_Command_Payload_Size = 1;
 			break;
 			
 		case PROTOCOL_COMMAND_SET_BOILER_RUNNING_MODE:
-			Protocol_Is_Boiler_Running = Protocol_Command_Payload_Buffer[0];
+			Settings = *SettingsGet();
+			Settings.Is_Boiler_Running = Protocol_Command_Payload_Buffer[0];
+			SettingsSet(&Settings);
 			Protocol_Command_Payload_Size = 0;
 			break;
 			
@@ -245,20 +417,59 @@ static void ProtocolExecuteCommand(void)
 			TemperatureSetHeatingCurveParameters(Pointer_Word[0], Pointer_Word[1]);
 			Protocol_Command_Payload_Size = 0;
 			break;
-			
+		
+		// Gather all values a monitoring client needs in a single answer
+		case PROTOCOL_COMMAND_GET_STATUS:
+			ProtocolFillStatusPayload();
+			break;
+		
+		// Change several settings at once, so the board is never left with only a part of them applied if the link drops, and answer with the resulting state
+		case PROTOCOL_COMMAND_APPLY_SETTINGS:
+			Flags = Protocol_Command_Payload_Buffer[0];
+			Settings = *SettingsGet();
+			if (Flags & PROTOCOL_APPLY_SETTINGS_FLAG_BOILER_RUNNING_MODE) Settings.Is_Boiler_Running = Protocol_Command_Payload_Buffer[1];
+			if (Flags & PROTOCOL_APPLY_SETTINGS_FLAG_NIGHT_MODE) Settings.Is_Night_Mode_Enabled = Protocol_Command_Payload_Buffer[2];
+			SettingsSet(&Settings);
+			if (Flags & PROTOCOL_APPLY_SETTINGS_FLAG_DESIRED_ROOM_TEMPERATURES) TemperatureSetDesiredRoomTemperatures((signed char) Protocol_Command_Payload_Buffer[3], (signed char) Protocol_Command_Payload_Buffer[4]);
+			if (Flags & PROTOCOL_APPLY_SETTINGS_FLAG_HEATING_CURVE_PARAMETERS)
+			{
+				Pointer_Word = (unsigned short *) &Protocol_Command_Payload_Buffer[5];
+				TemperatureSetHeatingCurveParameters(Pointer_Word[0], Pointer_Word[1]);
+			}
+			ProtocolFillStatusPayload();
+			break;
+		
+		// Send the recorded samples block by block, the requested sample number is the download cursor
+		case PROTOCOL_COMMAND_GET_TELEMETRY_BLOCK:
+			Pointer_Word = (unsigned short *) Protocol_Command_Payload_Buffer;
+			TelemetryReadBlock(*Pointer_Word, Protocol_Command_Payload_Buffer);
+			Protocol_Command_Payload_Size = TELEMETRY_BLOCK_PAYLOAD_SIZE;
+			break;
+		
+		// Tell how long a task or an interrupt handler takes, the server asks for each section in turn
+		case PROTOCOL_COMMAND_GET_TASK_PROFILE:
+			ProfilerReadSection(Protocol_Command_Payload_Buffer[0], Protocol_Command_Payload_Buffer[1], Protocol_Command_Payload_Buffer);
+			Protocol_Command_Payload_Size = PROFILER_SECTION_PAYLOAD_SIZE;
+			break;
+		
 		// Unknown command, should not get here
 		default:
 			break;
 	}
 	
-	// Send command answer
-	Protocol_State = PROTOCOL_STATE_TRANSMIT_COMMAND;
-	Protocol_Command_Payload_Index = 0;
-	UDR0 = PROTOCOL_MAGIC_NUMBER;
+	// Queue the command answer
+	ProtocolQueueByte(PROTOCOL_MAGIC_NUMBER);
+	ProtocolQueueByte(Protocol_Command);
+	for (i = 0; i < Protocol_Command_Payload_Size; i++) ProtocolQueueByte(Protocol_Command_Payload_Buffer[i]);
+	
+	// Start sending
+	PROTOCOL_ENABLE_TRANSMISSION_INTERRUPT();
 }
 
-/** Handle UART reception interrupts. */
-ISR(USART_RX_vect)
+/** Handle a byte received by the UART. Commands are only decoded here, they are executed by the main loop so the interrupt stays short.
+ * @param Byte The received byte.
+ */
+static inline void ProtocolHandleReceivedByte(unsigned char Byte)
 {
 	static unsigned char Received_Command_Payload[PROTOCOL_COMMANDS_COUNT] =
 	{
@@ -274,83 +485,104 @@ ISR(USART_RX_vect)
 		1, // PROTOCOL_COMMAND_SET_BOILER_RUNNING_MODE
 		0, // PROTOCOL_COMMAND_GET_TARGET_START_WATER_TEMPERATURE
 		0, // PROTOCOL_COMMAND_GET_HEATING_CURVE_PARAMETERS
-		4 // PROTOCOL_COMMAND_SET_HEATING_CURVE_PARAMETERS
+		4, // PROTOCOL_COMMAND_SET_HEATING_CURVE_PARAMETERS
+		0, // PROTOCOL_COMMAND_GET_STATUS
+		9, // PROTOCOL_COMMAND_APPLY_SETTINGS
+		2, // PROTOCOL_COMMAND_GET_TELEMETRY_BLOCK
+		2 // PROTOCOL_COMMAND_GET_TASK_PROFILE
 	};
-	unsigned char Byte;
+	unsigned char Next_Write_Index;
+	TProtocolReceivedCommand *Pointer_Received_Command;
+	const TProtocolLinkStepDescription *Pointer_Step;
+	
+	// Look for the ESP8266 answers
+	Pointer_Step = &Protocol_Link_Steps[Protocol_Link_Step];
+	if (ProtocolLinkMatchString(Pointer_Step->String_Success_Answer, &Protocol_Link_Success_Answer_Index, Byte)) Protocol_Link_Answer = PROTOCOL_LINK_ANSWER_SUCCESS;
+	if (ProtocolLinkMatchString(Pointer_Step->String_Error_Answer, &Protocol_Link_Error_Answer_Index, Byte)) Protocol_Link_Answer = PROTOCOL_LINK_ANSWER_ERROR;
+	
+	// Commands can be received only when the server is connected
+	if (Protocol_Link_Step != PROTOCOL_LINK_STEP_CONNECTED) return;
 	
-	// Get the received byte
-	Byte = UDR0;
+	// The free slot of the queue receives the command
+	Pointer_Received_Command = &Protocol_Received_Commands[Protocol_Received_Commands_Write_Index];
 	
 	switch (Protocol_State)
 	{
 		case PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER:
 			if (Byte == PROTOCOL_MAGIC_NUMBER) Protocol_State = PROTOCOL_STATE_RECEIVE_COMMAND;
-			break;
+			return;
 			
 		case PROTOCOL_STATE_RECEIVE_COMMAND:
-			Protocol_Command = Byte;
 			// Make sure it is a known command
-			if (Protocol_Command >= PROTOCOL_COMMANDS_COUNT)
+			if (Byte >= PROTOCOL_COMMANDS_COUNT)
 			{
 				Protocol_State = PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER; // Abort current command reception
-				break;
+				return;
 			}
+			Pointer_Received_Command->Command = Byte;
+			
 			// Determine how many bytes of payload to receive
-			Protocol_Command_Payload_Size = Received_Command_Payload[Protocol_Command];
-			// Execute the command if there is no payload to receive
-			if (Protocol_Command_Payload_Size == 0) ProtocolExecuteCommand();
-			else
+			Protocol_Received_Payload_Size = Received_Command_Payload[Byte];
+			if (Protocol_Received_Payload_Size > 0)
 			{
-				Protocol_Command_Payload_Index = 0; // Start filling the payload buffer from the beginning
+				Protocol_Received_Payload_Index = 0; // Start filling the payload buffer from the beginning
 				Protocol_State = PROTOCOL_STATE_RECEIVE_PAYLOAD;
+				return;
 			}
 			break;
 			
 		case PROTOCOL_STATE_RECEIVE_PAYLOAD:
 			// Receive next byte
-			Protocol_Command_Payload_Buffer[Protocol_Command_Payload_Index] = Byte;
-			Protocol_Command_Payload_Index++;
-			
-			// Execute command if the payload is fully received
-			if (Protocol_Command_Payload_Index == Protocol_Command_Payload_Size) ProtocolExecuteCommand();
+			Pointer_Received_Command->Payload_Buffer[Protocol_Received_Payload_Index] = Byte;
+			Protocol_Received_Payload_Index++;
+			if (Protocol_Received_Payload_Index < Protocol_Received_Payload_Size) return;
 			break;
 		
 		// Unknown state, do nothing
 		default:
-			break;
+			return;
 	}
+	
+	// The command is fully received, give it to the main loop (the command is lost if the queue is full, the server will time out waiting for the answer)
+	Protocol_State = PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
+	Protocol_Link_Is_Command_Received = 1;
+	Next_Write_Index = (Protocol_Received_Commands_Write_Index + 1) & (CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE - 1);
+	if (Next_Write_Index != Protocol_Received_Commands_Read_Index) Protocol_Received_Commands_Write_Index = Next_Write_Index;
 }
 
-/** Handle UART transmission interrupts. */
-ISR(USART_TX_vect)
+/** Handle UART reception interrupts. */
+ISR(USART_RX_vect)
 {
-	switch (Protocol_State)
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_UART_RECEPTION_INTERRUPT, ProtocolHandleReceivedByte(UDR0));
+}
+
+/** Send the next byte of the transmission buffer, or stop the transmission interrupt when everything has been sent. */
+static inline void ProtocolTransmitNextByte(void)
+{
+	// Stop the interrupt when everything has been sent
+	if (Protocol_Transmission_Buffer_Read_Index == Protocol_Transmission_Buffer_Write_Index)
 	{
-		case PROTOCOL_STATE_TRANSMIT_COMMAND:
-			UDR0 = Protocol_Command;
-			Protocol_State = PROTOCOL_STATE_TRANSMIT_PAYLOAD; // There is no special case for commands that do not provide payload in order to wait for the transmission interrupt to happen, this way we are sure that the byte was transmitted and we can safely go to another state of the state machine
-			break;
-			
-		case PROTOCOL_STATE_TRANSMIT_PAYLOAD:
-			// Wait for another command if this one's answer has been fully transmitted
-			if (Protocol_Command_Payload_Index == Protocol_Command_Payload_Size) Protocol_State = PROTOCOL_STATE_RECEIVE_MAGIC_NUMBER;
-			else
-			{
-				UDR0 = Protocol_Command_Payload_Buffer[Protocol_Command_Payload_Index];
-				Protocol_Command_Payload_Index++;
-			}
-			break;
-			
-		// Unknown state, do nothing
-		default:
-			break;
+		PROTOCOL_DISABLE_TRANSMISSION_INTERRUPT();
+		return;
 	}
+	
+	UDR0 = Protocol_Transmission_Buffer[Protocol_Transmission_Buffer_Read_Index];
+	Protocol_Transmission_Buffer_Read_Index = (Protocol_Transmission_Buffer_Read_Index + 1) & (CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE - 1);
+	
+	// Let the main loop execute the pending commands once the biggest answer fits again
+	if (Protocol_Is_Waiting_For_Transmission_Room && (ProtocolGetTransmissionBufferFreeSize() >= PROTOCOL_ANSWER_MAXIMUM_SIZE)) Protocol_Is_Waiting_For_Transmission_Room = 0;
+}
+
+/** Handle UART "data register empty" interrupts, the next byte is written as soon as the previous one started being sent, so answers are sent back to back. */
+ISR(USART_UDRE_vect)
+{
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_UART_TRANSMISSION_INTERRUPT, ProtocolTransmitNextByte());
 }
 
 //-------------------------------------------------------------------------------------------------
 // Public functions
 //-------------------------------------------------------------------------------------------------
-unsigned char ProtocolInitialize(void)
+void ProtocolInitialize(void)
 {
 	// Initialize UART module to 115200bit/s, 8-bit data, no parity
 	UBRR0H = 0;
@@ -359,53 +591,142 @@ unsigned char ProtocolInitialize(void)
 	UCSR0C = 0x06; // Select asynchronous UART, disable parity mode, select 1 stop bit, select 8-bit character size
 	UCSR0B = 0x18; // Enable reception and transmission
 	
-	// Reset the module in case the microcontroller rebooted (due to firmware programming). This reset sequence does not harm if the ESP8266 is powered at the same time the microcontroller is (for instance when powering the board), WiFi will just take some more seconds to connect
-	ProtocolUARTWriteStringNoInterrupt("+++"); // Exit from "transparent bridge mode"
-	_delay_ms(2000); // Wait at least 1 second for the "+++" sequence to be validated (see https://en.wikipedia.org/wiki/Hayes_command_set)
-	ProtocolUARTWriteStringNoInterrupt("AT+RST\r\n"); // Reset module
+	// Start connecting, the link task will do the next steps in background
+	ProtocolLinkEnterStep(PROTOCOL_LINK_STEP_EXIT_TRANSPARENT_MODE_BEFORE_RESET, 0);
+}
+
+void ProtocolLinkTask(void)
+{
+	const TProtocolLinkStepDescription *Pointer_Step;
 	
-	// ESP8266 will send a lot of data with a bad baud rate followed by the string "ready"
-	ProtocolESP8266IsCommandSuccessful("ready", "THIS STRING CAN'T BE FOUND");
+	Pointer_Step = &Protocol_Link_Steps[Protocol_Link_Step];
 	
-	// Set WiFi mode to access point + station, it's mandatory for the transparent mode to work
-	ProtocolUARTWriteStringNoInterrupt("AT+CWMODE_CUR=3\r\n");
-	if (!ProtocolESP8266IsCommandSuccessful("\r\nOK", "\r\nERROR")) return 0;
+	// Make sure the server is still there
+	if (Protocol_Link_Step == PROTOCOL_LINK_STEP_CONNECTED)
+	{
+		if (Protocol_Link_Is_Command_Received)
+		{
+			Protocol_Link_Is_Command_Received = 0;
+			Protocol_Link_Inactivity_Time = 0;
+		}
+		else Protocol_Link_Inactivity_Time++;
+		
+		if ((Protocol_Link_Answer == PROTOCOL_LINK_ANSWER_ERROR) || (Protocol_Link_Inactivity_Time >= PROTOCOL_LINK_SECONDS_TO_TASK_RUNS(CONFIGURATION_PROTOCOL_LINK_INACTIVITY_TIMEOUT))) ProtocolLinkHandleFailure();
+		return;
+	}
 	
-	// Try to connect to access point
-	ProtocolUARTWriteStringNoInterrupt("AT+CWJAP_CUR=\"");
-	ProtocolUARTWriteStringNoInterrupt(CONFIGURATION_PROTOCOL_WIFI_ACCESS_POINT_SSID);
-	ProtocolUARTWriteStringNoInterrupt("\",\"");
-	ProtocolUARTWriteStringNoInterrupt(CONFIGURATION_PROTOCOL_WIFI_ACCESS_POINT_PASSWORD);
-	ProtocolUARTWriteStringNoInterrupt("\"\r\n");
-	if (!ProtocolESP8266IsCommandSuccessful("\r\n\r\nOK", "\r\n\r\nFAIL")) return 0; // A fully matching string must be provided because the string comparison function does not recheck the current character with the received one when the index has been reset (for the sake of simplicity)
+	// Wait before retrying a failed step
+	if (Protocol_Link_Delay > 0)
+	{
+		Protocol_Link_Delay--;
+		if (Protocol_Link_Delay > 0) return;
+		ProtocolLinkResetAnswer(); // Ignore the answers received while waiting
+	}
 	
-	// Try to connect to server
-	ProtocolUARTWriteStringNoInterrupt("AT+CIPSTART=\"TCP\",\"");
-	ProtocolUARTWriteStringNoInterrupt(CONFIGURATION_PROTOCOL_WIFI_SERVER_ADDRESS);
-	ProtocolUARTWriteStringNoInterrupt("\",");
-	ProtocolUARTWriteStringNoInterrupt(CONFIGURATION_PROTOCOL_WIFI_SERVER_PORT);
-	ProtocolUARTWriteStringNoInterrupt("\r\n");
-	if (!ProtocolESP8266IsCommandSuccessful("\r\n\r\nOK", "\r\nERROR\r\nCLOSED")) return 0;
+	// Send the command, a bit at a time if it does not fit in the transmission buffer
+	if ((Protocol_Link_Pointer_String_Command != NULL) && (*Protocol_Link_Pointer_String_Command != 0))
+	{
+		while ((*Protocol_Link_Pointer_String_Command != 0) && (ProtocolGetTransmissionBufferFreeSize() > 0))
+		{
+			ProtocolQueueByte(*Protocol_Link_Pointer_String_Command);
+			Protocol_Link_Pointer_String_Command++;
+		}
+		PROTOCOL_ENABLE_TRANSMISSION_INTERRUPT();
+		return; // Start counting the answer timeout when the whole command has been queued
+	}
 	
-	// Set connection mode to "transparent bridge" to directly transmit what is written to the ESP8266 UART
-	ProtocolUARTWriteStringNoInterrupt("AT+CIPMODE=1\r\n");
-	if (!ProtocolESP8266IsCommandSuccessful("\r\nOK", "\r\nERROR")) return 0;
+	// Wait for the answer
+	if (Protocol_Link_Answer == PROTOCOL_LINK_ANSWER_ERROR)
+	{
+		ProtocolLinkHandleFailure();
+		return;
+	}
+	if (Protocol_Link_Answer == PROTOCOL_LINK_ANSWER_NONE)
+	{
+		if (Protocol_Link_Timeout > 0)
+		{
+			Protocol_Link_Timeout--;
+			return;
+		}
+		
+		// Some steps only need to wait
+		if (Pointer_Step->String_Success_Answer != NULL)
+		{
+			ProtocolLinkHandleFailure();
+			return;
+		}
+	}
 	
-	ProtocolUARTWriteStringNoInterrupt("AT+CIPSEND\r\n");
-	if (!ProtocolESP8266IsCommandSuccessful("\r\nOK", "\r\nERROR")) return 0;
+	// The step succeeded
+	ProtocolLinkEnterStep(Pointer_Step->Next_Step_On_Success, 0);
+	if (Protocol_Link_Step == PROTOCOL_LINK_STEP_CONNECTED)
+	{
+		Protocol_Link_Retry_Delay = CONFIGURATION_PROTOCOL_LINK_MINIMUM_RETRY_DELAY;
+		Protocol_Link_Inactivity_Time = 0;
+		
+		// Tell the server which heating circuit this board drives, so several boards can share the same server (the transmission buffer is empty because the link was not connected)
+		ProtocolQueueByte(PROTOCOL_MAGIC_NUMBER);
+		ProtocolQueueByte(PROTOCOL_BOARD_ANNOUNCEMENT_CODE);
+		ProtocolQueueByte(CONFIGURATION_PROTOCOL_BOARD_ID);
+		PROTOCOL_ENABLE_TRANSMISSION_INTERRUPT();
+	}
+}
+
+unsigned char ProtocolIsConnected(void)
+{
+	if (Protocol_Link_Step == PROTOCOL_LINK_STEP_CONNECTED) return 1;
+	return 0;
+}
+
+void ProtocolTask(void)
+{
+	TProtocolReceivedCommand *Pointer_Received_Command;
+	unsigned char i;
 	
-	// Enable interrupts now that the WiFi bridge has been initialized
-	PROTOCOL_ENABLE_INTERRUPTS();
+	// The commands received before the link was lost can't be answered anymore
+	if (Protocol_Link_Step != PROTOCOL_LINK_STEP_CONNECTED)
+	{
+		Protocol_Received_Commands_Read_Index = Protocol_Received_Commands_Write_Index;
+		return;
+	}
 	
-	return 1;
+	while (ProtocolIsCommandPending())
+	{
+		// Wait for the previous answers to be sent if the biggest answer can't fit in the transmission buffer. The flag is set before checking the room, so the interrupt can't make room unnoticed
+		Protocol_Is_Waiting_For_Transmission_Room = 1;
+		if (ProtocolGetTransmissionBufferFreeSize() < PROTOCOL_ANSWER_MAXIMUM_SIZE) return;
+		Protocol_Is_Waiting_For_Transmission_Room = 0;
+		
+		// Copy the command, so its queue slot can be reused as soon as possible
+		Pointer_Received_Command = &Protocol_Received_Commands[Protocol_Received_Commands_Read_Index];
+		Protocol_Command = Pointer_Received_Command->Command;
+		for (i = 0; i < PROTOCOL_PAYLOAD_MAXIMUM_SIZE; i++) Protocol_Command_Payload_Buffer[i] = Pointer_Received_Command->Payload_Buffer[i];
+		Protocol_Received_Commands_Read_Index = (Protocol_Received_Commands_Read_Index + 1) & (CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE - 1);
+		
+		ProtocolExecuteCommand();
+	}
+}
+
+unsigned char ProtocolIsCommandPending(void)
+{
+	if (Protocol_Is_Waiting_For_Transmission_Room) return 0; // The commands can't be executed until the transmission interrupt makes room for their answers
+	if (Protocol_Received_Commands_Read_Index != Protocol_Received_Commands_Write_Index) return 1;
+	return 0;
 }
 
 unsigned char ProtocolIsBoilerRunning(void)
 {
-	return Protocol_Is_Boiler_Running;
+	return SettingsGet()->Is_Boiler_Running;
 }
 
 unsigned char ProtocolIsNightModeEnabled(void)
 {
-	return Protocol_Is_Night_Mode_Enabled;
+	return SettingsGet()->Is_Night_Mode_Enabled;
+}
+
+#if CONFIGURATION_PROTOCOL_LINK_SIMULATED
+void ProtocolSimulateConnection(void)
+{
+	ProtocolLinkEnterStep(PROTOCOL_LINK_STEP_CONNECTED, 0);
 }
+#endif
@@ -25,3 +25,9 @@ void RelayTurnOff(TRelayID Relay_ID)
 {
 	PORTD &= ~(1 << Relay_ID);
 }
+
+unsigned char RelayIsTurnedOn(TRelayID Relay_ID)
+{
+	if (PORTD & (1 << Relay_ID)) return 1;
+	return 0;
+}
@@ -0,0 +1,218 @@
+/** @file Settings.c
+ * @see Settings.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Configuration.h>
+#include <EEPROM.h>
+#include <Settings.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The ATmega328P EEPROM size in bytes. */
+#define SETTINGS_EEPROM_SIZE 1024
+/** A journal record size in bytes, it must divide the EEPROM size. */
+#define SETTINGS_RECORD_SIZE 16
+/** How many records the EEPROM can hold. */
+#define SETTINGS_RECORDS_COUNT (SETTINGS_EEPROM_SIZE / SETTINGS_RECORD_SIZE)
+/** How many bytes the EEPROM layout of older firmwares uses at the beginning of the first record. */
+#define SETTINGS_LEGACY_LAYOUT_SIZE 4
+
+/** The records layout version, increment it each time the TSettings structure is modified (records with another version are ignored). Erased EEPROM bytes read 0xFF, so this value must not be 0xFF. */
+#define SETTINGS_RECORD_VERSION 1
+
+/** The CRC-16 CCITT polynomial. */
+#define SETTINGS_CRC_POLYNOMIAL 0x1021
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A journal record as stored in the EEPROM. The CRC is the last field, so it is written last and a record interrupted by a power loss is detected as corrupted. */
+typedef union
+{
+	struct __attribute__((packed))
+	{
+		unsigned char Version; //!< The records layout version.
+		unsigned short Sequence_Number; //!< Incremented for each new record, the most recent record has the highest number.
+		TSettings Settings; //!< The saved settings.
+		unsigned char Reserved[SETTINGS_RECORD_SIZE - 5 - sizeof(TSettings)]; //!< Keep room for future settings (the array size becomes negative and the build fails if the settings do not fit anymore).
+		unsigned short CRC; //!< All previous bytes CRC.
+	} Fields;
+	unsigned char Bytes[SETTINGS_RECORD_SIZE]; //!< Access the record bytes to read and write the EEPROM.
+} TSettingsRecord;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The current settings. */
+static TSettings Settings_Current;
+/** Tell whether the current settings must be saved. */
+static unsigned char Settings_Is_Modified = 0;
+
+/** The last written record, it is kept unchanged while the EEPROM writes it in background. */
+static TSettingsRecord Settings_Record;
+/** The last written record index in the journal. */
+static unsigned char Settings_Record_Index;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Compute a record CRC.
+ * @param Pointer_Record The record to compute the CRC of (the CRC field is not included in the computation).
+ * @return The CRC value.
+ */
+static unsigned short SettingsComputeRecordCRC(TSettingsRecord *Pointer_Record)
+{
+	unsigned short CRC = 0xFFFF;
+	unsigned char i, j;
+	
+	for (i = 0; i < SETTINGS_RECORD_SIZE - sizeof(Pointer_Record->Fields.CRC); i++)
+	{
+		CRC ^= Pointer_Record->Bytes[i] << 8;
+		for (j = 0; j < 8; j++)
+		{
+			if (CRC & 0x8000) CRC = (CRC << 1) ^ SETTINGS_CRC_POLYNOMIAL;
+			else CRC <<= 1;
+		}
+	}
+	return CRC;
+}
+
+/** Read a journal record.
+ * @param Index The record index.
+ * @param Pointer_Record On output, contain the record.
+ * @return 0 if the record is not valid (never written, interrupted by a power loss or having another version),
+ * @return 1 if the record is valid.
+ */
+static unsigned char SettingsReadRecord(unsigned char Index, TSettingsRecord *Pointer_Record)
+{
+	unsigned short Address;
+	unsigned char i;
+	
+	Address = Index * SETTINGS_RECORD_SIZE;
+	for (i = 0; i < SETTINGS_RECORD_SIZE; i++) Pointer_Record->Bytes[i] = EEPROMReadByte(Address + i);
+	
+	if (Pointer_Record->Fields.Version != SETTINGS_RECORD_VERSION) return 0;
+	if (Pointer_Record->Fields.CRC != SettingsComputeRecordCRC(Pointer_Record)) return 0;
+	return 1;
+}
+
+/** Tell whether a record that is not valid has never been written.
+ * @param Index The record index.
+ * @param Pointer_Record The record content.
+ * @return 0 if at least a record byte has been written,
+ * @return 1 if all record bytes are erased (the bytes of the older firmwares layout are not checked).
+ */
+static unsigned char SettingsIsRecordErased(unsigned char Index, TSettingsRecord *Pointer_Record)
+{
+	unsigned char i;
+	
+	for (i = 0; i < SETTINGS_RECORD_SIZE; i++)
+	{
+		if ((Index == 0) && (i < SETTINGS_LEGACY_LAYOUT_SIZE)) continue;
+		if (Pointer_Record->Bytes[i] != 0xFF) return 0;
+	}
+	return 1;
+}
+
+/** Set the default settings, retrieving the heating curve from the EEPROM layout used by older firmwares if it is present.
+ * @param Is_Journal_Erased Set to 1 if no journal record has ever been written. The older firmwares layout is read only in this case, because the journal records overwrite it.
+ */
+static void SettingsLoadDefaults(unsigned char Is_Journal_Erased)
+{
+	unsigned short Coefficient, Parallel_Shift;
+	
+	Coefficient = (EEPROMReadByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_HIGH_BYTE) << 8) | EEPROMReadByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_LOW_BYTE);
+	Parallel_Shift = (EEPROMReadByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_HIGH_BYTE) << 8) | EEPROMReadByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_LOW_BYTE);
+	if (Is_Journal_Erased && (Coefficient != 0xFFFF) && (Parallel_Shift != 0xFFFF))
+	{
+		Settings_Current.Heating_Curve_Coefficient = Coefficient;
+		Settings_Current.Heating_Curve_Parallel_Shift = Parallel_Shift;
+		Settings_Is_Modified = 1; // Move the settings to the journal
+	}
+	else
+	{
+		Settings_Current.Heating_Curve_Coefficient = CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT;
+		Settings_Current.Heating_Curve_Parallel_Shift = CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_PARALLEL_SHIFT;
+	}
+	
+	Settings_Current.Desired_Day_Room_Temperature = CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE;
+	Settings_Current.Desired_Night_Room_Temperature = CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE;
+	Settings_Current.Is_Boiler_Running = 1; // Automatically enable the boiler on first power on
+	Settings_Current.Is_Night_Mode_Enabled = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void SettingsInitialize(void)
+{
+	TSettingsRecord Record;
+	unsigned char i, Is_Record_Found = 0, Is_Journal_Erased = 1;
+	
+	// Find the most recent valid record
+	for (i = 0; i < SETTINGS_RECORDS_COUNT; i++)
+	{
+		if (!SettingsReadRecord(i, &Record))
+		{
+			// A corrupted record or a record written by another firmware version tells that the first record bytes do not hold the older firmwares layout
+			if (!SettingsIsRecordErased(i, &Record)) Is_Journal_Erased = 0;
+			continue;
+		}
+		
+		if (!Is_Record_Found || ((signed short) (Record.Fields.Sequence_Number - Settings_Record.Fields.Sequence_Number) > 0)) // The difference is right even when the sequence number wraps around, because records are at most SETTINGS_RECORDS_COUNT numbers apart
+		{
+			Settings_Record = Record;
+			Settings_Record_Index = i;
+			Is_Record_Found = 1;
+		}
+	}
+	
+	if (Is_Record_Found) Settings_Current = Settings_Record.Fields.Settings;
+	else
+	{
+		// Start the journal with the second record, so the older firmwares layout stays readable until a record is complete
+		Settings_Record.Fields.Sequence_Number = 0;
+		Settings_Record_Index = 0;
+		SettingsLoadDefaults(Is_Journal_Erased);
+	}
+}
+
+const TSettings *SettingsGet(void)
+{
+	return &Settings_Current;
+}
+
+void SettingsSet(const TSettings *Pointer_Settings)
+{
+	// Do not write the EEPROM if nothing changed
+	if ((Pointer_Settings->Heating_Curve_Coefficient == Settings_Current.Heating_Curve_Coefficient) && (Pointer_Settings->Heating_Curve_Parallel_Shift == Settings_Current.Heating_Curve_Parallel_Shift)
+		&& (Pointer_Settings->Desired_Day_Room_Temperature == Settings_Current.Desired_Day_Room_Temperature) && (Pointer_Settings->Desired_Night_Room_Temperature == Settings_Current.Desired_Night_Room_Temperature)
+		&& (Pointer_Settings->Is_Boiler_Running == Settings_Current.Is_Boiler_Running) && (Pointer_Settings->Is_Night_Mode_Enabled == Settings_Current.Is_Night_Mode_Enabled)) return;
+	
+	Settings_Current = *Pointer_Settings;
+	Settings_Is_Modified = 1;
+}
+
+void SettingsTask(void)
+{
+	unsigned char i;
+	
+	if (!Settings_Is_Modified) return;
+	
+	// Wait for the previous record to be fully written, its buffer is still in use
+	if (EEPROMIsWriting()) return;
+	
+	// Append a new record after the previous one, so the previous record stays valid until the new one is complete
+	Settings_Record_Index++;
+	if (Settings_Record_Index >= SETTINGS_RECORDS_COUNT) Settings_Record_Index = 0;
+	
+	Settings_Record.Fields.Version = SETTINGS_RECORD_VERSION;
+	Settings_Record.Fields.Sequence_Number++;
+	Settings_Record.Fields.Settings = Settings_Current;
+	for (i = 0; i < sizeof(Settings_Record.Fields.Reserved); i++) Settings_Record.Fields.Reserved[i] = 0xFF; // Keep the erased EEPROM value, so these bytes are never written
+	Settings_Record.Fields.CRC = SettingsComputeRecordCRC(&Settings_Record);
+	
+	EEPROMStartWriting(Settings_Record_Index * SETTINGS_RECORD_SIZE, Settings_Record.Bytes, SETTINGS_RECORD_SIZE);
+	Settings_Is_Modified = 0;
+}
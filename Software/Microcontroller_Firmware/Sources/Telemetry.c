@@ -0,0 +1,203 @@
+/** @file Telemetry.c
+ * @see Telemetry.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Configuration.h>
+#include <Mixing_Valve.h>
+#include <Relay.h>
+#include <Telemetry.h>
+#include <Temperature.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many bytes of records a block can hold. */
+#define TELEMETRY_BLOCK_RECORDS_SIZE 13
+
+// A record starts with a header byte holding the record type in bits 6 and 7 and the flags in bits 0 to 5, the following bytes depend on the record type
+/** All temperatures are the same than in the previous record, no other byte follows. */
+#define TELEMETRY_RECORD_TYPE_UNCHANGED 0x00
+/** The radiator start water temperature difference follows as a signed byte, then the outside (high nibble) and the target start water (low nibble) temperature differences follow as signed nibbles. */
+#define TELEMETRY_RECORD_TYPE_DELTAS 0x80
+/** The outside, radiator start water and target start water temperatures follow as signed bytes. Each block first record has this type. */
+#define TELEMETRY_RECORD_TYPE_ABSOLUTE 0xC0
+
+/** The gas burner relay flag. */
+#define TELEMETRY_RECORD_FLAG_GAS_BURNER_ON 0x01
+/** The pump relay flag. */
+#define TELEMETRY_RECORD_FLAG_PUMP_ON 0x02
+/** The mixing valve left relay flag. */
+#define TELEMETRY_RECORD_FLAG_MIXING_VALVE_LEFT_RELAY_ON 0x04
+/** The mixing valve right relay flag. */
+#define TELEMETRY_RECORD_FLAG_MIXING_VALVE_RIGHT_RELAY_ON 0x08
+/** The mixing valve position (a TMixingValvePosition value) is stored in bits 4 and 5. */
+#define TELEMETRY_RECORD_FLAGS_MIXING_VALVE_POSITION_SHIFT 4
+
+#if (CONFIGURATION_TELEMETRY_BLOCKS_COUNT & (CONFIGURATION_TELEMETRY_BLOCKS_COUNT - 1)) != 0
+	#error "CONFIGURATION_TELEMETRY_BLOCKS_COUNT must be a power of two."
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A ring block. */
+typedef struct
+{
+	unsigned short First_Sample_Number; //!< The number of the sample stored by the first record.
+	unsigned char Samples_Count; //!< How many records are stored.
+	unsigned char Records[TELEMETRY_BLOCK_RECORDS_SIZE]; //!< The records.
+} TTelemetryBlock;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The ring. */
+static TTelemetryBlock Telemetry_Blocks[CONFIGURATION_TELEMETRY_BLOCKS_COUNT];
+/** The block being filled. */
+static unsigned char Telemetry_Newest_Block_Index;
+/** How many blocks are stored. */
+static unsigned char Telemetry_Blocks_Count = 0;
+/** How many bytes of the block being filled are used. */
+static unsigned char Telemetry_Newest_Block_Used_Size;
+
+/** The number the next sample will get. */
+static unsigned short Telemetry_Next_Sample_Number = 0;
+/** How many seconds elapsed since the last sample. */
+static unsigned char Telemetry_Elapsed_Seconds = 0;
+
+/** The last recorded outside temperature. */
+static signed char Telemetry_Previous_Outside_Temperature;
+/** The last recorded radiator start water temperature. */
+static signed char Telemetry_Previous_Radiator_Start_Water_Temperature;
+/** The last recorded target start water temperature. */
+static signed char Telemetry_Previous_Target_Start_Water_Temperature;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Append the current board state to the ring. */
+static void TelemetryRecordSample(void)
+{
+	signed char Outside_Temperature, Radiator_Start_Water_Temperature, Target_Start_Water_Temperature;
+	signed short Outside_Temperature_Difference, Radiator_Start_Water_Temperature_Difference, Target_Start_Water_Temperature_Difference;
+	unsigned char Header, Record_Size, *Pointer_Record;
+	TTelemetryBlock *Pointer_Block;
+	
+	// Gather the values to record
+	Outside_Temperature = TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_OUTSIDE);
+	Radiator_Start_Water_Temperature = TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_RADIATOR_START);
+	Target_Start_Water_Temperature = TemperatureGetTargetStartWaterTemperature();
+	Header = MixingValveGetPosition() << TELEMETRY_RECORD_FLAGS_MIXING_VALVE_POSITION_SHIFT;
+	if (RelayIsTurnedOn(RELAY_ID_GAS_BURNER)) Header |= TELEMETRY_RECORD_FLAG_GAS_BURNER_ON;
+	if (RelayIsTurnedOn(RELAY_ID_PUMP)) Header |= TELEMETRY_RECORD_FLAG_PUMP_ON;
+	if (RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_LEFT)) Header |= TELEMETRY_RECORD_FLAG_MIXING_VALVE_LEFT_RELAY_ON;
+	if (RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_RIGHT)) Header |= TELEMETRY_RECORD_FLAG_MIXING_VALVE_RIGHT_RELAY_ON;
+	
+	// Use the smallest record able to hold the temperatures
+	Outside_Temperature_Difference = Outside_Temperature - Telemetry_Previous_Outside_Temperature;
+	Radiator_Start_Water_Temperature_Difference = Radiator_Start_Water_Temperature - Telemetry_Previous_Radiator_Start_Water_Temperature;
+	Target_Start_Water_Temperature_Difference = Target_Start_Water_Temperature - Telemetry_Previous_Target_Start_Water_Temperature;
+	if ((Outside_Temperature_Difference == 0) && (Radiator_Start_Water_Temperature_Difference == 0) && (Target_Start_Water_Temperature_Difference == 0)) Record_Size = 1;
+	else if ((Radiator_Start_Water_Temperature_Difference >= -128) && (Radiator_Start_Water_Temperature_Difference <= 127) && (Outside_Temperature_Difference >= -8) && (Outside_Temperature_Difference <= 7)
+		&& (Target_Start_Water_Temperature_Difference >= -8) && (Target_Start_Water_Temperature_Difference <= 7)) Record_Size = 3;
+	else Record_Size = 4;
+	
+	// Start a new block when the current one is full, overwriting the oldest block if the ring is full
+	if ((Telemetry_Blocks_Count == 0) || (Telemetry_Newest_Block_Used_Size + Record_Size > TELEMETRY_BLOCK_RECORDS_SIZE))
+	{
+		if (Telemetry_Blocks_Count == 0) Telemetry_Newest_Block_Index = 0;
+		else Telemetry_Newest_Block_Index = (Telemetry_Newest_Block_Index + 1) & (CONFIGURATION_TELEMETRY_BLOCKS_COUNT - 1);
+		if (Telemetry_Blocks_Count < CONFIGURATION_TELEMETRY_BLOCKS_COUNT) Telemetry_Blocks_Count++;
+		
+		Pointer_Block = &Telemetry_Blocks[Telemetry_Newest_Block_Index];
+		Pointer_Block->First_Sample_Number = Telemetry_Next_Sample_Number;
+		Pointer_Block->Samples_Count = 0;
+		Telemetry_Newest_Block_Used_Size = 0;
+		Record_Size = 4; // A block must be decodable on its own
+	}
+	else Pointer_Block = &Telemetry_Blocks[Telemetry_Newest_Block_Index];
+	
+	// Append the record
+	Pointer_Record = &Pointer_Block->Records[Telemetry_Newest_Block_Used_Size];
+	switch (Record_Size)
+	{
+		case 1:
+			Pointer_Record[0] = Header | TELEMETRY_RECORD_TYPE_UNCHANGED;
+			break;
+			
+		case 3:
+			Pointer_Record[0] = Header | TELEMETRY_RECORD_TYPE_DELTAS;
+			Pointer_Record[1] = (unsigned char) Radiator_Start_Water_Temperature_Difference;
+			Pointer_Record[2] = (Outside_Temperature_Difference << 4) | (Target_Start_Water_Temperature_Difference & 0x0F);
+			break;
+			
+		default:
+			Pointer_Record[0] = Header | TELEMETRY_RECORD_TYPE_ABSOLUTE;
+			Pointer_Record[1] = Outside_Temperature;
+			Pointer_Record[2] = Radiator_Start_Water_Temperature;
+			Pointer_Record[3] = Target_Start_Water_Temperature;
+			break;
+	}
+	Telemetry_Newest_Block_Used_Size += Record_Size;
+	Pointer_Block->Samples_Count++;
+	Telemetry_Next_Sample_Number++;
+	
+	// Next record is relative to this one
+	Telemetry_Previous_Outside_Temperature = Outside_Temperature;
+	Telemetry_Previous_Radiator_Start_Water_Temperature = Radiator_Start_Water_Temperature;
+	Telemetry_Previous_Target_Start_Water_Temperature = Target_Start_Water_Temperature;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void TelemetryTask(void)
+{
+	// Take the first sample as soon as the board boots
+	if (Telemetry_Blocks_Count > 0)
+	{
+		Telemetry_Elapsed_Seconds++;
+		if (Telemetry_Elapsed_Seconds < CONFIGURATION_TELEMETRY_SAMPLING_PERIOD) return;
+	}
+	
+	TelemetryRecordSample();
+	Telemetry_Elapsed_Seconds = 0;
+}
+
+void TelemetryReadBlock(unsigned short Sample_Number, unsigned char *Pointer_Buffer)
+{
+	TTelemetryBlock *Pointer_Block = 0;
+	unsigned char i, Index;
+	
+	// Tell when the samples were taken
+	Pointer_Buffer[0] = (unsigned char) Telemetry_Next_Sample_Number;
+	Pointer_Buffer[1] = Telemetry_Next_Sample_Number >> 8;
+	Pointer_Buffer[2] = Telemetry_Elapsed_Seconds;
+	Pointer_Buffer[3] = CONFIGURATION_TELEMETRY_SAMPLING_PERIOD;
+	
+	// Find the first block ending after the requested sample, from the oldest one
+	Index = (Telemetry_Newest_Block_Index - Telemetry_Blocks_Count + 1) & (CONFIGURATION_TELEMETRY_BLOCKS_COUNT - 1);
+	for (i = 0; i < Telemetry_Blocks_Count; i++)
+	{
+		if ((signed short) (Sample_Number - (unsigned short) (Telemetry_Blocks[Index].First_Sample_Number + Telemetry_Blocks[Index].Samples_Count)) < 0) // The difference is right even when the sample number wraps around
+		{
+			Pointer_Block = &Telemetry_Blocks[Index];
+			break;
+		}
+		Index = (Index + 1) & (CONFIGURATION_TELEMETRY_BLOCKS_COUNT - 1);
+	}
+	
+	// The sample has not been taken yet
+	if (Pointer_Block == 0)
+	{
+		Pointer_Buffer[4] = (unsigned char) Sample_Number;
+		Pointer_Buffer[5] = Sample_Number >> 8;
+		Pointer_Buffer[6] = 0;
+		return;
+	}
+	
+	Pointer_Buffer[4] = (unsigned char) Pointer_Block->First_Sample_Number;
+	Pointer_Buffer[5] = Pointer_Block->First_Sample_Number >> 8;
+	Pointer_Buffer[6] = Pointer_Block->Samples_Count;
+	for (i = 0; i < TELEMETRY_BLOCK_RECORDS_SIZE; i++) Pointer_Buffer[7 + i] = Pointer_Block->Records[i];
+}
@@ -3,62 +3,79 @@
  * @author Adrien RICCIARDI
  */
 #include <ADC.h>
+#include <avr/pgmspace.h>
 #include <Configuration.h>
-#include <EEPROM.h>
 #include <Protocol.h>
+#include <Settings.h>
 #include <Temperature.h>
+#include <Temperature_Tables.h>
 
 //-------------------------------------------------------------------------------------------------
 // Private variables
 //-------------------------------------------------------------------------------------------------
-/** The current desired temperature (in °C), this value is used only when night mode is disabled. */
-static signed char Temperature_Desired_Day_Room_Temperature = 0;
-/** The current desired temperature (in °C), this value is used only when night mode is enabled. */
-static signed char Temperature_Desired_Night_Room_Temperature = 0;
+/** The day trimmer offset (in °C) from the trimmers reference temperature, as selected when the trimmer was last moved. */
+static signed char Temperature_Day_Trimmer_Offset;
+/** The night trimmer offset (in °C) from the day temperature, as selected when the trimmer was last moved. */
+static signed char Temperature_Night_Trimmer_Offset;
 
 /** The start water temperature to reach (in °C). */
 static signed char Temperature_Target_Start_Water_Temperature = 0;
 
-/** Heating curve coefficient (multiplied by ten to make more precise computations). */
-static unsigned short Temperature_Heating_Curve_Coefficient;
-/** Heating curve parallel shift (also multiplied by ten to improve results precision). */
-static unsigned short Temperature_Heating_Curve_Parallel_Shift;
-
 //-------------------------------------------------------------------------------------------------
 // Private functions
 //-------------------------------------------------------------------------------------------------
-/** Get day trimmer selected temperature.
- * @return The absolute temperature (in °C) indicated by the day trimmer.
+/** Convert a channel last sampled value using a conversion table. The additional bits provided by oversampling are used to interpolate between two table values.
+ * @param Pointer_Table The conversion table, located in flash memory.
+ * @param Channel_ID The channel to convert.
+ * @return The temperature in tenths of °C.
  */
-static inline signed char TemperatureGetDayTrimmerTemperature(void)
+static signed short TemperatureConvertSampledValue(const signed short *Pointer_Table, TADCChannelID Channel_ID)
 {
-	signed long Temperature;
+	unsigned short Value, Index;
+	unsigned char Fraction;
+	signed short Temperature, Next_Temperature;
 	
-	Temperature = ADCGetLastSampledValue(ADC_CHANNEL_ID_DAY_TRIMMER);
+	Value = ADCGetLastOversampledValue(Channel_ID);
+	Index = Value >> CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS;
+	Fraction = Value & ((1 << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS) - 1);
 	
-	// Use a straight line representation to determine the Celsius temperature
-	// Datasheet tells that temperature is -4°C when trimmer resistance is 60ohm => measured voltage is 900mV => ADC value is 279
-	// We need a second point to determine the line equation : temperature is +4 when trimmer resistance is 100ohm => measured voltage is 1.269V => ADC value is 393
-	// Straight line equation is Celsius_Temperature = 0.070 * ADC_Value - 23.579, use x1000 fixed arithmetic to keep some precision
-	Temperature = ((70L * Temperature) - 23579L) / 1000;
-	return (signed char) (Temperature + CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE);
+	Temperature = (signed short) pgm_read_word(&Pointer_Table[Index]);
+	if (Fraction != 0) // The highest ADC value has no fractional part, so the next table value always exists here
+	{
+		Next_Temperature = (signed short) pgm_read_word(&Pointer_Table[Index + 1]);
+		Temperature += ((Next_Temperature - Temperature) * Fraction) / (1 << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS);
+	}
+	return Temperature;
+}
+
+/** Round a temperature to the nearest Celsius degree.
+ * @param Temperature The temperature in tenths of °C.
+ * @return The temperature in °C.
+ */
+static signed char TemperatureRoundToDegrees(signed short Temperature)
+{
+	if (Temperature >= 0) return (signed char) ((Temperature + 5) / 10);
+	return (signed char) ((Temperature - 5) / 10);
 }
 
-/** Get night trimmer selected temperature.
- * @return The absolute temperature (in °C) indicated by the night trimmer.
+/** Select a new trimmer offset if the trimmer has been moved far enough from the current one.
+ * @param Pointer_Table The trimmer conversion table, located in flash memory.
+ * @param Channel_ID The trimmer channel.
+ * @param Pointer_Offset On input, contain the current offset (in °C). On output, contain the new offset.
+ * @return 0 if the offset did not change,
+ * @return 1 if a new offset has been selected.
  */
-static inline signed char TemperatureGetNightTrimmerTemperature(void)
+static unsigned char TemperatureUpdateTrimmerOffset(const signed short *Pointer_Table, TADCChannelID Channel_ID, signed char *Pointer_Offset)
 {
-	signed long Temperature;
+	signed short Offset, Difference;
 	
-	Temperature = ADCGetLastSampledValue(ADC_CHANNEL_ID_NIGHT_TRIMMER);
+	// The current degree is kept until the trimmer goes past the middle of two degrees by the hysteresis
+	Offset = TemperatureConvertSampledValue(Pointer_Table, Channel_ID);
+	Difference = Offset - *Pointer_Offset * 10;
+	if ((Difference >= -(5 + CONFIGURATION_TRIMMERS_HYSTERESIS)) && (Difference <= 5 + CONFIGURATION_TRIMMERS_HYSTERESIS)) return 0;
 	
-	// Use a straight line representation to determine the Celsius temperature
-	// Datasheet tells that temperature is 0°C when trimmer resistance is 5ohm => measured voltage is 100mV => ADC value is 31
-	// We need a second point to determine the line equation : temperature is +8 when trimmer resistance is 50ohm => measured voltage is 786mV => ADC value is 244
-	// Straight line equation is Celsius_Temperature = 0.038 * ADC_Value - 1.164, use x1000 fixed arithmetic to keep some precision
-	Temperature = ((38L * Temperature) - 1164L) / 1000;
-	return (signed char) (TemperatureGetDayTrimmerTemperature() - Temperature);
+	*Pointer_Offset = TemperatureRoundToDegrees(Offset);
+	return 1;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -66,80 +83,59 @@ static inline signed char TemperatureGetNightTrimmerTemperature(void)
 //-------------------------------------------------------------------------------------------------
 void TemperatureInitialize(void)
 {
-	// Load heating curve coefficient
-	Temperature_Heating_Curve_Coefficient = EEPROMReadByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_HIGH_BYTE) << 8;
-	Temperature_Heating_Curve_Coefficient |= EEPROMReadByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_LOW_BYTE);
-	
-	// Load heating curve parallel shift
-	Temperature_Heating_Curve_Parallel_Shift = EEPROMReadByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_HIGH_BYTE) << 8;
-	Temperature_Heating_Curve_Parallel_Shift |= EEPROMReadByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_LOW_BYTE);
+	// The saved desired temperatures are kept until a trimmer is moved
+	Temperature_Day_Trimmer_Offset = TemperatureRoundToDegrees(TemperatureConvertSampledValue(Temperature_Tables_Day_Trimmer, ADC_CHANNEL_ID_DAY_TRIMMER));
+	Temperature_Night_Trimmer_Offset = TemperatureRoundToDegrees(TemperatureConvertSampledValue(Temperature_Tables_Night_Trimmer, ADC_CHANNEL_ID_NIGHT_TRIMMER));
 }
 
 signed char TemperatureGetSensorValue(TTemperatureSensorID Temperature_ID)
 {
-	signed long Temperature;
-	
 	switch (Temperature_ID)
 	{
 		case TEMPERATURE_SENSOR_ID_OUTSIDE:
-			Temperature = ADCGetLastSampledValue(ADC_CHANNEL_ID_OUTSIDE_THERMISTOR);
-			// Use a straight line representation to determine the Celsius temperature
-			// Datasheet tells that temperature is -10°C when thermistor resistance is 480ohm => measured voltage is 1.667V => ADC value is 516
-			// We need a second point to determine the line equation : temperature is 20 when thermistor resistance is 400ohm => measured voltage is 1.517 => ADC value is 470
-			// Straight line equation is Celsius_Temperature = -0.652 * ADC_Value + 326.440, use x1000 fixed arithmetic to keep some precision
-			Temperature = ((-652L * Temperature) + 326440L) / 1000;
-			break;
+			return TemperatureRoundToDegrees(TemperatureConvertSampledValue(Temperature_Tables_Outside_Thermistor, ADC_CHANNEL_ID_OUTSIDE_THERMISTOR));
 			
 		case TEMPERATURE_SENSOR_ID_RADIATOR_START:
-			Temperature = ADCGetLastSampledValue(ADC_CHANNEL_ID_RADIATOR_START_THERMISTOR);
-			// Use a straight line representation to determine the Celsius temperature
-			// Datasheet tells that temperature is 20°C when thermistor resistance is 770ohm => measured voltage is 1.436V => ADC value is 445
-			// We need a second point to determine the line equation : temperature is 80 when thermistor resistance is 580ohm => measured voltage is 1.211V => ADC value is 375
-			// Straight line equation is Celsius_Temperature = -0.857 * ADC_Value + 401.375, use x1000 fixed arithmetic to keep some precision
-			Temperature = ((-857L * Temperature) + 401375L) / 1000;
-			break;
+			return TemperatureRoundToDegrees(TemperatureConvertSampledValue(Temperature_Tables_Radiator_Start_Thermistor, ADC_CHANNEL_ID_RADIATOR_START_THERMISTOR));
 			
 		case TEMPERATURE_SENSOR_ID_RADIATOR_RETURN:
 			// TODO when sensor will be chosen
-			Temperature = -100;
-			break;
+			return -100;
 			
 		default:
 			return -100;
 	}
-	
-	return (signed char) Temperature;
 }
 
 void TemperatureGetDesiredRoomTemperatures(signed char *Pointer_Day_Temperature, signed char *Pointer_Night_Temperature)
 {
-	static signed char Previous_Day_Trimmer_Temperature = 0, Previous_Night_Trimmer_Temperature = 0;
-	signed char Current_Trimmer_Temperature;
+	TSettings Settings;
+	unsigned char Is_Day_Trimmer_Moved, Is_Night_Trimmer_Moved;
 	
-	// Change desired day temperature if the day trimmer has been changed
-	Current_Trimmer_Temperature = TemperatureGetDayTrimmerTemperature();
-	if (Current_Trimmer_Temperature != Previous_Day_Trimmer_Temperature)
-	{
-		Temperature_Desired_Day_Room_Temperature = Current_Trimmer_Temperature;
-		Previous_Day_Trimmer_Temperature = Current_Trimmer_Temperature; // Keep new trimmer temperature to be able to determine next trimmer value change
-	}
+	Settings = *SettingsGet();
+	Is_Day_Trimmer_Moved = TemperatureUpdateTrimmerOffset(Temperature_Tables_Day_Trimmer, ADC_CHANNEL_ID_DAY_TRIMMER, &Temperature_Day_Trimmer_Offset);
+	Is_Night_Trimmer_Moved = TemperatureUpdateTrimmerOffset(Temperature_Tables_Night_Trimmer, ADC_CHANNEL_ID_NIGHT_TRIMMER, &Temperature_Night_Trimmer_Offset);
 	
-	// Change desired night temperature if the night trimmer has been changed
-	Current_Trimmer_Temperature = TemperatureGetNightTrimmerTemperature();
-	if (Current_Trimmer_Temperature != Previous_Night_Trimmer_Temperature)
-	{
-		Temperature_Desired_Night_Room_Temperature = Current_Trimmer_Temperature;
-		Previous_Night_Trimmer_Temperature = Current_Trimmer_Temperature; // Keep new trimmer temperature to be able to determine next trimmer value change
-	}
+	// Change desired day temperature if the day trimmer has been moved
+	if (Is_Day_Trimmer_Moved) Settings.Desired_Day_Room_Temperature = CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE + Temperature_Day_Trimmer_Offset;
 	
-	*Pointer_Day_Temperature = Temperature_Desired_Day_Room_Temperature;
-	*Pointer_Night_Temperature = Temperature_Desired_Night_Room_Temperature;
+	// The night temperature is relative to the day trimmer, so it changes when any trimmer has been moved
+	if (Is_Day_Trimmer_Moved || Is_Night_Trimmer_Moved) Settings.Desired_Night_Room_Temperature = CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE + Temperature_Day_Trimmer_Offset - Temperature_Night_Trimmer_Offset;
+	
+	SettingsSet(&Settings); // Nothing is saved if no trimmer has been moved
+	
+	*Pointer_Day_Temperature = Settings.Desired_Day_Room_Temperature;
+	*Pointer_Night_Temperature = Settings.Desired_Night_Room_Temperature;
 }
 
 void TemperatureSetDesiredRoomTemperatures(signed char Day_Temperature, signed char Night_Temperature)
 {
-	Temperature_Desired_Day_Room_Temperature = Day_Temperature;
-	Temperature_Desired_Night_Room_Temperature = Night_Temperature;
+	TSettings Settings;
+	
+	Settings = *SettingsGet();
+	Settings.Desired_Day_Room_Temperature = Day_Temperature;
+	Settings.Desired_Night_Room_Temperature = Night_Temperature;
+	SettingsSet(&Settings);
 }
 
 signed char TemperatureGetTargetStartWaterTemperature(void)
@@ -150,46 +146,45 @@ signed char TemperatureGetTargetStartWaterTemperature(void)
 // Values can only be set by a protocol command, and this function is used exclusively by another protocol command, so there is no need to use a mutex
 void TemperatureGetHeatingCurveParameters(unsigned short *Pointer_Coefficient, unsigned short *Pointer_Parallel_Shift)
 {
-	*Pointer_Coefficient = Temperature_Heating_Curve_Coefficient;
-	*Pointer_Parallel_Shift = Temperature_Heating_Curve_Parallel_Shift;
+	const TSettings *Pointer_Settings;
+	
+	Pointer_Settings = SettingsGet();
+	*Pointer_Coefficient = Pointer_Settings->Heating_Curve_Coefficient;
+	*Pointer_Parallel_Shift = Pointer_Settings->Heating_Curve_Parallel_Shift;
 }
 
-// No need for mutex because this function is called exclusively by a protocol command (so this function call interrupts everything else), and all accesses to heating curve variables from main task are secured
+// No need for mutex because this function is called exclusively by a protocol command, which is executed by the main loop like the temperature task
 void TemperatureSetHeatingCurveParameters(unsigned short Coefficient, unsigned short Parallel_Shift)
 {
-	// Store coefficient to EEPROM
-	EEPROMWriteByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_HIGH_BYTE, Coefficient >> 8);
-	EEPROMWriteByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_LOW_BYTE, (unsigned char) Coefficient);
-	
-	// Store parallel shift to EEPROM
-	EEPROMWriteByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_HIGH_BYTE, Parallel_Shift >> 8);
-	EEPROMWriteByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_LOW_BYTE, (unsigned char) Parallel_Shift);
+	TSettings Settings;
 	
-	// Update variables
-	Temperature_Heating_Curve_Coefficient = Coefficient;
-	Temperature_Heating_Curve_Parallel_Shift = Parallel_Shift;
+	// The settings module saves the new values to the EEPROM in background
+	Settings = *SettingsGet();
+	Settings.Heating_Curve_Coefficient = Coefficient;
+	Settings.Heating_Curve_Parallel_Shift = Parallel_Shift;
+	SettingsSet(&Settings);
 }
 
 void TemperatureTask(void)
 {
-	signed char Outside_Temperature, Desired_Room_Temperature, Target_Start_Water_Temperature, Day_Temperature, Night_Temperature;
+	signed char Desired_Room_Temperature, Day_Temperature, Night_Temperature;
+	signed short Outside_Temperature;
+	signed long Target_Start_Water_Temperature; // A steep heating curve can give a value that does not fit in a byte before it is clamped
 	signed long Heating_Curve_Coefficient, Heating_Curve_Parallel_Shift; // Promote unsigned short values to long to force the heating curve computation to be done on long variables
 	
-	// Use some more variables to make the heating curve computation easier to understand
-	Outside_Temperature = TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_OUTSIDE);
+	// Use some more variables to make the heating curve computation easier to understand, keep the outside temperature tenths to get a more precise result
+	Outside_Temperature = TemperatureConvertSampledValue(Temperature_Tables_Outside_Thermistor, ADC_CHANNEL_ID_OUTSIDE_THERMISTOR);
 	// Determine the desired room temperature according to current mode
 	TemperatureGetDesiredRoomTemperatures(&Day_Temperature, &Night_Temperature);
 	if (ProtocolIsNightModeEnabled()) Desired_Room_Temperature = Night_Temperature;
 	else Desired_Room_Temperature = Day_Temperature;
 	
-	// Atomically retrieve values that can be set by Protocol module
-	PROTOCOL_DISABLE_INTERRUPTS();
-	Heating_Curve_Coefficient = Temperature_Heating_Curve_Coefficient;
-	Heating_Curve_Parallel_Shift = Temperature_Heating_Curve_Parallel_Shift;
-	PROTOCOL_ENABLE_INTERRUPTS();
+	// Values set by the Protocol module can be directly accessed because protocol commands are executed by the main loop too
+	Heating_Curve_Coefficient = SettingsGet()->Heating_Curve_Coefficient;
+	Heating_Curve_Parallel_Shift = SettingsGet()->Heating_Curve_Parallel_Shift;
 	
 	// Compute target start water temperature
-	Target_Start_Water_Temperature = (Heating_Curve_Coefficient * (Desired_Room_Temperature - Outside_Temperature) + Heating_Curve_Parallel_Shift) / 10L;
+	Target_Start_Water_Temperature = (Heating_Curve_Coefficient * (Desired_Room_Temperature * 10L - Outside_Temperature) + Heating_Curve_Parallel_Shift * 10L) / 100L; // Temperatures are in tenths of °C and heating curve parameters are multiplied by ten
 	
 	// Make sure output value is in the allowed water temperature range
 	if (Target_Start_Water_Temperature < CONFIGURATION_HEATING_CURVE_MINIMUM_TEMPERATURE) Target_Start_Water_Temperature = CONFIGURATION_HEATING_CURVE_MINIMUM_TEMPERATURE;
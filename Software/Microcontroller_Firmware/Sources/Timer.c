@@ -0,0 +1,95 @@
+/** @file Timer.c
+ * @see Timer.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <Configuration.h>
+#include <Timer.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The timer clock frequency. */
+#define TIMER_CLOCK_FREQUENCY (F_CPU / TIMER_PRESCALER)
+/** The compare value making the counter reset every tick (the counter matches 0 too, so one is subtracted). */
+#define TIMER_COMPARE_VALUE ((TIMER_CLOCK_FREQUENCY * CONFIGURATION_SCHEDULER_TICK_PERIOD / 1000) - 1)
+
+/** TCCR1B clock select bits matching the prescaler. */
+#if TIMER_PRESCALER == 8
+	#define TIMER_CLOCK_SELECT 0x02
+#else
+	#define TIMER_CLOCK_SELECT 0x04
+#endif
+
+// The 3686400Hz crystal divided by 256 gives 14400Hz (and 460800Hz when divided by 8), so a tick period multiple of 5ms is exact
+#if (TIMER_CLOCK_FREQUENCY * CONFIGURATION_SCHEDULER_TICK_PERIOD) % 1000 != 0
+	#error "CONFIGURATION_SCHEDULER_TICK_PERIOD can't be exactly generated from the CPU clock, timing would drift."
+#endif
+#if TIMER_COMPARE_VALUE > 65535
+	#error "CONFIGURATION_SCHEDULER_TICK_PERIOD is too long for the 16-bit timer."
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The elapsed ticks count. */
+static volatile unsigned short Timer_Ticks_Count = 0;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Count a tick. */
+ISR(TIMER1_COMPA_vect)
+{
+	Timer_Ticks_Count++;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void TimerInitialize(void)
+{
+	// Configure Timer 1 in CTC mode, the counter is reset by hardware on compare match, so interrupts latency does not accumulate
+	TCCR1A = 0; // Disconnect OC1A and OC1B pins
+	TCNT1 = 0;
+	OCR1A = TIMER_COMPARE_VALUE;
+	TIFR1 = 0x02; // Clear a pending compare match, if any
+	TIMSK1 = 0x02; // Enable "output compare A match" interrupt
+	TCCR1B = 0x08 | TIMER_CLOCK_SELECT; // Select CTC mode with OCR1A as top value, start the timer
+}
+
+unsigned short TimerGetTicksCount(void)
+{
+	unsigned short Ticks_Count;
+	
+	// Reading a 16-bit variable takes two instructions, make sure the interrupt can't update it in the middle
+	TIMSK1 &= ~0x02;
+	Ticks_Count = Timer_Ticks_Count;
+	TIMSK1 |= 0x02;
+	
+	return Ticks_Count;
+}
+
+#if CONFIGURATION_PROFILER_ENABLED
+void TimerGetTimestamp(TTimerTimestamp *Pointer_Timestamp)
+{
+	unsigned char Interrupts_State;
+	
+	// Read both values at the same time, restore the interrupts state instead of enabling them because an interrupt handler can call this function
+	Interrupts_State = SREG;
+	cli();
+	Pointer_Timestamp->Counter = TCNT1;
+	Pointer_Timestamp->Ticks_Count = Timer_Ticks_Count;
+	if ((TIFR1 & 0x02) && (Pointer_Timestamp->Counter < TIMER_COMPARE_VALUE / 2)) Pointer_Timestamp->Ticks_Count++; // The counter has been reset but the interrupt did not count the tick yet
+	SREG = Interrupts_State;
+}
+
+unsigned long TimerGetElapsedCounts(const TTimerTimestamp *Pointer_Start_Timestamp)
+{
+	TTimerTimestamp Timestamp;
+	
+	TimerGetTimestamp(&Timestamp);
+	return (unsigned short) (Timestamp.Ticks_Count - Pointer_Start_Timestamp->Ticks_Count) * (TIMER_COMPARE_VALUE + 1UL) + Timestamp.Counter - Pointer_Start_Timestamp->Counter; // The counters difference can be negative, the sum is right anyway
+}
+#endif
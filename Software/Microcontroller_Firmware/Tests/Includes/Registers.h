@@ -0,0 +1,76 @@
+/** @file Registers.h
+ * Emulate the microcontroller peripherals used by the firmware modules (ADC, EEPROM, Timer 1, UART and I/O ports), and count the accesses that are costly on the real hardware.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_REGISTERS_H
+#define H_REGISTERS_H
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** How many times each costly operation has been done. */
+typedef struct
+{
+	unsigned long ADC_Data_Register_Reads_Count; //!< How many conversion results have been read.
+	unsigned long ADC_Control_Register_Accesses_Count; //!< How many times ADCSRA has been read or written.
+	unsigned long ADC_Interrupts_Count; //!< How many times the "conversion complete" interrupt fired.
+	unsigned long Flash_Reads_Count; //!< How many words have been read from flash memory.
+	unsigned long EEPROM_Writes_Count; //!< How many EEPROM cells have been written.
+} TRegistersCounters;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Put all peripherals in their power-on state : registers are cleared, the EEPROM is erased and the counters are reset. */
+void RegistersInitialize(void);
+
+/** Set the value the ADC returns for a channel.
+ * @param Channel The channel multiplexer value.
+ * @param Value The 10-bit conversion result.
+ */
+void RegistersSetADCChannelValue(unsigned char Channel, unsigned short Value);
+
+/** Complete the conversions started by the firmware and fire the "conversion complete" interrupt, until no more conversion is started. */
+void RegistersRunADCInterrupts(void);
+
+/** Fire the "EEPROM ready" interrupt until the write started by the firmware is finished. Each write cycle completes immediately. */
+void RegistersRunEEPROMInterrupts(void);
+
+/** Read the EEPROM content without going through the firmware.
+ * @param Address The byte address in range [0..1023].
+ * @return The byte value.
+ */
+unsigned char RegistersReadEEPROMByte(unsigned short Address);
+
+/** Modify the EEPROM content without going through the firmware (the write is not counted), like an older firmware or a power loss would have done.
+ * @param Address The byte address in range [0..1023].
+ * @param Byte The byte value.
+ */
+void RegistersWriteEEPROMByte(unsigned short Address, unsigned char Byte);
+
+/** Let the timer count, as if some code was executed. The "output compare A match" interrupt is fired each time the counter reaches OCR1A, if it is enabled.
+ * @param Counts How many timer clock periods elapsed.
+ */
+void RegistersAdvanceTimer(unsigned long Counts);
+
+/** Give a byte to the UART reception interrupt.
+ * @param Byte The received byte.
+ */
+void RegistersReceiveUARTByte(unsigned char Byte);
+
+/** Fire the UART "data register empty" interrupt as long as the firmware keeps it enabled, collecting the sent bytes.
+ * @param Pointer_Buffer On output, contain the sent bytes.
+ * @param Maximum_Size The buffer size, the bytes that do not fit are sent but dropped.
+ * @return How many bytes have been stored in the buffer.
+ */
+int RegistersTransmitUARTBytes(unsigned char *Pointer_Buffer, int Maximum_Size);
+
+/** Get the costly operations counters.
+ * @param Pointer_Counters On output, contain the counters values.
+ */
+void RegistersGetCounters(TRegistersCounters *Pointer_Counters);
+
+/** Set all counters to zero. */
+void RegistersResetCounters(void);
+
+#endif
@@ -0,0 +1,86 @@
+/** @file Test.h
+ * Unit tests of the firmware modules, built for the computer on top of the emulated registers. Each test runs in its own process, so all firmware modules start from their power-on state.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TEST_H
+#define H_TEST_H
+
+#include <stdio.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** The ADC channels, in the order of the ADC module channel IDs. */
+#define TEST_ADC_CHANNEL_OUTSIDE_THERMISTOR 0
+#define TEST_ADC_CHANNEL_DAY_TRIMMER 1
+#define TEST_ADC_CHANNEL_NIGHT_TRIMMER 2
+#define TEST_ADC_CHANNEL_RADIATOR_START_THERMISTOR 3
+
+/** The day trimmer raw value selecting the trimmers reference temperature. */
+#define TEST_DAY_TRIMMER_REFERENCE_RAW_VALUE 337
+/** The night trimmer raw value selecting the same temperature than the day trimmer. */
+#define TEST_NIGHT_TRIMMER_REFERENCE_RAW_VALUE 31
+
+/** Make the current test fail if a condition is false.
+ * @param Condition The condition to check.
+ */
+#define TEST_ASSERT(Condition) \
+	do \
+	{ \
+		if (!(Condition)) \
+		{ \
+			printf("%s:%d : assertion \"%s\" failed.\n", __FILE__, __LINE__, #Condition); \
+			return 1; \
+		} \
+	} while (0)
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Sample all analog channels as many times as the moving average needs, so the averages are equal to the current channel values. */
+void TestSampleAllChannels(void);
+
+/** Give a byte to the protocol reception interrupt, execute the received commands, then collect the answers.
+ * @param Byte The received byte.
+ * @param Pointer_Answer On output, contain the sent bytes.
+ * @param Maximum_Answer_Size The answer buffer size.
+ * @return How many bytes have been sent.
+ */
+int TestReceiveProtocolByte(unsigned char Byte, unsigned char *Pointer_Answer, int Maximum_Answer_Size);
+
+/** Run the protocol link task several times, collecting the sent bytes.
+ * @param Runs_Count How many times to run the task.
+ * @param Pointer_Buffer On output, contain the sent bytes.
+ * @param Maximum_Size The buffer size.
+ * @return How many bytes have been sent.
+ */
+int TestRunProtocolLinkTask(int Runs_Count, unsigned char *Pointer_Buffer, int Maximum_Size);
+
+// All tests, they return 0 on success and 1 on failure
+int TestADCFirstSampling(void);
+int TestADCMovingAverage(void);
+int TestEEPROMWriteSkipsUnchangedBytes(void);
+int TestSettingsPersistence(void);
+int TestSettingsJournalWrapAround(void);
+int TestSettingsCorruptedRecord(void);
+int TestSettingsLegacyLayoutMigration(void);
+int TestProtocolCommandReceivedByteByByte(void);
+int TestProtocolGarbageIsIgnored(void);
+int TestProtocolPayloadReceivedByteByByte(void);
+int TestProtocolQueuedCommands(void);
+int TestProtocolTransmissionBufferFull(void);
+int TestProtocolLinkConnection(void);
+int TestProtocolLinkInactivity(void);
+int TestProtocolLinkReconnectionDropsPartialCommand(void);
+int TestTemperatureHeatingCurve(void);
+int TestTemperatureNightMode(void);
+int TestTemperatureHeatingCurveParameters(void);
+int TestTemperatureTrimmerHysteresis(void);
+int TestMixingValveFullTravel(void);
+int TestMixingValveHalfTravel(void);
+int TestProfilerSectionStatistics(void);
+int TestProfilerPendingTick(void);
+int TestProfilerReset(void);
+int TestProfilerProtocolCommand(void);
+
+#endif
@@ -0,0 +1,37 @@
+/** @file interrupt.h
+ * Turn interrupt handlers into plain functions the tests call when the fake hardware raises an interrupt.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TESTS_AVR_INTERRUPT_H
+#define H_TESTS_AVR_INTERRUPT_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** Declare an interrupt handler as a function named like its vector. */
+#define ISR(Vector) void Vector(void)
+
+/** The tests call the handlers one at a time, there is nothing to mask. */
+#define sei()
+/** The tests call the handlers one at a time, there is nothing to mask. */
+#define cli()
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** The ADC "conversion complete" interrupt handler. */
+void ADC_vect(void);
+
+/** The "EEPROM ready" interrupt handler. */
+void EE_READY_vect(void);
+
+/** The Timer 1 "output compare A match" interrupt handler. */
+void TIMER1_COMPA_vect(void);
+
+/** The UART "receive complete" interrupt handler. */
+void USART_RX_vect(void);
+
+/** The UART "data register empty" interrupt handler. */
+void USART_UDRE_vect(void);
+
+#endif
@@ -0,0 +1,51 @@
+/** @file io.h
+ * Replace the AVR registers by plain variables, so firmware modules can be built for the computer. Registers with a hardware side effect are accessed through functions emulating it (see Registers.h).
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TESTS_AVR_IO_H
+#define H_TESTS_AVR_IO_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** Reading the ADC data register returns the last conversion result. */
+#define ADC (*RegistersAccessADCDataRegister())
+/** Accessing the ADC control register completes the running conversion, so polling loops end. */
+#define ADCSRA (*RegistersAccessADCControlRegister())
+/** Accessing the EEPROM data register after a read strobe loads the addressed byte. */
+#define EEDR (*RegistersAccessEEPROMDataRegister())
+/** Accessing the UART data register is counted, so the tests can tell whether the transmission interrupt wrote a byte. */
+#define UDR0 (*RegistersAccessUARTDataRegister())
+
+//-------------------------------------------------------------------------------------------------
+// Variables
+//-------------------------------------------------------------------------------------------------
+/** Registers without side effects. */
+extern volatile unsigned char ADMUX, DDRB, DDRC, DDRD, DIDR0, EEARH, EEARL, EECR, PORTB, PORTC, PORTD, SREG, TCCR1A, TCCR1B, TIFR1, TIMSK1, UBRR0H, UBRR0L, UCSR0A, UCSR0B, UCSR0C;
+/** Timer 1 registers, the counter only moves when the tests call RegistersAdvanceTimer(). */
+extern volatile unsigned short OCR1A, TCNT1;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Called on each ADC access.
+ * @return The register storage.
+ */
+volatile unsigned short *RegistersAccessADCDataRegister(void);
+
+/** Called on each ADCSRA access.
+ * @return The register storage.
+ */
+volatile unsigned char *RegistersAccessADCControlRegister(void);
+
+/** Called on each EEDR access.
+ * @return The register storage.
+ */
+volatile unsigned char *RegistersAccessEEPROMDataRegister(void);
+
+/** Called on each UDR0 access.
+ * @return The register storage.
+ */
+volatile unsigned char *RegistersAccessUARTDataRegister(void);
+
+#endif
@@ -0,0 +1,26 @@
+/** @file pgmspace.h
+ * The computer has a single address space, so constant data is read like any other data. Reads are counted, because each one costs a slow LPM instruction on the microcontroller.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TESTS_AVR_PGMSPACE_H
+#define H_TESTS_AVR_PGMSPACE_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** Data does not need to be placed in a special section. */
+#define PROGMEM
+
+/** Read a 16-bit word from constant data. */
+#define pgm_read_word(Pointer_Address) RegistersReadFlashWord(Pointer_Address)
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Called on each flash read.
+ * @param Pointer_Address The word to read.
+ * @return The word value.
+ */
+unsigned short RegistersReadFlashWord(const void *Pointer_Address);
+
+#endif
@@ -0,0 +1,115 @@
+/** @file Benchmarks.c
+ * Measure the cost of the firmware hot paths. The computer execution time is only a trend indicator, the operations counts are what matters on the microcontroller : each flash word read takes 3 cycles, each ADC register access and each interrupt entry and exit takes several cycles.
+ * @author Adrien RICCIARDI
+ */
+#include <ADC.h>
+#include <Configuration.h>
+#include <Protocol.h>
+#include <Registers.h>
+#include <Settings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <Temperature.h>
+#include <Test.h>
+#include <time.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many times each benchmark calls the measured function. */
+#define BENCHMARKS_CALLS_COUNT 100000
+
+/** The "get status" command code. */
+#define BENCHMARKS_PROTOCOL_COMMAND_GET_STATUS 13
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A benchmark to run. */
+typedef struct
+{
+	const char *String_Name; //!< The name displayed in the report.
+	void (*Benchmark)(void); //!< Execute the measured code once.
+} TBenchmarksBenchmark;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Sample all channels once. */
+static void BenchmarksADCSampling(void)
+{
+	ADCTask();
+	RegistersRunADCInterrupts();
+}
+
+/** Convert the outside sensor value, the sampled value has oversampling bits so the interpolation is done. */
+static void BenchmarksTemperatureConversion(void)
+{
+	TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_OUTSIDE);
+}
+
+/** Compute the heating curve. */
+static void BenchmarksTemperatureTask(void)
+{
+	TemperatureTask();
+}
+
+/** Receive a "get status" command, execute it and send the answer. */
+static void BenchmarksProtocolGetStatus(void)
+{
+	unsigned char Answer[32];
+	
+	TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer));
+	TestReceiveProtocolByte(BENCHMARKS_PROTOCOL_COMMAND_GET_STATUS, Answer, sizeof(Answer));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** All benchmarks. */
+static TBenchmarksBenchmark Benchmarks[] =
+{
+	{ "Temperature sensor conversion", BenchmarksTemperatureConversion },
+	{ "Temperature task", BenchmarksTemperatureTask },
+	{ "Protocol get status command", BenchmarksProtocolGetStatus },
+	{ "ADC sampling of all channels", BenchmarksADCSampling } // Run it last, the moving average reaches the channel values exactly so the conversions do not need to interpolate anymore
+};
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(void)
+{
+	unsigned int i, j;
+	struct timespec Start_Time, End_Time;
+	double Elapsed_Nanoseconds;
+	TRegistersCounters Counters;
+	
+	// Boot the modules with values that are not exactly on a conversion table entry
+	RegistersInitialize();
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_OUTSIDE_THERMISTOR, 500);
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_DAY_TRIMMER, TEST_DAY_TRIMMER_REFERENCE_RAW_VALUE);
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_NIGHT_TRIMMER, TEST_NIGHT_TRIMMER_REFERENCE_RAW_VALUE);
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_RADIATOR_START_THERMISTOR, 450);
+	ADCInitialize();
+	SettingsInitialize();
+	TemperatureInitialize();
+	ProtocolSimulateConnection();
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_OUTSIDE_THERMISTOR, 504);
+	BenchmarksADCSampling();
+	
+	printf("%-32s %10s %12s %12s %12s %12s\n", "Benchmark", "ns/call", "ADC reads", "ADCSRA", "ADC IRQs", "Flash reads");
+	for (i = 0; i < sizeof(Benchmarks) / sizeof(Benchmarks[0]); i++)
+	{
+		RegistersResetCounters();
+		clock_gettime(CLOCK_MONOTONIC, &Start_Time);
+		for (j = 0; j < BENCHMARKS_CALLS_COUNT; j++) Benchmarks[i].Benchmark();
+		clock_gettime(CLOCK_MONOTONIC, &End_Time);
+		RegistersGetCounters(&Counters);
+		
+		Elapsed_Nanoseconds = (End_Time.tv_sec - Start_Time.tv_sec) * 1e9 + (End_Time.tv_nsec - Start_Time.tv_nsec);
+		printf("%-32s %10.1f %12.2f %12.2f %12.2f %12.2f\n", Benchmarks[i].String_Name, Elapsed_Nanoseconds / BENCHMARKS_CALLS_COUNT, (double) Counters.ADC_Data_Register_Reads_Count / BENCHMARKS_CALLS_COUNT,
+			(double) Counters.ADC_Control_Register_Accesses_Count / BENCHMARKS_CALLS_COUNT, (double) Counters.ADC_Interrupts_Count / BENCHMARKS_CALLS_COUNT, (double) Counters.Flash_Reads_Count / BENCHMARKS_CALLS_COUNT);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+/** @file Main.c
+ * Run all firmware unit tests.
+ * @author Adrien RICCIARDI
+ */
+#include <Registers.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <Test.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A test to run. */
+typedef struct
+{
+	const char *String_Name; //!< The name displayed in the report.
+	int (*Test)(void); //!< The test function.
+} TMainTest;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** All tests. */
+static TMainTest Main_Tests[] =
+{
+	{ "ADC first sampling", TestADCFirstSampling },
+	{ "ADC moving average", TestADCMovingAverage },
+	{ "EEPROM write skips unchanged bytes", TestEEPROMWriteSkipsUnchangedBytes },
+	{ "Settings persistence", TestSettingsPersistence },
+	{ "Settings journal wrap around", TestSettingsJournalWrapAround },
+	{ "Settings corrupted record", TestSettingsCorruptedRecord },
+	{ "Settings legacy layout migration", TestSettingsLegacyLayoutMigration },
+	{ "Protocol command received byte by byte", TestProtocolCommandReceivedByteByByte },
+	{ "Protocol garbage is ignored", TestProtocolGarbageIsIgnored },
+	{ "Protocol payload received byte by byte", TestProtocolPayloadReceivedByteByByte },
+	{ "Protocol queued commands", TestProtocolQueuedCommands },
+	{ "Protocol transmission buffer full", TestProtocolTransmissionBufferFull },
+	{ "Protocol link connection", TestProtocolLinkConnection },
+	{ "Protocol link inactivity", TestProtocolLinkInactivity },
+	{ "Protocol link reconnection drops partial command", TestProtocolLinkReconnectionDropsPartialCommand },
+	{ "Temperature heating curve", TestTemperatureHeatingCurve },
+	{ "Temperature night mode", TestTemperatureNightMode },
+	{ "Temperature heating curve parameters", TestTemperatureHeatingCurveParameters },
+	{ "Temperature trimmer hysteresis", TestTemperatureTrimmerHysteresis },
+	{ "Mixing valve full travel", TestMixingValveFullTravel },
+	{ "Mixing valve half travel", TestMixingValveHalfTravel },
+	{ "Profiler section statistics", TestProfilerSectionStatistics },
+	{ "Profiler pending tick", TestProfilerPendingTick },
+	{ "Profiler reset", TestProfilerReset },
+	{ "Profiler protocol command", TestProfilerProtocolCommand }
+};
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(void)
+{
+	unsigned int i;
+	int Status, Failed_Tests_Count = 0;
+	pid_t Process_ID;
+	
+	for (i = 0; i < sizeof(Main_Tests) / sizeof(Main_Tests[0]); i++)
+	{
+		fflush(stdout); // Do not let the child process print the parent buffered output again
+		
+		// Run the test in a child process, so all firmware modules variables get their initial value
+		Process_ID = fork();
+		if (Process_ID < 0)
+		{
+			perror("Error : failed to create the test process");
+			return EXIT_FAILURE;
+		}
+		if (Process_ID == 0)
+		{
+			RegistersInitialize();
+			exit(Main_Tests[i].Test());
+		}
+		
+		// A crash is a failure too
+		if ((waitpid(Process_ID, &Status, 0) < 0) || !WIFEXITED(Status) || (WEXITSTATUS(Status) != 0))
+		{
+			printf("[FAIL] %s\n", Main_Tests[i].String_Name);
+			Failed_Tests_Count++;
+		}
+		else printf("[ OK ] %s\n", Main_Tests[i].String_Name);
+	}
+	
+	printf("%d test(s) failed on %u.\n", Failed_Tests_Count, (unsigned int) (sizeof(Main_Tests) / sizeof(Main_Tests[0])));
+	if (Failed_Tests_Count > 0) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,240 @@
+/** @file Registers.c
+ * See Registers.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <Registers.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The ATmega328P EEPROM size in bytes. */
+#define REGISTERS_EEPROM_SIZE 1024
+/** How many channels the ADC multiplexer can select. */
+#define REGISTERS_ADC_CHANNELS_COUNT 16
+
+/** ADCSRA "start conversion" bit. */
+#define REGISTERS_ADCSRA_START_CONVERSION 0x40
+/** ADCSRA "conversion complete" flag. */
+#define REGISTERS_ADCSRA_INTERRUPT_FLAG 0x10
+/** ADCSRA "conversion complete" interrupt enable bit. */
+#define REGISTERS_ADCSRA_INTERRUPT_ENABLE 0x08
+
+/** EECR read strobe. */
+#define REGISTERS_EECR_READ_ENABLE 0x01
+/** EECR write strobe. */
+#define REGISTERS_EECR_WRITE_ENABLE 0x02
+/** EECR "EEPROM ready" interrupt enable bit. */
+#define REGISTERS_EECR_READY_INTERRUPT_ENABLE 0x08
+
+/** TIFR1 and TIMSK1 "output compare A match" bit. */
+#define REGISTERS_TIMER_OUTPUT_COMPARE_A_MATCH 0x02
+
+/** UCSR0B "data register empty" interrupt enable bit. */
+#define REGISTERS_UCSR0B_DATA_REGISTER_EMPTY_INTERRUPT_ENABLE 0x20
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The ADC data register storage. */
+static volatile unsigned short Registers_ADC;
+/** The ADCSRA storage. */
+static volatile unsigned char Registers_ADCSRA;
+/** The value each channel converts to. */
+static unsigned short Registers_ADC_Channel_Values[REGISTERS_ADC_CHANNELS_COUNT];
+
+/** The EEPROM content. */
+static unsigned char Registers_EEPROM[REGISTERS_EEPROM_SIZE];
+/** The EEDR storage. */
+static volatile unsigned char Registers_EEDR;
+
+/** The UDR0 storage, each interrupt handler accesses it at most once. */
+static volatile unsigned char Registers_UDR0;
+/** How many times UDR0 has been accessed since the counter was cleared. */
+static unsigned char Registers_UDR0_Accesses_Count;
+
+/** The costly operations counters. */
+static TRegistersCounters Registers_Counters;
+
+//-------------------------------------------------------------------------------------------------
+// Public variables
+//-------------------------------------------------------------------------------------------------
+volatile unsigned char ADMUX, DDRB, DDRC, DDRD, DIDR0, EEARH, EEARL, EECR, PORTB, PORTC, PORTD, SREG, TCCR1A, TCCR1B, TIFR1, TIMSK1, UBRR0H, UBRR0L, UCSR0A, UCSR0B, UCSR0C;
+volatile unsigned short OCR1A, TCNT1;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get the address selected by the EEPROM address registers.
+ * @return The address.
+ */
+static unsigned short RegistersGetEEPROMAddress(void)
+{
+	return ((EEARH << 8) | EEARL) & (REGISTERS_EEPROM_SIZE - 1);
+}
+
+/** Terminate the running conversion, if any. The conversion is instantaneous. */
+static void RegistersCompleteADCConversion(void)
+{
+	if (!(Registers_ADCSRA & REGISTERS_ADCSRA_START_CONVERSION)) return;
+	
+	Registers_ADC = Registers_ADC_Channel_Values[ADMUX & (REGISTERS_ADC_CHANNELS_COUNT - 1)];
+	Registers_ADCSRA = (Registers_ADCSRA & ~REGISTERS_ADCSRA_START_CONVERSION) | REGISTERS_ADCSRA_INTERRUPT_FLAG;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+volatile unsigned short *RegistersAccessADCDataRegister(void)
+{
+	Registers_Counters.ADC_Data_Register_Reads_Count++;
+	return &Registers_ADC;
+}
+
+volatile unsigned char *RegistersAccessADCControlRegister(void)
+{
+	Registers_Counters.ADC_Control_Register_Accesses_Count++;
+	
+	// Polling the register ends the conversion
+	RegistersCompleteADCConversion();
+	return &Registers_ADCSRA;
+}
+
+volatile unsigned char *RegistersAccessEEPROMDataRegister(void)
+{
+	// A read is instantaneous
+	if (EECR & REGISTERS_EECR_READ_ENABLE)
+	{
+		Registers_EEDR = Registers_EEPROM[RegistersGetEEPROMAddress()];
+		EECR &= ~REGISTERS_EECR_READ_ENABLE;
+	}
+	return &Registers_EEDR;
+}
+
+volatile unsigned char *RegistersAccessUARTDataRegister(void)
+{
+	Registers_UDR0_Accesses_Count++;
+	return &Registers_UDR0;
+}
+
+unsigned short RegistersReadFlashWord(const void *Pointer_Address)
+{
+	Registers_Counters.Flash_Reads_Count++;
+	return *(const unsigned short *) Pointer_Address;
+}
+
+void RegistersInitialize(void)
+{
+	Registers_ADC = 0;
+	Registers_ADCSRA = 0;
+	memset(Registers_ADC_Channel_Values, 0, sizeof(Registers_ADC_Channel_Values));
+	memset(Registers_EEPROM, 0xFF, sizeof(Registers_EEPROM));
+	Registers_EEDR = 0;
+	Registers_UDR0 = 0;
+	ADMUX = DDRB = DDRC = DDRD = DIDR0 = EEARH = EEARL = EECR = PORTB = PORTC = PORTD = SREG = TCCR1A = TCCR1B = TIFR1 = TIMSK1 = UBRR0H = UBRR0L = UCSR0A = UCSR0B = UCSR0C = 0;
+	OCR1A = TCNT1 = 0;
+	RegistersResetCounters();
+}
+
+void RegistersSetADCChannelValue(unsigned char Channel, unsigned short Value)
+{
+	Registers_ADC_Channel_Values[Channel & (REGISTERS_ADC_CHANNELS_COUNT - 1)] = Value & 0x03FF;
+}
+
+void RegistersRunADCInterrupts(void)
+{
+	while (1)
+	{
+		// The handler starts the next conversion until all channels have been sampled
+		RegistersCompleteADCConversion();
+		if ((Registers_ADCSRA & (REGISTERS_ADCSRA_INTERRUPT_FLAG | REGISTERS_ADCSRA_INTERRUPT_ENABLE)) != (REGISTERS_ADCSRA_INTERRUPT_FLAG | REGISTERS_ADCSRA_INTERRUPT_ENABLE)) return;
+		
+		Registers_ADCSRA &= ~REGISTERS_ADCSRA_INTERRUPT_FLAG; // The flag is cleared when the handler is called
+		Registers_Counters.ADC_Interrupts_Count++;
+		ADC_vect();
+	}
+}
+
+void RegistersRunEEPROMInterrupts(void)
+{
+	while (EECR & REGISTERS_EECR_READY_INTERRUPT_ENABLE)
+	{
+		// Terminate the write cycle started by the previous handler
+		if (EECR & REGISTERS_EECR_WRITE_ENABLE)
+		{
+			Registers_EEPROM[RegistersGetEEPROMAddress()] = Registers_EEDR;
+			EECR &= ~REGISTERS_EECR_WRITE_ENABLE;
+			Registers_Counters.EEPROM_Writes_Count++;
+		}
+		EE_READY_vect();
+	}
+}
+
+unsigned char RegistersReadEEPROMByte(unsigned short Address)
+{
+	return Registers_EEPROM[Address & (REGISTERS_EEPROM_SIZE - 1)];
+}
+
+void RegistersWriteEEPROMByte(unsigned short Address, unsigned char Byte)
+{
+	Registers_EEPROM[Address & (REGISTERS_EEPROM_SIZE - 1)] = Byte;
+}
+
+void RegistersAdvanceTimer(unsigned long Counts)
+{
+	while (Counts > 0)
+	{
+		// The counter is reset on the clock period following the compare match (CTC mode)
+		if (TCNT1 == OCR1A)
+		{
+			TCNT1 = 0;
+			TIFR1 |= REGISTERS_TIMER_OUTPUT_COMPARE_A_MATCH;
+		}
+		else TCNT1++;
+		Counts--;
+		
+		// The handler is called as soon as the flag is set, and the flag is cleared when the handler is called
+		if ((TIFR1 & REGISTERS_TIMER_OUTPUT_COMPARE_A_MATCH) && (TIMSK1 & REGISTERS_TIMER_OUTPUT_COMPARE_A_MATCH))
+		{
+			TIFR1 &= ~REGISTERS_TIMER_OUTPUT_COMPARE_A_MATCH;
+			TIMER1_COMPA_vect();
+		}
+	}
+}
+
+void RegistersReceiveUARTByte(unsigned char Byte)
+{
+	Registers_UDR0 = Byte;
+	USART_RX_vect();
+}
+
+int RegistersTransmitUARTBytes(unsigned char *Pointer_Buffer, int Maximum_Size)
+{
+	int Size = 0;
+	
+	while (UCSR0B & REGISTERS_UCSR0B_DATA_REGISTER_EMPTY_INTERRUPT_ENABLE)
+	{
+		Registers_UDR0_Accesses_Count = 0;
+		USART_UDRE_vect();
+		if (Registers_UDR0_Accesses_Count == 0) continue; // The handler disabled the interrupt because there is nothing left to send
+		if (Size < Maximum_Size)
+		{
+			Pointer_Buffer[Size] = Registers_UDR0;
+			Size++;
+		}
+	}
+	return Size;
+}
+
+void RegistersGetCounters(TRegistersCounters *Pointer_Counters)
+{
+	*Pointer_Counters = Registers_Counters;
+}
+
+void RegistersResetCounters(void)
+{
+	memset(&Registers_Counters, 0, sizeof(Registers_Counters));
+}
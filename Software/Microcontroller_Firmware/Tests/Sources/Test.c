@@ -0,0 +1,43 @@
+/** @file Test.c
+ * See Test.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <ADC.h>
+#include <Configuration.h>
+#include <Protocol.h>
+#include <Registers.h>
+#include <Test.h>
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void TestSampleAllChannels(void)
+{
+	int i;
+	
+	for (i = 0; i < CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT; i++)
+	{
+		ADCTask();
+		RegistersRunADCInterrupts();
+	}
+}
+
+int TestReceiveProtocolByte(unsigned char Byte, unsigned char *Pointer_Answer, int Maximum_Answer_Size)
+{
+	// The main loop is woken up by the interrupt and executes the command
+	RegistersReceiveUARTByte(Byte);
+	ProtocolTask();
+	return RegistersTransmitUARTBytes(Pointer_Answer, Maximum_Answer_Size);
+}
+
+int TestRunProtocolLinkTask(int Runs_Count, unsigned char *Pointer_Buffer, int Maximum_Size)
+{
+	int i, Size = 0;
+	
+	for (i = 0; i < Runs_Count; i++)
+	{
+		ProtocolLinkTask();
+		Size += RegistersTransmitUARTBytes(&Pointer_Buffer[Size], Maximum_Size - Size);
+	}
+	return Size;
+}
@@ -0,0 +1,68 @@
+/** @file Test_ADC.c
+ * Check the oversampling and the moving average of the ADC module.
+ * @author Adrien RICCIARDI
+ */
+#include <ADC.h>
+#include <Configuration.h>
+#include <Registers.h>
+#include <Test.h>
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int TestADCFirstSampling(void)
+{
+	int i;
+	
+	for (i = 0; i < ADC_CHANNEL_IDS_COUNT; i++) RegistersSetADCChannelValue(i, 100 + 200 * i);
+	ADCInitialize();
+	
+	// The moving averages must be filled with the first sample, so values are right as soon as the module is initialized
+	for (i = 0; i < ADC_CHANNEL_IDS_COUNT; i++)
+	{
+		TEST_ASSERT(ADCGetLastOversampledValue(i) == (100 + 200 * i) << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS);
+		TEST_ASSERT(ADCGetLastSampledValue(i) == 100 + 200 * i);
+	}
+	TEST_ASSERT(ADCGetLastSampledValue(ADC_CHANNEL_IDS_COUNT) == 0);
+	return 0;
+}
+
+int TestADCMovingAverage(void)
+{
+	TRegistersCounters Counters;
+	int i;
+	
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_OUTSIDE_THERMISTOR, 400);
+	ADCInitialize();
+	
+	// A single new sample moves the average by a tenth of the difference
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_OUTSIDE_THERMISTOR, 800);
+	RegistersResetCounters();
+	ADCTask();
+	RegistersRunADCInterrupts();
+	TEST_ASSERT(ADCGetLastSampledValue(ADC_CHANNEL_ID_OUTSIDE_THERMISTOR) == 400 + (800 - 400) / CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT);
+	
+	// Each channel sample needs all oversampling conversions, each one handled by a single interrupt
+	RegistersGetCounters(&Counters);
+	TEST_ASSERT(Counters.ADC_Data_Register_Reads_Count == ADC_CHANNEL_IDS_COUNT << (2 * CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS));
+	TEST_ASSERT(Counters.ADC_Interrupts_Count == Counters.ADC_Data_Register_Reads_Count);
+	
+	// A sampling that is still running is not restarted
+	ADCTask();
+	ADCTask();
+	RegistersRunADCInterrupts();
+	RegistersGetCounters(&Counters);
+	TEST_ASSERT(Counters.ADC_Interrupts_Count == 2 * (ADC_CHANNEL_IDS_COUNT << (2 * CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS)));
+	
+	// The average reaches the new value when all samples have been replaced
+	for (i = 2; i < CONFIGURATION_ADC_MOVING_AVERAGE_SAMPLES_COUNT; i++)
+	{
+		ADCTask();
+		RegistersRunADCInterrupts();
+	}
+	TEST_ASSERT(ADCGetLastOversampledValue(ADC_CHANNEL_ID_OUTSIDE_THERMISTOR) == 800 << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS);
+	
+	// The other channels did not move
+	TEST_ASSERT(ADCGetLastSampledValue(ADC_CHANNEL_ID_RADIATOR_START_THERMISTOR) == 0);
+	return 0;
+}
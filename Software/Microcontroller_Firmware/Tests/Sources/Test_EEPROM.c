@@ -0,0 +1,222 @@
+/** @file Test_EEPROM.c
+ * Check the EEPROM background writes and the settings journal.
+ * @author Adrien RICCIARDI
+ */
+#include <Configuration.h>
+#include <EEPROM.h>
+#include <Registers.h>
+#include <Settings.h>
+#include <Test.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The settings journal record size in bytes. */
+#define TEST_EEPROM_SETTINGS_RECORD_SIZE 16
+/** How many records the settings journal holds. */
+#define TEST_EEPROM_SETTINGS_RECORDS_COUNT 64
+/** The offset of the settings in a journal record (after the version and the sequence number). */
+#define TEST_EEPROM_SETTINGS_RECORD_SETTINGS_OFFSET 3
+
+/** The heating curve coefficient stored by an older firmware. */
+#define TEST_EEPROM_LEGACY_HEATING_CURVE_COEFFICIENT 0x0123
+/** The heating curve parallel shift stored by an older firmware. */
+#define TEST_EEPROM_LEGACY_HEATING_CURVE_PARALLEL_SHIFT 0x0456
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Change the heating curve coefficient and wait for the settings journal to be written.
+ * @param Coefficient The new coefficient, it must differ from the current one.
+ */
+static void TestEEPROMSaveHeatingCurveCoefficient(unsigned short Coefficient)
+{
+	TSettings Settings;
+	
+	Settings = *SettingsGet();
+	Settings.Heating_Curve_Coefficient = Coefficient;
+	SettingsSet(&Settings);
+	SettingsTask();
+	RegistersRunEEPROMInterrupts();
+}
+
+/** Corrupt a settings journal record, as a power loss during its writing would do.
+ * @param Index The record index.
+ */
+static void TestEEPROMCorruptSettingsRecord(unsigned char Index)
+{
+	unsigned short Address;
+	
+	Address = Index * TEST_EEPROM_SETTINGS_RECORD_SIZE + TEST_EEPROM_SETTINGS_RECORD_SETTINGS_OFFSET;
+	RegistersWriteEEPROMByte(Address, RegistersReadEEPROMByte(Address) ^ 0x01);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int TestEEPROMWriteSkipsUnchangedBytes(void)
+{
+	static unsigned char Buffer[] = { 0x12, 0xFF, 0x34, 0xFF, 0x56 };
+	TRegistersCounters Counters;
+	unsigned int i;
+	
+	// Erased bytes already hold 0xFF
+	EEPROMStartWriting(100, Buffer, sizeof(Buffer));
+	TEST_ASSERT(EEPROMIsWriting());
+	RegistersRunEEPROMInterrupts();
+	TEST_ASSERT(!EEPROMIsWriting());
+	RegistersGetCounters(&Counters);
+	TEST_ASSERT(Counters.EEPROM_Writes_Count == 3);
+	for (i = 0; i < sizeof(Buffer); i++)
+	{
+		TEST_ASSERT(RegistersReadEEPROMByte(100 + i) == Buffer[i]);
+		TEST_ASSERT(EEPROMReadByte(100 + i) == Buffer[i]);
+	}
+	TEST_ASSERT(RegistersReadEEPROMByte(99) == 0xFF);
+	TEST_ASSERT(RegistersReadEEPROMByte(100 + sizeof(Buffer)) == 0xFF);
+	
+	// Writing the same data again does not wear any cell
+	RegistersResetCounters();
+	EEPROMStartWriting(100, Buffer, sizeof(Buffer));
+	RegistersRunEEPROMInterrupts();
+	TEST_ASSERT(!EEPROMIsWriting());
+	RegistersGetCounters(&Counters);
+	TEST_ASSERT(Counters.EEPROM_Writes_Count == 0);
+	return 0;
+}
+
+int TestSettingsPersistence(void)
+{
+	TSettings Settings;
+	TRegistersCounters Counters;
+	
+	// An erased EEPROM provides the default settings
+	SettingsInitialize();
+	Settings = *SettingsGet();
+	TEST_ASSERT(Settings.Heating_Curve_Coefficient == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT);
+	TEST_ASSERT(Settings.Heating_Curve_Parallel_Shift == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_PARALLEL_SHIFT);
+	TEST_ASSERT(Settings.Desired_Day_Room_Temperature == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE);
+	TEST_ASSERT(Settings.Is_Boiler_Running == 1);
+	
+	// Unchanged settings are not saved
+	SettingsSet(&Settings);
+	SettingsTask();
+	TEST_ASSERT(!EEPROMIsWriting());
+	
+	// Save new settings
+	Settings.Heating_Curve_Coefficient = 17;
+	Settings.Desired_Night_Room_Temperature = 16;
+	Settings.Is_Night_Mode_Enabled = 1;
+	SettingsSet(&Settings);
+	SettingsTask();
+	RegistersRunEEPROMInterrupts();
+	TEST_ASSERT(!EEPROMIsWriting());
+	RegistersGetCounters(&Counters);
+	TEST_ASSERT(Counters.EEPROM_Writes_Count > 0);
+	
+	// The saved settings are found again after a reboot, even if settings modified later have not been saved
+	Settings.Heating_Curve_Coefficient = 30;
+	SettingsSet(&Settings);
+	SettingsInitialize();
+	Settings = *SettingsGet();
+	TEST_ASSERT(Settings.Heating_Curve_Coefficient == 17);
+	TEST_ASSERT(Settings.Heating_Curve_Parallel_Shift == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_PARALLEL_SHIFT);
+	TEST_ASSERT(Settings.Desired_Night_Room_Temperature == 16);
+	TEST_ASSERT(Settings.Is_Night_Mode_Enabled == 1);
+	return 0;
+}
+
+int TestSettingsJournalWrapAround(void)
+{
+	unsigned long i, Saves_Count;
+	
+	// Fill the journal many times, until the sequence number wraps around too
+	SettingsInitialize();
+	Saves_Count = 0x10000 + TEST_EEPROM_SETTINGS_RECORDS_COUNT / 2;
+	for (i = 1; i <= Saves_Count; i++)
+	{
+		TestEEPROMSaveHeatingCurveCoefficient(i % 1000);
+		
+		// The most recent record is found when the journal has just wrapped around
+		if (i == TEST_EEPROM_SETTINGS_RECORDS_COUNT + 3)
+		{
+			SettingsInitialize();
+			TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == i % 1000);
+		}
+	}
+	
+	// The most recent record is found when the sequence number has wrapped around, and the first record bytes are not taken for the older firmwares layout
+	SettingsInitialize();
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == Saves_Count % 1000);
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Parallel_Shift == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_PARALLEL_SHIFT);
+	SettingsTask();
+	TEST_ASSERT(!EEPROMIsWriting());
+	return 0;
+}
+
+int TestSettingsCorruptedRecord(void)
+{
+	// The journal starts with the second record
+	SettingsInitialize();
+	TestEEPROMSaveHeatingCurveCoefficient(17);
+	TestEEPROMSaveHeatingCurveCoefficient(18);
+	
+	// The previous record is used when the most recent one has a bad CRC
+	TestEEPROMCorruptSettingsRecord(2);
+	SettingsInitialize();
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == 17);
+	
+	// The next record replaces the corrupted one
+	TestEEPROMSaveHeatingCurveCoefficient(19);
+	SettingsInitialize();
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == 19);
+	
+	// The defaults are used when no record is valid anymore
+	TestEEPROMCorruptSettingsRecord(1);
+	TestEEPROMCorruptSettingsRecord(2);
+	SettingsInitialize();
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT);
+	return 0;
+}
+
+int TestSettingsLegacyLayoutMigration(void)
+{
+	TSettings Settings;
+	
+	// An older firmware stored the heating curve at the EEPROM beginning
+	RegistersWriteEEPROMByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_LOW_BYTE, (unsigned char) TEST_EEPROM_LEGACY_HEATING_CURVE_COEFFICIENT);
+	RegistersWriteEEPROMByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_HIGH_BYTE, TEST_EEPROM_LEGACY_HEATING_CURVE_COEFFICIENT >> 8);
+	RegistersWriteEEPROMByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_LOW_BYTE, (unsigned char) TEST_EEPROM_LEGACY_HEATING_CURVE_PARALLEL_SHIFT);
+	RegistersWriteEEPROMByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_HIGH_BYTE, TEST_EEPROM_LEGACY_HEATING_CURVE_PARALLEL_SHIFT >> 8);
+	
+	// The heating curve is migrated from an erased journal
+	SettingsInitialize();
+	Settings = *SettingsGet();
+	TEST_ASSERT(Settings.Heating_Curve_Coefficient == TEST_EEPROM_LEGACY_HEATING_CURVE_COEFFICIENT);
+	TEST_ASSERT(Settings.Heating_Curve_Parallel_Shift == TEST_EEPROM_LEGACY_HEATING_CURVE_PARALLEL_SHIFT);
+	TEST_ASSERT(Settings.Desired_Day_Room_Temperature == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE);
+	TEST_ASSERT(Settings.Is_Boiler_Running == 1);
+	
+	// The migrated settings are saved without overwriting the older firmwares layout
+	SettingsTask();
+	TEST_ASSERT(EEPROMIsWriting());
+	RegistersRunEEPROMInterrupts();
+	TEST_ASSERT(RegistersReadEEPROMByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_COEFFICIENT_LOW_BYTE) == (unsigned char) TEST_EEPROM_LEGACY_HEATING_CURVE_COEFFICIENT);
+	TEST_ASSERT(RegistersReadEEPROMByte(CONFIGURATION_EEPROM_ADDRESS_HEATING_CURVE_PARALLEL_SHIFT_HIGH_BYTE) == TEST_EEPROM_LEGACY_HEATING_CURVE_PARALLEL_SHIFT >> 8);
+	
+	// The journal record is used from now on
+	SettingsInitialize();
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == TEST_EEPROM_LEGACY_HEATING_CURVE_COEFFICIENT);
+	SettingsTask();
+	TEST_ASSERT(!EEPROMIsWriting());
+	
+	// A journal holding only corrupted records is not migrated again, even if the older firmwares layout is still present
+	TestEEPROMCorruptSettingsRecord(1);
+	SettingsInitialize();
+	Settings = *SettingsGet();
+	TEST_ASSERT(Settings.Heating_Curve_Coefficient == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT);
+	TEST_ASSERT(Settings.Heating_Curve_Parallel_Shift == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_PARALLEL_SHIFT);
+	SettingsTask();
+	TEST_ASSERT(!EEPROMIsWriting());
+	return 0;
+}
@@ -0,0 +1,99 @@
+/** @file Test_Mixing_Valve.c
+ * Check the mixing valve relays timing.
+ * @author Adrien RICCIARDI
+ */
+#include <avr/io.h>
+#include <Configuration.h>
+#include <Led.h>
+#include <Mixing_Valve.h>
+#include <Relay.h>
+#include <Test.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The "mixing valve moving" led bit in PORTB. */
+#define TEST_MIXING_VALVE_LED_MASK 0x02
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Run the mixing valve task once per second of a move, checking that the relays stay on until the last second.
+ * @param Seconds_Count How long the move must last.
+ * @param Relay_ID The relay that makes the valve move.
+ * @return 0 if the relays were driven as expected,
+ * @return 1 if the move did not last the right time.
+ */
+static int TestMixingValveRunMove(int Seconds_Count, TRelayID Relay_ID)
+{
+	int i;
+	
+	for (i = 0; i < Seconds_Count - 1; i++)
+	{
+		MixingValveTask();
+		TEST_ASSERT(RelayIsTurnedOn(Relay_ID));
+		TEST_ASSERT(PORTB & TEST_MIXING_VALVE_LED_MASK);
+	}
+	
+	// Everything stops on the last second
+	MixingValveTask();
+	TEST_ASSERT(!RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_LEFT));
+	TEST_ASSERT(!RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_RIGHT));
+	TEST_ASSERT(!(PORTB & TEST_MIXING_VALVE_LED_MASK));
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int TestMixingValveFullTravel(void)
+{
+	RelayInitialize();
+	LedInitialize();
+	TEST_ASSERT(MixingValveGetPosition() == MIXING_VALVE_POSITION_LEFT);
+	
+	// Go from left to right
+	MixingValveSetPosition(MIXING_VALVE_POSITION_RIGHT);
+	TEST_ASSERT(RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_RIGHT));
+	TEST_ASSERT(!RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_LEFT));
+	TEST_ASSERT(TestMixingValveRunMove(CONFIGURATION_MIXING_VALVE_MAXIMUM_MOVING_TIME, RELAY_ID_MIXING_VALVE_RIGHT) == 0);
+	TEST_ASSERT(MixingValveGetPosition() == MIXING_VALVE_POSITION_RIGHT);
+	
+	// The position is updated only when the valve stopped
+	MixingValveSetPosition(MIXING_VALVE_POSITION_LEFT);
+	MixingValveTask();
+	TEST_ASSERT(MixingValveGetPosition() == MIXING_VALVE_POSITION_RIGHT);
+	TEST_ASSERT(TestMixingValveRunMove(CONFIGURATION_MIXING_VALVE_MAXIMUM_MOVING_TIME - 1, RELAY_ID_MIXING_VALVE_LEFT) == 0);
+	TEST_ASSERT(MixingValveGetPosition() == MIXING_VALVE_POSITION_LEFT);
+	
+	// Nothing happens once the valve is stopped
+	MixingValveTask();
+	TEST_ASSERT(!RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_LEFT));
+	TEST_ASSERT(MixingValveGetPosition() == MIXING_VALVE_POSITION_LEFT);
+	return 0;
+}
+
+int TestMixingValveHalfTravel(void)
+{
+	RelayInitialize();
+	LedInitialize();
+	
+	// Go from left to center
+	MixingValveSetPosition(MIXING_VALVE_POSITION_CENTER);
+	TEST_ASSERT(TestMixingValveRunMove(CONFIGURATION_MIXING_VALVE_MAXIMUM_MOVING_TIME / 2, RELAY_ID_MIXING_VALVE_RIGHT) == 0);
+	TEST_ASSERT(MixingValveGetPosition() == MIXING_VALVE_POSITION_CENTER);
+	
+	// Go from center to left
+	MixingValveSetPosition(MIXING_VALVE_POSITION_LEFT);
+	TEST_ASSERT(TestMixingValveRunMove(CONFIGURATION_MIXING_VALVE_MAXIMUM_MOVING_TIME / 2, RELAY_ID_MIXING_VALVE_LEFT) == 0);
+	TEST_ASSERT(MixingValveGetPosition() == MIXING_VALVE_POSITION_LEFT);
+	
+	// Go from right to center
+	MixingValveSetPosition(MIXING_VALVE_POSITION_RIGHT);
+	TEST_ASSERT(TestMixingValveRunMove(CONFIGURATION_MIXING_VALVE_MAXIMUM_MOVING_TIME, RELAY_ID_MIXING_VALVE_RIGHT) == 0);
+	MixingValveSetPosition(MIXING_VALVE_POSITION_CENTER);
+	TEST_ASSERT(RelayIsTurnedOn(RELAY_ID_MIXING_VALVE_LEFT));
+	TEST_ASSERT(TestMixingValveRunMove(CONFIGURATION_MIXING_VALVE_MAXIMUM_MOVING_TIME / 2, RELAY_ID_MIXING_VALVE_LEFT) == 0);
+	TEST_ASSERT(MixingValveGetPosition() == MIXING_VALVE_POSITION_CENTER);
+	return 0;
+}
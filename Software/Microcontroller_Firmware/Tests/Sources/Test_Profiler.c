@@ -0,0 +1,201 @@
+/** @file Test_Profiler.c
+ * Let the emulated timer count while sections are measured, then check the statistics read directly and through the protocol.
+ * @author Adrien RICCIARDI
+ */
+#include <avr/io.h>
+#include <Configuration.h>
+#include <Profiler.h>
+#include <Protocol.h>
+#include <Registers.h>
+#include <Settings.h>
+#include <Test.h>
+#include <Timer.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The command code used by the tests, it is part of the protocol so it never changes. */
+#define TEST_PROFILER_COMMAND_GET_TASK_PROFILE 16
+
+/** How many timer counts a tick lasts. */
+#define TEST_PROFILER_TICK_COUNTS ((F_CPU / TIMER_PRESCALER) * CONFIGURATION_SCHEDULER_TICK_PERIOD / 1000)
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A section statistics decoded from ProfilerReadSection() output. */
+typedef struct
+{
+	unsigned char Section_ID; //!< The section ID.
+	unsigned char Sections_Count; //!< How many sections exist.
+	unsigned char Cycles_Per_Count; //!< How many CPU cycles a count lasts.
+	unsigned long Calls_Count; //!< How many times the section has been executed.
+	unsigned short Minimum_Counts; //!< The shortest execution time.
+	unsigned short Maximum_Counts; //!< The longest execution time.
+	unsigned long Total_Counts; //!< All execution times sum.
+} TTestProfilerSection;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Decode a section statistics.
+ * @param Pointer_Buffer The PROFILER_SECTION_PAYLOAD_SIZE bytes returned by the profiler.
+ * @param Pointer_Section On output, contain the decoded statistics.
+ */
+static void TestProfilerDecodeSection(unsigned char *Pointer_Buffer, TTestProfilerSection *Pointer_Section)
+{
+	Pointer_Section->Section_ID = Pointer_Buffer[0];
+	Pointer_Section->Sections_Count = Pointer_Buffer[1];
+	Pointer_Section->Cycles_Per_Count = Pointer_Buffer[2];
+	Pointer_Section->Calls_Count = Pointer_Buffer[3] | (Pointer_Buffer[4] << 8) | ((unsigned long) Pointer_Buffer[5] << 16) | ((unsigned long) Pointer_Buffer[6] << 24);
+	Pointer_Section->Minimum_Counts = Pointer_Buffer[7] | (Pointer_Buffer[8] << 8);
+	Pointer_Section->Maximum_Counts = Pointer_Buffer[9] | (Pointer_Buffer[10] << 8);
+	Pointer_Section->Total_Counts = Pointer_Buffer[11] | (Pointer_Buffer[12] << 8) | ((unsigned long) Pointer_Buffer[13] << 16) | ((unsigned long) Pointer_Buffer[14] << 24);
+}
+
+/** Read and decode a section statistics.
+ * @param Section_ID The section.
+ * @param Is_Reset_Requested Set to 1 to clear the statistics once they have been read.
+ * @param Pointer_Section On output, contain the decoded statistics.
+ */
+static void TestProfilerReadSection(unsigned char Section_ID, unsigned char Is_Reset_Requested, TTestProfilerSection *Pointer_Section)
+{
+	unsigned char Buffer[PROFILER_SECTION_PAYLOAD_SIZE];
+	
+	ProfilerReadSection(Section_ID, Is_Reset_Requested, Buffer);
+	TestProfilerDecodeSection(Buffer, Pointer_Section);
+}
+
+/** Start the timer with no pending compare match. The emulated TIFR1 is a plain variable, so the write clearing the flag on the real hardware sets it instead. */
+static void TestProfilerStartTimer(void)
+{
+	TimerInitialize();
+	TIFR1 = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int TestProfilerSectionStatistics(void)
+{
+	TTestProfilerSection Section;
+	
+	TestProfilerStartTimer();
+	
+	// Sections shorter and longer than a tick are measured to the count
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_REGULATION_TASK, RegistersAdvanceTimer(300));
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_REGULATION_TASK, RegistersAdvanceTimer(100));
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_REGULATION_TASK, RegistersAdvanceTimer(TEST_PROFILER_TICK_COUNTS + 500));
+	TEST_ASSERT(TimerGetTicksCount() == 1);
+	TestProfilerReadSection(PROFILER_SECTION_ID_REGULATION_TASK, 0, &Section);
+	TEST_ASSERT(Section.Section_ID == PROFILER_SECTION_ID_REGULATION_TASK);
+	TEST_ASSERT(Section.Sections_Count == PROFILER_SECTION_IDS_COUNT);
+	TEST_ASSERT(Section.Cycles_Per_Count == TIMER_PRESCALER);
+	TEST_ASSERT(Section.Calls_Count == 3);
+	TEST_ASSERT(Section.Minimum_Counts == 100);
+	TEST_ASSERT(Section.Maximum_Counts == TEST_PROFILER_TICK_COUNTS + 500);
+	TEST_ASSERT(Section.Total_Counts == TEST_PROFILER_TICK_COUNTS + 900);
+	
+	// The extremes saturate, but the total is exact
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_REGULATION_TASK, RegistersAdvanceTimer(100000));
+	TestProfilerReadSection(PROFILER_SECTION_ID_REGULATION_TASK, 0, &Section);
+	TEST_ASSERT(Section.Calls_Count == 4);
+	TEST_ASSERT(Section.Maximum_Counts == 0xFFFF);
+	TEST_ASSERT(Section.Total_Counts == TEST_PROFILER_TICK_COUNTS + 100900);
+	
+	// Other sections are not modified
+	TestProfilerReadSection(PROFILER_SECTION_ID_ADC_TASK, 0, &Section);
+	TEST_ASSERT(Section.Calls_Count == 0);
+	TEST_ASSERT(Section.Total_Counts == 0);
+	return 0;
+}
+
+int TestProfilerPendingTick(void)
+{
+	TTimerTimestamp Timestamp;
+	TTestProfilerSection Section;
+	
+	TestProfilerStartTimer();
+	RegistersAdvanceTimer(TEST_PROFILER_TICK_COUNTS - 10);
+	
+	// Emulate a section masking the interrupts, the counter is reset but the tick interrupt is not executed yet
+	TIMSK1 &= ~0x02;
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_EEPROM_INTERRUPT, RegistersAdvanceTimer(20));
+	TimerGetTimestamp(&Timestamp);
+	TEST_ASSERT(TimerGetTicksCount() == 0);
+	TEST_ASSERT(Timestamp.Ticks_Count == 1);
+	TEST_ASSERT(Timestamp.Counter == 10);
+	TestProfilerReadSection(PROFILER_SECTION_ID_EEPROM_INTERRUPT, 0, &Section);
+	TEST_ASSERT(Section.Calls_Count == 1);
+	TEST_ASSERT(Section.Total_Counts == 20);
+	
+	// The late interrupt does not count the tick twice
+	TIMSK1 |= 0x02;
+	RegistersAdvanceTimer(1);
+	TimerGetTimestamp(&Timestamp);
+	TEST_ASSERT(TimerGetTicksCount() == 1);
+	TEST_ASSERT(Timestamp.Ticks_Count == 1);
+	TEST_ASSERT(Timestamp.Counter == 11);
+	return 0;
+}
+
+int TestProfilerReset(void)
+{
+	TTestProfilerSection Section;
+	
+	TestProfilerStartTimer();
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_TELEMETRY_TASK, RegistersAdvanceTimer(50));
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_TELEMETRY_TASK, RegistersAdvanceTimer(70));
+	
+	// The statistics are returned before being cleared
+	TestProfilerReadSection(PROFILER_SECTION_ID_TELEMETRY_TASK, 1, &Section);
+	TEST_ASSERT(Section.Calls_Count == 2);
+	TEST_ASSERT(Section.Minimum_Counts == 50);
+	TEST_ASSERT(Section.Maximum_Counts == 70);
+	TEST_ASSERT(Section.Total_Counts == 120);
+	TestProfilerReadSection(PROFILER_SECTION_ID_TELEMETRY_TASK, 0, &Section);
+	TEST_ASSERT(Section.Calls_Count == 0);
+	TEST_ASSERT(Section.Maximum_Counts == 0);
+	TEST_ASSERT(Section.Total_Counts == 0);
+	
+	// The previous minimum does not hide the new one
+	PROFILER_MEASURE_SECTION(PROFILER_SECTION_ID_TELEMETRY_TASK, RegistersAdvanceTimer(80));
+	TestProfilerReadSection(PROFILER_SECTION_ID_TELEMETRY_TASK, 0, &Section);
+	TEST_ASSERT(Section.Calls_Count == 1);
+	TEST_ASSERT(Section.Minimum_Counts == 80);
+	TEST_ASSERT(Section.Maximum_Counts == 80);
+	return 0;
+}
+
+int TestProfilerProtocolCommand(void)
+{
+	static unsigned char Command[] = { PROTOCOL_MAGIC_NUMBER, TEST_PROFILER_COMMAND_GET_TASK_PROFILE, PROFILER_SECTION_ID_UART_RECEPTION_INTERRUPT, 0 };
+	unsigned char Answer[32];
+	unsigned int i;
+	TTestProfilerSection Section;
+	
+	SettingsInitialize();
+	ProtocolSimulateConnection();
+	TestProfilerStartTimer();
+	
+	// The reception interrupt measures itself, the command is executed once all its bytes have been received
+	for (i = 0; i < sizeof(Command) - 1; i++) TEST_ASSERT(TestReceiveProtocolByte(Command[i], Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(Command[i], Answer, sizeof(Answer)) == 2 + PROFILER_SECTION_PAYLOAD_SIZE);
+	TEST_ASSERT(Answer[0] == PROTOCOL_MAGIC_NUMBER);
+	TEST_ASSERT(Answer[1] == TEST_PROFILER_COMMAND_GET_TASK_PROFILE);
+	TestProfilerDecodeSection(&Answer[2], &Section);
+	TEST_ASSERT(Section.Section_ID == PROFILER_SECTION_ID_UART_RECEPTION_INTERRUPT);
+	TEST_ASSERT(Section.Sections_Count == PROFILER_SECTION_IDS_COUNT);
+	TEST_ASSERT(Section.Cycles_Per_Count == TIMER_PRESCALER);
+	TEST_ASSERT(Section.Calls_Count == sizeof(Command));
+	
+	// An unknown section has no statistics, but the server can still learn how many sections exist
+	Command[2] = PROFILER_SECTION_IDS_COUNT;
+	for (i = 0; i < sizeof(Command) - 1; i++) TEST_ASSERT(TestReceiveProtocolByte(Command[i], Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(Command[i], Answer, sizeof(Answer)) == 2 + PROFILER_SECTION_PAYLOAD_SIZE);
+	TestProfilerDecodeSection(&Answer[2], &Section);
+	TEST_ASSERT(Section.Section_ID == PROFILER_SECTION_IDS_COUNT);
+	TEST_ASSERT(Section.Sections_Count == PROFILER_SECTION_IDS_COUNT);
+	TEST_ASSERT(Section.Calls_Count == 0);
+	return 0;
+}
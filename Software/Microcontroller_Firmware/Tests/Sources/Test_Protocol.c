@@ -0,0 +1,334 @@
+/** @file Test_Protocol.c
+ * Feed the protocol reception interrupt byte by byte and check the answers, then drive the ESP8266 connection sequence.
+ * @author Adrien RICCIARDI
+ */
+#include <Configuration.h>
+#include <Protocol.h>
+#include <Registers.h>
+#include <Settings.h>
+#include <string.h>
+#include <Telemetry.h>
+#include <Test.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The command codes used by the tests, they are part of the protocol so they never change. */
+#define TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION 0
+#define TEST_PROTOCOL_COMMAND_GET_HEATING_CURVE_PARAMETERS 11
+#define TEST_PROTOCOL_COMMAND_SET_HEATING_CURVE_PARAMETERS 12
+
+/** How many link task runs make a second. */
+#define TEST_PROTOCOL_LINK_TASK_RUNS_PER_SECOND (1000 / CONFIGURATION_SCHEDULER_PROTOCOL_LINK_TASK_PERIOD)
+
+/** Enough runs for any connection step to time out. */
+#define TEST_PROTOCOL_MAXIMUM_LINK_TASK_RUNS 1000
+
+/** The biggest answer size (the telemetry block one), the protocol waits for this room in the transmission buffer before executing a command. */
+#define TEST_PROTOCOL_ANSWER_MAXIMUM_SIZE (2 + TELEMETRY_BLOCK_PAYLOAD_SIZE)
+/** How many 3-byte firmware version answers can be queued before the biggest answer does not fit in the transmission buffer anymore. */
+#define TEST_PROTOCOL_TRANSMISSION_BUFFER_ANSWERS_COUNT ((CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE - 1 - TEST_PROTOCOL_ANSWER_MAXIMUM_SIZE) / 3 + 1)
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Give a string to the reception interrupt.
+ * @param String The received characters.
+ */
+static void TestProtocolReceiveString(const char *String)
+{
+	while (*String != 0)
+	{
+		RegistersReceiveUARTByte(*String);
+		String++;
+	}
+}
+
+/** Run the link task until it sends something.
+ * @param String_Expected_Command The string that must be sent.
+ * @return 0 if the expected string has been sent,
+ * @return 1 if something else or nothing has been sent.
+ */
+static int TestProtocolWaitForLinkCommand(const char *String_Expected_Command)
+{
+	unsigned char Buffer[128];
+	int i, Size;
+	
+	for (i = 0; i < TEST_PROTOCOL_MAXIMUM_LINK_TASK_RUNS; i++)
+	{
+		Size = TestRunProtocolLinkTask(1, Buffer, sizeof(Buffer));
+		if (Size == 0) continue;
+		
+		if ((Size != (int) strlen(String_Expected_Command)) || (memcmp(Buffer, String_Expected_Command, Size) != 0))
+		{
+			printf("Expected link command \"%s\", got %d other bytes.\n", String_Expected_Command, Size);
+			return 1;
+		}
+		return 0;
+	}
+	printf("Link command \"%s\" has never been sent.\n", String_Expected_Command);
+	return 1;
+}
+
+/** Run the whole connection sequence, the ESP8266 accepting all commands.
+ * @return 0 if the board is connected to the server,
+ * @return 1 if the connection failed.
+ */
+static int TestProtocolConnect(void)
+{
+	unsigned char Buffer[16];
+	
+	ProtocolInitialize();
+	TEST_ASSERT(!ProtocolIsConnected());
+	
+	// The "+++" sequence step succeeds when its timeout expires
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("+++") == 0);
+	TEST_ASSERT(TestRunProtocolLinkTask(2 * TEST_PROTOCOL_LINK_TASK_RUNS_PER_SECOND, Buffer, sizeof(Buffer)) == 0);
+	
+	// The other steps wait for the ESP8266 answer, which is received in several parts like on the real UART
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+RST\r\n") == 0);
+	TestProtocolReceiveString("\x12\x34garbage from the ESP8266 boot at 74880 bit/s");
+	TestProtocolReceiveString("\r\nread");
+	TEST_ASSERT(TestRunProtocolLinkTask(5, Buffer, sizeof(Buffer)) == 0);
+	TestProtocolReceiveString("y\r\n");
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CWMODE_CUR=3\r\n") == 0);
+	TestProtocolReceiveString("\r\nOK\r\n");
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CWJAP_CUR=\"" CONFIGURATION_PROTOCOL_WIFI_ACCESS_POINT_SSID "\",\"" CONFIGURATION_PROTOCOL_WIFI_ACCESS_POINT_PASSWORD "\"\r\n") == 0);
+	TestProtocolReceiveString("WIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n");
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPSTART=\"TCP\",\"" CONFIGURATION_PROTOCOL_WIFI_SERVER_ADDRESS "\"," CONFIGURATION_PROTOCOL_WIFI_SERVER_PORT "\r\n") == 0);
+	TestProtocolReceiveString("CONNECT\r\n\r\nOK\r\n");
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPMODE=1\r\n") == 0);
+	TestProtocolReceiveString("\r\nOK\r\n");
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPSEND\r\n") == 0);
+	TEST_ASSERT(!ProtocolIsConnected());
+	TestProtocolReceiveString("\r\nOK\r\n> ");
+	
+	// The board announces itself as soon as it is connected
+	TEST_ASSERT(TestRunProtocolLinkTask(1, Buffer, sizeof(Buffer)) == 3);
+	TEST_ASSERT(Buffer[0] == PROTOCOL_MAGIC_NUMBER);
+	TEST_ASSERT(Buffer[1] == PROTOCOL_BOARD_ANNOUNCEMENT_CODE);
+	TEST_ASSERT(Buffer[2] == CONFIGURATION_PROTOCOL_BOARD_ID);
+	TEST_ASSERT(ProtocolIsConnected());
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int TestProtocolCommandReceivedByteByByte(void)
+{
+	unsigned char Answer[32];
+	
+	SettingsInitialize();
+	ProtocolSimulateConnection();
+	
+	// Nothing is answered until the command is complete
+	TEST_ASSERT(TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(!ProtocolIsCommandPending());
+	TEST_ASSERT(TestReceiveProtocolByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION, Answer, sizeof(Answer)) == 3);
+	TEST_ASSERT(Answer[0] == PROTOCOL_MAGIC_NUMBER);
+	TEST_ASSERT(Answer[1] == TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION);
+	TEST_ASSERT(Answer[2] == CONFIGURATION_FIRMWARE_VERSION);
+	TEST_ASSERT(!ProtocolIsCommandPending());
+	return 0;
+}
+
+int TestProtocolGarbageIsIgnored(void)
+{
+	static unsigned char Garbage[] = { 0x00, 0x12, 0xFF, 0x5A, PROTOCOL_MAGIC_NUMBER, 0xFF, 0x00, PROTOCOL_MAGIC_NUMBER, PROTOCOL_MAGIC_NUMBER, TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION };
+	unsigned char Answer[32];
+	unsigned int i;
+	
+	SettingsInitialize();
+	ProtocolSimulateConnection();
+	
+	// Unknown commands abort the reception, so the bytes following them are not taken as a command
+	for (i = 0; i < sizeof(Garbage); i++) TEST_ASSERT(TestReceiveProtocolByte(Garbage[i], Answer, sizeof(Answer)) == 0);
+	
+	// The next valid command is still decoded
+	TEST_ASSERT(TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(TEST_PROTOCOL_COMMAND_GET_HEATING_CURVE_PARAMETERS, Answer, sizeof(Answer)) == 6);
+	TEST_ASSERT(Answer[0] == PROTOCOL_MAGIC_NUMBER);
+	TEST_ASSERT(Answer[1] == TEST_PROTOCOL_COMMAND_GET_HEATING_CURVE_PARAMETERS);
+	TEST_ASSERT(Answer[2] == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT);
+	TEST_ASSERT(Answer[3] == 0);
+	TEST_ASSERT(Answer[4] == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_PARALLEL_SHIFT);
+	TEST_ASSERT(Answer[5] == 0);
+	return 0;
+}
+
+int TestProtocolPayloadReceivedByteByByte(void)
+{
+	static unsigned char Command[] = { PROTOCOL_MAGIC_NUMBER, TEST_PROTOCOL_COMMAND_SET_HEATING_CURVE_PARAMETERS, 20, 0, 5, 1 };
+	unsigned char Answer[32];
+	unsigned int i;
+	
+	SettingsInitialize();
+	ProtocolSimulateConnection();
+	
+	// The command is executed only when its whole payload has been received
+	for (i = 0; i < sizeof(Command) - 1; i++) TEST_ASSERT(TestReceiveProtocolByte(Command[i], Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT);
+	TEST_ASSERT(TestReceiveProtocolByte(Command[i], Answer, sizeof(Answer)) == 2);
+	TEST_ASSERT(Answer[0] == PROTOCOL_MAGIC_NUMBER);
+	TEST_ASSERT(Answer[1] == TEST_PROTOCOL_COMMAND_SET_HEATING_CURVE_PARAMETERS);
+	
+	// Payload bytes equal to the magic number or to a command code are not decoded as a new command
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == 20);
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Parallel_Shift == 0x0105);
+	return 0;
+}
+
+int TestProtocolQueuedCommands(void)
+{
+	unsigned char Answer[64];
+	int i;
+	
+	SettingsInitialize();
+	ProtocolSimulateConnection();
+	
+	// Receive more commands than the queue can hold while the main loop is busy, one slot is always used for the command being received
+	for (i = 0; i < CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE; i++)
+	{
+		RegistersReceiveUARTByte(PROTOCOL_MAGIC_NUMBER);
+		RegistersReceiveUARTByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION);
+	}
+	TEST_ASSERT(ProtocolIsCommandPending());
+	
+	// The commands that did not fit are lost
+	ProtocolTask();
+	TEST_ASSERT(!ProtocolIsCommandPending());
+	TEST_ASSERT(RegistersTransmitUARTBytes(Answer, sizeof(Answer)) == 3 * (CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE - 1));
+	for (i = 0; i < CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE - 1; i++)
+	{
+		TEST_ASSERT(Answer[3 * i] == PROTOCOL_MAGIC_NUMBER);
+		TEST_ASSERT(Answer[3 * i + 1] == TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION);
+		TEST_ASSERT(Answer[3 * i + 2] == CONFIGURATION_FIRMWARE_VERSION);
+	}
+	
+	// The queue is usable again
+	TEST_ASSERT(TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION, Answer, sizeof(Answer)) == 3);
+	return 0;
+}
+
+int TestProtocolTransmissionBufferFull(void)
+{
+	unsigned char Answer[CONFIGURATION_PROTOCOL_TRANSMISSION_BUFFER_SIZE];
+	int i;
+	
+	SettingsInitialize();
+	ProtocolSimulateConnection();
+	
+	// Execute commands while the UART is not sending, until their answers fill the transmission buffer
+	for (i = 0; i < TEST_PROTOCOL_TRANSMISSION_BUFFER_ANSWERS_COUNT; i++)
+	{
+		RegistersReceiveUARTByte(PROTOCOL_MAGIC_NUMBER);
+		RegistersReceiveUARTByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION);
+		ProtocolTask();
+		TEST_ASSERT(!ProtocolIsCommandPending());
+	}
+	
+	// The next command waits for room, it must not be reported as pending or the main loop would never sleep
+	RegistersReceiveUARTByte(PROTOCOL_MAGIC_NUMBER);
+	RegistersReceiveUARTByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION);
+	for (i = 0; i < 10; i++)
+	{
+		ProtocolTask();
+		TEST_ASSERT(!ProtocolIsCommandPending());
+	}
+	
+	// Sending the previous answers makes room, so the command can be executed
+	TEST_ASSERT(RegistersTransmitUARTBytes(Answer, sizeof(Answer)) == 3 * TEST_PROTOCOL_TRANSMISSION_BUFFER_ANSWERS_COUNT);
+	TEST_ASSERT(ProtocolIsCommandPending());
+	ProtocolTask();
+	TEST_ASSERT(!ProtocolIsCommandPending());
+	TEST_ASSERT(RegistersTransmitUARTBytes(Answer, sizeof(Answer)) == 3);
+	TEST_ASSERT(Answer[0] == PROTOCOL_MAGIC_NUMBER);
+	TEST_ASSERT(Answer[1] == TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION);
+	TEST_ASSERT(Answer[2] == CONFIGURATION_FIRMWARE_VERSION);
+	return 0;
+}
+
+int TestProtocolLinkConnection(void)
+{
+	unsigned char Answer[32];
+	
+	SettingsInitialize();
+	
+	// Commands are ignored until the board is connected
+	ProtocolInitialize();
+	TEST_ASSERT(TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(!ProtocolIsCommandPending());
+	
+	TEST_ASSERT(TestProtocolConnect() == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION, Answer, sizeof(Answer)) == 3);
+	
+	// The ESP8266 tells that the server closed the connection, the board reconnects to the server without resetting the ESP8266
+	TestProtocolReceiveString("CLOSED\r\n");
+	TEST_ASSERT(TestRunProtocolLinkTask(1, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(!ProtocolIsConnected());
+	TEST_ASSERT(TestRunProtocolLinkTask(CONFIGURATION_PROTOCOL_LINK_MINIMUM_RETRY_DELAY * TEST_PROTOCOL_LINK_TASK_RUNS_PER_SECOND - 1, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("+++") == 0);
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPCLOSE\r\n") == 0);
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPSTART=\"TCP\",\"" CONFIGURATION_PROTOCOL_WIFI_SERVER_ADDRESS "\"," CONFIGURATION_PROTOCOL_WIFI_SERVER_PORT "\r\n") == 0);
+	return 0;
+}
+
+int TestProtocolLinkInactivity(void)
+{
+	unsigned char Answer[32];
+	int Inactivity_Runs_Count;
+	
+	SettingsInitialize();
+	TEST_ASSERT(TestProtocolConnect() == 0);
+	Inactivity_Runs_Count = CONFIGURATION_PROTOCOL_LINK_INACTIVITY_TIMEOUT * TEST_PROTOCOL_LINK_TASK_RUNS_PER_SECOND;
+	
+	// A command received just before the timeout keeps the link up
+	TEST_ASSERT(TestRunProtocolLinkTask(Inactivity_Runs_Count - 1, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION, Answer, sizeof(Answer)) == 3);
+	TEST_ASSERT(TestRunProtocolLinkTask(Inactivity_Runs_Count, Answer, sizeof(Answer)) == 0); // The first run notices the received command
+	TEST_ASSERT(ProtocolIsConnected());
+	
+	// A silent server is considered lost
+	TEST_ASSERT(TestRunProtocolLinkTask(1, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(!ProtocolIsConnected());
+	return 0;
+}
+
+int TestProtocolLinkReconnectionDropsPartialCommand(void)
+{
+	unsigned char Answer[32];
+	
+	SettingsInitialize();
+	TEST_ASSERT(TestProtocolConnect() == 0);
+	
+	// The link is lost while a command is being received
+	TEST_ASSERT(TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(TEST_PROTOCOL_COMMAND_SET_HEATING_CURVE_PARAMETERS, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(20, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestRunProtocolLinkTask(CONFIGURATION_PROTOCOL_LINK_INACTIVITY_TIMEOUT * TEST_PROTOCOL_LINK_TASK_RUNS_PER_SECOND + 1, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(!ProtocolIsConnected());
+	
+	// Reconnect to the server
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("+++") == 0);
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPCLOSE\r\n") == 0);
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPSTART=\"TCP\",\"" CONFIGURATION_PROTOCOL_WIFI_SERVER_ADDRESS "\"," CONFIGURATION_PROTOCOL_WIFI_SERVER_PORT "\r\n") == 0);
+	TestProtocolReceiveString("CONNECT\r\n\r\nOK\r\n");
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPMODE=1\r\n") == 0);
+	TestProtocolReceiveString("\r\nOK\r\n");
+	TEST_ASSERT(TestProtocolWaitForLinkCommand("AT+CIPSEND\r\n") == 0);
+	TestProtocolReceiveString("\r\nOK\r\n> ");
+	TEST_ASSERT(TestRunProtocolLinkTask(1, Answer, sizeof(Answer)) == 3); // The board announcement
+	TEST_ASSERT(ProtocolIsConnected());
+	
+	// The first command sent on the new connection is not taken for the end of the interrupted one
+	TEST_ASSERT(TestReceiveProtocolByte(PROTOCOL_MAGIC_NUMBER, Answer, sizeof(Answer)) == 0);
+	TEST_ASSERT(TestReceiveProtocolByte(TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION, Answer, sizeof(Answer)) == 3);
+	TEST_ASSERT(Answer[1] == TEST_PROTOCOL_COMMAND_GET_FIRMWARE_VERSION);
+	TEST_ASSERT(SettingsGet()->Heating_Curve_Coefficient == CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT);
+	return 0;
+}
@@ -0,0 +1,208 @@
+/** @file Test_Temperature.c
+ * Check the heating curve computation from the sampled sensors and trimmers values.
+ * @author Adrien RICCIARDI
+ */
+#include <ADC.h>
+#include <Configuration.h>
+#include <Registers.h>
+#include <Settings.h>
+#include <Temperature.h>
+#include <Temperature_Tables.h>
+#include <Test.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** An outside thermistor raw value converting to 0.4°C. */
+#define TEST_TEMPERATURE_OUTSIDE_MILD_RAW_VALUE 500
+/** An outside thermistor raw value converting to -10°C. */
+#define TEST_TEMPERATURE_OUTSIDE_COLD_RAW_VALUE 516
+/** An outside thermistor raw value converting to -20.4°C. */
+#define TEST_TEMPERATURE_OUTSIDE_VERY_COLD_RAW_VALUE 532
+/** An outside thermistor raw value converting to 65.7°C. */
+#define TEST_TEMPERATURE_OUTSIDE_HOT_RAW_VALUE 400
+
+/** A day trimmer raw value converting to a 0.4°C offset, it rounds to the reference temperature. */
+#define TEST_TEMPERATURE_DAY_TRIMMER_BELOW_BOUNDARY_RAW_VALUE 342
+/** A day trimmer raw value converting to a 0.5°C offset, it rounds to the next degree. */
+#define TEST_TEMPERATURE_DAY_TRIMMER_ABOVE_BOUNDARY_RAW_VALUE 343
+/** A day trimmer raw value converting to a 1°C offset. */
+#define TEST_TEMPERATURE_DAY_TRIMMER_NEXT_DEGREE_RAW_VALUE 350
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Boot the modules the temperature module relies on, with the trimmers set to the reference temperature.
+ * @param Outside_Raw_Value The outside thermistor ADC value.
+ */
+static void TestTemperatureInitialize(unsigned short Outside_Raw_Value)
+{
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_OUTSIDE_THERMISTOR, Outside_Raw_Value);
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_DAY_TRIMMER, TEST_DAY_TRIMMER_REFERENCE_RAW_VALUE);
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_NIGHT_TRIMMER, TEST_NIGHT_TRIMMER_REFERENCE_RAW_VALUE);
+	ADCInitialize();
+	SettingsInitialize();
+	TemperatureInitialize();
+}
+
+/** Change the outside temperature and wait for the moving average to reach it.
+ * @param Outside_Raw_Value The outside thermistor ADC value.
+ */
+static void TestTemperatureSetOutsideRawValue(unsigned short Outside_Raw_Value)
+{
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_OUTSIDE_THERMISTOR, Outside_Raw_Value);
+	TestSampleAllChannels();
+}
+
+/** Move the day trimmer, then let the temperature task read it and the settings task save the desired temperatures.
+ * @param Day_Trimmer_Raw_Value The day trimmer ADC value.
+ * @return The desired day temperature.
+ */
+static signed char TestTemperatureMoveDayTrimmer(unsigned short Day_Trimmer_Raw_Value)
+{
+	signed char Day_Temperature, Night_Temperature;
+	
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_DAY_TRIMMER, Day_Trimmer_Raw_Value);
+	TestSampleAllChannels();
+	TemperatureTask();
+	SettingsTask();
+	RegistersRunEEPROMInterrupts();
+	
+	TemperatureGetDesiredRoomTemperatures(&Day_Temperature, &Night_Temperature);
+	return Day_Temperature;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int TestTemperatureHeatingCurve(void)
+{
+	signed short Outside_Temperature;
+	signed char Day_Temperature, Night_Temperature;
+	
+	TestTemperatureInitialize(TEST_TEMPERATURE_OUTSIDE_MILD_RAW_VALUE);
+	TEST_ASSERT(TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_OUTSIDE) == 0);
+	TemperatureGetDesiredRoomTemperatures(&Day_Temperature, &Night_Temperature);
+	TEST_ASSERT(Day_Temperature == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE);
+	TEST_ASSERT(Night_Temperature == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE);
+	
+	// The outside temperature tenths are used : (1.4 * (20 - 0.4) + 15) rounded down
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == 42);
+	
+	TestTemperatureSetOutsideRawValue(TEST_TEMPERATURE_OUTSIDE_COLD_RAW_VALUE);
+	TEST_ASSERT(TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_OUTSIDE) == -10);
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == 57);
+	
+	// The result is kept in the allowed water temperature range
+	TestTemperatureSetOutsideRawValue(TEST_TEMPERATURE_OUTSIDE_VERY_COLD_RAW_VALUE);
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == CONFIGURATION_HEATING_CURVE_MAXIMUM_TEMPERATURE);
+	TestTemperatureSetOutsideRawValue(TEST_TEMPERATURE_OUTSIDE_HOT_RAW_VALUE);
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == CONFIGURATION_HEATING_CURVE_MINIMUM_TEMPERATURE);
+	
+	// Oversampling bits interpolate between two table values, a single sample moves the average to the first quarter between the two raw values
+	TestTemperatureSetOutsideRawValue(TEST_TEMPERATURE_OUTSIDE_MILD_RAW_VALUE);
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_OUTSIDE_THERMISTOR, TEST_TEMPERATURE_OUTSIDE_MILD_RAW_VALUE + 4);
+	ADCTask();
+	RegistersRunADCInterrupts();
+	TEST_ASSERT(ADCGetLastOversampledValue(ADC_CHANNEL_ID_OUTSIDE_THERMISTOR) == (TEST_TEMPERATURE_OUTSIDE_MILD_RAW_VALUE << CONFIGURATION_ADC_OVERSAMPLING_EXTRA_BITS) + 1);
+	Outside_Temperature = Temperature_Tables_Outside_Thermistor[TEST_TEMPERATURE_OUTSIDE_MILD_RAW_VALUE];
+	Outside_Temperature += (Temperature_Tables_Outside_Thermistor[TEST_TEMPERATURE_OUTSIDE_MILD_RAW_VALUE + 1] - Outside_Temperature) / 4;
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == (CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_COEFFICIENT * (CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE * 10 - Outside_Temperature) + CONFIGURATION_SETTINGS_DEFAULT_HEATING_CURVE_PARALLEL_SHIFT * 10) / 100);
+	
+	// Moving the day trimmer by 4.5°C changes the desired temperature
+	TestTemperatureSetOutsideRawValue(TEST_TEMPERATURE_OUTSIDE_COLD_RAW_VALUE);
+	RegistersSetADCChannelValue(TEST_ADC_CHANNEL_DAY_TRIMMER, 400);
+	TestSampleAllChannels();
+	TemperatureTask();
+	TemperatureGetDesiredRoomTemperatures(&Day_Temperature, &Night_Temperature);
+	TEST_ASSERT(Day_Temperature == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE + 5);
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == 64);
+	return 0;
+}
+
+int TestTemperatureNightMode(void)
+{
+	TSettings Settings;
+	
+	TestTemperatureInitialize(TEST_TEMPERATURE_OUTSIDE_COLD_RAW_VALUE);
+	TemperatureSetDesiredRoomTemperatures(21, 16);
+	
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == 58);
+	
+	// The night temperature is used as soon as the night mode is enabled
+	Settings = *SettingsGet();
+	Settings.Is_Night_Mode_Enabled = 1;
+	SettingsSet(&Settings);
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == 51);
+	
+	// The desired temperatures set by the server are kept as long as the trimmers do not move
+	TestSampleAllChannels();
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == 51);
+	return 0;
+}
+
+int TestTemperatureHeatingCurveParameters(void)
+{
+	unsigned short Coefficient, Parallel_Shift;
+	
+	TestTemperatureInitialize(TEST_TEMPERATURE_OUTSIDE_COLD_RAW_VALUE);
+	TemperatureSetHeatingCurveParameters(20, 50);
+	TemperatureGetHeatingCurveParameters(&Coefficient, &Parallel_Shift);
+	TEST_ASSERT(Coefficient == 20);
+	TEST_ASSERT(Parallel_Shift == 50);
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == 65);
+	
+	// A steep curve must not overflow before the result is clamped
+	TemperatureSetHeatingCurveParameters(40, 0);
+	TestTemperatureSetOutsideRawValue(TEST_TEMPERATURE_OUTSIDE_VERY_COLD_RAW_VALUE);
+	TemperatureTask();
+	TEST_ASSERT(TemperatureGetTargetStartWaterTemperature() == CONFIGURATION_HEATING_CURVE_MAXIMUM_TEMPERATURE);
+	return 0;
+}
+
+int TestTemperatureTrimmerHysteresis(void)
+{
+	TRegistersCounters Counters;
+	signed char Day_Temperature, Night_Temperature;
+	int i;
+	
+	TestTemperatureInitialize(TEST_TEMPERATURE_OUTSIDE_MILD_RAW_VALUE);
+	TEST_ASSERT(TemperatureGetSensorValue(TEMPERATURE_SENSOR_ID_OUTSIDE) == 0); // Make sure the sensors have been sampled before counting the EEPROM writes
+	RegistersResetCounters();
+	
+	// The trimmer flickers on each side of the boundary between two degrees, without any effect
+	for (i = 0; i < 20; i++)
+	{
+		TEST_ASSERT(TestTemperatureMoveDayTrimmer(TEST_TEMPERATURE_DAY_TRIMMER_ABOVE_BOUNDARY_RAW_VALUE) == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE);
+		TEST_ASSERT(TestTemperatureMoveDayTrimmer(TEST_TEMPERATURE_DAY_TRIMMER_BELOW_BOUNDARY_RAW_VALUE) == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE);
+	}
+	RegistersGetCounters(&Counters);
+	TEST_ASSERT(Counters.EEPROM_Writes_Count == 0);
+	
+	// Moving the trimmer further selects the next degree, the night temperature follows the day one
+	TEST_ASSERT(TestTemperatureMoveDayTrimmer(TEST_TEMPERATURE_DAY_TRIMMER_NEXT_DEGREE_RAW_VALUE) == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE + 1);
+	TemperatureGetDesiredRoomTemperatures(&Day_Temperature, &Night_Temperature);
+	TEST_ASSERT(Night_Temperature == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE + 1);
+	RegistersGetCounters(&Counters);
+	TEST_ASSERT(Counters.EEPROM_Writes_Count > 0);
+	
+	// The new degree is kept when the trimmer flickers around the same boundary again
+	RegistersResetCounters();
+	for (i = 0; i < 20; i++)
+	{
+		TEST_ASSERT(TestTemperatureMoveDayTrimmer(TEST_TEMPERATURE_DAY_TRIMMER_BELOW_BOUNDARY_RAW_VALUE) == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE + 1);
+		TEST_ASSERT(TestTemperatureMoveDayTrimmer(TEST_TEMPERATURE_DAY_TRIMMER_ABOVE_BOUNDARY_RAW_VALUE) == CONFIGURATION_TRIMMERS_REFERENCE_TEMPERATURE + 1);
+	}
+	RegistersGetCounters(&Counters);
+	TEST_ASSERT(Counters.EEPROM_Writes_Count == 0);
+	return 0;
+}
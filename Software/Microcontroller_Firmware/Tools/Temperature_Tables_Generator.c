@@ -0,0 +1,203 @@
+/** @file Temperature_Tables_Generator.c
+ * Generate the tables converting the 10-bit ADC values of each sensor to temperatures, so the firmware does not need any multiplication or division to convert a value.
+ * Each sensor is described by calibration points, the temperature between two points is linearly interpolated and the temperature outside of the points range follows the nearest segment.
+ * @author Adrien RICCIARDI
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many values the ADC can provide. */
+#define TEMPERATURE_TABLES_GENERATOR_ADC_VALUES_COUNT 1024
+/** The lowest temperature a table can hold, in tenths of °C (converted temperatures must fit in a signed char). */
+#define TEMPERATURE_TABLES_GENERATOR_MINIMUM_TEMPERATURE -1280
+/** The highest temperature a table can hold, in tenths of °C. */
+#define TEMPERATURE_TABLES_GENERATOR_MAXIMUM_TEMPERATURE 1270
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A sensor calibration point. */
+typedef struct
+{
+	int ADC_Value; //!< The 10-bit value sampled by the ADC.
+	int Temperature; //!< The matching temperature in tenths of °C.
+} TTemperatureTablesGeneratorPoint;
+
+/** A sensor to generate a table for. */
+typedef struct
+{
+	const char *Pointer_String_Name; //!< The sensor name, used to name the table.
+	const char *Pointer_String_Description; //!< The table documentation.
+	int Points_Count; //!< How many calibration points there are, there must be at least two.
+	const TTemperatureTablesGeneratorPoint *Pointer_Points; //!< The calibration points, sorted by increasing ADC value.
+} TTemperatureTablesGeneratorSensor;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+// Datasheet tells that temperature is -10°C when thermistor resistance is 480ohm => measured voltage is 1.667V => ADC value is 516
+// Temperature is 20°C when thermistor resistance is 400ohm => measured voltage is 1.517 => ADC value is 470
+static const TTemperatureTablesGeneratorPoint Temperature_Tables_Generator_Outside_Thermistor_Points[] = { { 470, 200 }, { 516, -100 } };
+
+// Datasheet tells that temperature is 20°C when thermistor resistance is 770ohm => measured voltage is 1.436V => ADC value is 445
+// Temperature is 80°C when thermistor resistance is 580ohm => measured voltage is 1.211V => ADC value is 375
+static const TTemperatureTablesGeneratorPoint Temperature_Tables_Generator_Radiator_Start_Thermistor_Points[] = { { 375, 800 }, { 445, 200 } };
+
+// Datasheet tells that temperature is -4°C when trimmer resistance is 60ohm => measured voltage is 900mV => ADC value is 279
+// Temperature is +4°C when trimmer resistance is 100ohm => measured voltage is 1.269V => ADC value is 393
+static const TTemperatureTablesGeneratorPoint Temperature_Tables_Generator_Day_Trimmer_Points[] = { { 279, -40 }, { 393, 40 } };
+
+// Datasheet tells that temperature is 0°C when trimmer resistance is 5ohm => measured voltage is 100mV => ADC value is 31
+// Temperature is +8°C when trimmer resistance is 50ohm => measured voltage is 786mV => ADC value is 244
+static const TTemperatureTablesGeneratorPoint Temperature_Tables_Generator_Night_Trimmer_Points[] = { { 31, 0 }, { 244, 80 } };
+
+/** All sensors. The radiator return sensor has not been chosen yet, add its points here when it is known. */
+static const TTemperatureTablesGeneratorSensor Temperature_Tables_Generator_Sensors[] =
+{
+	{ "Outside_Thermistor", "The outside temperature.", sizeof(Temperature_Tables_Generator_Outside_Thermistor_Points) / sizeof(TTemperatureTablesGeneratorPoint), Temperature_Tables_Generator_Outside_Thermistor_Points },
+	{ "Radiator_Start_Thermistor", "The water temperature on the pipe going to the radiators.", sizeof(Temperature_Tables_Generator_Radiator_Start_Thermistor_Points) / sizeof(TTemperatureTablesGeneratorPoint), Temperature_Tables_Generator_Radiator_Start_Thermistor_Points },
+	{ "Day_Trimmer", "The day temperature offset added to the trimmers reference temperature.", sizeof(Temperature_Tables_Generator_Day_Trimmer_Points) / sizeof(TTemperatureTablesGeneratorPoint), Temperature_Tables_Generator_Day_Trimmer_Points },
+	{ "Night_Trimmer", "The temperature offset subtracted from the day temperature at night.", sizeof(Temperature_Tables_Generator_Night_Trimmer_Points) / sizeof(TTemperatureTablesGeneratorPoint), Temperature_Tables_Generator_Night_Trimmer_Points }
+};
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Compute the temperature matching an ADC value.
+ * @param Pointer_Sensor The sensor.
+ * @param ADC_Value The ADC value.
+ * @return The temperature in tenths of °C, clamped to the range a table can hold.
+ */
+static int TemperatureTablesGeneratorComputeTemperature(const TTemperatureTablesGeneratorSensor *Pointer_Sensor, int ADC_Value)
+{
+	const TTemperatureTablesGeneratorPoint *Pointer_First_Point, *Pointer_Second_Point;
+	int i;
+	double Temperature;
+	
+	// Find the segment the value belongs to, values outside of the calibration range use the first or the last segment
+	for (i = 1; i < Pointer_Sensor->Points_Count - 1; i++)
+	{
+		if (ADC_Value < Pointer_Sensor->Pointer_Points[i].ADC_Value) break;
+	}
+	Pointer_First_Point = &Pointer_Sensor->Pointer_Points[i - 1];
+	Pointer_Second_Point = &Pointer_Sensor->Pointer_Points[i];
+	
+	// Interpolate
+	Temperature = Pointer_First_Point->Temperature + (double) (Pointer_Second_Point->Temperature - Pointer_First_Point->Temperature) * (ADC_Value - Pointer_First_Point->ADC_Value) / (Pointer_Second_Point->ADC_Value - Pointer_First_Point->ADC_Value);
+	Temperature = round(Temperature);
+	
+	if (Temperature < TEMPERATURE_TABLES_GENERATOR_MINIMUM_TEMPERATURE) return TEMPERATURE_TABLES_GENERATOR_MINIMUM_TEMPERATURE;
+	if (Temperature > TEMPERATURE_TABLES_GENERATOR_MAXIMUM_TEMPERATURE) return TEMPERATURE_TABLES_GENERATOR_MAXIMUM_TEMPERATURE;
+	return (int) Temperature;
+}
+
+/** Make sure a sensor description can be used.
+ * @param Pointer_Sensor The sensor.
+ * @return -1 if the sensor is badly described,
+ * @return 0 on success.
+ */
+static int TemperatureTablesGeneratorCheckSensor(const TTemperatureTablesGeneratorSensor *Pointer_Sensor)
+{
+	int i;
+	
+	if (Pointer_Sensor->Points_Count < 2)
+	{
+		fprintf(stderr, "Error : sensor \"%s\" needs at least two calibration points.\n", Pointer_Sensor->Pointer_String_Name);
+		return -1;
+	}
+	for (i = 0; i < Pointer_Sensor->Points_Count; i++)
+	{
+		if ((Pointer_Sensor->Pointer_Points[i].ADC_Value < 0) || (Pointer_Sensor->Pointer_Points[i].ADC_Value >= TEMPERATURE_TABLES_GENERATOR_ADC_VALUES_COUNT))
+		{
+			fprintf(stderr, "Error : sensor \"%s\" calibration point %d ADC value is out of range.\n", Pointer_Sensor->Pointer_String_Name, i);
+			return -1;
+		}
+		if ((i > 0) && (Pointer_Sensor->Pointer_Points[i].ADC_Value <= Pointer_Sensor->Pointer_Points[i - 1].ADC_Value))
+		{
+			fprintf(stderr, "Error : sensor \"%s\" calibration points must be sorted by increasing ADC value.\n", Pointer_Sensor->Pointer_String_Name);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	FILE *Pointer_Source_File = NULL, *Pointer_Header_File = NULL;
+	const TTemperatureTablesGeneratorSensor *Pointer_Sensor;
+	int i, ADC_Value, Return_Value = EXIT_FAILURE;
+	
+	// Check parameters
+	if (argc != 3)
+	{
+		printf("Usage : %s Output_Source_File Output_Header_File\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	
+	// Create the output files
+	Pointer_Source_File = fopen(argv[1], "w");
+	if (Pointer_Source_File == NULL)
+	{
+		fprintf(stderr, "Error : could not create source file \"%s\".\n", argv[1]);
+		goto Exit;
+	}
+	Pointer_Header_File = fopen(argv[2], "w");
+	if (Pointer_Header_File == NULL)
+	{
+		fprintf(stderr, "Error : could not create header file \"%s\".\n", argv[2]);
+		goto Exit;
+	}
+	
+	// Write the files beginning
+	fputs("/** @file Temperature_Tables.c\n * The temperature conversion tables. This file is generated by the temperature tables generator, do not edit it.\n */\n"
+		"#include <Temperature_Tables.h>\n", Pointer_Source_File);
+	fprintf(Pointer_Header_File, "/** @file Temperature_Tables.h\n * The temperature conversion tables, stored in flash memory (read them with pgm_read_word()). They are indexed by the 10-bit ADC value and hold temperatures in tenths of °C. This file is generated by the temperature tables generator, do not edit it.\n */\n"
+		"#ifndef H_TEMPERATURE_TABLES_H\n#define H_TEMPERATURE_TABLES_H\n\n#include <avr/pgmspace.h>\n\n"
+		"/** How many values each table holds. */\n#define TEMPERATURE_TABLES_VALUES_COUNT %d\n\n", TEMPERATURE_TABLES_GENERATOR_ADC_VALUES_COUNT);
+	
+	// Generate all tables
+	for (i = 0; i < (int) (sizeof(Temperature_Tables_Generator_Sensors) / sizeof(TTemperatureTablesGeneratorSensor)); i++)
+	{
+		Pointer_Sensor = &Temperature_Tables_Generator_Sensors[i];
+		if (TemperatureTablesGeneratorCheckSensor(Pointer_Sensor) != 0) goto Exit;
+		
+		fprintf(Pointer_Header_File, "/** %s */\nextern const signed short Temperature_Tables_%s[TEMPERATURE_TABLES_VALUES_COUNT] PROGMEM;\n\n", Pointer_Sensor->Pointer_String_Description, Pointer_Sensor->Pointer_String_Name);
+		
+		fprintf(Pointer_Source_File, "\nconst signed short Temperature_Tables_%s[TEMPERATURE_TABLES_VALUES_COUNT] PROGMEM =\n{", Pointer_Sensor->Pointer_String_Name);
+		for (ADC_Value = 0; ADC_Value < TEMPERATURE_TABLES_GENERATOR_ADC_VALUES_COUNT; ADC_Value++)
+		{
+			if (ADC_Value % 16 == 0) fputs("\n\t", Pointer_Source_File);
+			else fputc(' ', Pointer_Source_File);
+			fprintf(Pointer_Source_File, "%d%s", TemperatureTablesGeneratorComputeTemperature(Pointer_Sensor, ADC_Value), ADC_Value + 1 < TEMPERATURE_TABLES_GENERATOR_ADC_VALUES_COUNT ? "," : "");
+		}
+		fputs("\n};\n", Pointer_Source_File);
+	}
+	fputs("#endif\n", Pointer_Header_File);
+	
+	// Make sure everything has been written
+	if (ferror(Pointer_Source_File) || ferror(Pointer_Header_File))
+	{
+		fprintf(stderr, "Error : could not write the output files.\n");
+		goto Exit;
+	}
+	Return_Value = EXIT_SUCCESS;
+	
+Exit:
+	if ((Pointer_Source_File != NULL) && (fclose(Pointer_Source_File) != 0)) Return_Value = EXIT_FAILURE;
+	if ((Pointer_Header_File != NULL) && (fclose(Pointer_Header_File) != 0)) Return_Value = EXIT_FAILURE;
+	
+	// Do not let truncated files look up to date
+	if (Return_Value != EXIT_SUCCESS)
+	{
+		remove(argv[1]);
+		remove(argv[2]);
+	}
+	return Return_Value;
+}
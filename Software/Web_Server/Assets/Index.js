@@ -0,0 +1,14 @@
+// Display the temperatures selected with the sliders
+function updateDesiredDayTemperature()
+{
+	var temperature = document.getElementById("id_day_temperature").value;
+	temperature = temperature.concat("&deg;C");
+	document.getElementById("id_desired_day_temperature").innerHTML = temperature;
+}
+
+function updateDesiredNightTemperature()
+{
+	var temperature = document.getElementById("id_night_temperature").value;
+	temperature = temperature.concat("&deg;C");
+	document.getElementById("id_desired_night_temperature").innerHTML = temperature;
+}
@@ -0,0 +1,30 @@
+var boilerStatus = {};
+
+function updateMonitoring()
+{
+	document.getElementById("id_error").classList.toggle("hidden", boilerStatus.is_valid);
+	document.getElementById("id_values").classList.toggle("hidden", !boilerStatus.is_valid);
+	if (!boilerStatus.is_valid) return;
+
+	document.getElementById("id_outside_temperature").innerHTML = boilerStatus.outside_temperature + "&deg;C";
+	document.getElementById("id_radiator_start_water_temperature").innerHTML = boilerStatus.radiator_start_water_temperature + "&deg;C";
+	document.getElementById("id_target_radiator_start_water_temperature").innerHTML = boilerStatus.target_radiator_start_water_temperature + "&deg;C";
+	document.getElementById("id_heating_curve_coefficient").innerHTML = (boilerStatus.heating_curve_coefficient / 10).toFixed(1);
+	document.getElementById("id_heating_curve_parallel_shift").innerHTML = Math.trunc(boilerStatus.heating_curve_parallel_shift / 10);
+	document.getElementById("id_gas_burner").innerHTML = boilerStatus.is_gas_burner_on ? "allum&eacute;" : "&eacute;teint";
+	document.getElementById("id_pump").innerHTML = boilerStatus.is_pump_on ? "en marche" : "arr&ecirc;t&eacute;";
+	if (boilerStatus.is_mixing_valve_left_relay_on || boilerStatus.is_mixing_valve_right_relay_on) document.getElementById("id_mixing_valve").innerHTML = "en mouvement";
+	else document.getElementById("id_mixing_valve").innerHTML = { left: "gauche", center: "centre", right: "droite" }[boilerStatus.mixing_valve_position];
+}
+
+// The page is static, so it gets the monitored board from its own URL arguments
+document.getElementById("id_back_link").href = "/index.html" + location.search;
+
+// The page holds no values, the first event holds all of them and next events hold only the values that changed
+var eventSource = new EventSource("/events" + location.search);
+eventSource.addEventListener("status", function(event)
+{
+	var changes = JSON.parse(event.data);
+	for (var name in changes) boilerStatus[name] = changes[name];
+	updateMonitoring();
+});
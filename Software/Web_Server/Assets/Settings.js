@@ -0,0 +1,5 @@
+// Allow to send the form only when a heating curve has been selected
+function enableSubmitButton()
+{
+	document.getElementById("id_submit_button").disabled = false;
+}
@@ -0,0 +1,461 @@
+/** @file Load_Generator.c
+ * Send HTTP requests to the web server from several threads at the same time and report latency and server memory usage.
+ * Several URLs can be given, each one is measured on its own and all results can be written to a JSON file for later comparison.
+ * A request fails when the connection fails, when the answer status is not a success or a redirection, or when the answer is shorter than announced.
+ * @author Adrien RICCIARDI
+ */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many URLs can be measured in a single run. */
+#define LOAD_GENERATOR_MAXIMUM_URLS_COUNT 16
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** All data a client thread needs. */
+typedef struct
+{
+	pthread_t Thread; //!< The thread handle.
+	int Requests_Count; //!< How many requests to send.
+	double *Pointer_Latencies; //!< On output, contain the latency in milliseconds of each successful request.
+	int Successful_Requests_Count; //!< On output, tell how many requests succeeded.
+} TLoadGeneratorClient;
+
+/** The measures of a single URL. */
+typedef struct
+{
+	char *String_URL; //!< The requested URL.
+	int Requests_Count; //!< How many requests were sent.
+	int Successful_Requests_Count; //!< How many requests succeeded.
+	int Failed_Requests_Count; //!< How many requests failed (connection error, unexpected status code or short answer).
+	double Throughput; //!< How many requests were served per second.
+	double Latency_P50; //!< The median latency in milliseconds.
+	double Latency_P99; //!< The 99th percentile latency in milliseconds.
+	double Latency_P999; //!< The 99.9th percentile latency in milliseconds.
+	double Board_Round_Trips_Per_Request; //!< How many commands the board executed per successful request, negative if the board counter is not available.
+	long Server_RSS; //!< The server resident memory in KB after the run, -1 if not available.
+	long Server_Peak_RSS; //!< The server peak resident memory in KB after the run, -1 if not available.
+} TLoadGeneratorResult;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The web server address. */
+static struct sockaddr_in Load_Generator_Server_Address;
+/** The HTTP request to send, fully formatted. */
+static char Load_Generator_String_Request[512];
+/** The executed commands count published by the board simulator (NULL when no counter file is used). */
+static volatile unsigned long long *Load_Generator_Pointer_Board_Executed_Commands_Count = NULL;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get a monotonic time.
+ * @return The time in milliseconds.
+ */
+static double LoadGeneratorGetTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return Time.tv_sec * 1000. + Time.tv_nsec / 1000000.;
+}
+
+/** Send a request on a new connection, receive the whole answer and check it.
+ * @return -1 if an error occurred or if the answer is not a successful one,
+ * @return 0 on success.
+ */
+static int LoadGeneratorSendRequest(void)
+{
+	int Socket, Request_Size, Status_Code, Return_Value = -1;
+	char Buffer[4096], String_Headers[4096], *Pointer_String_Body, *Pointer_String_Content_Length;
+	ssize_t Size;
+	size_t Headers_Size = 0, Copied_Size;
+	unsigned long long Received_Size = 0, Body_Size;
+	
+	Socket = socket(AF_INET, SOCK_STREAM, 0);
+	if (Socket == -1) return -1;
+	if (connect(Socket, (const struct sockaddr *) &Load_Generator_Server_Address, sizeof(Load_Generator_Server_Address)) != 0) goto Exit;
+	
+	// Send the request
+	Request_Size = strlen(Load_Generator_String_Request);
+	if (write(Socket, Load_Generator_String_Request, Request_Size) != Request_Size) goto Exit;
+	
+	// The server closes the connection when the answer has been fully sent, keep the beginning of the answer to check the headers
+	do
+	{
+		Size = read(Socket, Buffer, sizeof(Buffer));
+		if (Size < 0) goto Exit;
+		
+		Copied_Size = sizeof(String_Headers) - 1 - Headers_Size;
+		if (Copied_Size > (size_t) Size) Copied_Size = Size;
+		memcpy(&String_Headers[Headers_Size], Buffer, Copied_Size);
+		Headers_Size += Copied_Size;
+		Received_Size += Size;
+	} while (Size > 0);
+	String_Headers[Headers_Size] = 0;
+	
+	// Only success and redirection status codes are expected
+	if (sscanf(String_Headers, "HTTP/1.%*d %d", &Status_Code) != 1) goto Exit;
+	if ((Status_Code < 200) || (Status_Code >= 400)) goto Exit;
+	
+	// The connection may have been closed before the whole answer was sent
+	Pointer_String_Body = strstr(String_Headers, "\r\n\r\n");
+	if (Pointer_String_Body == NULL) goto Exit;
+	Pointer_String_Body += 4;
+	Pointer_String_Content_Length = strstr(String_Headers, "\r\nContent-Length:");
+	if ((Pointer_String_Content_Length != NULL) && (Pointer_String_Content_Length < Pointer_String_Body))
+	{
+		Body_Size = Received_Size - (Pointer_String_Body - String_Headers);
+		if (Body_Size != strtoull(&Pointer_String_Content_Length[17], NULL, 10)) goto Exit;
+	}
+	Return_Value = 0;
+	
+Exit:
+	close(Socket);
+	return Return_Value;
+}
+
+/** Send all requests of a client.
+ * @param Pointer_Parameters The client data.
+ * @return Always NULL.
+ */
+static void *LoadGeneratorClientThread(void *Pointer_Parameters)
+{
+	TLoadGeneratorClient *Pointer_Client = Pointer_Parameters;
+	int i;
+	double Start_Time;
+	
+	for (i = 0; i < Pointer_Client->Requests_Count; i++)
+	{
+		Start_Time = LoadGeneratorGetTime();
+		if (LoadGeneratorSendRequest() != 0) continue;
+		Pointer_Client->Pointer_Latencies[Pointer_Client->Successful_Requests_Count] = LoadGeneratorGetTime() - Start_Time;
+		Pointer_Client->Successful_Requests_Count++;
+	}
+	
+	return NULL;
+}
+
+/** Compare two latencies for qsort().
+ * @param Pointer_A First latency.
+ * @param Pointer_B Second latency.
+ * @return A negative, null or positive value according to the latencies order.
+ */
+static int LoadGeneratorCompareLatencies(const void *Pointer_A, const void *Pointer_B)
+{
+	double A = *((const double *) Pointer_A), B = *((const double *) Pointer_B);
+	
+	if (A < B) return -1;
+	if (A > B) return 1;
+	return 0;
+}
+
+/** Read a memory value from the /proc status file of a process.
+ * @param Process_ID The process to inspect.
+ * @param String_Field_Name The field name including the colon, like "VmRSS:".
+ * @return The value in KB,
+ * @return -1 if the value could not be read.
+ */
+static long LoadGeneratorGetProcessMemory(int Process_ID, const char *String_Field_Name)
+{
+	char String_Path[64], String_Line[256];
+	FILE *Pointer_File;
+	long Value = -1;
+	size_t Field_Name_Length = strlen(String_Field_Name);
+	
+	snprintf(String_Path, sizeof(String_Path), "/proc/%d/status", Process_ID);
+	Pointer_File = fopen(String_Path, "r");
+	if (Pointer_File == NULL) return -1;
+	
+	while (fgets(String_Line, sizeof(String_Line), Pointer_File) != NULL)
+	{
+		if (strncmp(String_Line, String_Field_Name, Field_Name_Length) == 0)
+		{
+			Value = atol(&String_Line[Field_Name_Length]);
+			break;
+		}
+	}
+	
+	fclose(Pointer_File);
+	return Value;
+}
+
+/** Map the counter file the board simulator keeps its executed commands count in.
+ * @param String_File_Path The counter file path.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int LoadGeneratorMapBoardCounterFile(char *String_File_Path)
+{
+	int File_Descriptor;
+	void *Pointer_Mapping;
+	
+	File_Descriptor = open(String_File_Path, O_RDONLY);
+	if (File_Descriptor == -1)
+	{
+		printf("Error : failed to open board counter file '%s' (%s).\n", String_File_Path, strerror(errno));
+		return -1;
+	}
+	
+	// The mapping stays valid once the file is closed
+	Pointer_Mapping = mmap(NULL, sizeof(unsigned long long), PROT_READ, MAP_SHARED, File_Descriptor, 0);
+	close(File_Descriptor);
+	if (Pointer_Mapping == MAP_FAILED)
+	{
+		printf("Error : failed to map board counter file (%s).\n", strerror(errno));
+		return -1;
+	}
+	Load_Generator_Pointer_Board_Executed_Commands_Count = Pointer_Mapping;
+	return 0;
+}
+
+/** Load the server with requests to a single URL and compute the statistics.
+ * @param String_URL The URL to request.
+ * @param Pointer_Clients The client threads, there must be Threads_Count of them.
+ * @param Threads_Count How many threads send requests at the same time.
+ * @param Requests_Count How many requests each thread sends.
+ * @param Pointer_Latencies Room for Threads_Count * Requests_Count latencies.
+ * @param Server_Process_ID The server process to read memory usage from, or -1 if unknown.
+ * @param Pointer_Result On output, contain the measures.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int LoadGeneratorRunScenario(char *String_URL, TLoadGeneratorClient *Pointer_Clients, int Threads_Count, int Requests_Count, double *Pointer_Latencies, int Server_Process_ID, TLoadGeneratorResult *Pointer_Result)
+{
+	int i, Total_Requests_Count = 0;
+	double Start_Time, Duration;
+	unsigned long long Initial_Board_Commands_Count = 0;
+	
+	snprintf(Load_Generator_String_Request, sizeof(Load_Generator_String_Request), "GET %s HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n", String_URL);
+	memset(Pointer_Clients, 0, sizeof(TLoadGeneratorClient) * Threads_Count);
+	if (Load_Generator_Pointer_Board_Executed_Commands_Count != NULL) Initial_Board_Commands_Count = *Load_Generator_Pointer_Board_Executed_Commands_Count;
+	
+	// Run all clients at the same time
+	Start_Time = LoadGeneratorGetTime();
+	for (i = 0; i < Threads_Count; i++)
+	{
+		Pointer_Clients[i].Requests_Count = Requests_Count;
+		Pointer_Clients[i].Pointer_Latencies = &Pointer_Latencies[i * Requests_Count];
+		if (pthread_create(&Pointer_Clients[i].Thread, NULL, LoadGeneratorClientThread, &Pointer_Clients[i]) != 0)
+		{
+			printf("Error : failed to create client thread (%s).\n", strerror(errno));
+			return -1;
+		}
+	}
+	for (i = 0; i < Threads_Count; i++) pthread_join(Pointer_Clients[i].Thread, NULL);
+	Duration = LoadGeneratorGetTime() - Start_Time;
+	
+	// Gather all successful requests latencies at the beginning of the array
+	for (i = 0; i < Threads_Count; i++)
+	{
+		memmove(&Pointer_Latencies[Total_Requests_Count], Pointer_Clients[i].Pointer_Latencies, Pointer_Clients[i].Successful_Requests_Count * sizeof(double));
+		Total_Requests_Count += Pointer_Clients[i].Successful_Requests_Count;
+	}
+	if (Total_Requests_Count == 0)
+	{
+		printf("Error : no request to '%s' succeeded.\n", String_URL);
+		return -1;
+	}
+	qsort(Pointer_Latencies, Total_Requests_Count, sizeof(double), LoadGeneratorCompareLatencies);
+	
+	Pointer_Result->String_URL = String_URL;
+	Pointer_Result->Requests_Count = Threads_Count * Requests_Count;
+	Pointer_Result->Successful_Requests_Count = Total_Requests_Count;
+	Pointer_Result->Failed_Requests_Count = Pointer_Result->Requests_Count - Total_Requests_Count;
+	Pointer_Result->Throughput = Total_Requests_Count * 1000. / Duration;
+	Pointer_Result->Latency_P50 = Pointer_Latencies[Total_Requests_Count * 50 / 100];
+	Pointer_Result->Latency_P99 = Pointer_Latencies[Total_Requests_Count * 99 / 100];
+	Pointer_Result->Latency_P999 = Pointer_Latencies[Total_Requests_Count * 999 / 1000];
+	// The periodic status polling is counted too, it is negligible compared to a run commands count
+	if (Load_Generator_Pointer_Board_Executed_Commands_Count != NULL) Pointer_Result->Board_Round_Trips_Per_Request = (double) (*Load_Generator_Pointer_Board_Executed_Commands_Count - Initial_Board_Commands_Count) / Total_Requests_Count;
+	else Pointer_Result->Board_Round_Trips_Per_Request = -1;
+	if (Server_Process_ID > 0)
+	{
+		Pointer_Result->Server_RSS = LoadGeneratorGetProcessMemory(Server_Process_ID, "VmRSS:");
+		Pointer_Result->Server_Peak_RSS = LoadGeneratorGetProcessMemory(Server_Process_ID, "VmHWM:");
+	}
+	else
+	{
+		Pointer_Result->Server_RSS = -1;
+		Pointer_Result->Server_Peak_RSS = -1;
+	}
+	return 0;
+}
+
+/** Display a scenario measures in a human-readable way.
+ * @param Pointer_Result The measures.
+ */
+static void LoadGeneratorDisplayResult(TLoadGeneratorResult *Pointer_Result)
+{
+	printf("URL : %s\n", Pointer_Result->String_URL);
+	printf("Successful requests : %d/%d\n", Pointer_Result->Successful_Requests_Count, Pointer_Result->Requests_Count);
+	printf("Failed requests : %d\n", Pointer_Result->Failed_Requests_Count);
+	printf("Throughput : %.1f requests/s\n", Pointer_Result->Throughput);
+	printf("Latency p50 : %.3f ms\n", Pointer_Result->Latency_P50);
+	printf("Latency p99 : %.3f ms\n", Pointer_Result->Latency_P99);
+	printf("Latency p99.9 : %.3f ms\n", Pointer_Result->Latency_P999);
+	if (Pointer_Result->Board_Round_Trips_Per_Request >= 0) printf("Board round trips per request : %.2f\n", Pointer_Result->Board_Round_Trips_Per_Request);
+	if (Pointer_Result->Server_RSS >= 0)
+	{
+		printf("Server RSS : %ld KB\n", Pointer_Result->Server_RSS);
+		printf("Server peak RSS : %ld KB\n", Pointer_Result->Server_Peak_RSS);
+	}
+}
+
+/** Write all scenarios measures to a JSON file.
+ * @param String_File_Path The results file path.
+ * @param Pointer_Results The measures.
+ * @param Results_Count How many scenarios were run.
+ * @param Threads_Count How many client threads were used.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int LoadGeneratorWriteResults(char *String_File_Path, TLoadGeneratorResult *Pointer_Results, int Results_Count, int Threads_Count)
+{
+	FILE *Pointer_File;
+	int i, Return_Value = 0;
+	
+	Pointer_File = fopen(String_File_Path, "w");
+	if (Pointer_File == NULL)
+	{
+		printf("Error : failed to create results file '%s' (%s).\n", String_File_Path, strerror(errno));
+		return -1;
+	}
+	
+	// Unavailable values are written as null so tools can tell them from real measures
+	fprintf(Pointer_File, "{\n\t\"threads\": %d,\n\t\"scenarios\": [\n", Threads_Count);
+	for (i = 0; i < Results_Count; i++)
+	{
+		fprintf(Pointer_File, "\t\t{\"url\": \"%s\", \"requests\": %d, \"successful_requests\": %d, \"failed_requests\": %d, \"throughput\": %.1f, \"latency_p50_ms\": %.3f, \"latency_p99_ms\": %.3f, \"latency_p999_ms\": %.3f, ", Pointer_Results[i].String_URL, Pointer_Results[i].Requests_Count, Pointer_Results[i].Successful_Requests_Count, Pointer_Results[i].Failed_Requests_Count, Pointer_Results[i].Throughput, Pointer_Results[i].Latency_P50, Pointer_Results[i].Latency_P99, Pointer_Results[i].Latency_P999);
+		if (Pointer_Results[i].Board_Round_Trips_Per_Request >= 0) fprintf(Pointer_File, "\"board_round_trips_per_request\": %.2f, ", Pointer_Results[i].Board_Round_Trips_Per_Request);
+		else fprintf(Pointer_File, "\"board_round_trips_per_request\": null, ");
+		if (Pointer_Results[i].Server_RSS >= 0) fprintf(Pointer_File, "\"server_rss_kb\": %ld, \"server_peak_rss_kb\": %ld}", Pointer_Results[i].Server_RSS, Pointer_Results[i].Server_Peak_RSS);
+		else fprintf(Pointer_File, "\"server_rss_kb\": null, \"server_peak_rss_kb\": null}");
+		fprintf(Pointer_File, "%s\n", i < Results_Count - 1 ? "," : "");
+	}
+	fprintf(Pointer_File, "\t]\n}\n");
+	
+	if (fclose(Pointer_File) != 0)
+	{
+		printf("Error : failed to write results file '%s' (%s).\n", String_File_Path, strerror(errno));
+		Return_Value = -1;
+	}
+	return Return_Value;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	int Option, Threads_Count = 8, Requests_Count = 1000, Server_Process_ID = -1, i, URLs_Count = 0, Is_Parameter_Bad = 0, Return_Value = EXIT_FAILURE;
+	unsigned short Port = 8888;
+	char *String_URLs[LOAD_GENERATOR_MAXIMUM_URLS_COUNT], *String_Board_Counter_File_Path = NULL, *String_Results_File_Path = NULL;
+	TLoadGeneratorClient *Pointer_Clients;
+	TLoadGeneratorResult Results[LOAD_GENERATOR_MAXIMUM_URLS_COUNT];
+	double *Pointer_Latencies;
+	
+	// Check parameters
+	while ((Option = getopt(argc, argv, "b:n:o:p:s:t:u:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'b':
+				String_Board_Counter_File_Path = optarg;
+				break;
+				
+			case 'n':
+				Requests_Count = atoi(optarg);
+				break;
+				
+			case 'o':
+				String_Results_File_Path = optarg;
+				break;
+				
+			case 'p':
+				Port = atoi(optarg);
+				break;
+				
+			case 's':
+				Server_Process_ID = atoi(optarg);
+				break;
+				
+			case 't':
+				Threads_Count = atoi(optarg);
+				break;
+				
+			case 'u':
+				if (URLs_Count == LOAD_GENERATOR_MAXIMUM_URLS_COUNT) Is_Parameter_Bad = 1;
+				else
+				{
+					String_URLs[URLs_Count] = optarg;
+					URLs_Count++;
+				}
+				break;
+				
+			default:
+				Is_Parameter_Bad = 1;
+				break;
+		}
+	}
+	if (Is_Parameter_Bad || (Threads_Count <= 0) || (Requests_Count <= 0))
+	{
+		printf("Usage : %s [-p Port] [-u URL]... [-t Threads_Count] [-n Requests_Per_Thread] [-s Server_Process_ID] [-b Board_Counter_File] [-o Results_File]\n"
+			"  -u : a URL to request, repeat the option to measure several URLs one after the other (up to %d, default is /monitoring.html).\n"
+			"  -b : the counter file of the board simulator, used to compute how many board round trips a request costs.\n"
+			"  -o : write all results to this JSON file.\n", argv[0], LOAD_GENERATOR_MAXIMUM_URLS_COUNT);
+		return EXIT_FAILURE;
+	}
+	if (URLs_Count == 0)
+	{
+		String_URLs[0] = "/monitoring.html";
+		URLs_Count = 1;
+	}
+	if ((String_Board_Counter_File_Path != NULL) && (LoadGeneratorMapBoardCounterFile(String_Board_Counter_File_Path) != 0)) return EXIT_FAILURE;
+	
+	// Prepare the server address
+	Load_Generator_Server_Address.sin_family = AF_INET;
+	Load_Generator_Server_Address.sin_port = htons(Port);
+	Load_Generator_Server_Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	
+	// Allocate all clients, they are reused by all scenarios
+	Pointer_Clients = malloc(sizeof(TLoadGeneratorClient) * Threads_Count);
+	Pointer_Latencies = malloc(sizeof(double) * Threads_Count * Requests_Count);
+	if ((Pointer_Clients == NULL) || (Pointer_Latencies == NULL))
+	{
+		printf("Error : failed to allocate memory.\n");
+		goto Exit;
+	}
+	
+	// Measure each URL on its own so results don't mix
+	for (i = 0; i < URLs_Count; i++)
+	{
+		if (LoadGeneratorRunScenario(String_URLs[i], Pointer_Clients, Threads_Count, Requests_Count, Pointer_Latencies, Server_Process_ID, &Results[i]) != 0) goto Exit;
+		if (i > 0) printf("\n");
+		LoadGeneratorDisplayResult(&Results[i]);
+	}
+	
+	if ((String_Results_File_Path != NULL) && (LoadGeneratorWriteResults(String_Results_File_Path, Results, URLs_Count, Threads_Count) != 0)) goto Exit;
+	Return_Value = EXIT_SUCCESS;
+	
+Exit:
+	free(Pointer_Clients);
+	free(Pointer_Latencies);
+	return Return_Value;
+}
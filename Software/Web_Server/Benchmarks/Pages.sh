@@ -0,0 +1,36 @@
+#!/bin/sh
+# Measure all pages with the board simulator standing in for the real board, and write the results to a JSON file.
+# Run "make bench" rather than calling this script directly. Usage : Benchmarks/Pages.sh [Results_File] [Client_Threads_Count] [Requests_Per_Client_Thread]
+# Author : Adrien RICCIARDI
+
+RESULTS_FILE=${1:-Benchmark_Results.json}
+CLIENT_THREADS_COUNT=${2:-8}
+REQUESTS_COUNT=${3:-500}
+PORT=8889
+SIMULATOR=../Microcontroller_Firmware/boiler-controller-board-simulator
+
+if [ ! -x ./boiler-controller-web-server ] || [ ! -x ./load-generator ] || [ ! -x $SIMULATOR ]
+then
+	printf "\033[31mBuild the server, the load generator and the board simulator first (make bench).\033[0m\n"
+	exit 1
+fi
+
+# Keep the benchmark files away from the installed server ones
+WORK_DIRECTORY=$(mktemp -d)
+trap 'kill $SIMULATOR_PID $SERVER_PID 2> /dev/null; wait 2> /dev/null; rm -rf $WORK_DIRECTORY' EXIT INT TERM
+
+./boiler-controller-web-server -a Assets.bin -f $WORK_DIRECTORY/History.bin $PORT &
+SERVER_PID=$!
+$SIMULATOR -c $WORK_DIRECTORY/Board_Counter > /dev/null &
+SIMULATOR_PID=$!
+
+# Give the board the time to connect and the server the time to get a first status
+sleep 2
+
+./load-generator -p $PORT -t $CLIENT_THREADS_COUNT -n $REQUESTS_COUNT -s $SERVER_PID -b $WORK_DIRECTORY/Board_Counter -o $RESULTS_FILE \
+	-u / \
+	-u "/index.html?power_state=1&day_temperature=20&night_temperature=18" \
+	-u /settings.html \
+	-u /monitoring.html \
+	|| exit 1
+printf "\033[32mResults have been written to %s.\033[0m\n" "$RESULTS_FILE"
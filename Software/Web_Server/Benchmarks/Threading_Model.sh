@@ -0,0 +1,42 @@
+#!/bin/sh
+# Compare the legacy thread-per-connection model with the epoll threads pool, in terms of memory usage and latency.
+# The board simulator stands in for the real board, so the measured page is rendered with the board values like in production.
+# Run "make all load-generator" and "make -C ../Microcontroller_Firmware simulator" first. Usage : Benchmarks/Threading_Model.sh [Pool_Threads_Count] [Client_Threads_Count] [Requests_Per_Client_Thread]
+# Author : Adrien RICCIARDI
+
+POOL_THREADS_COUNT=${1:-2}
+CLIENT_THREADS_COUNT=${2:-32}
+REQUESTS_COUNT=${3:-500}
+PORT=8889
+SIMULATOR=../Microcontroller_Firmware/boiler-controller-board-simulator
+
+# Start the server with the provided threads count, load it, then stop it
+# $1 : the server threads count (0 selects the thread-per-connection model)
+# $2 : a human-readable description of the model
+run_benchmark()
+{
+	printf "\033[33m=== %s ===\033[0m\n" "$2"
+	./boiler-controller-web-server -t $1 -c $((CLIENT_THREADS_COUNT * 2)) -a Assets.bin -f $WORK_DIRECTORY/History.bin $PORT &
+	SERVER_PID=$!
+	$SIMULATOR > /dev/null &
+	SIMULATOR_PID=$!
+
+	# Give the board the time to connect and the server the time to get a first status
+	sleep 2
+	./load-generator -p $PORT -t $CLIENT_THREADS_COUNT -n $REQUESTS_COUNT -s $SERVER_PID -u /
+	kill $SIMULATOR_PID $SERVER_PID
+	wait $SIMULATOR_PID $SERVER_PID 2> /dev/null
+}
+
+if [ ! -x ./boiler-controller-web-server ] || [ ! -x ./load-generator ] || [ ! -x $SIMULATOR ]
+then
+	printf "\033[31mBuild the server, the load generator and the board simulator first (make all load-generator, then make -C ../Microcontroller_Firmware simulator).\033[0m\n"
+	exit 1
+fi
+
+# Keep the benchmark files away from the installed server ones
+WORK_DIRECTORY=$(mktemp -d)
+trap 'kill $SIMULATOR_PID $SERVER_PID 2> /dev/null; wait 2> /dev/null; rm -rf $WORK_DIRECTORY' EXIT INT TERM
+
+run_benchmark 0 "Thread per connection"
+run_benchmark $POOL_THREADS_COUNT "Epoll threads pool ($POOL_THREADS_COUNT threads)"
@@ -0,0 +1,45 @@
+/** @file Api.h
+ * A versioned JSON API allowing scripts to monitor and configure the boiler without parsing HTML pages.
+ * Available endpoints :
+ * - GET /api/v1/boards : list the boards that connected since the server started, telling whether they are connected and whether their status is known.
+ * - GET /api/v1/status : get the whole board status.
+ * - POST /api/v1/settings : change the running mode, the desired temperatures or the heating curve. All members are optional, the answer is the updated status.
+ * The board is selected with the "board" URL argument (for instance /api/v1/status?board=1), the default board is used when it is missing.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_API_H
+#define H_API_H
+
+#include <Boiler.h>
+#include <Json.h>
+#include <microhttpd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** All API URLs start with this prefix. */
+#define API_URL_PREFIX "/api/v1/"
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Write the board status values as object members, using the same members names than the settings endpoint.
+ * @param Pointer_Writer The writer, an object must be opened.
+ * @param Pointer_Status The status to write.
+ * @param Pointer_Previous_Status If not NULL, only the values differing from this status are written.
+ */
+void ApiWriteStatusMembers(TJsonWriter *Pointer_Writer, TBoilerStatus *Pointer_Status, TBoilerStatus *Pointer_Previous_Status);
+
+/** Handle an API request. Must be called each time the web server access handler is called for an URL starting with API_URL_PREFIX.
+ * @param Pointer_Connection The connection handle used to build the response.
+ * @param Pointer_String_URL The requested URL.
+ * @param Pointer_String_Method The HTTP method.
+ * @param Pointer_String_Upload_Data The request body chunk.
+ * @param Pointer_Upload_Data_Size On input, how many bytes of body the chunk contains. On output, how many bytes have not been consumed.
+ * @param Pointer_Persistent_Connection_Custom_Data The request context pointer. The API allocates its context on the first call, it must be freed with free() when the request is completed.
+ * @return MHD_NO to close the connection,
+ * @return MHD_YES to continue servicing the client request.
+ */
+int ApiHandleRequest(struct MHD_Connection *Pointer_Connection, const char *Pointer_String_URL, const char *Pointer_String_Method, const char *Pointer_String_Upload_Data, size_t *Pointer_Upload_Data_Size, void **Pointer_Persistent_Connection_Custom_Data);
+
+#endif
@@ -0,0 +1,38 @@
+/** @file Assets.h
+ * Serve the static files (pages, style sheets, scripts) from the bundle built by the assets packer.
+ * The bundle is memory-mapped and its content is sent without copy. Each asset is sent with the best encoding the browser accepts, with a strong entity tag so it can be revalidated, and versioned assets can be cached forever.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_ASSETS_H
+#define H_ASSETS_H
+
+#include <microhttpd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Map the assets bundle to memory and prepare the responses.
+ * @param Pointer_String_Bundle_File_Path The bundle file built by the assets packer.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+int AssetsInitialize(const char *Pointer_String_Bundle_File_Path);
+
+/** Release the responses and unmap the bundle. Call it only after the web server has been stopped. */
+void AssetsUninitialize(void);
+
+/** Get the bundle version, dynamic pages append it to the assets URLs so browsers can cache the assets forever.
+ * @return The bundle version string.
+ */
+const char *AssetsGetVersion(void);
+
+/** Send an asset if the bundle contains it.
+ * @param Pointer_Connection The connection to send the asset to.
+ * @param Pointer_String_URL The requested URL.
+ * @param Pointer_Return_Value On output, contain the value the web server access handler must return (only when the asset has been found).
+ * @return -1 if the bundle does not contain the requested URL,
+ * @return 0 if the asset response has been queued.
+ */
+int AssetsQueueResponse(struct MHD_Connection *Pointer_Connection, const char *Pointer_String_URL, int *Pointer_Return_Value);
+
+#endif
@@ -0,0 +1,71 @@
+/** @file Assets_Bundle.h
+ * The assets bundle file format, shared by the bundle packer and the web server.
+ * A bundle starts with a header, followed by the entries table and by the representations data. All integers are stored in the machine byte order, the bundle is built on the machine that serves it.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_ASSETS_BUNDLE_H
+#define H_ASSETS_BUNDLE_H
+
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** Identify an assets bundle file ("BCAB" in little endian). */
+#define ASSETS_BUNDLE_MAGIC_NUMBER 0x42414342
+/** Increment this value each time the bundle layout changes. */
+#define ASSETS_BUNDLE_FORMAT_VERSION 1
+
+/** The bundle version string can be found in assets text with this placeholder, it is replaced by the bundle version when the bundle is built. */
+#define ASSETS_BUNDLE_VERSION_PLACEHOLDER "@ASSETS_VERSION@"
+/** Size in bytes of the bundle version string, including the terminating zero. */
+#define ASSETS_BUNDLE_VERSION_STRING_SIZE 17
+
+/** Maximum size in bytes of an asset URL, including the terminating zero. */
+#define ASSETS_BUNDLE_URL_STRING_SIZE 64
+/** Maximum size in bytes of an asset content type, including the terminating zero. */
+#define ASSETS_BUNDLE_CONTENT_TYPE_STRING_SIZE 48
+/** Maximum size in bytes of a representation entity tag, including the quotes and the terminating zero. */
+#define ASSETS_BUNDLE_ETAG_STRING_SIZE 24
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** All encodings an asset can be stored with. */
+typedef enum
+{
+	ASSETS_BUNDLE_ENCODING_IDENTITY,
+	ASSETS_BUNDLE_ENCODING_GZIP,
+	ASSETS_BUNDLE_ENCODING_BROTLI,
+	ASSETS_BUNDLE_ENCODINGS_COUNT
+} TAssetsBundleEncoding;
+
+/** An asset content stored with a specific encoding. */
+typedef struct __attribute__((packed))
+{
+	uint32_t Offset; //!< Where the representation data start, from the beginning of the bundle.
+	uint32_t Size; //!< The representation data size in bytes. A zero size means that the asset is not available with this encoding (the compressed data would not be smaller than the original ones).
+	char String_ETag[ASSETS_BUNDLE_ETAG_STRING_SIZE]; //!< The strong entity tag of the representation, quotes included.
+} TAssetsBundleRepresentation;
+
+/** Describe an asset. */
+typedef struct __attribute__((packed))
+{
+	char String_URL[ASSETS_BUNDLE_URL_STRING_SIZE]; //!< The URL the asset is served from.
+	char String_Content_Type[ASSETS_BUNDLE_CONTENT_TYPE_STRING_SIZE]; //!< The asset MIME type.
+	uint8_t Is_Immutable; //!< Set to 1 when the asset URL is always requested with the bundle version, so browsers can cache it forever. Set to 0 when browsers must revalidate the asset on each use.
+	uint8_t Padding[3]; //!< Keep the representations aligned.
+	TAssetsBundleRepresentation Representations[ASSETS_BUNDLE_ENCODINGS_COUNT]; //!< The asset content with each encoding.
+} TAssetsBundleEntry;
+
+/** Start the bundle file. */
+typedef struct __attribute__((packed))
+{
+	uint32_t Magic_Number; //!< Must be ASSETS_BUNDLE_MAGIC_NUMBER.
+	uint16_t Format_Version; //!< Must be ASSETS_BUNDLE_FORMAT_VERSION.
+	uint16_t Entries_Count; //!< How many entries follow the header.
+	char String_Version[ASSETS_BUNDLE_VERSION_STRING_SIZE]; //!< Change each time an asset content changes, so it can be used to build URLs that browsers can cache forever.
+	uint8_t Padding[3]; //!< Keep the entries aligned.
+} TAssetsBundleHeader;
+
+#endif
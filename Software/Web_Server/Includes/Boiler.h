@@ -1,13 +1,45 @@
 /** @file Boiler.h
- * A TCP server allowing to communicate with the boiler board.
+ * A TCP server allowing to communicate with several boiler boards, each one driving its own heating circuit.
+ * Each board announces its ID when it connects, all functions take the ID of the board to work with. All board connections are served by a single thread.
  * @author Adrien RICCIARDI
  */
 #ifndef H_BOILER_H
 #define H_BOILER_H
 
+#include <time.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** How many buckets a command round-trip time histogram has. Bucket i counts the round trips that lasted less than 2^i milliseconds (and not less than the previous bucket limit), the last bucket counts all longer round trips. */
+#define BOILER_ROUND_TRIP_TIME_HISTOGRAM_BUCKETS_COUNT 14
+
 //-------------------------------------------------------------------------------------------------
 // Types
 //-------------------------------------------------------------------------------------------------
+/** All known commands. */
+typedef enum
+{
+	BOILER_COMMAND_GET_FIRMWARE_VERSION,
+	BOILER_COMMAND_GET_SENSORS_RAW_TEMPERATURES,
+	BOILER_COMMAND_GET_SENSORS_CELSIUS_TEMPERATURES,
+	BOILER_COMMAND_GET_MIXING_VALVE_POSITION,
+	BOILER_COMMAND_SET_NIGHT_MODE,
+	BOILER_COMMAND_GET_DESIRED_ROOM_TEMPERATURES,
+	BOILER_COMMAND_SET_DESIRED_ROOM_TEMPERATURES,
+	BOILER_COMMAND_GET_TRIMMERS_RAW_VALUES,
+	BOILER_COMMAND_GET_BOILER_RUNNING_MODE,
+	BOILER_COMMAND_SET_BOILER_RUNNING_MODE,
+	BOILER_COMMAND_GET_TARGET_START_WATER_TEMPERATURE,
+	BOILER_COMMAND_GET_HEATING_CURVE_PARAMETERS,
+	BOILER_COMMAND_SET_HEATING_CURVE_PARAMETERS,
+	BOILER_COMMAND_GET_STATUS,
+	BOILER_COMMAND_APPLY_SETTINGS,
+	BOILER_COMMAND_GET_TELEMETRY_BLOCK,
+	BOILER_COMMAND_GET_TASK_PROFILE,
+	BOILER_COMMANDS_COUNT
+} TBoilerCommand;
+
 /** All available valve positions. */
 typedef enum
 {
@@ -16,10 +48,102 @@ typedef enum
 	BOILER_MIXING_VALVE_POSITION_RIGHT
 } TBoilerMixingValvePosition;
 
+/** A coherent copy of all board values periodically retrieved by the status poll. */
+typedef struct
+{
+	unsigned int Version; //!< Incremented each time the snapshot content changes (a poll returning the same values does not change it), so readers can tell whether something new is available.
+	int Is_Valid; //!< Set to 1 if the last board poll succeeded, set to 0 if the board could not be reached (all other fields are meaningless in this case).
+	time_t Update_Time; //!< When the board was successfully polled for the last time.
+	int Outside_Temperature; //!< Outside temperature in Celsius degrees.
+	int Radiator_Start_Water_Temperature; //!< Radiator start water temperature in Celsius degrees.
+	int Target_Radiator_Start_Water_Temperature; //!< Radiator start water temperature computed by the heating curve, in Celsius degrees.
+	int Desired_Day_Temperature; //!< The desired room temperature during the day.
+	int Desired_Night_Temperature; //!< The desired room temperature during the night.
+	int Is_Boiler_Running; //!< Set to 1 if the boiler is running, set to 0 if the boiler is idle.
+	int Is_Night_Mode_Enabled; //!< Set to 1 if the night temperature is used, set to 0 if the day temperature is used.
+	TBoilerMixingValvePosition Mixing_Valve_Position; //!< The last position reached by the mixing valve.
+	int Is_Mixing_Valve_Left_Relay_On; //!< Set to 1 when the mixing valve is moving to the left.
+	int Is_Mixing_Valve_Right_Relay_On; //!< Set to 1 when the mixing valve is moving to the right.
+	int Is_Pump_On; //!< Set to 1 when the pump is running.
+	int Is_Gas_Burner_On; //!< Set to 1 when the gas burner is lit.
+	int Heating_Curve_Coefficient; //!< The heating curve coefficient multiplied by ten.
+	int Heating_Curve_Parallel_Shift; //!< The heating curve parallel shift multiplied by ten.
+} TBoilerStatus;
+
+/** Settings to change at once with BoilerApplySettings(). */
+typedef struct
+{
+	int Is_Boiler_Running_Mode_Present; //!< Set to 1 to change the boiler running mode.
+	int Is_Boiler_Running; //!< Set to 1 to put boiler in running mode, set to 0 to put boiler in idle mode.
+	int Is_Night_Mode_Present; //!< Set to 1 to change the night mode.
+	int Is_Night_Mode_Enabled; //!< Set to 1 to use the night temperature, set to 0 to use the day temperature.
+	int Are_Desired_Room_Temperatures_Present; //!< Set to 1 to change both desired room temperatures.
+	int Desired_Day_Temperature; //!< The desired temperature during the day.
+	int Desired_Night_Temperature; //!< The desired temperature during the night.
+	int Are_Heating_Curve_Parameters_Present; //!< Set to 1 to change the heating curve.
+	int Heating_Curve_Coefficient; //!< The heating curve coefficient multiplied by ten.
+	int Heating_Curve_Parallel_Shift; //!< The heating curve parallel shift multiplied by ten.
+} TBoilerSettings;
+
+/** A board state recorded by the board itself, so it can be retrieved after the board link has been down. */
+typedef struct
+{
+	time_t Time; //!< When the sample has been taken, computed from the board uptime (so it is accurate to a second or so).
+	int Outside_Temperature; //!< Outside temperature in Celsius degrees.
+	int Radiator_Start_Water_Temperature; //!< Radiator start water temperature in Celsius degrees.
+	int Target_Radiator_Start_Water_Temperature; //!< Radiator start water temperature computed by the heating curve, in Celsius degrees.
+	TBoilerMixingValvePosition Mixing_Valve_Position; //!< The last position reached by the mixing valve.
+	int Is_Mixing_Valve_Left_Relay_On; //!< Set to 1 when the mixing valve is moving to the left.
+	int Is_Mixing_Valve_Right_Relay_On; //!< Set to 1 when the mixing valve is moving to the right.
+	int Is_Pump_On; //!< Set to 1 when the pump is running.
+	int Is_Gas_Burner_On; //!< Set to 1 when the gas burner is lit.
+} TBoilerTelemetrySample;
+
+/** How long a firmware task or interrupt handler takes to execute, measured by the board itself. */
+typedef struct
+{
+	int Sections_Count; //!< How many sections the board measures, it is 0 when the firmware has been built without profiling (all other fields are zero in this case).
+	unsigned long Calls_Count; //!< How many times the section has been executed since the statistics were cleared.
+	unsigned long Minimum_Cycles; //!< The shortest execution time in CPU cycles.
+	unsigned long Maximum_Cycles; //!< The longest execution time in CPU cycles.
+	int Is_Maximum_Saturated; //!< Set to 1 when the longest execution time was too long to be stored by the board, the real value is greater than Maximum_Cycles.
+	unsigned long long Total_Cycles; //!< All execution times sum in CPU cycles.
+} TBoilerTaskProfile;
+
+/** Board command queue statistics, allowing to tell whether the board link is saturated. */
+typedef struct
+{
+	unsigned int Current_Depth; //!< How many commands are waiting to be sent right now.
+	unsigned int Maximum_Depth; //!< The highest queue depth seen since the server started.
+	unsigned long long Processed_Commands_Count; //!< How many commands have been taken from the queue to be sent to the board.
+	unsigned long long Rejected_Commands_Count; //!< How many commands have been dropped because the queue was full.
+	unsigned long long Total_Wait_Time; //!< Cumulated time in microseconds the processed commands spent in the queue.
+	unsigned long long Maximum_Wait_Time; //!< The longest time in microseconds a command spent in the queue.
+} TBoilerCommandQueueStatistics;
+
+/** Round-trip time and errors statistics of a board command. */
+typedef struct
+{
+	unsigned long long Round_Trip_Time_Histogram[BOILER_ROUND_TRIP_TIME_HISTOGRAM_BUCKETS_COUNT]; //!< How many successful commands fell in each round-trip time bucket.
+	unsigned long long Successful_Commands_Count; //!< How many commands got an answer.
+	unsigned long long Total_Round_Trip_Time; //!< Cumulated round-trip time in microseconds of the successful commands.
+	unsigned long long Failed_Commands_Count; //!< How many commands did not get an answer, whatever the reason is.
+	unsigned long long Timed_Out_Commands_Count; //!< How many of the failed commands did not get an answer in time.
+} TBoilerCommandStatistics;
+
+/** Board connection statistics, allowing to tell whether the board link is stable. */
+typedef struct
+{
+	int Is_Connected; //!< Set to 1 if the board is currently connected.
+	unsigned long long Connection_Age; //!< How many seconds the current board connection has lasted (meaningless if the board is not connected).
+	unsigned long long Connections_Count; //!< How many times the board connected since the server started.
+	unsigned long long Lost_Connections_Count; //!< How many times the board connection has been closed because the board could not be reached anymore or because the board reconnected.
+} TBoilerConnectionStatistics;
+
 //-------------------------------------------------------------------------------------------------
 // Functions
 //-------------------------------------------------------------------------------------------------
-/** Start server on default port.
+/** Start server on default port and start the thread serving all board connections (it also polls the boards status).
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
@@ -28,77 +152,178 @@ int BoilerInitializeServer(void);
 /** Gracefully release all resources. */
 void BoilerUninitializeServer(void);
 
-/** Wait for the board to connect to the server.
+/** Convert a board selector received from a web client to a board ID.
+ * @param Pointer_String_Board_ID The board ID string, NULL if the client did not select a board.
+ * @return -1 if the string is not a valid board ID,
+ * @return CONFIGURATION_BOILER_DEFAULT_BOARD_ID if no board is selected,
+ * @return The selected board ID on success.
+ */
+int BoilerParseBoardID(const char *Pointer_String_Board_ID);
+
+/** Get the IDs of all boards that connected at least once since the server started.
+ * @param Pointer_Board_IDs On output, contain the board IDs in ascending order. The array must have room for CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT entries.
+ * @return How many boards are known.
+ */
+int BoilerGetKnownBoards(int *Pointer_Board_IDs);
+
+/** Get a board command queue statistics.
+ * @param Board_ID The board ID.
+ * @param Pointer_Statistics On output, contain a copy of the statistics.
+ */
+void BoilerGetCommandQueueStatistics(int Board_ID, TBoilerCommandQueueStatistics *Pointer_Statistics);
+
+/** Get a board command round-trip time and errors statistics.
+ * @param Board_ID The board ID.
+ * @param Command The command to get statistics of.
+ * @param Pointer_Statistics On output, contain a copy of the statistics.
+ * @return -1 if the board or the command does not exist,
+ * @return 0 on success.
+ */
+int BoilerGetCommandStatistics(int Board_ID, TBoilerCommand Command, TBoilerCommandStatistics *Pointer_Statistics);
+
+/** Get a board connection statistics.
+ * @param Board_ID The board ID.
+ * @param Pointer_Statistics On output, contain a copy of the statistics.
+ */
+void BoilerGetConnectionStatistics(int Board_ID, TBoilerConnectionStatistics *Pointer_Statistics);
+
+/** Get a command name suitable to be exported.
+ * @param Command The command.
+ * @return A lowercase command name.
+ */
+const char *BoilerGetCommandName(TBoilerCommand Command);
+
+/** Get a copy of the last board status retrieved by the poll. This function does not communicate with the board, so it returns immediately.
+ * @param Board_ID The board ID.
+ * @param Pointer_Status On output, contain the status snapshot (it is not valid if the board ID does not exist).
+ */
+void BoilerGetStatusSnapshot(int Board_ID, TBoilerStatus *Pointer_Status);
+
+/** Wait for a board status snapshot content to change.
+ * @param Board_ID The board ID.
+ * @param Known_Version The snapshot version the caller already knows.
+ * @param Timeout How many milliseconds to wait at most.
+ * @return 0 if the snapshot did not change before the timeout,
+ * @return 1 if the snapshot version differs from the known one.
+ */
+int BoilerWaitForStatusSnapshotChange(int Board_ID, unsigned int Known_Version, int Timeout);
+
+/** Wait for any board status snapshot content to change.
+ * @param Known_Changes_Count The changes count returned by the previous call, or 0 on the first call.
+ * @param Timeout How many milliseconds to wait at most.
+ * @return How many times a snapshot changed since the server started, it differs from the known count if something changed.
+ */
+unsigned int BoilerWaitForAnyStatusSnapshotChange(unsigned int Known_Changes_Count, int Timeout);
+
+/** Read all board values in a single command.
+ * @param Board_ID The board ID.
+ * @param Pointer_Status On output, contain the board values. Snapshot management fields (version, validity and update time) are not modified.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+int BoilerGetStatus(int Board_ID, TBoilerStatus *Pointer_Status);
+
+/** Change several settings in a single command. The board applies all of them or none of them, and answers with its resulting state, which updates the status snapshot.
+ * @param Board_ID The board ID.
+ * @param Pointer_Settings The settings to change, the settings that are not present keep their current value.
+ * @return -1 if an error occurred (no setting has been changed if the command did not reach the board),
+ * @return 0 on success.
+ */
+int BoilerApplySettings(int Board_ID, TBoilerSettings *Pointer_Settings);
+
+/** Download the samples the board recorded after a given time. The board keeps a few hours of samples in RAM, they are downloaded block by block (so this function sends several commands).
+ * @param Board_ID The board ID.
+ * @param Start_Time Only the samples taken after this time are returned.
+ * @param Pointer_Samples On output, contain the samples from the oldest to the newest.
+ * @param Maximum_Samples_Count The samples buffer capacity. If more samples are matching, only the oldest ones are returned.
+ * @return -1 if an error occurred,
+ * @return The amount of returned samples on success.
+ */
+int BoilerGetTelemetrySamples(int Board_ID, time_t Start_Time, TBoilerTelemetrySample *Pointer_Samples, int Maximum_Samples_Count);
+
+/** Read the execution time statistics of a firmware section (a main loop task or an interrupt handler).
+ * @param Board_ID The board ID.
+ * @param Section_ID The section, in range [0..Sections_Count - 1].
+ * @param Is_Reset_Requested Set to 1 to clear the section statistics on the board once they have been read.
+ * @param Pointer_Profile On output, contain the section statistics.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerRunServer(void);
+int BoilerGetTaskProfile(int Board_ID, int Section_ID, int Is_Reset_Requested, TBoilerTaskProfile *Pointer_Profile);
 
 /** Read temperature sensors values.
+ * @param Board_ID The board ID.
  * @param Pointer_Outside_Temperature On output, contain the outside temperature in Celsius degrees.
  * @param Pointer_Radiator_Start_Water_Temperature On output, contain the start water temperature in Celsius degrees.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerGetSensorsCelsiusTemperatures(int *Pointer_Outside_Temperature, int *Pointer_Radiator_Start_Water_Temperature);
+int BoilerGetSensorsCelsiusTemperatures(int Board_ID, int *Pointer_Outside_Temperature, int *Pointer_Radiator_Start_Water_Temperature);
 
 /** TODO */
-int BoilerGetMixingValvePosition(TBoilerMixingValvePosition *Pointer_Position);
+int BoilerGetMixingValvePosition(int Board_ID, TBoilerMixingValvePosition *Pointer_Position);
 
 /** TODO */
-int BoilerSetNightMode(int Is_Night_Mode_Enabled);
+int BoilerSetNightMode(int Board_ID, int Is_Night_Mode_Enabled);
 
 /** Read the desired room temperatures.
+ * @param Board_ID The board ID.
  * @param Pointer_Day_Temperature On output, contain the desired temperature during the day.
  * @param Pointer_Night_Temperature On output, contain the desired temperature during the night.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerGetDesiredRoomTemperatures(int *Pointer_Day_Temperature, int *Pointer_Night_Temperature);
+int BoilerGetDesiredRoomTemperatures(int Board_ID, int *Pointer_Day_Temperature, int *Pointer_Night_Temperature);
 
 /** Write the desired room temperatures.
+ * @param Board_ID The board ID.
  * @param Day_Temperature The desired temperature during the day.
  * @param Night_Temperature The desired temperature during the night.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerSetDesiredRoomTemperatures(int Day_Temperature, int Night_Temperature);
+int BoilerSetDesiredRoomTemperatures(int Board_ID, int Day_Temperature, int Night_Temperature);
 
 /** Tell whether boiler is running or is idle.
+ * @param Board_ID The board ID.
  * @param Pointer_Is_Boiler_Running On output, is equal to 1 if the boiler is running or is equal to 0 if the boiler is idle.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerGetBoilerRunningMode(int *Pointer_Is_Boiler_Running);
+int BoilerGetBoilerRunningMode(int Board_ID, int *Pointer_Is_Boiler_Running);
 
 /** Put boiler in running or idle mode.
+ * @param Board_ID The board ID.
  * @param Is_Boiler_Running Set to 1 to put boiler in running mode, set to 0 to put boiler in idle mode.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerSetBoilerRunningMode(int Is_Boiler_Running);
+int BoilerSetBoilerRunningMode(int Board_ID, int Is_Boiler_Running);
 
 /** Read target radiator start water temperature.
+ * @param Board_ID The board ID.
  * @param Pointer_Temperature On output, contain the retrieved temperature.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerGetTargetRadiatorStartWaterTemperature(int *Pointer_Temperature);
+int BoilerGetTargetRadiatorStartWaterTemperature(int Board_ID, int *Pointer_Temperature);
 
 /** Read heating curve parameters.
+ * @param Board_ID The board ID.
  * @param Pointer_Coefficient On output, contain the coefficient multiplied by ten.
  * @param Pointer_Parallel_Shift On output, contain the parallel shift multiplied by ten.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerGetHeatingCurveParameters(int *Pointer_Coefficient, int *Pointer_Parallel_Shift);
+int BoilerGetHeatingCurveParameters(int Board_ID, int *Pointer_Coefficient, int *Pointer_Parallel_Shift);
 
 /** Write heating curve parameters to board EEPROM.
+ * @param Board_ID The board ID.
  * @param Coefficient The coefficient multiplied by ten.
  * @param Parallel_Shift The parallel shift multiplied by ten.
  * @return -1 if an error occurred,
  * @return 0 on success.
  */
-int BoilerSetHeatingCurveParameters(int Coefficient, int Parallel_Shift);
+int BoilerSetHeatingCurveParameters(int Board_ID, int Coefficient, int Parallel_Shift);
 
 #endif
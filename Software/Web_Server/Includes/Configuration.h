@@ -13,4 +13,55 @@
 /** Maximum allowed day or night temperature in Celsius degrees. */
 #define CONFIGURATION_TEMPERATURE_MAXIMUM_VALUE 25
 
+/** How many boards can be served, board IDs range from 0 to this value minus one. */
+#define CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT 64
+/** The board served when a web client does not select a board, it is also the ID given to boards running a firmware that does not announce its ID. */
+#define CONFIGURATION_BOILER_DEFAULT_BOARD_ID 0
+/** How many milliseconds a newly connected board is given to announce its ID. */
+#define CONFIGURATION_BOILER_ANNOUNCEMENT_TIMEOUT 1000
+
+/** How many seconds to wait between two board status polls. */
+#define CONFIGURATION_BOILER_STATUS_POLLING_PERIOD 5
+
+/** How many commands can wait to be sent to the board. Commands submitted while the queue is full fail immediately. */
+#define CONFIGURATION_BOILER_COMMAND_QUEUE_SIZE 16
+/** How many commands are sent to the board before waiting for their answers. The firmware queues the received commands while it is executing or answering the previous ones, but it drops the commands that do not fit in its queue (they then time out), so keep it to CONFIGURATION_PROTOCOL_RECEIVED_COMMANDS_QUEUE_SIZE - 1 at most (see the microcontroller firmware Configuration.h file). */
+#define CONFIGURATION_BOILER_COMMAND_PIPELINE_DEPTH 3
+/** How many milliseconds the board is given to answer a command. */
+#define CONFIGURATION_BOILER_COMMAND_TIMEOUT 2000
+/** The board connection is closed after this amount of consecutive unanswered commands. */
+#define CONFIGURATION_BOILER_MAXIMUM_CONSECUTIVE_TIMEOUTS 3
+/** How many milliseconds to wait for late answers to discard after a command timed out. */
+#define CONFIGURATION_BOILER_RESYNCHRONIZATION_DELAY 200
+/** How many seconds the board link can stay idle before a heartbeat command is sent to make sure the board is still reachable. */
+#define CONFIGURATION_BOILER_HEARTBEAT_PERIOD 3
+/** How many seconds the board link can stay idle before the kernel starts sending keepalive probes. */
+#define CONFIGURATION_BOILER_KEEPALIVE_IDLE_TIME 5
+/** How many seconds to wait between two keepalive probes. */
+#define CONFIGURATION_BOILER_KEEPALIVE_INTERVAL 2
+/** How many unanswered keepalive probes make the kernel close the board connection. */
+#define CONFIGURATION_BOILER_KEEPALIVE_PROBES_COUNT 3
+/** How many milliseconds sent data can stay unacknowledged by the board before the kernel closes the connection. */
+#define CONFIGURATION_BOILER_TCP_USER_TIMEOUT 6000
+
+/** The history file used when no file is provided on the command line. */
+#define CONFIGURATION_HISTORY_DEFAULT_FILE_PATH "/var/lib/boiler-controller-web-server/History.bin"
+/** How many seconds to wait between two history samples when no value is provided on the command line. */
+#define CONFIGURATION_HISTORY_DEFAULT_SAMPLING_PERIOD 60
+/** How many samples the history file can hold before overwriting the oldest ones (a year of per-minute samples, about 4MB). */
+#define CONFIGURATION_HISTORY_SAMPLES_CAPACITY (366 * 24 * 60)
+/** How many samples recorded by the board can be retrieved at once when the board comes back after a link failure (the board keeps at most a few hundreds of samples). */
+#define CONFIGURATION_HISTORY_BACKFILL_MAXIMUM_SAMPLES_COUNT 512
+
+/** How many seconds an events stream can stay silent before a heartbeat is sent. */
+#define CONFIGURATION_EVENTS_HEARTBEAT_PERIOD 15
+
+/** The assets bundle used when no file is provided on the command line. */
+#define CONFIGURATION_ASSETS_DEFAULT_BUNDLE_FILE_PATH "/usr/share/boiler-controller-web-server/Assets.bin"
+
+/** How many threads serve web requests when no value is provided on the command line. */
+#define CONFIGURATION_WEB_SERVER_DEFAULT_THREADS_COUNT 2
+/** How many simultaneous web connections are accepted when no value is provided on the command line. */
+#define CONFIGURATION_WEB_SERVER_DEFAULT_CONNECTIONS_LIMIT 32
+
 #endif
@@ -0,0 +1,37 @@
+/** @file Events.h
+ * Push board status changes to the web browsers with Server-Sent Events, so the monitoring page does not need to be reloaded.
+ * Each event is a JSON object holding only the values that changed since the previous event (the first event holds all values).
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_EVENTS_H
+#define H_EVENTS_H
+
+#include <microhttpd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** The URL the events stream is served from. */
+#define EVENTS_URL "/events"
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Prepare the events streams management.
+ * @param Is_Suspend_Resume_Used Set to 1 when the web server uses a threads pool, so waiting streams suspend their connection instead of blocking a thread (the web server must be started with MHD_ALLOW_SUSPEND_RESUME). Set to 0 when each connection has its own thread, waiting streams block their thread in this case.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+int EventsInitialize(int Is_Suspend_Resume_Used);
+
+/** End all streams and stop waking the suspended streams up. Call it before stopping the web server, which can't be stopped while connections are suspended. */
+void EventsUninitialize(void);
+
+/** Create the endless response sending the events to a client. The board is selected with the "board" URL argument, the default board is streamed when it is missing.
+ * @param Pointer_Connection The client connection.
+ * @return NULL if an error occurred or if the board ID is invalid,
+ * @return The response to queue on success.
+ */
+struct MHD_Response *EventsCreateResponse(struct MHD_Connection *Pointer_Connection);
+
+#endif
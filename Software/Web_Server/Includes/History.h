@@ -0,0 +1,49 @@
+/** @file History.h
+ * Periodically record the board status in a memory-mapped ring file, so the values history survives server restarts.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_HISTORY_H
+#define H_HISTORY_H
+
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** The sample flags telling the relays states and the mixing valve position. */
+#define HISTORY_SAMPLE_FLAG_GAS_BURNER_ON 0x01
+#define HISTORY_SAMPLE_FLAG_PUMP_ON 0x02
+#define HISTORY_SAMPLE_FLAG_MIXING_VALVE_LEFT_RELAY_ON 0x04
+#define HISTORY_SAMPLE_FLAG_MIXING_VALVE_RIGHT_RELAY_ON 0x08
+/** The mixing valve position (a TBoilerMixingValvePosition value) is stored in these bits. */
+#define HISTORY_SAMPLE_FLAGS_MIXING_VALVE_POSITION_SHIFT 4
+#define HISTORY_SAMPLE_FLAGS_MIXING_VALVE_POSITION_MASK 0x30
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** A board status sample, stored as is in the history file. */
+typedef struct __attribute__((packed))
+{
+	uint32_t Time; //!< When the sample has been taken (UNIX time).
+	int8_t Outside_Temperature; //!< Outside temperature in Celsius degrees.
+	int8_t Radiator_Start_Water_Temperature; //!< Radiator start water temperature in Celsius degrees.
+	int8_t Target_Radiator_Start_Water_Temperature; //!< Radiator start water temperature computed by the heating curve, in Celsius degrees.
+	uint8_t Flags; //!< A combination of HISTORY_SAMPLE_FLAG_XXX values and the mixing valve position.
+} THistorySample;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Map the history file (creating it if needed) and start sampling the board status.
+ * @param String_File_Path The history file path.
+ * @param Sampling_Period How many seconds to wait between two samples.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+int HistoryInitialize(const char *String_File_Path, int Sampling_Period);
+
+/** Stop sampling and unmap the history file. */
+void HistoryUninitialize(void);
+
+#endif
@@ -0,0 +1,127 @@
+/** @file Json.h
+ * A minimal JSON writer and flat object parser working on caller-provided buffers, so no memory is allocated.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_JSON_H
+#define H_JSON_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** How many objects and arrays can be nested when writing. */
+#define JSON_WRITER_MAXIMUM_NESTING_LEVEL 32
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** Serialize JSON values to a fixed-size buffer. */
+typedef struct
+{
+	char *Pointer_String_Buffer; //!< The output buffer.
+	int Buffer_Size; //!< The output buffer size in bytes, including the terminating zero.
+	int Length; //!< How many characters have been written so far.
+	int Is_Overflowed; //!< Set to 1 when the buffer was too small to hold all written values.
+	int Nesting_Level; //!< How many objects or arrays are currently opened.
+	unsigned int Is_Separator_Needed_Bitmask; //!< Bit N is set when the container at nesting level N already holds a value, so the next value must be preceded by a comma.
+} TJsonWriter;
+
+/** All value types the parser recognizes. */
+typedef enum
+{
+	JSON_VALUE_TYPE_NULL,
+	JSON_VALUE_TYPE_BOOLEAN,
+	JSON_VALUE_TYPE_INTEGER,
+	JSON_VALUE_TYPE_STRING
+} TJsonValueType;
+
+/** A parsed object member. Strings point into the parsed text, they are neither terminated nor unescaped. */
+typedef struct
+{
+	const char *Pointer_String_Key; //!< The member name.
+	int Key_Length; //!< The member name length in characters.
+	TJsonValueType Value_Type; //!< The value type.
+	long long Integer_Value; //!< The value of an integer, or 1 for true and 0 for false.
+	const char *Pointer_String_Value; //!< The content of a string.
+	int String_Value_Length; //!< The string length in characters.
+} TJsonMember;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Start writing to a buffer.
+ * @param Pointer_Writer The writer to initialize.
+ * @param Pointer_String_Buffer The output buffer.
+ * @param Buffer_Size The output buffer size in bytes.
+ */
+void JsonWriterInitialize(TJsonWriter *Pointer_Writer, char *Pointer_String_Buffer, int Buffer_Size);
+
+/** Open an object.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String_Key The member name if the object is an object member, NULL otherwise.
+ */
+void JsonWriterBeginObject(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key);
+
+/** Close the last opened object.
+ * @param Pointer_Writer The writer.
+ */
+void JsonWriterEndObject(TJsonWriter *Pointer_Writer);
+
+/** Open an array.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String_Key The member name if the array is an object member, NULL otherwise.
+ */
+void JsonWriterBeginArray(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key);
+
+/** Close the last opened array.
+ * @param Pointer_Writer The writer.
+ */
+void JsonWriterEndArray(TJsonWriter *Pointer_Writer);
+
+/** Write an integer.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String_Key The member name if the value is an object member, NULL otherwise.
+ * @param Value The value.
+ */
+void JsonWriterAddInteger(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key, long long Value);
+
+/** Write a boolean.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String_Key The member name if the value is an object member, NULL otherwise.
+ * @param Value Write false if the value is 0, write true otherwise.
+ */
+void JsonWriterAddBoolean(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key, int Value);
+
+/** Write a string, escaping all characters that need to.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String_Key The member name if the value is an object member, NULL otherwise.
+ * @param Pointer_String_Value The value.
+ */
+void JsonWriterAddString(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key, const char *Pointer_String_Value);
+
+/** Terminate the output string.
+ * @param Pointer_Writer The writer.
+ * @return -1 if the buffer was too small,
+ * @return The output string length on success.
+ */
+int JsonWriterTerminate(TJsonWriter *Pointer_Writer);
+
+/** Parse an object whose members are null, booleans, integers or strings (nested objects and arrays are rejected).
+ * @param Pointer_String The text to parse.
+ * @param Length The text length in characters (the text does not need to be terminated).
+ * @param Pointer_Members On output, contain the object members in their order of appearance.
+ * @param Maximum_Members_Count How many members the members array can hold.
+ * @return -1 if the text is not a valid object or has too many members,
+ * @return The members count on success.
+ */
+int JsonParseFlatObject(const char *Pointer_String, int Length, TJsonMember *Pointer_Members, int Maximum_Members_Count);
+
+/** Find an object member by its name.
+ * @param Pointer_Members The members returned by JsonParseFlatObject().
+ * @param Members_Count The members count.
+ * @param Pointer_String_Key The member name.
+ * @return NULL if the member is not present,
+ * @return The member on success.
+ */
+TJsonMember *JsonFindMember(TJsonMember *Pointer_Members, int Members_Count, const char *Pointer_String_Key);
+
+#endif
@@ -0,0 +1,67 @@
+/** @file Metrics.h
+ * Count what the web server does and export it with the board link statistics in the Prometheus text format, so link quality and server overhead can be graphed over long periods.
+ * Request counters are updated without lock : each web server thread owns a counters slot, and the exporter sums all slots.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_METRICS_H
+#define H_METRICS_H
+
+#include <microhttpd.h>
+#include <time.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** The URL the metrics are served from. */
+#define METRICS_URL "/metrics"
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** All request handlers whose render time is measured. */
+typedef enum
+{
+	METRICS_HANDLER_INDEX_PAGE,
+	METRICS_HANDLER_SETTINGS_PAGE,
+	METRICS_HANDLER_DIAGNOSTICS_PAGE,
+	METRICS_HANDLER_API,
+	METRICS_HANDLER_EVENTS,
+	METRICS_HANDLER_ASSETS,
+	METRICS_HANDLER_METRICS,
+	METRICS_HANDLER_UNKNOWN, //!< The requested URL is not served.
+	METRICS_HANDLERS_COUNT
+} TMetricsHandler;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Count a request served by a handler and record how long the handler took to build the response.
+ * @param Handler The handler that served the request.
+ * @param Pointer_Start_Time When the handler was called (CLOCK_MONOTONIC time).
+ */
+void MetricsObserveHandlerDuration(TMetricsHandler Handler, struct timespec *Pointer_Start_Time);
+
+/** Queue a response like MHD_queue_response() does, counting its status code.
+ * @param Pointer_Connection The connection to send the response on.
+ * @param Status_Code The HTTP status code.
+ * @param Pointer_Response The response.
+ * @return MHD_NO if an error occurred,
+ * @return MHD_YES on success.
+ */
+int MetricsQueueResponse(struct MHD_Connection *Pointer_Connection, unsigned int Status_Code, struct MHD_Response *Pointer_Response);
+
+/** Must be registered with the MHD_OPTION_NOTIFY_CONNECTION web server option to count the opened connections.
+ * @param Pointer_Custom_Data Unused.
+ * @param Pointer_Connection Unused.
+ * @param Pointer_Socket_Context Unused.
+ * @param Notification_Code Tell whether the connection has been opened or closed.
+ */
+void MetricsConnectionNotificationCallback(void *Pointer_Custom_Data, struct MHD_Connection *Pointer_Connection, void **Pointer_Socket_Context, enum MHD_ConnectionNotificationCode Notification_Code);
+
+/** Create a response holding all metrics.
+ * @return NULL if an error occurred,
+ * @return The response to queue on success.
+ */
+struct MHD_Response *MetricsCreateResponse(void);
+
+#endif
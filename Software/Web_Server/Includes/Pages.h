@@ -1,5 +1,5 @@
 /** @file Pages.h
- * List all website pages.
+ * List all website pages generated on each request. Static pages are served from the assets bundle (see Assets.h), and generated pages are rendered from the compiled templates (see Templates.h).
  * @author Adrien RICCIARDI
  */
 #ifndef H_PAGES_H
@@ -7,39 +7,36 @@
 
 #include <microhttpd.h>
 
-//-------------------------------------------------------------------------------------------------
-// Constants and macros
-//-------------------------------------------------------------------------------------------------
-/** Convert the macro identifier to a C string. */
-#define PAGES_CONVERT_MACRO_NAME_TO_STRING(X) #X
-/** Convert the macro value to a C string. The preprocessor needs two passes to do the conversion, so the MAIN_CONVERT_MACRO_NAME_TO_STRING() is needed. */
-#define PAGES_CONVERT_MACRO_VALUE_TO_STRING(X) PAGES_CONVERT_MACRO_NAME_TO_STRING(X)
-
 //-------------------------------------------------------------------------------------------------
 // Functions
 //-------------------------------------------------------------------------------------------------
 /** Create the "index.html" page response.
  * @param Pointer_Connection The connection object.
- * @param Pointer_String_Response On output, contain the HTML page code.
- * @return -1 if an error occurred,
- * @return 0 on success.
+ * @return NULL if an error occurred,
+ * @return The response to queue on success.
  */
-int PageIndex(struct MHD_Connection *Pointer_Connection, char *Pointer_String_Response);
+struct MHD_Response *PageIndex(struct MHD_Connection *Pointer_Connection);
 
 /** Create the settings page response.
  * @param Pointer_Connection The connection object.
- * @param Pointer_String_Response On output, contain the HTML page code.
- * @return -1 if an error occurred,
- * @return 0 on success.
+ * @return NULL if an error occurred,
+ * @return The response to queue on success.
  */
-int PageSettings(struct MHD_Connection *Pointer_Connection, char *Pointer_String_Response);
+struct MHD_Response *PageSettings(struct MHD_Connection *Pointer_Connection);
 
-/** Create the monitoring page response.
+/** Create the diagnostics page response, showing how long the board firmware tasks and interrupt handlers take to execute.
  * @param Pointer_Connection The connection object.
- * @param Pointer_String_Response On output, contain the HTML page code.
- * @return -1 if an error occurred,
- * @return 0 on success.
+ * @return NULL if an error occurred,
+ * @return The response to queue on success.
+ */
+struct MHD_Response *PageDiagnostics(struct MHD_Connection *Pointer_Connection);
+
+/** Create the page displayed when the board can't be reached.
+ * @param Pointer_String_Title The page title, it must be valid HTML.
+ * @param Pointer_String_Heading The page heading, it must be valid HTML.
+ * @return NULL if an error occurred,
+ * @return The response to queue on success.
  */
-int PageMonitoring(struct MHD_Connection *Pointer_Connection, char *Pointer_String_Response);
+struct MHD_Response *PageError(const char *Pointer_String_Title, const char *Pointer_String_Heading);
 
 #endif
@@ -0,0 +1,89 @@
+/** @file Templates.h
+ * Render the HTML page templates compiled by the templates compiler (see Tools/Templates_Compiler.c).
+ * A compiled template is a table of constant segments separated by typed slots. Rendering only formats the slot values, and the response gives the constant segments and the values to the socket in place (scatter/gather), so the rendering cost depends on the number of slots and not on the page size.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TEMPLATES_H
+#define H_TEMPLATES_H
+
+#include <microhttpd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Constants
+//-------------------------------------------------------------------------------------------------
+/** How many slots a template can have. */
+#define TEMPLATES_MAXIMUM_SLOTS_COUNT 32
+/** Size in bytes of the buffer holding the formatted slot values of a rendering. */
+#define TEMPLATES_VALUES_BUFFER_SIZE 4096
+
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** All slot types, a slot value must be set with the function matching its type. */
+typedef enum
+{
+	TEMPLATES_SLOT_TYPE_INTEGER, //!< A signed integer ("@integer:Name@" placeholder).
+	TEMPLATES_SLOT_TYPE_DECIMAL, //!< A value in tenths, displayed with one decimal ("@decimal:Name@" placeholder).
+	TEMPLATES_SLOT_TYPE_STRING //!< A string inserted verbatim, it must already be valid HTML ("@string:Name@" placeholder).
+} TTemplatesSlotType;
+
+/** A constant part of a template. */
+typedef struct
+{
+	const char *Pointer_String_Data; //!< The segment content, it is not terminated.
+	unsigned int Size; //!< The segment size in bytes.
+} TTemplatesSegment;
+
+/** A compiled template. Segments and slots alternate, starting and ending with a segment (a segment can be empty). */
+typedef struct
+{
+	const char *Pointer_String_Name; //!< The template file name, used in logs.
+	int Segments_Count; //!< How many segments the template has.
+	const TTemplatesSegment *Pointer_Segments; //!< All segments.
+	const unsigned char *Pointer_Segment_Slot_Indexes; //!< The slot following each segment but the last one. The same slot can appear several times in a template.
+	int Slots_Count; //!< How many different slots the template has.
+	const TTemplatesSlotType *Pointer_Slot_Types; //!< Each slot type.
+} TTemplatesTemplate;
+
+/** A template filled with a request values (the type is private to Templates.c). */
+typedef struct TTemplatesRendering TTemplatesRendering;
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Start rendering a template. All slots are empty until they are set.
+ * @param Pointer_Template The compiled template.
+ * @return NULL if an error occurred,
+ * @return The rendering on success, it must be given to TemplatesCreateResponse() which frees it.
+ */
+TTemplatesRendering *TemplatesCreateRendering(const TTemplatesTemplate *Pointer_Template);
+
+/** Set an integer slot value.
+ * @param Pointer_Rendering The rendering.
+ * @param Slot_Index The slot, it must be an integer slot.
+ * @param Value The value.
+ */
+void TemplatesSetInteger(TTemplatesRendering *Pointer_Rendering, int Slot_Index, int Value);
+
+/** Set a decimal slot value.
+ * @param Pointer_Rendering The rendering.
+ * @param Slot_Index The slot, it must be a decimal slot.
+ * @param Tenths The value in tenths (for instance 14 is displayed "1.4").
+ */
+void TemplatesSetDecimal(TTemplatesRendering *Pointer_Rendering, int Slot_Index, int Tenths);
+
+/** Set a string slot value.
+ * @param Pointer_Rendering The rendering.
+ * @param Slot_Index The slot, it must be a string slot.
+ * @param Pointer_String_Value The value, it is copied.
+ */
+void TemplatesSetString(TTemplatesRendering *Pointer_Rendering, int Slot_Index, const char *Pointer_String_Value);
+
+/** Create the response sending the rendered page. The response is made of the constant segments and of the values buffer parts, which are sent in place without being copied to an intermediate buffer.
+ * @param Pointer_Rendering The rendering, it is freed when the response is destroyed (or immediately if an error occurred).
+ * @return NULL if an error occurred (a value did not fit in the values buffer or had a wrong type),
+ * @return The response to queue on success.
+ */
+struct MHD_Response *TemplatesCreateResponse(TTemplatesRendering *Pointer_Rendering);
+
+#endif
@@ -0,0 +1,332 @@
+/** @file Api.c
+ * See Api.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Api.h>
+#include <Boiler.h>
+#include <Configuration.h>
+#include <Json.h>
+#include <Metrics.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The largest accepted request body. */
+#define API_REQUEST_BODY_MAXIMUM_SIZE 512
+/** The response buffer size, a status is about 500 bytes long and each board of the boards list takes about 60 bytes. */
+#define API_RESPONSE_BUFFER_SIZE 4096
+/** How many members a settings object can have. */
+#define API_SETTINGS_MAXIMUM_MEMBERS_COUNT 16
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** All data needed by a request, allocated once when the request starts. */
+typedef struct
+{
+	char Body[API_REQUEST_BODY_MAXIMUM_SIZE]; //!< The received request body.
+	int Body_Size; //!< How many bytes of body have been received.
+	int Is_Body_Too_Large; //!< Set to 1 if the body did not fit in the buffer.
+	int Board_ID; //!< The board the request is about.
+	char String_Response[API_RESPONSE_BUFFER_SIZE]; //!< The JSON response, sent directly from this buffer.
+} TApiRequest;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Queue the response stored in the request context.
+ * @param Pointer_Connection The connection.
+ * @param Pointer_Request The request context holding the JSON response (it stays allocated until the request is completed, so the response does not need to be copied).
+ * @param Status_Code The HTTP status code.
+ * @param Pointer_String_Allowed_Method The method to advertise in the Allow header when the status code is MHD_HTTP_METHOD_NOT_ALLOWED, NULL otherwise.
+ * @return MHD_NO if an error occurred,
+ * @return MHD_YES on success.
+ */
+static int ApiQueueResponse(struct MHD_Connection *Pointer_Connection, TApiRequest *Pointer_Request, unsigned int Status_Code, const char *Pointer_String_Allowed_Method)
+{
+	struct MHD_Response *Pointer_Response;
+	int Return_Value;
+	
+	Pointer_Response = MHD_create_response_from_buffer(strlen(Pointer_Request->String_Response), Pointer_Request->String_Response, MHD_RESPMEM_PERSISTENT);
+	if (Pointer_Response == NULL) return MHD_NO;
+	MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CONTENT_TYPE, "application/json");
+	MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CACHE_CONTROL, "no-store");
+	if (Pointer_String_Allowed_Method != NULL) MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_ALLOW, Pointer_String_Allowed_Method);
+	
+	Return_Value = MetricsQueueResponse(Pointer_Connection, Status_Code, Pointer_Response);
+	MHD_destroy_response(Pointer_Response);
+	return Return_Value;
+}
+
+/** Send an error response.
+ * @param Pointer_Connection The connection.
+ * @param Pointer_Request The request context.
+ * @param Status_Code The HTTP status code.
+ * @param Pointer_String_Message A human-readable error description.
+ * @param Pointer_String_Allowed_Method The method the endpoint accepts if the status code is MHD_HTTP_METHOD_NOT_ALLOWED, NULL otherwise.
+ * @return MHD_NO if an error occurred,
+ * @return MHD_YES on success.
+ */
+static int ApiSendError(struct MHD_Connection *Pointer_Connection, TApiRequest *Pointer_Request, unsigned int Status_Code, const char *Pointer_String_Message, const char *Pointer_String_Allowed_Method)
+{
+	TJsonWriter Writer;
+	
+	JsonWriterInitialize(&Writer, Pointer_Request->String_Response, sizeof(Pointer_Request->String_Response));
+	JsonWriterBeginObject(&Writer, NULL);
+	JsonWriterAddString(&Writer, "error", Pointer_String_Message);
+	JsonWriterEndObject(&Writer);
+	JsonWriterTerminate(&Writer); // The message is always short enough
+	
+	return ApiQueueResponse(Pointer_Connection, Pointer_Request, Status_Code, Pointer_String_Allowed_Method);
+}
+
+/** Send the current board status snapshot.
+ * @param Pointer_Connection The connection.
+ * @param Pointer_Request The request context.
+ * @return MHD_NO if an error occurred,
+ * @return MHD_YES on success.
+ */
+static int ApiSendStatus(struct MHD_Connection *Pointer_Connection, TApiRequest *Pointer_Request)
+{
+	TBoilerStatus Status;
+	TJsonWriter Writer;
+	
+	BoilerGetStatusSnapshot(Pointer_Request->Board_ID, &Status);
+	if (!Status.Is_Valid) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_SERVICE_UNAVAILABLE, "Board is not reachable.", NULL);
+	
+	JsonWriterInitialize(&Writer, Pointer_Request->String_Response, sizeof(Pointer_Request->String_Response));
+	JsonWriterBeginObject(&Writer, NULL);
+	JsonWriterAddInteger(&Writer, "update_time", Status.Update_Time);
+	ApiWriteStatusMembers(&Writer, &Status, NULL);
+	JsonWriterEndObject(&Writer);
+	if (JsonWriterTerminate(&Writer) < 0)
+	{
+		syslog(LOG_ERR, "API response buffer is too small to hold the status.");
+		return MHD_NO;
+	}
+	
+	return ApiQueueResponse(Pointer_Connection, Pointer_Request, MHD_HTTP_OK, NULL);
+}
+
+/** Send the boards that connected at least once since the server started.
+ * @param Pointer_Connection The connection.
+ * @param Pointer_Request The request context.
+ * @return MHD_NO if an error occurred,
+ * @return MHD_YES on success.
+ */
+static int ApiSendBoards(struct MHD_Connection *Pointer_Connection, TApiRequest *Pointer_Request)
+{
+	int Board_IDs[CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT], Boards_Count, i;
+	TBoilerConnectionStatistics Connection_Statistics;
+	TBoilerStatus Status;
+	TJsonWriter Writer;
+	
+	Boards_Count = BoilerGetKnownBoards(Board_IDs);
+	
+	JsonWriterInitialize(&Writer, Pointer_Request->String_Response, sizeof(Pointer_Request->String_Response));
+	JsonWriterBeginObject(&Writer, NULL);
+	JsonWriterBeginArray(&Writer, "boards");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetConnectionStatistics(Board_IDs[i], &Connection_Statistics);
+		BoilerGetStatusSnapshot(Board_IDs[i], &Status);
+		
+		JsonWriterBeginObject(&Writer, NULL);
+		JsonWriterAddInteger(&Writer, "id", Board_IDs[i]);
+		JsonWriterAddBoolean(&Writer, "is_connected", Connection_Statistics.Is_Connected);
+		JsonWriterAddBoolean(&Writer, "is_status_valid", Status.Is_Valid);
+		JsonWriterEndObject(&Writer);
+	}
+	JsonWriterEndArray(&Writer);
+	JsonWriterEndObject(&Writer);
+	if (JsonWriterTerminate(&Writer) < 0)
+	{
+		syslog(LOG_ERR, "API response buffer is too small to hold the boards list.");
+		return MHD_NO;
+	}
+	
+	return ApiQueueResponse(Pointer_Connection, Pointer_Request, MHD_HTTP_OK, NULL);
+}
+
+/** Get an integer member value, checking its range.
+ * @param Pointer_Members The object members.
+ * @param Members_Count The members count.
+ * @param Pointer_String_Key The member name.
+ * @param Minimum_Value The minimum allowed value.
+ * @param Maximum_Value The maximum allowed value.
+ * @param Pointer_Value On output, contain the member value if it is present.
+ * @return -1 if the member is present but is not a valid integer,
+ * @return 0 if the member is not present,
+ * @return 1 if the member value has been retrieved.
+ */
+static int ApiGetIntegerMember(TJsonMember *Pointer_Members, int Members_Count, const char *Pointer_String_Key, int Minimum_Value, int Maximum_Value, int *Pointer_Value)
+{
+	TJsonMember *Pointer_Member;
+	
+	Pointer_Member = JsonFindMember(Pointer_Members, Members_Count, Pointer_String_Key);
+	if (Pointer_Member == NULL) return 0;
+	if ((Pointer_Member->Value_Type != JSON_VALUE_TYPE_INTEGER) || (Pointer_Member->Integer_Value < Minimum_Value) || (Pointer_Member->Integer_Value > Maximum_Value)) return -1;
+	
+	*Pointer_Value = (int) Pointer_Member->Integer_Value;
+	return 1;
+}
+
+/** Apply the settings provided in the request body, then send the updated status.
+ * @param Pointer_Connection The connection.
+ * @param Pointer_Request The request context.
+ * @return MHD_NO if an error occurred,
+ * @return MHD_YES on success.
+ */
+static int ApiApplySettings(struct MHD_Connection *Pointer_Connection, TApiRequest *Pointer_Request)
+{
+	TJsonMember Members[API_SETTINGS_MAXIMUM_MEMBERS_COUNT], *Pointer_Member;
+	int Members_Count, Is_Day_Temperature_Present, Is_Night_Temperature_Present, Is_Coefficient_Present, Is_Parallel_Shift_Present;
+	TBoilerStatus Status;
+	TBoilerSettings Settings;
+	
+	if (Pointer_Request->Is_Body_Too_Large) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "Request body is too large.", NULL);
+	Members_Count = JsonParseFlatObject(Pointer_Request->Body, Pointer_Request->Body_Size, Members, API_SETTINGS_MAXIMUM_MEMBERS_COUNT);
+	if (Members_Count < 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "Request body is not a valid JSON object.", NULL);
+	
+	// Validate all values before sending anything to the board, so a bad request does not get partially applied
+	memset(&Settings, 0, sizeof(Settings));
+	// Running mode
+	Pointer_Member = JsonFindMember(Members, Members_Count, "is_boiler_running");
+	if (Pointer_Member != NULL)
+	{
+		if (Pointer_Member->Value_Type != JSON_VALUE_TYPE_BOOLEAN) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "'is_boiler_running' must be a boolean.", NULL);
+		Settings.Is_Boiler_Running_Mode_Present = 1;
+		Settings.Is_Boiler_Running = (int) Pointer_Member->Integer_Value;
+	}
+	
+	// Night mode
+	Pointer_Member = JsonFindMember(Members, Members_Count, "is_night_mode_enabled");
+	if (Pointer_Member != NULL)
+	{
+		if (Pointer_Member->Value_Type != JSON_VALUE_TYPE_BOOLEAN) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "'is_night_mode_enabled' must be a boolean.", NULL);
+		Settings.Is_Night_Mode_Present = 1;
+		Settings.Is_Night_Mode_Enabled = (int) Pointer_Member->Integer_Value;
+	}
+	
+	// Desired temperatures
+	Is_Day_Temperature_Present = ApiGetIntegerMember(Members, Members_Count, "desired_day_temperature", CONFIGURATION_TEMPERATURE_MINIMUM_VALUE, CONFIGURATION_TEMPERATURE_MAXIMUM_VALUE, &Settings.Desired_Day_Temperature);
+	if (Is_Day_Temperature_Present < 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "'desired_day_temperature' must be an integer in the allowed temperature range.", NULL);
+	Is_Night_Temperature_Present = ApiGetIntegerMember(Members, Members_Count, "desired_night_temperature", CONFIGURATION_TEMPERATURE_MINIMUM_VALUE, CONFIGURATION_TEMPERATURE_MAXIMUM_VALUE, &Settings.Desired_Night_Temperature);
+	if (Is_Night_Temperature_Present < 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "'desired_night_temperature' must be an integer in the allowed temperature range.", NULL);
+	
+	// Heating curve (the board stores both values as 16-bit unsigned integers)
+	Is_Coefficient_Present = ApiGetIntegerMember(Members, Members_Count, "heating_curve_coefficient", 0, 65535, &Settings.Heating_Curve_Coefficient);
+	if (Is_Coefficient_Present < 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "'heating_curve_coefficient' must be an integer in range [0; 65535].", NULL);
+	Is_Parallel_Shift_Present = ApiGetIntegerMember(Members, Members_Count, "heating_curve_parallel_shift", 0, 65535, &Settings.Heating_Curve_Parallel_Shift);
+	if (Is_Parallel_Shift_Present < 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "'heating_curve_parallel_shift' must be an integer in range [0; 65535].", NULL);
+	
+	// The board sets values by pairs, take the missing value of a pair from the last known status
+	if ((Is_Day_Temperature_Present != Is_Night_Temperature_Present) || (Is_Coefficient_Present != Is_Parallel_Shift_Present))
+	{
+		BoilerGetStatusSnapshot(Pointer_Request->Board_ID, &Status);
+		if (!Status.Is_Valid) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_SERVICE_UNAVAILABLE, "Board is not reachable.", NULL);
+		
+		if (!Is_Day_Temperature_Present) Settings.Desired_Day_Temperature = Status.Desired_Day_Temperature;
+		if (!Is_Night_Temperature_Present) Settings.Desired_Night_Temperature = Status.Desired_Night_Temperature;
+		if (!Is_Coefficient_Present) Settings.Heating_Curve_Coefficient = Status.Heating_Curve_Coefficient;
+		if (!Is_Parallel_Shift_Present) Settings.Heating_Curve_Parallel_Shift = Status.Heating_Curve_Parallel_Shift;
+	}
+	
+	// Apply all new settings in a single command, so the board gets either all of them or none of them
+	Settings.Are_Desired_Room_Temperatures_Present = Is_Day_Temperature_Present || Is_Night_Temperature_Present;
+	Settings.Are_Heating_Curve_Parameters_Present = Is_Coefficient_Present || Is_Parallel_Shift_Present;
+	if (BoilerApplySettings(Pointer_Request->Board_ID, &Settings) != 0)
+	{
+		syslog(LOG_ERR, "Failed to apply board %d settings.", Pointer_Request->Board_ID);
+		return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_SERVICE_UNAVAILABLE, "Failed to apply settings.", NULL);
+	}
+	
+	// The status snapshot already takes the new settings into account
+	return ApiSendStatus(Pointer_Connection, Pointer_Request);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void ApiWriteStatusMembers(TJsonWriter *Pointer_Writer, TBoilerStatus *Pointer_Status, TBoilerStatus *Pointer_Previous_Status)
+{
+	static const char *Pointer_String_Mixing_Valve_Positions[] = {"left", "center", "right"};
+	
+	// Members are named like the settings members, so a script can send back a value it has read
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Outside_Temperature != Pointer_Previous_Status->Outside_Temperature)) JsonWriterAddInteger(Pointer_Writer, "outside_temperature", Pointer_Status->Outside_Temperature);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Radiator_Start_Water_Temperature != Pointer_Previous_Status->Radiator_Start_Water_Temperature)) JsonWriterAddInteger(Pointer_Writer, "radiator_start_water_temperature", Pointer_Status->Radiator_Start_Water_Temperature);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Target_Radiator_Start_Water_Temperature != Pointer_Previous_Status->Target_Radiator_Start_Water_Temperature)) JsonWriterAddInteger(Pointer_Writer, "target_radiator_start_water_temperature", Pointer_Status->Target_Radiator_Start_Water_Temperature);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Desired_Day_Temperature != Pointer_Previous_Status->Desired_Day_Temperature)) JsonWriterAddInteger(Pointer_Writer, "desired_day_temperature", Pointer_Status->Desired_Day_Temperature);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Desired_Night_Temperature != Pointer_Previous_Status->Desired_Night_Temperature)) JsonWriterAddInteger(Pointer_Writer, "desired_night_temperature", Pointer_Status->Desired_Night_Temperature);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Is_Boiler_Running != Pointer_Previous_Status->Is_Boiler_Running)) JsonWriterAddBoolean(Pointer_Writer, "is_boiler_running", Pointer_Status->Is_Boiler_Running);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Is_Night_Mode_Enabled != Pointer_Previous_Status->Is_Night_Mode_Enabled)) JsonWriterAddBoolean(Pointer_Writer, "is_night_mode_enabled", Pointer_Status->Is_Night_Mode_Enabled);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Mixing_Valve_Position != Pointer_Previous_Status->Mixing_Valve_Position)) JsonWriterAddString(Pointer_Writer, "mixing_valve_position", Pointer_String_Mixing_Valve_Positions[Pointer_Status->Mixing_Valve_Position]);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Is_Mixing_Valve_Left_Relay_On != Pointer_Previous_Status->Is_Mixing_Valve_Left_Relay_On)) JsonWriterAddBoolean(Pointer_Writer, "is_mixing_valve_left_relay_on", Pointer_Status->Is_Mixing_Valve_Left_Relay_On);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Is_Mixing_Valve_Right_Relay_On != Pointer_Previous_Status->Is_Mixing_Valve_Right_Relay_On)) JsonWriterAddBoolean(Pointer_Writer, "is_mixing_valve_right_relay_on", Pointer_Status->Is_Mixing_Valve_Right_Relay_On);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Is_Pump_On != Pointer_Previous_Status->Is_Pump_On)) JsonWriterAddBoolean(Pointer_Writer, "is_pump_on", Pointer_Status->Is_Pump_On);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Is_Gas_Burner_On != Pointer_Previous_Status->Is_Gas_Burner_On)) JsonWriterAddBoolean(Pointer_Writer, "is_gas_burner_on", Pointer_Status->Is_Gas_Burner_On);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Heating_Curve_Coefficient != Pointer_Previous_Status->Heating_Curve_Coefficient)) JsonWriterAddInteger(Pointer_Writer, "heating_curve_coefficient", Pointer_Status->Heating_Curve_Coefficient);
+	if ((Pointer_Previous_Status == NULL) || (Pointer_Status->Heating_Curve_Parallel_Shift != Pointer_Previous_Status->Heating_Curve_Parallel_Shift)) JsonWriterAddInteger(Pointer_Writer, "heating_curve_parallel_shift", Pointer_Status->Heating_Curve_Parallel_Shift);
+}
+
+int ApiHandleRequest(struct MHD_Connection *Pointer_Connection, const char *Pointer_String_URL, const char *Pointer_String_Method, const char *Pointer_String_Upload_Data, size_t *Pointer_Upload_Data_Size, void **Pointer_Persistent_Connection_Custom_Data)
+{
+	TApiRequest *Pointer_Request = *Pointer_Persistent_Connection_Custom_Data;
+	const char *Pointer_String_Endpoint;
+	size_t Size;
+	
+	// Allocate the request context when the request headers are received
+	if (Pointer_Request == NULL)
+	{
+		Pointer_Request = malloc(sizeof(TApiRequest));
+		if (Pointer_Request == NULL)
+		{
+			syslog(LOG_ERR, "Failed to allocate API request context.");
+			return MHD_NO;
+		}
+		Pointer_Request->Body_Size = 0;
+		Pointer_Request->Is_Body_Too_Large = 0;
+		*Pointer_Persistent_Connection_Custom_Data = Pointer_Request;
+		return MHD_YES;
+	}
+	
+	// Gather the body chunks, the response can be sent only when the whole body has been received
+	if (*Pointer_Upload_Data_Size != 0)
+	{
+		Size = *Pointer_Upload_Data_Size;
+		if (Pointer_Request->Body_Size + Size > sizeof(Pointer_Request->Body)) Pointer_Request->Is_Body_Too_Large = 1;
+		else
+		{
+			memcpy(&Pointer_Request->Body[Pointer_Request->Body_Size], Pointer_String_Upload_Data, Size);
+			Pointer_Request->Body_Size += Size;
+		}
+		*Pointer_Upload_Data_Size = 0; // Tell that all data have been consumed
+		return MHD_YES;
+	}
+	
+	// All endpoints but the boards list are about a single board
+	Pointer_Request->Board_ID = BoilerParseBoardID(MHD_lookup_connection_value(Pointer_Connection, MHD_GET_ARGUMENT_KIND, "board"));
+	if (Pointer_Request->Board_ID < 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_BAD_REQUEST, "Unknown board.", NULL);
+	
+	// Dispatch to the right endpoint
+	Pointer_String_Endpoint = &Pointer_String_URL[sizeof(API_URL_PREFIX) - 1];
+	if (strcmp(Pointer_String_Endpoint, "boards") == 0)
+	{
+		if (strcmp(Pointer_String_Method, "GET") != 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_METHOD_NOT_ALLOWED, "Only GET method is allowed.", "GET");
+		return ApiSendBoards(Pointer_Connection, Pointer_Request);
+	}
+	if (strcmp(Pointer_String_Endpoint, "status") == 0)
+	{
+		if (strcmp(Pointer_String_Method, "GET") != 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_METHOD_NOT_ALLOWED, "Only GET method is allowed.", "GET");
+		return ApiSendStatus(Pointer_Connection, Pointer_Request);
+	}
+	if (strcmp(Pointer_String_Endpoint, "settings") == 0)
+	{
+		if (strcmp(Pointer_String_Method, "POST") != 0) return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_METHOD_NOT_ALLOWED, "Only POST method is allowed.", "POST");
+		return ApiApplySettings(Pointer_Connection, Pointer_Request);
+	}
+	return ApiSendError(Pointer_Connection, Pointer_Request, MHD_HTTP_NOT_FOUND, "Unknown endpoint.", NULL);
+}
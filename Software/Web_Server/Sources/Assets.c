@@ -0,0 +1,320 @@
+/** @file Assets.c
+ * See Assets.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Assets.h>
+#include <Assets_Bundle.h>
+#include <fcntl.h>
+#include <Metrics.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <syslog.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** Versioned assets URLs change each time their content changes, so browsers never need to ask for them again. */
+#define ASSETS_CACHE_CONTROL_IMMUTABLE "public, max-age=31536000, immutable"
+/** Pages must be revalidated each time they are used, the entity tag avoids sending them again when they did not change. */
+#define ASSETS_CACHE_CONTROL_REVALIDATE "no-cache"
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** The ready-to-send responses of an asset. */
+typedef struct
+{
+	TAssetsBundleEntry *Pointer_Entry; //!< The asset description in the bundle.
+	struct MHD_Response *Pointer_Responses[ASSETS_BUNDLE_ENCODINGS_COUNT]; //!< The response sending each representation, NULL if the representation is not available.
+	struct MHD_Response *Pointer_Not_Modified_Responses[ASSETS_BUNDLE_ENCODINGS_COUNT]; //!< The response telling that the browser representation is still valid, NULL if the representation is not available.
+} TAssetsAsset;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The bundle mapped to memory. */
+static void *Assets_Pointer_Bundle = MAP_FAILED;
+/** The mapped bundle size in bytes. */
+static size_t Assets_Bundle_Size;
+/** All assets found in the bundle. */
+static TAssetsAsset *Assets_Pointer_Assets = NULL;
+/** How many assets the bundle contains. */
+static int Assets_Assets_Count = 0;
+
+/** The encoding names sent in the Content-Encoding header. */
+static const char *Assets_Pointer_String_Encoding_Names[ASSETS_BUNDLE_ENCODINGS_COUNT] = { "identity", "gzip", "br" };
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Tell whether a string stored in a fixed-size bundle field is terminated.
+ * @param Pointer_String The string field.
+ * @param Size The field size in bytes.
+ * @return 1 if the string is terminated,
+ * @return 0 if the string overflows the field.
+ */
+static inline int AssetsIsStringTerminated(const char *Pointer_String, size_t Size)
+{
+	return memchr(Pointer_String, 0, Size) != NULL;
+}
+
+/** Add the headers shared by a representation full and not modified responses.
+ * @param Pointer_Response The response.
+ * @param Pointer_Entry The asset description.
+ * @param Encoding The representation encoding.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int AssetsAddCachingHeaders(struct MHD_Response *Pointer_Response, TAssetsBundleEntry *Pointer_Entry, TAssetsBundleEncoding Encoding)
+{
+	if (MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_ETAG, Pointer_Entry->Representations[Encoding].String_ETag) != MHD_YES) return -1;
+	if (MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CACHE_CONTROL, Pointer_Entry->Is_Immutable ? ASSETS_CACHE_CONTROL_IMMUTABLE : ASSETS_CACHE_CONTROL_REVALIDATE) != MHD_YES) return -1;
+	// Caches must store a representation per encoding
+	if (MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_VARY, MHD_HTTP_HEADER_ACCEPT_ENCODING) != MHD_YES) return -1;
+	return 0;
+}
+
+/** Create all responses of an asset. Responses are created once and shared by all requests, they point to the mapped bundle.
+ * @param Pointer_Asset The asset, its entry must be set.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int AssetsCreateResponses(TAssetsAsset *Pointer_Asset)
+{
+	TAssetsBundleEntry *Pointer_Entry = Pointer_Asset->Pointer_Entry;
+	TAssetsBundleRepresentation *Pointer_Representation;
+	struct MHD_Response *Pointer_Response;
+	int i;
+	
+	for (i = 0; i < ASSETS_BUNDLE_ENCODINGS_COUNT; i++)
+	{
+		// The identity representation is always present, even for an empty file
+		Pointer_Representation = &Pointer_Entry->Representations[i];
+		if ((i != ASSETS_BUNDLE_ENCODING_IDENTITY) && (Pointer_Representation->Size == 0)) continue;
+		
+		// Full response
+		Pointer_Response = MHD_create_response_from_buffer(Pointer_Representation->Size, (char *) Assets_Pointer_Bundle + Pointer_Representation->Offset, MHD_RESPMEM_PERSISTENT);
+		if (Pointer_Response == NULL) return -1;
+		Pointer_Asset->Pointer_Responses[i] = Pointer_Response;
+		if (MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CONTENT_TYPE, Pointer_Entry->String_Content_Type) != MHD_YES) return -1;
+		if ((i != ASSETS_BUNDLE_ENCODING_IDENTITY) && (MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CONTENT_ENCODING, Assets_Pointer_String_Encoding_Names[i]) != MHD_YES)) return -1;
+		if (AssetsAddCachingHeaders(Pointer_Response, Pointer_Entry, i) != 0) return -1;
+		
+		// Not modified response
+		Pointer_Response = MHD_create_response_from_buffer(0, NULL, MHD_RESPMEM_PERSISTENT);
+		if (Pointer_Response == NULL) return -1;
+		Pointer_Asset->Pointer_Not_Modified_Responses[i] = Pointer_Response;
+		if (AssetsAddCachingHeaders(Pointer_Response, Pointer_Entry, i) != 0) return -1;
+	}
+	
+	return 0;
+}
+
+/** Tell whether the browser accepts an encoding.
+ * @param Pointer_String_Accept_Encoding The Accept-Encoding header value (like "gzip, deflate;q=0.5, br").
+ * @param Pointer_String_Encoding_Name The encoding to look for.
+ * @return 1 if the encoding is accepted,
+ * @return 0 if the encoding is not listed or is explicitly refused with a zero quality value.
+ */
+static int AssetsIsEncodingAccepted(const char *Pointer_String_Accept_Encoding, const char *Pointer_String_Encoding_Name)
+{
+	const char *Pointer_String_Parameters;
+	size_t Name_Length, Encoding_Name_Length = strlen(Pointer_String_Encoding_Name);
+	int Is_Accepted, Is_Explicitly_Accepted = -1, Is_Accepted_By_Wildcard = 0;
+	
+	while (*Pointer_String_Accept_Encoding != 0)
+	{
+		// Find the coding name
+		Pointer_String_Accept_Encoding += strspn(Pointer_String_Accept_Encoding, " \t,");
+		Name_Length = strcspn(Pointer_String_Accept_Encoding, " \t,;");
+		if (Name_Length == 0) break;
+		
+		// A zero quality value means that the coding is refused
+		Pointer_String_Parameters = Pointer_String_Accept_Encoding + Name_Length;
+		Is_Accepted = 1;
+		while ((*Pointer_String_Parameters != 0) && (*Pointer_String_Parameters != ','))
+		{
+			if (((*Pointer_String_Parameters == 'q') || (*Pointer_String_Parameters == 'Q')) && (Pointer_String_Parameters[1] == '=')) Is_Accepted = strtod(&Pointer_String_Parameters[2], NULL) > 0;
+			Pointer_String_Parameters++;
+		}
+		
+		// An explicit coding takes precedence over the wildcard
+		if ((Name_Length == Encoding_Name_Length) && (strncasecmp(Pointer_String_Accept_Encoding, Pointer_String_Encoding_Name, Name_Length) == 0)) Is_Explicitly_Accepted = Is_Accepted;
+		else if ((Name_Length == 1) && (*Pointer_String_Accept_Encoding == '*')) Is_Accepted_By_Wildcard = Is_Accepted;
+		
+		Pointer_String_Accept_Encoding = Pointer_String_Parameters;
+	}
+	
+	if (Is_Explicitly_Accepted != -1) return Is_Explicitly_Accepted;
+	return Is_Accepted_By_Wildcard;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int AssetsInitialize(const char *Pointer_String_Bundle_File_Path)
+{
+	int File_Descriptor, i, j;
+	struct stat File_Status;
+	TAssetsBundleHeader *Pointer_Header;
+	TAssetsBundleEntry *Pointer_Entries;
+	TAssetsBundleRepresentation *Pointer_Representation;
+	
+	// Map the whole bundle, it is never modified while the server runs
+	File_Descriptor = open(Pointer_String_Bundle_File_Path, O_RDONLY);
+	if (File_Descriptor == -1)
+	{
+		syslog(LOG_ERR, "Failed to open assets bundle file '%s' (%m).", Pointer_String_Bundle_File_Path);
+		return -1;
+	}
+	if (fstat(File_Descriptor, &File_Status) != 0)
+	{
+		syslog(LOG_ERR, "Failed to get assets bundle file size (%m).");
+		close(File_Descriptor);
+		return -1;
+	}
+	Assets_Bundle_Size = File_Status.st_size;
+	if (Assets_Bundle_Size < sizeof(TAssetsBundleHeader))
+	{
+		syslog(LOG_ERR, "The assets bundle file is too small.");
+		close(File_Descriptor);
+		return -1;
+	}
+	Assets_Pointer_Bundle = mmap(NULL, Assets_Bundle_Size, PROT_READ, MAP_SHARED, File_Descriptor, 0);
+	close(File_Descriptor); // The mapping stays valid when the file is closed
+	if (Assets_Pointer_Bundle == MAP_FAILED)
+	{
+		syslog(LOG_ERR, "Failed to map assets bundle file to memory (%m).");
+		return -1;
+	}
+	
+	// Make sure the bundle has been built by a compatible packer
+	Pointer_Header = Assets_Pointer_Bundle;
+	if ((Pointer_Header->Magic_Number != ASSETS_BUNDLE_MAGIC_NUMBER) || (Pointer_Header->Format_Version != ASSETS_BUNDLE_FORMAT_VERSION) || !AssetsIsStringTerminated(Pointer_Header->String_Version, sizeof(Pointer_Header->String_Version)))
+	{
+		syslog(LOG_ERR, "The assets bundle file has not been built with the same format version than this server, rebuild it.");
+		goto Exit_Error;
+	}
+	if (Assets_Bundle_Size < sizeof(TAssetsBundleHeader) + Pointer_Header->Entries_Count * sizeof(TAssetsBundleEntry))
+	{
+		syslog(LOG_ERR, "The assets bundle file is truncated.");
+		goto Exit_Error;
+	}
+	
+	// Check all entries before trusting them
+	Pointer_Entries = (TAssetsBundleEntry *) (Pointer_Header + 1);
+	for (i = 0; i < Pointer_Header->Entries_Count; i++)
+	{
+		if (!AssetsIsStringTerminated(Pointer_Entries[i].String_URL, sizeof(Pointer_Entries[i].String_URL)) || !AssetsIsStringTerminated(Pointer_Entries[i].String_Content_Type, sizeof(Pointer_Entries[i].String_Content_Type)))
+		{
+			syslog(LOG_ERR, "The assets bundle entry %d is corrupted.", i);
+			goto Exit_Error;
+		}
+		for (j = 0; j < ASSETS_BUNDLE_ENCODINGS_COUNT; j++)
+		{
+			Pointer_Representation = &Pointer_Entries[i].Representations[j];
+			if (((unsigned long long) Pointer_Representation->Offset + Pointer_Representation->Size > Assets_Bundle_Size) || !AssetsIsStringTerminated(Pointer_Representation->String_ETag, sizeof(Pointer_Representation->String_ETag)))
+			{
+				syslog(LOG_ERR, "The assets bundle entry %d (%s) is corrupted.", i, Pointer_Entries[i].String_URL);
+				goto Exit_Error;
+			}
+		}
+	}
+	
+	// Create all responses once
+	Assets_Pointer_Assets = calloc(Pointer_Header->Entries_Count, sizeof(TAssetsAsset));
+	if ((Assets_Pointer_Assets == NULL) && (Pointer_Header->Entries_Count > 0))
+	{
+		syslog(LOG_ERR, "Failed to allocate assets responses.");
+		goto Exit_Error;
+	}
+	Assets_Assets_Count = Pointer_Header->Entries_Count;
+	for (i = 0; i < Assets_Assets_Count; i++)
+	{
+		Assets_Pointer_Assets[i].Pointer_Entry = &Pointer_Entries[i];
+		if (AssetsCreateResponses(&Assets_Pointer_Assets[i]) != 0)
+		{
+			syslog(LOG_ERR, "Failed to create asset '%s' responses.", Pointer_Entries[i].String_URL);
+			goto Exit_Error;
+		}
+	}
+	
+	syslog(LOG_INFO, "Assets bundle version %s loaded (%d assets, %zu bytes).", Pointer_Header->String_Version, Assets_Assets_Count, Assets_Bundle_Size);
+	return 0;
+	
+Exit_Error:
+	AssetsUninitialize();
+	return -1;
+}
+
+void AssetsUninitialize(void)
+{
+	int i, j;
+	
+	// Release the responses before the memory they point to
+	for (i = 0; i < Assets_Assets_Count; i++)
+	{
+		for (j = 0; j < ASSETS_BUNDLE_ENCODINGS_COUNT; j++)
+		{
+			if (Assets_Pointer_Assets[i].Pointer_Responses[j] != NULL) MHD_destroy_response(Assets_Pointer_Assets[i].Pointer_Responses[j]);
+			if (Assets_Pointer_Assets[i].Pointer_Not_Modified_Responses[j] != NULL) MHD_destroy_response(Assets_Pointer_Assets[i].Pointer_Not_Modified_Responses[j]);
+		}
+	}
+	free(Assets_Pointer_Assets);
+	Assets_Pointer_Assets = NULL;
+	Assets_Assets_Count = 0;
+	
+	if (Assets_Pointer_Bundle != MAP_FAILED)
+	{
+		munmap(Assets_Pointer_Bundle, Assets_Bundle_Size);
+		Assets_Pointer_Bundle = MAP_FAILED;
+	}
+}
+
+const char *AssetsGetVersion(void)
+{
+	if (Assets_Pointer_Bundle == MAP_FAILED) return "";
+	return ((TAssetsBundleHeader *) Assets_Pointer_Bundle)->String_Version;
+}
+
+int AssetsQueueResponse(struct MHD_Connection *Pointer_Connection, const char *Pointer_String_URL, int *Pointer_Return_Value)
+{
+	TAssetsAsset *Pointer_Asset = NULL;
+	const char *Pointer_String_Header_Value;
+	TAssetsBundleEncoding Encoding = ASSETS_BUNDLE_ENCODING_IDENTITY;
+	int i;
+	
+	// There are only a few assets, a linear search is fast enough
+	for (i = 0; i < Assets_Assets_Count; i++)
+	{
+		if (strcmp(Assets_Pointer_Assets[i].Pointer_Entry->String_URL, Pointer_String_URL) == 0)
+		{
+			Pointer_Asset = &Assets_Pointer_Assets[i];
+			break;
+		}
+	}
+	if (Pointer_Asset == NULL) return -1;
+	
+	// Select the smallest representation the browser can decode (brotli is always smaller than gzip for text)
+	Pointer_String_Header_Value = MHD_lookup_connection_value(Pointer_Connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_ACCEPT_ENCODING);
+	if (Pointer_String_Header_Value != NULL)
+	{
+		if ((Pointer_Asset->Pointer_Responses[ASSETS_BUNDLE_ENCODING_BROTLI] != NULL) && AssetsIsEncodingAccepted(Pointer_String_Header_Value, Assets_Pointer_String_Encoding_Names[ASSETS_BUNDLE_ENCODING_BROTLI])) Encoding = ASSETS_BUNDLE_ENCODING_BROTLI;
+		else if ((Pointer_Asset->Pointer_Responses[ASSETS_BUNDLE_ENCODING_GZIP] != NULL) && AssetsIsEncodingAccepted(Pointer_String_Header_Value, Assets_Pointer_String_Encoding_Names[ASSETS_BUNDLE_ENCODING_GZIP])) Encoding = ASSETS_BUNDLE_ENCODING_GZIP;
+	}
+	
+	// Do not send the asset again if the browser already has this representation (a weak comparison is allowed here, so a "W/" prefix does not matter)
+	Pointer_String_Header_Value = MHD_lookup_connection_value(Pointer_Connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+	if ((Pointer_String_Header_Value != NULL) && ((strcmp(Pointer_String_Header_Value, "*") == 0) || (strstr(Pointer_String_Header_Value, Pointer_Asset->Pointer_Entry->Representations[Encoding].String_ETag) != NULL)))
+	{
+		*Pointer_Return_Value = MetricsQueueResponse(Pointer_Connection, MHD_HTTP_NOT_MODIFIED, Pointer_Asset->Pointer_Not_Modified_Responses[Encoding]);
+		return 0;
+	}
+	
+	*Pointer_Return_Value = MetricsQueueResponse(Pointer_Connection, MHD_HTTP_OK, Pointer_Asset->Pointer_Responses[Encoding]);
+	return 0;
+}
@@ -4,10 +4,19 @@
  */
 #include <arpa/inet.h>
 #include <Boiler.h>
+#include <Configuration.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <syslog.h>
@@ -18,79 +27,1075 @@
 //-------------------------------------------------------------------------------------------------
 /** The magic number preceding all received and sent commands. */
 #define BOILER_PROTOCOL_MAGIC_NUMBER 0xA5
+/** The code of the frame a board sends right after connecting, its single payload byte is the board ID. */
+#define BOILER_PROTOCOL_BOARD_ANNOUNCEMENT_CODE 0x80
+/** The biggest frame size (magic number, command code and payload). */
+#define BOILER_PROTOCOL_FRAME_MAXIMUM_SIZE 16
+/** The status command answer payload size. */
+#define BOILER_STATUS_PAYLOAD_SIZE 13
+/** The apply settings command payload size. */
+#define BOILER_APPLY_SETTINGS_PAYLOAD_SIZE 9
+/** The telemetry block command answer payload size. */
+#define BOILER_TELEMETRY_BLOCK_PAYLOAD_SIZE 20
+/** Where the records start in the telemetry block command answer. */
+#define BOILER_TELEMETRY_BLOCK_RECORDS_OFFSET 7
+/** The task profile command answer payload size. */
+#define BOILER_TASK_PROFILE_PAYLOAD_SIZE 15
+
+/** Relays states bits in the status command answer. */
+#define BOILER_STATUS_RELAY_MIXING_VALVE_LEFT 0x01
+#define BOILER_STATUS_RELAY_MIXING_VALVE_RIGHT 0x02
+#define BOILER_STATUS_RELAY_PUMP 0x04
+#define BOILER_STATUS_RELAY_GAS_BURNER 0x08
+
+/** Tell which settings the apply settings command changes. */
+#define BOILER_APPLY_SETTINGS_FLAG_BOILER_RUNNING_MODE 0x01
+#define BOILER_APPLY_SETTINGS_FLAG_NIGHT_MODE 0x02
+#define BOILER_APPLY_SETTINGS_FLAG_DESIRED_ROOM_TEMPERATURES 0x04
+#define BOILER_APPLY_SETTINGS_FLAG_HEATING_CURVE_PARAMETERS 0x08
+
+/** The telemetry record types, stored in the record header byte bits 6 and 7. */
+#define BOILER_TELEMETRY_RECORD_TYPE_MASK 0xC0
+#define BOILER_TELEMETRY_RECORD_TYPE_UNCHANGED 0x00
+#define BOILER_TELEMETRY_RECORD_TYPE_DELTAS 0x80
+#define BOILER_TELEMETRY_RECORD_TYPE_ABSOLUTE 0xC0
+/** The telemetry record flags, stored in the record header byte. */
+#define BOILER_TELEMETRY_RECORD_FLAG_GAS_BURNER_ON 0x01
+#define BOILER_TELEMETRY_RECORD_FLAG_PUMP_ON 0x02
+#define BOILER_TELEMETRY_RECORD_FLAG_MIXING_VALVE_LEFT_RELAY_ON 0x04
+#define BOILER_TELEMETRY_RECORD_FLAG_MIXING_VALVE_RIGHT_RELAY_ON 0x08
+#define BOILER_TELEMETRY_RECORD_FLAGS_MIXING_VALVE_POSITION_SHIFT 4
+#define BOILER_TELEMETRY_RECORD_FLAGS_MIXING_VALVE_POSITION_MASK 0x30
+
+/** How many board connections can wait to be accepted. All boards reconnect at the same time when the server restarts, and a board reconnecting after a network failure must not be refused because its previous connection attempt is still pending. */
+#define BOILER_SERVER_LISTEN_BACKLOG 16
+/** How many newly connected boards can wait for their ID announcement at the same time. */
+#define BOILER_PENDING_CONNECTIONS_MAXIMUM_COUNT 16
+/** How many events the I/O thread retrieves at once. */
+#define BOILER_EPOLL_EVENTS_MAXIMUM_COUNT 32
+
+/** The kinds of descriptors the I/O thread watches. */
+#define BOILER_EVENT_SOURCE_SERVER_SOCKET 0
+#define BOILER_EVENT_SOURCE_WAKE_UP 1
+#define BOILER_EVENT_SOURCE_PENDING_CONNECTION 2
+#define BOILER_EVENT_SOURCE_BOARD 3
+
+/** Build an epoll event data value from the descriptor kind, the index of the context owning the descriptor and the descriptor itself (it allows to recognize the events of a descriptor closed while the previous events of the same batch were processed). */
+#define BOILER_MAKE_EVENT_DATA(Source, Index, Descriptor) (((uint64_t) (Source) << 56) | ((uint64_t) (Index) << 32) | (uint32_t) (Descriptor))
 
 //-------------------------------------------------------------------------------------------------
 // Private types
 //-------------------------------------------------------------------------------------------------
-/** All known commands. */
+/** Tell how a board transfer ended. */
 typedef enum
 {
-	BOILER_COMMAND_GET_FIRMWARE_VERSION,
-	BOILER_COMMAND_GET_SENSORS_RAW_TEMPERATURES,
-	BOILER_COMMAND_GET_SENSORS_CELSIUS_TEMPERATURES,
-	BOILER_COMMAND_GET_MIXING_VALVE_POSITION,
-	BOILER_COMMAND_SET_NIGHT_MODE,
-	BOILER_COMMAND_GET_DESIRED_ROOM_TEMPERATURES,
-	BOILER_COMMAND_SET_DESIRED_ROOM_TEMPERATURES,
-	BOILER_COMMAND_GET_TRIMMERS_RAW_VALUES,
-	BOILER_COMMAND_GET_BOILER_RUNNING_MODE,
-	BOILER_COMMAND_SET_BOILER_RUNNING_MODE,
-	BOILER_COMMAND_GET_TARGET_START_WATER_TEMPERATURE,
-	BOILER_COMMAND_GET_HEATING_CURVE_PARAMETERS,
-	BOILER_COMMAND_SET_HEATING_CURVE_PARAMETERS,
-	BOILER_COMMANDS_COUNT
-} TBoilerCommand;
+	BOILER_TRANSFER_RESULT_SUCCESS,
+	BOILER_TRANSFER_RESULT_TIMEOUT, //!< The board did not answer in time, the connection may still be usable.
+	BOILER_TRANSFER_RESULT_CONNECTION_ERROR //!< The connection is broken and must be closed.
+} TBoilerTransferResult;
+
+struct TBoilerBoard;
+
+/** A command waiting in a board queue to be sent. The descriptor of a submitted command lives on the submitting thread stack until the command is completed. */
+typedef struct
+{
+	TBoilerCommand Command; //!< The command code.
+	int Command_Payload_Size; //!< How many bytes of payload to send.
+	int Answer_Payload_Size; //!< How many bytes of payload to receive.
+	void *Pointer_Payload_Buffer; //!< The command payload on input, the answer payload on output.
+	unsigned long long Submission_Time; //!< When the command has been added to the queue (monotonic time in microseconds).
+	int Result; //!< Set to 0 if the command succeeded, set to -1 if it failed.
+	unsigned long long Round_Trip_Time; //!< How many microseconds elapsed between the command sending and the full answer reception (valid only if the command succeeded).
+	int Is_Completed; //!< Set to 1 by the I/O thread when the command has been processed.
+	pthread_cond_t Completion_Condition; //!< Signaled when the command has been processed.
+	void (*Completion_Callback)(struct TBoilerBoard *Pointer_Board); //!< Called by the I/O thread when the command has been processed, it allows the server to send commands on its own without a thread waiting for them. Set to NULL if not needed.
+} TBoilerCommandDescriptor;
+
+/** Everything the server knows about a board. Boards contexts are never freed, so statistics and status survive the reconnections. */
+typedef struct TBoilerBoard
+{
+	int ID; //!< The board ID, it is also the context index.
+	int Socket; //!< The board connection, set to -1 when the board is not connected.
+	
+	TBoilerCommandDescriptor *Command_Queue[CONFIGURATION_BOILER_COMMAND_QUEUE_SIZE]; //!< All commands waiting to be sent, in submission order.
+	int Command_Queue_Read_Index; //!< Index of the oldest queued command.
+	int Command_Queue_Count; //!< How many commands are queued.
+	
+	TBoilerCommandDescriptor *Pointer_Transfer_Descriptors[CONFIGURATION_BOILER_COMMAND_PIPELINE_DEPTH]; //!< The commands sent to the board in a single write, their answers come in the same order.
+	int Transfer_Descriptors_Count; //!< How many commands are in transfer, it is 0 when the link is idle.
+	unsigned char Transmission_Buffer[CONFIGURATION_BOILER_COMMAND_PIPELINE_DEPTH * BOILER_PROTOCOL_FRAME_MAXIMUM_SIZE]; //!< All concatenated commands of the transfer.
+	int Transmission_Size; //!< How many bytes the transmission buffer holds.
+	int Transmitted_Size; //!< How many bytes of the transmission buffer have been sent.
+	int Is_Write_Event_Enabled; //!< Set to 1 when the I/O thread waits for room in the socket buffer to send the rest of the transfer.
+	unsigned long long Transfer_Start_Time; //!< When the transfer commands started to be sent.
+	unsigned long long Transfer_Deadline; //!< When the answer being received must have been fully received.
+	int Answer_Index; //!< The transfer command whose answer is being received.
+	unsigned char Answer_Header[2]; //!< The last received bytes while the answer header is hunted for.
+	int Answer_Header_Size; //!< How many answer header bytes have been received.
+	int Answer_Payload_Received_Size; //!< How many answer payload bytes have been received.
+	int Discarded_Bytes_Count; //!< How many bytes have been discarded while hunting for the answer header.
+	
+	int Consecutive_Timeouts_Count; //!< How many transfers timed out in a row.
+	int Is_Resynchronizing; //!< Set to 1 while the late answers to the timed out commands are discarded.
+	unsigned long long Resynchronization_End_Time; //!< When to stop discarding the late answers.
+	unsigned long long Last_Transfer_End_Time; //!< When the link became idle, a heartbeat is sent if it stays idle for too long.
+	TBoilerCommandDescriptor Heartbeat_Descriptor; //!< The heartbeat is an ordinary command nobody waits for.
+	unsigned char Heartbeat_Answer; //!< The firmware version returned by the heartbeat.
+	
+	TBoilerCommandDescriptor Poll_Descriptor; //!< The periodic status poll.
+	unsigned char Poll_Answer[BOILER_STATUS_PAYLOAD_SIZE]; //!< The raw status returned by the poll.
+	int Is_Poll_Queued; //!< Set to 1 until the poll has been processed.
+	unsigned int Poll_Status_Version; //!< The snapshot version when the poll has been queued.
+	unsigned long long Next_Poll_Time; //!< When to queue the next poll.
+	
+	TBoilerCommandQueueStatistics Command_Queue_Statistics; //!< The command queue statistics.
+	TBoilerCommandStatistics Command_Statistics[BOILER_COMMANDS_COUNT]; //!< Each command round-trip time and error statistics.
+	TBoilerConnectionStatistics Connection_Statistics; //!< The connection statistics (the connection age is computed on demand from the connection time).
+	unsigned long long Connection_Time; //!< When the current connection has been established.
+	
+	TBoilerStatus Status; //!< The last status retrieved from the board.
+} TBoilerBoard;
+
+/** A board connection waiting for the board to announce its ID. */
+typedef struct
+{
+	int Socket; //!< The connection, set to -1 when the slot is free.
+	unsigned long long Deadline; //!< When to stop waiting for the announcement.
+	unsigned char Announcement[3]; //!< The last received bytes, the announcement is hunted for like a command answer.
+	int Announcement_Size; //!< How many bytes the announcement buffer holds.
+} TBoilerPendingConnection;
 
 //-------------------------------------------------------------------------------------------------
 // Private variables
 //-------------------------------------------------------------------------------------------------
 /** The server socket. */
 static int Boiler_Server_Socket = -1;
-/** The board socket. */
-static int Boiler_Board_Socket = -1;
+/** Watch all sockets served by the I/O thread. */
+static int Boiler_Epoll_Descriptor = -1;
+/** Wake the I/O thread up when a command has been queued or when it must exit. */
+static int Boiler_Wake_Up_Event_Descriptor = -1;
+
+/** All boards contexts, indexed by board ID. */
+static TBoilerBoard Boiler_Boards[CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT];
+/** The connections whose board has not announced its ID yet. */
+static TBoilerPendingConnection Boiler_Pending_Connections[BOILER_PENDING_CONNECTIONS_MAXIMUM_COUNT];
+/** Protect all boards contexts and the pending connections. */
+static pthread_mutex_t Boiler_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Broadcast each time a status snapshot content changes. */
+static pthread_cond_t Boiler_Status_Change_Condition = PTHREAD_COND_INITIALIZER;
+/** Incremented each time a status snapshot content changes, whatever the board is. */
+static unsigned int Boiler_Status_Changes_Count = 0;
+
+/** The thread serving all board connections. */
+static pthread_t Boiler_IO_Thread;
+/** Tell whether the I/O thread has been started. */
+static int Boiler_Is_IO_Thread_Started = 0;
+/** Set to 1 to make the I/O thread exit. */
+static int Boiler_Is_IO_Thread_Stop_Requested = 0;
 
 //-------------------------------------------------------------------------------------------------
 // Private functions
 //-------------------------------------------------------------------------------------------------
-/** Send a command and its payload and wait for the answer.
+/** Get a monotonic time.
+ * @return The time in microseconds.
+ */
+static unsigned long long BoilerGetCurrentTime(void)
+{
+	struct timespec Time;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return Time.tv_sec * 1000000ULL + Time.tv_nsec / 1000;
+}
+
+/** Compute the absolute time a condition wait must stop at.
+ * @param Pointer_Deadline On output, contain the deadline (CLOCK_REALTIME time, as expected by pthread_cond_timedwait()).
+ * @param Delay The delay in milliseconds from now.
+ */
+static void BoilerSetConditionDeadline(struct timespec *Pointer_Deadline, int Delay)
+{
+	clock_gettime(CLOCK_REALTIME, Pointer_Deadline);
+	Pointer_Deadline->tv_sec += Delay / 1000;
+	Pointer_Deadline->tv_nsec += (Delay % 1000) * 1000000L;
+	if (Pointer_Deadline->tv_nsec >= 1000000000L)
+	{
+		Pointer_Deadline->tv_sec++;
+		Pointer_Deadline->tv_nsec -= 1000000000L;
+	}
+}
+
+/** Get a board context.
+ * @param Board_ID The board ID.
+ * @return NULL if the board ID is out of range,
+ * @return The board context on success.
+ */
+static TBoilerBoard *BoilerGetBoard(int Board_ID)
+{
+	if ((Board_ID < 0) || (Board_ID >= CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT)) return NULL;
+	return &Boiler_Boards[Board_ID];
+}
+
+/** Tell the snapshot readers that a board snapshot content changed. Caller must hold the lock.
+ * @param Pointer_Board The board whose snapshot changed.
+ */
+static void BoilerPublishStatusChange(TBoilerBoard *Pointer_Board)
+{
+	Pointer_Board->Status.Version++;
+	Boiler_Status_Changes_Count++;
+	pthread_cond_broadcast(&Boiler_Status_Change_Condition);
+}
+
+/** Update a command statistics.
+ * @param Pointer_Board The board the command has been sent to.
+ * @param Pointer_Descriptor The processed command.
+ * @param Transfer_Result Why the transfer stopped.
+ */
+static void BoilerUpdateCommandStatistics(TBoilerBoard *Pointer_Board, TBoilerCommandDescriptor *Pointer_Descriptor, TBoilerTransferResult Transfer_Result)
+{
+	TBoilerCommandStatistics *Pointer_Statistics = &Pointer_Board->Command_Statistics[Pointer_Descriptor->Command];
+	int Bucket_Index;
+	
+	if (Pointer_Descriptor->Result != 0)
+	{
+		Pointer_Statistics->Failed_Commands_Count++;
+		if (Transfer_Result == BOILER_TRANSFER_RESULT_TIMEOUT) Pointer_Statistics->Timed_Out_Commands_Count++;
+		return;
+	}
+	
+	// Find the histogram bucket the round-trip time belongs to
+	for (Bucket_Index = 0; Bucket_Index < BOILER_ROUND_TRIP_TIME_HISTOGRAM_BUCKETS_COUNT - 1; Bucket_Index++)
+	{
+		if (Pointer_Descriptor->Round_Trip_Time < (1000ULL << Bucket_Index)) break;
+	}
+	Pointer_Statistics->Round_Trip_Time_Histogram[Bucket_Index]++;
+	Pointer_Statistics->Successful_Commands_Count++;
+	Pointer_Statistics->Total_Round_Trip_Time += Pointer_Descriptor->Round_Trip_Time;
+}
+
+/** Account for a processed command and tell whoever waits for it.
+ * @param Pointer_Board The board the command has been sent to.
+ * @param Pointer_Descriptor The processed command, its result must be set.
+ * @param Transfer_Result Why the transfer stopped.
+ */
+static void BoilerCompleteCommand(TBoilerBoard *Pointer_Board, TBoilerCommandDescriptor *Pointer_Descriptor, TBoilerTransferResult Transfer_Result)
+{
+	BoilerUpdateCommandStatistics(Pointer_Board, Pointer_Descriptor, Transfer_Result);
+	Pointer_Descriptor->Is_Completed = 1;
+	pthread_cond_signal(&Pointer_Descriptor->Completion_Condition);
+	if (Pointer_Descriptor->Completion_Callback != NULL) Pointer_Descriptor->Completion_Callback(Pointer_Board);
+}
+
+/** Append a command to a board queue.
+ * @param Pointer_Board The board.
+ * @param Pointer_Descriptor The command.
+ * @param Current_Time The current monotonic time in microseconds.
+ * @return -1 if the queue is full,
+ * @return 0 on success.
+ */
+static int BoilerEnqueueCommand(TBoilerBoard *Pointer_Board, TBoilerCommandDescriptor *Pointer_Descriptor, unsigned long long Current_Time)
+{
+	if (Pointer_Board->Command_Queue_Count >= CONFIGURATION_BOILER_COMMAND_QUEUE_SIZE)
+	{
+		Pointer_Board->Command_Queue_Statistics.Rejected_Commands_Count++;
+		return -1;
+	}
+	
+	Pointer_Descriptor->Submission_Time = Current_Time;
+	Pointer_Descriptor->Is_Completed = 0;
+	Pointer_Board->Command_Queue[(Pointer_Board->Command_Queue_Read_Index + Pointer_Board->Command_Queue_Count) % CONFIGURATION_BOILER_COMMAND_QUEUE_SIZE] = Pointer_Descriptor;
+	Pointer_Board->Command_Queue_Count++;
+	Pointer_Board->Command_Queue_Statistics.Current_Depth = Pointer_Board->Command_Queue_Count;
+	if ((unsigned int) Pointer_Board->Command_Queue_Count > Pointer_Board->Command_Queue_Statistics.Maximum_Depth) Pointer_Board->Command_Queue_Statistics.Maximum_Depth = Pointer_Board->Command_Queue_Count;
+	
+	return 0;
+}
+
+/** Remove the oldest command from a board queue.
+ * @param Pointer_Board The board, its queue must not be empty.
+ * @return The oldest queued command.
+ */
+static TBoilerCommandDescriptor *BoilerDequeueCommand(TBoilerBoard *Pointer_Board)
+{
+	TBoilerCommandDescriptor *Pointer_Descriptor;
+	
+	Pointer_Descriptor = Pointer_Board->Command_Queue[Pointer_Board->Command_Queue_Read_Index];
+	Pointer_Board->Command_Queue_Read_Index = (Pointer_Board->Command_Queue_Read_Index + 1) % CONFIGURATION_BOILER_COMMAND_QUEUE_SIZE;
+	Pointer_Board->Command_Queue_Count--;
+	Pointer_Board->Command_Queue_Statistics.Current_Depth = Pointer_Board->Command_Queue_Count;
+	
+	return Pointer_Descriptor;
+}
+
+/** Convert the status command answer.
+ * @param Pointer_Payload The answer payload.
+ * @param Pointer_Status On output, contain the board values. Snapshot management fields are not modified.
+ * @return -1 if the answer holds an unknown mixing valve position (the status is not modified),
+ * @return 0 on success.
+ */
+static int BoilerDecodeStatus(unsigned char *Pointer_Payload, TBoilerStatus *Pointer_Status)
+{
+	// The position is used as a table index by the status users, so never let a corrupted value reach them
+	if (Pointer_Payload[7] > BOILER_MIXING_VALVE_POSITION_RIGHT)
+	{
+		syslog(LOG_ERR, "The board status holds an unknown mixing valve position (%u), discarding it.", Pointer_Payload[7]);
+		return -1;
+	}
+	
+	// Temperatures
+	Pointer_Status->Outside_Temperature = (signed char) Pointer_Payload[0];
+	Pointer_Status->Radiator_Start_Water_Temperature = (signed char) Pointer_Payload[1];
+	Pointer_Status->Target_Radiator_Start_Water_Temperature = (signed char) Pointer_Payload[2];
+	Pointer_Status->Desired_Day_Temperature = (signed char) Pointer_Payload[3];
+	Pointer_Status->Desired_Night_Temperature = (signed char) Pointer_Payload[4];
+	
+	// Modes
+	Pointer_Status->Is_Boiler_Running = Pointer_Payload[5] ? 1 : 0;
+	Pointer_Status->Is_Night_Mode_Enabled = Pointer_Payload[6] ? 1 : 0;
+	Pointer_Status->Mixing_Valve_Position = Pointer_Payload[7];
+	
+	// Relays
+	Pointer_Status->Is_Mixing_Valve_Left_Relay_On = (Pointer_Payload[8] & BOILER_STATUS_RELAY_MIXING_VALVE_LEFT) ? 1 : 0;
+	Pointer_Status->Is_Mixing_Valve_Right_Relay_On = (Pointer_Payload[8] & BOILER_STATUS_RELAY_MIXING_VALVE_RIGHT) ? 1 : 0;
+	Pointer_Status->Is_Pump_On = (Pointer_Payload[8] & BOILER_STATUS_RELAY_PUMP) ? 1 : 0;
+	Pointer_Status->Is_Gas_Burner_On = (Pointer_Payload[8] & BOILER_STATUS_RELAY_GAS_BURNER) ? 1 : 0;
+	
+	// Heating curve (board sends 16-bit values in little endian)
+	Pointer_Status->Heating_Curve_Coefficient = Pointer_Payload[9] | (Pointer_Payload[10] << 8);
+	Pointer_Status->Heating_Curve_Parallel_Shift = Pointer_Payload[11] | (Pointer_Payload[12] << 8);
+	
+	return 0;
+}
+
+/** Tell whether two statuses hold the same board values (the snapshot bookkeeping fields are not compared).
+ * @param Pointer_Status_A The first status.
+ * @param Pointer_Status_B The second status.
+ * @return 0 if at least a value differs,
+ * @return 1 if all values are equal.
+ */
+static int BoilerAreStatusValuesEqual(TBoilerStatus *Pointer_Status_A, TBoilerStatus *Pointer_Status_B)
+{
+	return (Pointer_Status_A->Outside_Temperature == Pointer_Status_B->Outside_Temperature) && (Pointer_Status_A->Radiator_Start_Water_Temperature == Pointer_Status_B->Radiator_Start_Water_Temperature)
+		&& (Pointer_Status_A->Target_Radiator_Start_Water_Temperature == Pointer_Status_B->Target_Radiator_Start_Water_Temperature) && (Pointer_Status_A->Desired_Day_Temperature == Pointer_Status_B->Desired_Day_Temperature)
+		&& (Pointer_Status_A->Desired_Night_Temperature == Pointer_Status_B->Desired_Night_Temperature) && (Pointer_Status_A->Is_Boiler_Running == Pointer_Status_B->Is_Boiler_Running)
+		&& (Pointer_Status_A->Is_Night_Mode_Enabled == Pointer_Status_B->Is_Night_Mode_Enabled) && (Pointer_Status_A->Mixing_Valve_Position == Pointer_Status_B->Mixing_Valve_Position)
+		&& (Pointer_Status_A->Is_Mixing_Valve_Left_Relay_On == Pointer_Status_B->Is_Mixing_Valve_Left_Relay_On) && (Pointer_Status_A->Is_Mixing_Valve_Right_Relay_On == Pointer_Status_B->Is_Mixing_Valve_Right_Relay_On)
+		&& (Pointer_Status_A->Is_Pump_On == Pointer_Status_B->Is_Pump_On) && (Pointer_Status_A->Is_Gas_Burner_On == Pointer_Status_B->Is_Gas_Burner_On)
+		&& (Pointer_Status_A->Heating_Curve_Coefficient == Pointer_Status_B->Heating_Curve_Coefficient) && (Pointer_Status_A->Heating_Curve_Parallel_Shift == Pointer_Status_B->Heating_Curve_Parallel_Shift);
+}
+
+/** Publish the values retrieved by a board status poll. Called by the I/O thread when the poll command has been processed.
+ * @param Pointer_Board The polled board.
+ */
+static void BoilerPollCompletionCallback(TBoilerBoard *Pointer_Board)
+{
+	TBoilerStatus Status;
+	
+	Pointer_Board->Is_Poll_Queued = 0;
+	
+	// A setting has been changed while the board was polled, the retrieved values may be older than the ones in the snapshot, so poll again
+	if (Pointer_Board->Status.Version != Pointer_Board->Poll_Status_Version)
+	{
+		Pointer_Board->Next_Poll_Time = 0;
+		return;
+	}
+	
+	// Publish the new values, waking the snapshot readers up only if something changed
+	Status = Pointer_Board->Status;
+	if ((Pointer_Board->Poll_Descriptor.Result == 0) && (BoilerDecodeStatus(Pointer_Board->Poll_Answer, &Status) == 0))
+	{
+		Pointer_Board->Status.Update_Time = time(NULL);
+		if (!Pointer_Board->Status.Is_Valid || !BoilerAreStatusValuesEqual(&Status, &Pointer_Board->Status))
+		{
+			Status.Is_Valid = 1;
+			Status.Update_Time = Pointer_Board->Status.Update_Time;
+			Pointer_Board->Status = Status;
+			BoilerPublishStatusChange(Pointer_Board);
+		}
+	}
+	else if (Pointer_Board->Status.Is_Valid)
+	{
+		Pointer_Board->Status.Is_Valid = 0;
+		BoilerPublishStatusChange(Pointer_Board);
+	}
+}
+
+/** Select the events the I/O thread waits for on a board socket.
+ * @param Pointer_Board The connected board.
+ * @param Is_Write_Event_Enabled Set to 1 to be woken up when there is room in the socket buffer, set to 0 to be woken up only when data are received.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int BoilerSetBoardSocketEvents(TBoilerBoard *Pointer_Board, int Is_Write_Event_Enabled)
+{
+	struct epoll_event Event;
+	
+	Event.events = EPOLLIN;
+	if (Is_Write_Event_Enabled) Event.events |= EPOLLOUT;
+	Event.data.u64 = BOILER_MAKE_EVENT_DATA(BOILER_EVENT_SOURCE_BOARD, Pointer_Board->ID, Pointer_Board->Socket);
+	if (epoll_ctl(Boiler_Epoll_Descriptor, EPOLL_CTL_MOD, Pointer_Board->Socket, &Event) != 0)
+	{
+		syslog(LOG_ERR, "Failed to select board %d socket events (%s).", Pointer_Board->ID, strerror(errno));
+		return -1;
+	}
+	Pointer_Board->Is_Write_Event_Enabled = Is_Write_Event_Enabled;
+	
+	return 0;
+}
+
+/** Close a board connection, failing all its queued and in transfer commands.
+ * @param Pointer_Board The connected board.
+ */
+static void BoilerCloseBoardConnection(TBoilerBoard *Pointer_Board)
+{
+	TBoilerCommandDescriptor *Pointer_Descriptor;
+	int i;
+	
+	// Closing the socket removes it from the watched descriptors
+	close(Pointer_Board->Socket);
+	Pointer_Board->Socket = -1;
+	Pointer_Board->Connection_Statistics.Is_Connected = 0;
+	Pointer_Board->Connection_Statistics.Lost_Connections_Count++;
+	
+	// The commands that did not get their answer yet will never get it
+	for (i = Pointer_Board->Answer_Index; i < Pointer_Board->Transfer_Descriptors_Count; i++) BoilerCompleteCommand(Pointer_Board, Pointer_Board->Pointer_Transfer_Descriptors[i], BOILER_TRANSFER_RESULT_CONNECTION_ERROR);
+	Pointer_Board->Transfer_Descriptors_Count = 0;
+	
+	// Do not keep the queued commands submitters waiting for a board that may never come back
+	while (Pointer_Board->Command_Queue_Count > 0)
+	{
+		Pointer_Descriptor = BoilerDequeueCommand(Pointer_Board);
+		Pointer_Descriptor->Result = -1;
+		BoilerCompleteCommand(Pointer_Board, Pointer_Descriptor, BOILER_TRANSFER_RESULT_CONNECTION_ERROR);
+	}
+	
+	// Tell the snapshot readers immediately instead of waiting for a poll that won't happen
+	if (Pointer_Board->Status.Is_Valid)
+	{
+		Pointer_Board->Status.Is_Valid = 0;
+		BoilerPublishStatusChange(Pointer_Board);
+	}
+}
+
+/** Send the part of the transfer commands that has not been sent yet, without blocking.
+ * @param Pointer_Board The connected board.
+ * @return -1 if the connection is not usable anymore,
+ * @return 0 on success (the I/O thread will be woken up to send the remaining bytes if the socket buffer is full).
+ */
+static int BoilerSendTransmissionBuffer(TBoilerBoard *Pointer_Board)
+{
+	ssize_t Sent_Size;
+	
+	while (Pointer_Board->Transmitted_Size < Pointer_Board->Transmission_Size)
+	{
+		Sent_Size = send(Pointer_Board->Socket, &Pointer_Board->Transmission_Buffer[Pointer_Board->Transmitted_Size], Pointer_Board->Transmission_Size - Pointer_Board->Transmitted_Size, MSG_NOSIGNAL); // Do not get killed by SIGPIPE if the board closed the connection
+		if (Sent_Size > 0)
+		{
+			Pointer_Board->Transmitted_Size += Sent_Size;
+			continue;
+		}
+		if (errno == EINTR) continue;
+		
+		// Socket buffer is full, wait for room
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+		{
+			if (Pointer_Board->Is_Write_Event_Enabled) return 0;
+			return BoilerSetBoardSocketEvents(Pointer_Board, 1);
+		}
+		
+		syslog(LOG_ERR, "Failed to send commands to board %d (first command code : %d, commands count : %d, size : %d, %s).", Pointer_Board->ID, Pointer_Board->Pointer_Transfer_Descriptors[0]->Command, Pointer_Board->Transfer_Descriptors_Count, Pointer_Board->Transmission_Size, strerror(errno));
+		return -1;
+	}
+	
+	// Everything has been sent, stop waiting for room
+	if (Pointer_Board->Is_Write_Event_Enabled) return BoilerSetBoardSocketEvents(Pointer_Board, 0);
+	return 0;
+}
+
+/** Take as many queued commands as can be pipelined and start sending them in a single write.
+ * @param Pointer_Board The connected board, its link must be idle and its queue must not be empty.
+ * @param Current_Time The current monotonic time in microseconds.
+ * @return -1 if the connection is not usable anymore,
+ * @return 0 on success.
+ */
+static int BoilerStartTransfer(TBoilerBoard *Pointer_Board, unsigned long long Current_Time)
+{
+	TBoilerCommandDescriptor *Pointer_Descriptor;
+	unsigned long long Wait_Time;
+	int Size = 0;
+	
+	Pointer_Board->Transfer_Descriptors_Count = 0;
+	while ((Pointer_Board->Command_Queue_Count > 0) && (Pointer_Board->Transfer_Descriptors_Count < CONFIGURATION_BOILER_COMMAND_PIPELINE_DEPTH))
+	{
+		Pointer_Descriptor = BoilerDequeueCommand(Pointer_Board);
+		Pointer_Descriptor->Result = -1; // The transfer will tell which commands succeeded
+		Pointer_Board->Pointer_Transfer_Descriptors[Pointer_Board->Transfer_Descriptors_Count] = Pointer_Descriptor;
+		Pointer_Board->Transfer_Descriptors_Count++;
+		
+		// Update statistics
+		Wait_Time = Current_Time - Pointer_Descriptor->Submission_Time;
+		Pointer_Board->Command_Queue_Statistics.Total_Wait_Time += Wait_Time;
+		if (Wait_Time > Pointer_Board->Command_Queue_Statistics.Maximum_Wait_Time) Pointer_Board->Command_Queue_Statistics.Maximum_Wait_Time = Wait_Time;
+		Pointer_Board->Command_Queue_Statistics.Processed_Commands_Count++;
+		
+		// Concatenate all commands
+		Pointer_Board->Transmission_Buffer[Size] = BOILER_PROTOCOL_MAGIC_NUMBER;
+		Pointer_Board->Transmission_Buffer[Size + 1] = Pointer_Descriptor->Command;
+		memcpy(&Pointer_Board->Transmission_Buffer[Size + 2], Pointer_Descriptor->Pointer_Payload_Buffer, Pointer_Descriptor->Command_Payload_Size);
+		Size += Pointer_Descriptor->Command_Payload_Size + 2; // Take magic number and command code into account
+	}
+	Pointer_Board->Transmission_Size = Size;
+	Pointer_Board->Transmitted_Size = 0;
+	
+	// Answers come in the same order than commands
+	Pointer_Board->Answer_Index = 0;
+	Pointer_Board->Answer_Header_Size = 0;
+	Pointer_Board->Answer_Payload_Received_Size = 0;
+	Pointer_Board->Discarded_Bytes_Count = 0;
+	Pointer_Board->Transfer_Start_Time = Current_Time;
+	Pointer_Board->Transfer_Deadline = Current_Time + CONFIGURATION_BOILER_COMMAND_TIMEOUT * 1000ULL;
+	
+	return BoilerSendTransmissionBuffer(Pointer_Board);
+}
+
+/** Feed the bytes received from a board to the answers parser, completing the commands whose answer is complete.
+ * @param Pointer_Board The connected board.
+ * @param Pointer_Buffer The received bytes.
+ * @param Size How many bytes have been received.
+ * @param Current_Time The current monotonic time in microseconds.
+ */
+static void BoilerProcessReceivedData(TBoilerBoard *Pointer_Board, unsigned char *Pointer_Buffer, int Size, unsigned long long Current_Time)
+{
+	TBoilerCommandDescriptor *Pointer_Descriptor;
+	int Copied_Size;
+	
+	while (1)
+	{
+		// Late answers to timed out commands and unexpected bytes are dropped
+		if (Pointer_Board->Is_Resynchronizing || (Pointer_Board->Answer_Index >= Pointer_Board->Transfer_Descriptors_Count)) return;
+		Pointer_Descriptor = Pointer_Board->Pointer_Transfer_Descriptors[Pointer_Board->Answer_Index];
+		
+		// Complete the command as soon as its whole answer has been received
+		if ((Pointer_Board->Answer_Header_Size == 2) && (Pointer_Board->Answer_Payload_Received_Size == Pointer_Descriptor->Answer_Payload_Size))
+		{
+			if (Pointer_Board->Discarded_Bytes_Count > 0) syslog(LOG_WARNING, "Discarded %d bytes to resynchronize with board %d (command code : %d).", Pointer_Board->Discarded_Bytes_Count, Pointer_Board->ID, Pointer_Descriptor->Command);
+			Pointer_Descriptor->Round_Trip_Time = Current_Time - Pointer_Board->Transfer_Start_Time;
+			Pointer_Descriptor->Result = 0;
+			BoilerCompleteCommand(Pointer_Board, Pointer_Descriptor, BOILER_TRANSFER_RESULT_SUCCESS);
+			
+			// Next answer gets its own full delay
+			Pointer_Board->Answer_Index++;
+			Pointer_Board->Answer_Header_Size = 0;
+			Pointer_Board->Answer_Payload_Received_Size = 0;
+			Pointer_Board->Discarded_Bytes_Count = 0;
+			Pointer_Board->Transfer_Deadline = Current_Time + CONFIGURATION_BOILER_COMMAND_TIMEOUT * 1000ULL;
+			
+			// The link is idle again when all answers have been received
+			if (Pointer_Board->Answer_Index == Pointer_Board->Transfer_Descriptors_Count)
+			{
+				Pointer_Board->Transfer_Descriptors_Count = 0;
+				Pointer_Board->Answer_Index = 0;
+				Pointer_Board->Consecutive_Timeouts_Count = 0;
+				Pointer_Board->Last_Transfer_End_Time = Current_Time;
+			}
+			continue;
+		}
+		if (Size == 0) return;
+		
+		// Hunt for the magic number followed by the expected command code
+		if (Pointer_Board->Answer_Header_Size < 2)
+		{
+			Pointer_Board->Answer_Header[Pointer_Board->Answer_Header_Size] = *Pointer_Buffer;
+			Pointer_Board->Answer_Header_Size++;
+			Pointer_Buffer++;
+			Size--;
+			if ((Pointer_Board->Answer_Header_Size == 2) && ((Pointer_Board->Answer_Header[0] != BOILER_PROTOCOL_MAGIC_NUMBER) || (Pointer_Board->Answer_Header[1] != Pointer_Descriptor->Command)))
+			{
+				Pointer_Board->Answer_Header[0] = Pointer_Board->Answer_Header[1];
+				Pointer_Board->Answer_Header_Size = 1;
+				Pointer_Board->Discarded_Bytes_Count++;
+			}
+			continue;
+		}
+		
+		// Receive the answer payload directly in the submitter buffer
+		Copied_Size = Pointer_Descriptor->Answer_Payload_Size - Pointer_Board->Answer_Payload_Received_Size;
+		if (Copied_Size > Size) Copied_Size = Size;
+		memcpy((unsigned char *) Pointer_Descriptor->Pointer_Payload_Buffer + Pointer_Board->Answer_Payload_Received_Size, Pointer_Buffer, Copied_Size);
+		Pointer_Board->Answer_Payload_Received_Size += Copied_Size;
+		Pointer_Buffer += Copied_Size;
+		Size -= Copied_Size;
+	}
+}
+
+/** Read everything a board sent, without blocking.
+ * @param Pointer_Board The connected board.
+ * @param Current_Time The current monotonic time in microseconds.
+ * @return -1 if the connection is not usable anymore,
+ * @return 0 on success.
+ */
+static int BoilerReceiveBoardData(TBoilerBoard *Pointer_Board, unsigned long long Current_Time)
+{
+	unsigned char Buffer[256];
+	ssize_t Size;
+	
+	while (1)
+	{
+		Size = recv(Pointer_Board->Socket, Buffer, sizeof(Buffer), 0);
+		if (Size > 0)
+		{
+			BoilerProcessReceivedData(Pointer_Board, Buffer, Size, Current_Time);
+			continue;
+		}
+		if (Size == 0)
+		{
+			syslog(LOG_ERR, "Board %d closed the connection.", Pointer_Board->ID);
+			return -1;
+		}
+		if (errno == EINTR) continue;
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) return 0;
+		
+		syslog(LOG_ERR, "Failed to receive data from board %d (%s).", Pointer_Board->ID, strerror(errno));
+		return -1;
+	}
+}
+
+/** Handle a board deadlines, schedule the status poll and the heartbeat, and start the next transfer if the link is idle.
+ * @param Pointer_Board The board.
+ * @param Current_Time The current monotonic time in microseconds.
+ */
+static void BoilerServiceBoard(TBoilerBoard *Pointer_Board, unsigned long long Current_Time)
+{
+	int i;
+	
+	if (Pointer_Board->Socket == -1) return;
+	
+	// Give up on the commands that did not get their answer in time
+	if ((Pointer_Board->Transfer_Descriptors_Count > 0) && (Current_Time >= Pointer_Board->Transfer_Deadline))
+	{
+		if (Pointer_Board->Transmitted_Size < Pointer_Board->Transmission_Size) syslog(LOG_ERR, "Timed out while sending commands to board %d (first command code : %d, commands count : %d, size : %d).", Pointer_Board->ID, Pointer_Board->Pointer_Transfer_Descriptors[0]->Command, Pointer_Board->Transfer_Descriptors_Count, Pointer_Board->Transmission_Size);
+		else syslog(LOG_ERR, "Timed out while waiting for board %d answer (command code : %d).", Pointer_Board->ID, Pointer_Board->Pointer_Transfer_Descriptors[Pointer_Board->Answer_Index]->Command);
+		for (i = Pointer_Board->Answer_Index; i < Pointer_Board->Transfer_Descriptors_Count; i++) BoilerCompleteCommand(Pointer_Board, Pointer_Board->Pointer_Transfer_Descriptors[i], BOILER_TRANSFER_RESULT_TIMEOUT);
+		Pointer_Board->Transfer_Descriptors_Count = 0;
+		Pointer_Board->Answer_Index = 0;
+		
+		// Drop what could not be sent
+		Pointer_Board->Transmitted_Size = Pointer_Board->Transmission_Size;
+		if (Pointer_Board->Is_Write_Event_Enabled && (BoilerSetBoardSocketEvents(Pointer_Board, 0) != 0))
+		{
+			BoilerCloseBoardConnection(Pointer_Board);
+			return;
+		}
+		
+		// Keep the connection, the board may be only slow, but give up if it does not answer anymore
+		Pointer_Board->Consecutive_Timeouts_Count++;
+		if (Pointer_Board->Consecutive_Timeouts_Count >= CONFIGURATION_BOILER_MAXIMUM_CONSECUTIVE_TIMEOUTS)
+		{
+			syslog(LOG_ERR, "Board %d did not answer to %d consecutive commands, closing connection.", Pointer_Board->ID, Pointer_Board->Consecutive_Timeouts_Count);
+			BoilerCloseBoardConnection(Pointer_Board);
+			return;
+		}
+		
+		// Get rid of the answers to the timed out commands before sending the next ones
+		Pointer_Board->Is_Resynchronizing = 1;
+		Pointer_Board->Resynchronization_End_Time = Current_Time + CONFIGURATION_BOILER_RESYNCHRONIZATION_DELAY * 1000ULL;
+	}
+	
+	// Wait for the end of the resynchronization or of the transfer in progress
+	if (Pointer_Board->Is_Resynchronizing)
+	{
+		if (Current_Time < Pointer_Board->Resynchronization_End_Time) return;
+		Pointer_Board->Is_Resynchronizing = 0;
+	}
+	if (Pointer_Board->Transfer_Descriptors_Count > 0) return;
+	
+	// Periodically refresh the status snapshot, so web pages never need to wait for the board
+	if (!Pointer_Board->Is_Poll_Queued && (Current_Time >= Pointer_Board->Next_Poll_Time))
+	{
+		Pointer_Board->Poll_Status_Version = Pointer_Board->Status.Version;
+		if (BoilerEnqueueCommand(Pointer_Board, &Pointer_Board->Poll_Descriptor, Current_Time) == 0) Pointer_Board->Is_Poll_Queued = 1;
+		Pointer_Board->Next_Poll_Time = Current_Time + CONFIGURATION_BOILER_STATUS_POLLING_PERIOD * 1000000ULL;
+	}
+	
+	// Probe the board when the link stays idle for too long, so a dead board is detected even if nobody uses it
+	if ((Pointer_Board->Command_Queue_Count == 0) && (Current_Time >= Pointer_Board->Last_Transfer_End_Time + CONFIGURATION_BOILER_HEARTBEAT_PERIOD * 1000000ULL)) BoilerEnqueueCommand(Pointer_Board, &Pointer_Board->Heartbeat_Descriptor, Current_Time);
+	
+	if ((Pointer_Board->Command_Queue_Count > 0) && (BoilerStartTransfer(Pointer_Board, Current_Time) != 0)) BoilerCloseBoardConnection(Pointer_Board);
+}
+
+/** Tell when a board needs to be serviced again.
+ * @param Pointer_Board The board.
+ * @return ULLONG_MAX if the board is not connected,
+ * @return The monotonic time in microseconds of the next board deadline or scheduled command.
+ */
+static unsigned long long BoilerGetBoardNextEventTime(TBoilerBoard *Pointer_Board)
+{
+	unsigned long long Time;
+	
+	if (Pointer_Board->Socket == -1) return ULLONG_MAX;
+	if (Pointer_Board->Transfer_Descriptors_Count > 0) return Pointer_Board->Transfer_Deadline;
+	if (Pointer_Board->Is_Resynchronizing) return Pointer_Board->Resynchronization_End_Time;
+	if (Pointer_Board->Command_Queue_Count > 0) return 0; // The next transfer can start right now
+	
+	Time = Pointer_Board->Last_Transfer_End_Time + CONFIGURATION_BOILER_HEARTBEAT_PERIOD * 1000000ULL;
+	if (!Pointer_Board->Is_Poll_Queued && (Pointer_Board->Next_Poll_Time < Time)) Time = Pointer_Board->Next_Poll_Time;
+	return Time;
+}
+
+/** Configure a newly connected board socket so a dead board is noticed in seconds rather than hours.
+ * @param Socket The board socket.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int BoilerConfigureBoardSocket(int Socket)
+{
+	int Value = 1;
+	
+	// Probe the board when the link stays idle, the kernel defaults wait more than two hours before the first probe
+	if (setsockopt(Socket, SOL_SOCKET, SO_KEEPALIVE, &Value, sizeof(Value)) != 0) goto Error;
+	Value = CONFIGURATION_BOILER_KEEPALIVE_IDLE_TIME;
+	if (setsockopt(Socket, IPPROTO_TCP, TCP_KEEPIDLE, &Value, sizeof(Value)) != 0) goto Error;
+	Value = CONFIGURATION_BOILER_KEEPALIVE_INTERVAL;
+	if (setsockopt(Socket, IPPROTO_TCP, TCP_KEEPINTVL, &Value, sizeof(Value)) != 0) goto Error;
+	Value = CONFIGURATION_BOILER_KEEPALIVE_PROBES_COUNT;
+	if (setsockopt(Socket, IPPROTO_TCP, TCP_KEEPCNT, &Value, sizeof(Value)) != 0) goto Error;
+	
+	// Keepalive probes are not sent while data is waiting to be acknowledged, so bound the retransmissions too
+	Value = CONFIGURATION_BOILER_TCP_USER_TIMEOUT;
+	if (setsockopt(Socket, IPPROTO_TCP, TCP_USER_TIMEOUT, &Value, sizeof(Value)) != 0) goto Error;
+	
+	// The I/O thread serves all boards, it must never block on one of them
+	if (fcntl(Socket, F_SETFL, fcntl(Socket, F_GETFL) | O_NONBLOCK) != 0) goto Error;
+	
+	return 0;
+	
+Error:
+	syslog(LOG_ERR, "Failed to configure board socket (%s).", strerror(errno));
+	return -1;
+}
+
+/** Close a connection whose board has not been identified.
+ * @param Pointer_Pending_Connection The connection.
+ */
+static void BoilerClosePendingConnection(TBoilerPendingConnection *Pointer_Pending_Connection)
+{
+	close(Pointer_Pending_Connection->Socket);
+	Pointer_Pending_Connection->Socket = -1;
+}
+
+/** Make a connection the board connection, replacing the previous board connection : a board reconnecting after a network failure means the previous connection is dead, even if the server did not notice it yet.
+ * @param Pointer_Pending_Connection The connection, its slot is freed.
+ * @param Board_ID The board ID.
+ * @param Current_Time The current monotonic time in microseconds.
+ */
+static void BoilerAttachBoardConnection(TBoilerPendingConnection *Pointer_Pending_Connection, int Board_ID, unsigned long long Current_Time)
+{
+	TBoilerBoard *Pointer_Board = &Boiler_Boards[Board_ID];
+	
+	if (Pointer_Board->Socket != -1)
+	{
+		syslog(LOG_INFO, "Replacing previous board %d connection.", Board_ID);
+		BoilerCloseBoardConnection(Pointer_Board);
+	}
+	
+	// Start from an idle link
+	Pointer_Board->Socket = Pointer_Pending_Connection->Socket;
+	Pointer_Pending_Connection->Socket = -1;
+	Pointer_Board->Transfer_Descriptors_Count = 0;
+	Pointer_Board->Consecutive_Timeouts_Count = 0;
+	Pointer_Board->Is_Resynchronizing = 0;
+	Pointer_Board->Last_Transfer_End_Time = Current_Time;
+	if (BoilerSetBoardSocketEvents(Pointer_Board, 0) != 0)
+	{
+		close(Pointer_Board->Socket);
+		Pointer_Board->Socket = -1;
+		return;
+	}
+	
+	Pointer_Board->Connection_Statistics.Is_Connected = 1;
+	Pointer_Board->Connection_Statistics.Connections_Count++;
+	Pointer_Board->Connection_Time = Current_Time;
+	
+	// Do not wait for the next poll to get the new board values
+	Pointer_Board->Next_Poll_Time = Current_Time;
+}
+
+/** Accept all waiting board connections, the boards are identified when their announcement is received.
+ * @param Current_Time The current monotonic time in microseconds.
+ */
+static void BoilerAcceptConnections(unsigned long long Current_Time)
+{
+	struct sockaddr_in Address;
+	socklen_t Address_Size;
+	int Socket, i;
+	struct epoll_event Event;
+	TBoilerPendingConnection *Pointer_Pending_Connection;
+	
+	while (1)
+	{
+		Address_Size = sizeof(Address);
+		Socket = accept(Boiler_Server_Socket, (struct sockaddr *) &Address, &Address_Size);
+		if (Socket == -1)
+		{
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) return; // All connections have been accepted
+			if ((errno == EINTR) || (errno == ECONNABORTED)) continue;
+			syslog(LOG_ERR, "Failed to accept next board connection (%s).", strerror(errno));
+			return;
+		}
+		syslog(LOG_INFO, "Board connected with address %s:%d.", inet_ntoa(Address.sin_addr), ntohs(Address.sin_port));
+		
+		if (BoilerConfigureBoardSocket(Socket) != 0)
+		{
+			close(Socket);
+			continue;
+		}
+		
+		// Find a free slot to wait for the board announcement
+		for (i = 0; i < BOILER_PENDING_CONNECTIONS_MAXIMUM_COUNT; i++)
+		{
+			if (Boiler_Pending_Connections[i].Socket == -1) break;
+		}
+		if (i == BOILER_PENDING_CONNECTIONS_MAXIMUM_COUNT)
+		{
+			syslog(LOG_ERR, "Too many boards are waiting to be identified, closing the new connection.");
+			close(Socket);
+			continue;
+		}
+		Pointer_Pending_Connection = &Boiler_Pending_Connections[i];
+		
+		Event.events = EPOLLIN;
+		Event.data.u64 = BOILER_MAKE_EVENT_DATA(BOILER_EVENT_SOURCE_PENDING_CONNECTION, i, Socket);
+		if (epoll_ctl(Boiler_Epoll_Descriptor, EPOLL_CTL_ADD, Socket, &Event) != 0)
+		{
+			syslog(LOG_ERR, "Failed to watch board connection (%s).", strerror(errno));
+			close(Socket);
+			continue;
+		}
+		Pointer_Pending_Connection->Socket = Socket;
+		Pointer_Pending_Connection->Deadline = Current_Time + CONFIGURATION_BOILER_ANNOUNCEMENT_TIMEOUT * 1000ULL;
+		Pointer_Pending_Connection->Announcement_Size = 0;
+	}
+}
+
+/** Look for the board announcement in the data received on a connection whose board has not been identified yet.
+ * @param Pointer_Pending_Connection The connection.
+ * @param Current_Time The current monotonic time in microseconds.
+ */
+static void BoilerReceiveAnnouncement(TBoilerPendingConnection *Pointer_Pending_Connection, unsigned long long Current_Time)
+{
+	unsigned char Buffer[64], *Pointer_Announcement = Pointer_Pending_Connection->Announcement;
+	ssize_t Size, i;
+	
+	while (1)
+	{
+		Size = recv(Pointer_Pending_Connection->Socket, Buffer, sizeof(Buffer), 0);
+		if (Size == 0)
+		{
+			syslog(LOG_ERR, "Board closed the connection before announcing its ID.");
+			BoilerClosePendingConnection(Pointer_Pending_Connection);
+			return;
+		}
+		if (Size < 0)
+		{
+			if (errno == EINTR) continue;
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) return;
+			syslog(LOG_ERR, "Failed to receive board announcement (%s).", strerror(errno));
+			BoilerClosePendingConnection(Pointer_Pending_Connection);
+			return;
+		}
+		
+		// Hunt for the magic number followed by the announcement code and the board ID
+		for (i = 0; i < Size; i++)
+		{
+			Pointer_Announcement[Pointer_Pending_Connection->Announcement_Size] = Buffer[i];
+			Pointer_Pending_Connection->Announcement_Size++;
+			if (Pointer_Pending_Connection->Announcement_Size < 3) continue;
+			
+			if ((Pointer_Announcement[0] == BOILER_PROTOCOL_MAGIC_NUMBER) && (Pointer_Announcement[1] == BOILER_PROTOCOL_BOARD_ANNOUNCEMENT_CODE))
+			{
+				if (Pointer_Announcement[2] >= CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT)
+				{
+					syslog(LOG_ERR, "Board announced ID %d, which is not in range [0; %d], closing connection.", Pointer_Announcement[2], CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT - 1);
+					BoilerClosePendingConnection(Pointer_Pending_Connection);
+					return;
+				}
+				syslog(LOG_INFO, "Board %d identified.", Pointer_Announcement[2]);
+				BoilerAttachBoardConnection(Pointer_Pending_Connection, Pointer_Announcement[2], Current_Time);
+				return; // The board does not send anything else before receiving a command
+			}
+			
+			Pointer_Announcement[0] = Pointer_Announcement[1];
+			Pointer_Announcement[1] = Pointer_Announcement[2];
+			Pointer_Pending_Connection->Announcement_Size = 2;
+		}
+	}
+}
+
+/** Serve all board connections : accept and identify the boards, send the queued commands, receive the answers and handle all timeouts, without ever blocking on a board.
+ * @param Pointer_Parameters Unused.
+ * @return Always NULL.
+ */
+static void *BoilerIOThread(void __attribute__((unused)) *Pointer_Parameters)
+{
+	struct epoll_event Events[BOILER_EPOLL_EVENTS_MAXIMUM_COUNT];
+	int Events_Count, Timeout, Source, Index, Socket, i;
+	unsigned long long Current_Time, Next_Event_Time, Time;
+	uint64_t Wake_Up_Counter;
+	TBoilerBoard *Pointer_Board;
+	TBoilerPendingConnection *Pointer_Pending_Connection;
+	
+	pthread_mutex_lock(&Boiler_Mutex);
+	while (!Boiler_Is_IO_Thread_Stop_Requested)
+	{
+		// Find when the next deadline or scheduled command is due
+		Current_Time = BoilerGetCurrentTime();
+		Next_Event_Time = ULLONG_MAX;
+		for (i = 0; i < CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT; i++)
+		{
+			Time = BoilerGetBoardNextEventTime(&Boiler_Boards[i]);
+			if (Time < Next_Event_Time) Next_Event_Time = Time;
+		}
+		for (i = 0; i < BOILER_PENDING_CONNECTIONS_MAXIMUM_COUNT; i++)
+		{
+			if ((Boiler_Pending_Connections[i].Socket != -1) && (Boiler_Pending_Connections[i].Deadline < Next_Event_Time)) Next_Event_Time = Boiler_Pending_Connections[i].Deadline;
+		}
+		if (Next_Event_Time == ULLONG_MAX) Timeout = -1;
+		else if (Next_Event_Time <= Current_Time) Timeout = 0;
+		else Timeout = (int) ((Next_Event_Time - Current_Time + 999) / 1000); // Round up, so the deadline has been reached when waking up
+		
+		// Wait without holding the lock, so commands can be submitted in the meantime
+		pthread_mutex_unlock(&Boiler_Mutex);
+		Events_Count = epoll_wait(Boiler_Epoll_Descriptor, Events, BOILER_EPOLL_EVENTS_MAXIMUM_COUNT, Timeout);
+		pthread_mutex_lock(&Boiler_Mutex);
+		if (Events_Count < 0)
+		{
+			if (errno != EINTR)
+			{
+				syslog(LOG_ERR, "Failed to wait for board events (%s).", strerror(errno));
+				break;
+			}
+			Events_Count = 0;
+		}
+		
+		Current_Time = BoilerGetCurrentTime();
+		for (i = 0; i < Events_Count; i++)
+		{
+			Source = Events[i].data.u64 >> 56;
+			Index = (Events[i].data.u64 >> 32) & 0xFFFFFF;
+			Socket = (int) (uint32_t) Events[i].data.u64;
+			
+			switch (Source)
+			{
+				case BOILER_EVENT_SOURCE_SERVER_SOCKET:
+					BoilerAcceptConnections(Current_Time);
+					break;
+					
+				case BOILER_EVENT_SOURCE_WAKE_UP:
+					// Only clear the event, the queued commands are sent below
+					if (read(Boiler_Wake_Up_Event_Descriptor, &Wake_Up_Counter, sizeof(Wake_Up_Counter)) < 0) syslog(LOG_ERR, "Failed to clear the board I/O thread wake up event (%s).", strerror(errno));
+					break;
+					
+				case BOILER_EVENT_SOURCE_PENDING_CONNECTION:
+					Pointer_Pending_Connection = &Boiler_Pending_Connections[Index];
+					if (Pointer_Pending_Connection->Socket == Socket) BoilerReceiveAnnouncement(Pointer_Pending_Connection, Current_Time);
+					break;
+					
+				case BOILER_EVENT_SOURCE_BOARD:
+					Pointer_Board = &Boiler_Boards[Index];
+					if (Pointer_Board->Socket != Socket) break; // The connection has been closed while processing the previous events
+					
+					// Receiving reports the connection errors
+					if ((Events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && (BoilerReceiveBoardData(Pointer_Board, Current_Time) != 0))
+					{
+						BoilerCloseBoardConnection(Pointer_Board);
+						break;
+					}
+					if ((Events[i].events & EPOLLOUT) && (BoilerSendTransmissionBuffer(Pointer_Board) != 0)) BoilerCloseBoardConnection(Pointer_Board);
+					break;
+			}
+		}
+		
+		// The boards that did not announce their ID run an older firmware
+		for (i = 0; i < BOILER_PENDING_CONNECTIONS_MAXIMUM_COUNT; i++)
+		{
+			Pointer_Pending_Connection = &Boiler_Pending_Connections[i];
+			if ((Pointer_Pending_Connection->Socket != -1) && (Current_Time >= Pointer_Pending_Connection->Deadline))
+			{
+				syslog(LOG_WARNING, "Board did not announce its ID, giving it the default ID %d.", CONFIGURATION_BOILER_DEFAULT_BOARD_ID);
+				BoilerAttachBoardConnection(Pointer_Pending_Connection, CONFIGURATION_BOILER_DEFAULT_BOARD_ID, Current_Time);
+			}
+		}
+		
+		for (i = 0; i < CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT; i++) BoilerServiceBoard(&Boiler_Boards[i], Current_Time);
+	}
+	
+	// Fail all commands that could not be sent
+	for (i = 0; i < CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT; i++)
+	{
+		if (Boiler_Boards[i].Socket != -1) BoilerCloseBoardConnection(&Boiler_Boards[i]);
+	}
+	for (i = 0; i < BOILER_PENDING_CONNECTIONS_MAXIMUM_COUNT; i++)
+	{
+		if (Boiler_Pending_Connections[i].Socket != -1) BoilerClosePendingConnection(&Boiler_Pending_Connections[i]);
+	}
+	pthread_mutex_unlock(&Boiler_Mutex);
+	
+	return NULL;
+}
+
+/** Queue a command and wait for the I/O thread to send it and receive its answer.
+ * @param Board_ID The board to send the command to.
  * @param Command The command code.
  * @param Command_Payload_Size How may bytes of payload to send (set to 0 if the command has no payload).
  * @param Answer_Payload_Size How many bytes of payload to wait for (set to 0 for a command providing no answer other than magic number and command code).
  * @param Pointer_Payload_Buffer The payload (if any). Make sure the buffer is big enough for answer.
- * @return -1 if an error occurred (board connection is automatically closed in this case),
+ * @return -1 if an error occurred (board connection is automatically closed if the board does not answer anymore),
  * @return 0 on success.
  */
-static int BoilerSendCommand(TBoilerCommand Command, int Command_Payload_Size, int Answer_Payload_Size, void *Pointer_Payload_Buffer)
+static int BoilerSendCommand(int Board_ID, TBoilerCommand Command, int Command_Payload_Size, int Answer_Payload_Size, void *Pointer_Payload_Buffer)
 {
-	unsigned char Buffer[16];
+	TBoilerBoard *Pointer_Board;
+	TBoilerCommandDescriptor Descriptor;
+	uint64_t Wake_Up_Value = 1;
+	
+	Pointer_Board = BoilerGetBoard(Board_ID);
+	if (Pointer_Board == NULL) return -1;
 	
-	// Create the full command
-	Buffer[0] = BOILER_PROTOCOL_MAGIC_NUMBER;
-	Buffer[1] = Command;
-	memcpy(&Buffer[2], Pointer_Payload_Buffer, Command_Payload_Size);
-	Command_Payload_Size += 2; // Adjust command size to take all fields into account
+	// Prepare the command
+	Descriptor.Command = Command;
+	Descriptor.Command_Payload_Size = Command_Payload_Size;
+	Descriptor.Answer_Payload_Size = Answer_Payload_Size;
+	Descriptor.Pointer_Payload_Buffer = Pointer_Payload_Buffer;
+	Descriptor.Completion_Callback = NULL;
+	pthread_cond_init(&Descriptor.Completion_Condition, NULL);
 	
-	// Send command
-	if (write(Boiler_Board_Socket, Buffer, Command_Payload_Size) != Command_Payload_Size)
+	pthread_mutex_lock(&Boiler_Mutex);
+	
+	// Do not wait for a board that is not connected
+	if (Pointer_Board->Socket == -1)
 	{
-		close(Boiler_Board_Socket);
-		syslog(LOG_ERR, "Failed to send command (command code : %d, command size : %d, %s).", Command, Command_Payload_Size, strerror(errno));
+		Pointer_Board->Command_Statistics[Command].Failed_Commands_Count++;
+		pthread_mutex_unlock(&Boiler_Mutex);
+		pthread_cond_destroy(&Descriptor.Completion_Condition);
 		return -1;
 	}
 	
-	// Wait for the answer
-	Answer_Payload_Size += 2; // Adjust answer size to take all fields into account
-	if (read(Boiler_Board_Socket, Buffer, Answer_Payload_Size) != Answer_Payload_Size)
+	// Do not wait for room in the queue, a full queue means that the board link is saturated
+	if (BoilerEnqueueCommand(Pointer_Board, &Descriptor, BoilerGetCurrentTime()) != 0)
 	{
-		close(Boiler_Board_Socket);
-		syslog(LOG_ERR, "Failed to receive answer (command code : %d, command size : %d, %s).", Command, Answer_Payload_Size, strerror(errno));
+		pthread_mutex_unlock(&Boiler_Mutex);
+		pthread_cond_destroy(&Descriptor.Completion_Condition);
+		syslog(LOG_WARNING, "Board %d command queue is full, dropping command %d.", Board_ID, Command);
 		return -1;
 	}
 	
-	// Copy answer to buffer
-	memcpy(Pointer_Payload_Buffer, &Buffer[2], Answer_Payload_Size - 2);
+	// The I/O thread sends the command as soon as the board link is idle
+	if (write(Boiler_Wake_Up_Event_Descriptor, &Wake_Up_Value, sizeof(Wake_Up_Value)) < 0) syslog(LOG_ERR, "Failed to wake the board I/O thread up (%s).", strerror(errno));
+	while (!Descriptor.Is_Completed) pthread_cond_wait(&Descriptor.Completion_Condition, &Boiler_Mutex);
 	
-	return 0;
+	pthread_mutex_unlock(&Boiler_Mutex);
+	pthread_cond_destroy(&Descriptor.Completion_Condition);
+	
+	return Descriptor.Result;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -98,8 +1103,33 @@ static int BoilerSendCommand(TBoilerCommand Command, int Command_Payload_Size, i
 //-------------------------------------------------------------------------------------------------
 int BoilerInitializeServer(void)
 {
-	int Is_Enabled = 1;
+	int Is_Enabled = 1, i;
 	struct sockaddr_in Address;
+	struct epoll_event Event;
+	TBoilerBoard *Pointer_Board;
+	
+	// Each board gets its own status poll and heartbeat commands
+	for (i = 0; i < CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT; i++)
+	{
+		Pointer_Board = &Boiler_Boards[i];
+		Pointer_Board->ID = i;
+		Pointer_Board->Socket = -1;
+		
+		Pointer_Board->Heartbeat_Descriptor.Command = BOILER_COMMAND_GET_FIRMWARE_VERSION;
+		Pointer_Board->Heartbeat_Descriptor.Command_Payload_Size = 0;
+		Pointer_Board->Heartbeat_Descriptor.Answer_Payload_Size = sizeof(Pointer_Board->Heartbeat_Answer);
+		Pointer_Board->Heartbeat_Descriptor.Pointer_Payload_Buffer = &Pointer_Board->Heartbeat_Answer;
+		Pointer_Board->Heartbeat_Descriptor.Completion_Callback = NULL;
+		pthread_cond_init(&Pointer_Board->Heartbeat_Descriptor.Completion_Condition, NULL);
+		
+		Pointer_Board->Poll_Descriptor.Command = BOILER_COMMAND_GET_STATUS;
+		Pointer_Board->Poll_Descriptor.Command_Payload_Size = 0;
+		Pointer_Board->Poll_Descriptor.Answer_Payload_Size = sizeof(Pointer_Board->Poll_Answer);
+		Pointer_Board->Poll_Descriptor.Pointer_Payload_Buffer = Pointer_Board->Poll_Answer;
+		Pointer_Board->Poll_Descriptor.Completion_Callback = BoilerPollCompletionCallback;
+		pthread_cond_init(&Pointer_Board->Poll_Descriptor.Completion_Condition, NULL);
+	}
+	for (i = 0; i < BOILER_PENDING_CONNECTIONS_MAXIMUM_COUNT; i++) Boiler_Pending_Connections[i].Socket = -1;
 	
 	// Try to create server socket
 	Boiler_Server_Socket = socket(AF_INET, SOCK_STREAM, 0);
@@ -118,131 +1148,543 @@ int BoilerInitializeServer(void)
 	Address.sin_addr.s_addr = INADDR_ANY;
 	if (bind(Boiler_Server_Socket, (const struct sockaddr *) &Address, sizeof(Address)) != 0)
 	{
-		close(Boiler_Server_Socket);
 		syslog(LOG_ERR, "Failed to bind server socket (%s).", strerror(errno));
-		return -1;
+		goto Error;
 	}
 	
-	// Accept only one client at a time
-	if (listen(Boiler_Server_Socket, 1) != 0)
+	// Several boards can connect at the same time, and a reconnecting board must not be refused
+	if (listen(Boiler_Server_Socket, BOILER_SERVER_LISTEN_BACKLOG) != 0)
 	{
-		close(Boiler_Server_Socket);
 		syslog(LOG_ERR, "Failed to configure server socket connections listening (%s).", strerror(errno));
-		return -1;
+		goto Error;
+	}
+	
+	// The I/O thread accepts all waiting connections in a row, it must never block in accept()
+	if (fcntl(Boiler_Server_Socket, F_SETFL, fcntl(Boiler_Server_Socket, F_GETFL) | O_NONBLOCK) != 0)
+	{
+		syslog(LOG_ERR, "Failed to configure server socket non-blocking mode (%s).", strerror(errno));
+		goto Error;
+	}
+	
+	// Watch the server socket and the wake up event, the board sockets will be added when the boards connect
+	Boiler_Epoll_Descriptor = epoll_create1(0);
+	if (Boiler_Epoll_Descriptor == -1)
+	{
+		syslog(LOG_ERR, "Failed to create board events watcher (%s).", strerror(errno));
+		goto Error;
+	}
+	Boiler_Wake_Up_Event_Descriptor = eventfd(0, EFD_NONBLOCK);
+	if (Boiler_Wake_Up_Event_Descriptor == -1)
+	{
+		syslog(LOG_ERR, "Failed to create board I/O thread wake up event (%s).", strerror(errno));
+		goto Error;
+	}
+	Event.events = EPOLLIN;
+	Event.data.u64 = BOILER_MAKE_EVENT_DATA(BOILER_EVENT_SOURCE_SERVER_SOCKET, 0, Boiler_Server_Socket);
+	if (epoll_ctl(Boiler_Epoll_Descriptor, EPOLL_CTL_ADD, Boiler_Server_Socket, &Event) != 0)
+	{
+		syslog(LOG_ERR, "Failed to watch server socket (%s).", strerror(errno));
+		goto Error;
 	}
+	Event.data.u64 = BOILER_MAKE_EVENT_DATA(BOILER_EVENT_SOURCE_WAKE_UP, 0, Boiler_Wake_Up_Event_Descriptor);
+	if (epoll_ctl(Boiler_Epoll_Descriptor, EPOLL_CTL_ADD, Boiler_Wake_Up_Event_Descriptor, &Event) != 0)
+	{
+		syslog(LOG_ERR, "Failed to watch board I/O thread wake up event (%s).", strerror(errno));
+		goto Error;
+	}
+	
+	// Start serving the boards
+	Boiler_Is_IO_Thread_Stop_Requested = 0;
+	if (pthread_create(&Boiler_IO_Thread, NULL, BoilerIOThread, NULL) != 0)
+	{
+		syslog(LOG_ERR, "Failed to create board I/O thread.");
+		goto Error;
+	}
+	Boiler_Is_IO_Thread_Started = 1;
 	
 	return 0;
+	
+Error:
+	BoilerUninitializeServer();
+	return -1;
 }
 
 void BoilerUninitializeServer(void)
 {
-	if (Boiler_Board_Socket != -1) close(Boiler_Board_Socket);
-	if (Boiler_Server_Socket != -1) close(Boiler_Server_Socket);
+	uint64_t Wake_Up_Value = 1;
+	
+	// Stop the I/O thread, failing all pending commands
+	if (Boiler_Is_IO_Thread_Started)
+	{
+		pthread_mutex_lock(&Boiler_Mutex);
+		Boiler_Is_IO_Thread_Stop_Requested = 1;
+		pthread_mutex_unlock(&Boiler_Mutex);
+		if (write(Boiler_Wake_Up_Event_Descriptor, &Wake_Up_Value, sizeof(Wake_Up_Value)) < 0) syslog(LOG_ERR, "Failed to wake the board I/O thread up (%s).", strerror(errno));
+		pthread_join(Boiler_IO_Thread, NULL);
+		Boiler_Is_IO_Thread_Started = 0;
+	}
+	
+	if (Boiler_Wake_Up_Event_Descriptor != -1)
+	{
+		close(Boiler_Wake_Up_Event_Descriptor);
+		Boiler_Wake_Up_Event_Descriptor = -1;
+	}
+	if (Boiler_Epoll_Descriptor != -1)
+	{
+		close(Boiler_Epoll_Descriptor);
+		Boiler_Epoll_Descriptor = -1;
+	}
+	if (Boiler_Server_Socket != -1)
+	{
+		close(Boiler_Server_Socket);
+		Boiler_Server_Socket = -1;
+	}
 }
 
-int BoilerRunServer(void)
+int BoilerParseBoardID(const char *Pointer_String_Board_ID)
 {
-	struct sockaddr_in Address;
-	socklen_t Address_Size;
-	int Is_Enabled = 1;
+	char *Pointer_String_End;
+	long Board_ID;
+	
+	if (Pointer_String_Board_ID == NULL) return CONFIGURATION_BOILER_DEFAULT_BOARD_ID;
+	
+	Board_ID = strtol(Pointer_String_Board_ID, &Pointer_String_End, 10);
+	if ((Pointer_String_End == Pointer_String_Board_ID) || (*Pointer_String_End != 0) || (Board_ID < 0) || (Board_ID >= CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT)) return -1;
+	return (int) Board_ID;
+}
+
+int BoilerGetKnownBoards(int *Pointer_Board_IDs)
+{
+	int i, Count = 0;
+	
+	pthread_mutex_lock(&Boiler_Mutex);
+	for (i = 0; i < CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT; i++)
+	{
+		if (Boiler_Boards[i].Connection_Statistics.Connections_Count > 0)
+		{
+			Pointer_Board_IDs[Count] = i;
+			Count++;
+		}
+	}
+	pthread_mutex_unlock(&Boiler_Mutex);
+	
+	return Count;
+}
+
+void BoilerGetCommandQueueStatistics(int Board_ID, TBoilerCommandQueueStatistics *Pointer_Statistics)
+{
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID);
+	
+	if (Pointer_Board == NULL)
+	{
+		memset(Pointer_Statistics, 0, sizeof(TBoilerCommandQueueStatistics));
+		return;
+	}
+	
+	pthread_mutex_lock(&Boiler_Mutex);
+	*Pointer_Statistics = Pointer_Board->Command_Queue_Statistics;
+	pthread_mutex_unlock(&Boiler_Mutex);
+}
+
+int BoilerGetCommandStatistics(int Board_ID, TBoilerCommand Command, TBoilerCommandStatistics *Pointer_Statistics)
+{
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID);
+	
+	if ((Pointer_Board == NULL) || (Command >= BOILER_COMMANDS_COUNT)) return -1;
+	
+	pthread_mutex_lock(&Boiler_Mutex);
+	*Pointer_Statistics = Pointer_Board->Command_Statistics[Command];
+	pthread_mutex_unlock(&Boiler_Mutex);
+	
+	return 0;
+}
+
+void BoilerGetConnectionStatistics(int Board_ID, TBoilerConnectionStatistics *Pointer_Statistics)
+{
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID);
+	
+	if (Pointer_Board == NULL)
+	{
+		memset(Pointer_Statistics, 0, sizeof(TBoilerConnectionStatistics));
+		return;
+	}
+	
+	pthread_mutex_lock(&Boiler_Mutex);
+	*Pointer_Statistics = Pointer_Board->Connection_Statistics;
+	if (Pointer_Statistics->Is_Connected) Pointer_Statistics->Connection_Age = (BoilerGetCurrentTime() - Pointer_Board->Connection_Time) / 1000000;
+	pthread_mutex_unlock(&Boiler_Mutex);
+}
+
+const char *BoilerGetCommandName(TBoilerCommand Command)
+{
+	static const char *Pointer_Strings_Names[BOILER_COMMANDS_COUNT] =
+	{
+		"get_firmware_version",
+		"get_sensors_raw_temperatures",
+		"get_sensors_celsius_temperatures",
+		"get_mixing_valve_position",
+		"set_night_mode",
+		"get_desired_room_temperatures",
+		"set_desired_room_temperatures",
+		"get_trimmers_raw_values",
+		"get_boiler_running_mode",
+		"set_boiler_running_mode",
+		"get_target_start_water_temperature",
+		"get_heating_curve_parameters",
+		"set_heating_curve_parameters",
+		"get_status",
+		"apply_settings",
+		"get_telemetry_block",
+		"get_task_profile"
+	};
+	
+	if (Command >= BOILER_COMMANDS_COUNT) return "unknown";
+	return Pointer_Strings_Names[Command];
+}
+
+void BoilerGetStatusSnapshot(int Board_ID, TBoilerStatus *Pointer_Status)
+{
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID);
+	
+	// A board that does not exist is never reachable
+	if (Pointer_Board == NULL)
+	{
+		memset(Pointer_Status, 0, sizeof(TBoilerStatus));
+		return;
+	}
+	
+	pthread_mutex_lock(&Boiler_Mutex);
+	*Pointer_Status = Pointer_Board->Status;
+	pthread_mutex_unlock(&Boiler_Mutex);
+}
+
+int BoilerWaitForStatusSnapshotChange(int Board_ID, unsigned int Known_Version, int Timeout)
+{
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID);
+	struct timespec Wake_Up_Time;
+	int Is_Changed;
+	
+	if (Pointer_Board == NULL) return 0;
+	
+	BoilerSetConditionDeadline(&Wake_Up_Time, Timeout);
+	pthread_mutex_lock(&Boiler_Mutex);
+	while (Pointer_Board->Status.Version == Known_Version)
+	{
+		if (pthread_cond_timedwait(&Boiler_Status_Change_Condition, &Boiler_Mutex, &Wake_Up_Time) == ETIMEDOUT) break;
+	}
+	Is_Changed = (Pointer_Board->Status.Version != Known_Version);
+	pthread_mutex_unlock(&Boiler_Mutex);
+	
+	return Is_Changed;
+}
+
+unsigned int BoilerWaitForAnyStatusSnapshotChange(unsigned int Known_Changes_Count, int Timeout)
+{
+	struct timespec Wake_Up_Time;
+	unsigned int Changes_Count;
+	
+	BoilerSetConditionDeadline(&Wake_Up_Time, Timeout);
+	pthread_mutex_lock(&Boiler_Mutex);
+	while (Boiler_Status_Changes_Count == Known_Changes_Count)
+	{
+		if (pthread_cond_timedwait(&Boiler_Status_Change_Condition, &Boiler_Mutex, &Wake_Up_Time) == ETIMEDOUT) break;
+	}
+	Changes_Count = Boiler_Status_Changes_Count;
+	pthread_mutex_unlock(&Boiler_Mutex);
+	
+	return Changes_Count;
+}
+
+int BoilerGetStatus(int Board_ID, TBoilerStatus *Pointer_Status)
+{
+	unsigned char Payload[BOILER_STATUS_PAYLOAD_SIZE];
+	
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_STATUS, 0, sizeof(Payload), Payload) != 0) return -1;
+	return BoilerDecodeStatus(Payload, Pointer_Status);
+}
+
+int BoilerApplySettings(int Board_ID, TBoilerSettings *Pointer_Settings)
+{
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID); // Can't be NULL if the command succeeded
+	unsigned char Payload[BOILER_STATUS_PAYLOAD_SIZE]; // The answer is bigger than the command
+	TBoilerStatus Status;
+	
+	// Build the command (board expects 16-bit values in little endian)
+	memset(Payload, 0, sizeof(Payload));
+	if (Pointer_Settings->Is_Boiler_Running_Mode_Present)
+	{
+		Payload[0] |= BOILER_APPLY_SETTINGS_FLAG_BOILER_RUNNING_MODE;
+		Payload[1] = Pointer_Settings->Is_Boiler_Running ? 1 : 0;
+	}
+	if (Pointer_Settings->Is_Night_Mode_Present)
+	{
+		Payload[0] |= BOILER_APPLY_SETTINGS_FLAG_NIGHT_MODE;
+		Payload[2] = Pointer_Settings->Is_Night_Mode_Enabled ? 1 : 0;
+	}
+	if (Pointer_Settings->Are_Desired_Room_Temperatures_Present)
+	{
+		Payload[0] |= BOILER_APPLY_SETTINGS_FLAG_DESIRED_ROOM_TEMPERATURES;
+		Payload[3] = (unsigned char) Pointer_Settings->Desired_Day_Temperature;
+		Payload[4] = (unsigned char) Pointer_Settings->Desired_Night_Temperature;
+	}
+	if (Pointer_Settings->Are_Heating_Curve_Parameters_Present)
+	{
+		Payload[0] |= BOILER_APPLY_SETTINGS_FLAG_HEATING_CURVE_PARAMETERS;
+		Payload[5] = (unsigned char) Pointer_Settings->Heating_Curve_Coefficient;
+		Payload[6] = (unsigned char) (Pointer_Settings->Heating_Curve_Coefficient >> 8);
+		Payload[7] = (unsigned char) Pointer_Settings->Heating_Curve_Parallel_Shift;
+		Payload[8] = (unsigned char) (Pointer_Settings->Heating_Curve_Parallel_Shift >> 8);
+	}
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_APPLY_SETTINGS, BOILER_APPLY_SETTINGS_PAYLOAD_SIZE, BOILER_STATUS_PAYLOAD_SIZE, Payload) != 0) return -1;
 	
-	// Wait for a client to connect
-	Address_Size = sizeof(Address);
-	Boiler_Board_Socket = accept(Boiler_Server_Socket, (struct sockaddr *) &Address, &Address_Size);
-	if (Boiler_Board_Socket == -1)
+	// The answer is the whole board state, so the snapshot is as fresh as after a poll
+	pthread_mutex_lock(&Boiler_Mutex);
+	Status = Pointer_Board->Status;
+	if (BoilerDecodeStatus(Payload, &Status) != 0)
 	{
-		syslog(LOG_ERR, "Failed to accept next board connection (%s).", strerror(errno));
+		pthread_mutex_unlock(&Boiler_Mutex);
 		return -1;
 	}
-	syslog(LOG_INFO, "Board connected with address %s:%d.", inet_ntoa(Address.sin_addr), ntohs(Address.sin_port));
+	Status.Is_Valid = 1;
+	Status.Update_Time = time(NULL);
+	Pointer_Board->Status = Status;
+	BoilerPublishStatusChange(Pointer_Board);
+	pthread_mutex_unlock(&Boiler_Mutex);
 	
-	// Enable keep alive to keep connection with board open
-	setsockopt(Boiler_Board_Socket, SOL_SOCKET, SO_KEEPALIVE, &Is_Enabled, sizeof(Is_Enabled));
+	return 0;
+}
+
+int BoilerGetTelemetrySamples(int Board_ID, time_t Start_Time, TBoilerTelemetrySample *Pointer_Samples, int Maximum_Samples_Count)
+{
+	unsigned char Payload[BOILER_TELEMETRY_BLOCK_PAYLOAD_SIZE], *Pointer_Records, Header;
+	unsigned short Cursor, Next_Sample_Number, First_Sample_Number, Sample_Number;
+	int Samples_Count = 0, Block_Samples_Count, Sampling_Period, Offset, Record_Size, Outside_Temperature = 0, Radiator_Start_Water_Temperature = 0, Target_Radiator_Start_Water_Temperature = 0, i;
+	time_t Last_Sample_Time, Sample_Time;
+	TBoilerTelemetrySample *Pointer_Sample;
+	
+	// Any cursor returns the board time reference, use it to find the first sample to download
+	memset(Payload, 0, sizeof(Payload));
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_TELEMETRY_BLOCK, 2, sizeof(Payload), Payload) != 0) return -1;
+	Next_Sample_Number = Payload[0] | (Payload[1] << 8);
+	Last_Sample_Time = time(NULL) - Payload[2];
+	Sampling_Period = Payload[3];
+	if ((Sampling_Period == 0) || (Start_Time >= Last_Sample_Time)) return 0;
+	if ((Last_Sample_Time - Start_Time) / Sampling_Period >= SHRT_MAX) Cursor = Next_Sample_Number - SHRT_MAX; // The board can't store that many samples, it will answer with its oldest block
+	else Cursor = Next_Sample_Number - (unsigned short) ((Last_Sample_Time - Start_Time) / Sampling_Period) - 1;
+	
+	while (Samples_Count < Maximum_Samples_Count)
+	{
+		// Get the block holding the cursor (board expects 16-bit values in little endian)
+		Payload[0] = (unsigned char) Cursor;
+		Payload[1] = (unsigned char) (Cursor >> 8);
+		if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_TELEMETRY_BLOCK, 2, sizeof(Payload), Payload) != 0) return -1;
+		
+		// A sample may have been taken since the previous block, so refresh the time reference
+		Next_Sample_Number = Payload[0] | (Payload[1] << 8);
+		Last_Sample_Time = time(NULL) - Payload[2];
+		Sampling_Period = Payload[3];
+		First_Sample_Number = Payload[4] | (Payload[5] << 8);
+		Block_Samples_Count = Payload[6];
+		if (Block_Samples_Count == 0) break; // No more sample
+		
+		// Decode the records, each one is relative to the previous one
+		Pointer_Records = &Payload[BOILER_TELEMETRY_BLOCK_RECORDS_OFFSET];
+		Offset = 0;
+		for (i = 0; i < Block_Samples_Count; i++)
+		{
+			Header = Pointer_Records[Offset];
+			switch (Header & BOILER_TELEMETRY_RECORD_TYPE_MASK)
+			{
+				case BOILER_TELEMETRY_RECORD_TYPE_UNCHANGED:
+					Record_Size = 1;
+					break;
+					
+				case BOILER_TELEMETRY_RECORD_TYPE_DELTAS:
+					Record_Size = 3;
+					break;
+					
+				case BOILER_TELEMETRY_RECORD_TYPE_ABSOLUTE:
+					Record_Size = 4;
+					break;
+					
+				default:
+					Record_Size = 0;
+					break;
+			}
+			if ((Record_Size == 0) || (BOILER_TELEMETRY_BLOCK_RECORDS_OFFSET + Offset + Record_Size > BOILER_TELEMETRY_BLOCK_PAYLOAD_SIZE) || ((i == 0) && (Record_Size != 4)))
+			{
+				syslog(LOG_ERR, "Board %d sent a corrupted telemetry block (first sample number : %u, record : %d).", Board_ID, First_Sample_Number, i);
+				return -1;
+			}
+			
+			if (Record_Size == 3)
+			{
+				Radiator_Start_Water_Temperature += (signed char) Pointer_Records[Offset + 1];
+				Outside_Temperature += (signed char) Pointer_Records[Offset + 2] >> 4;
+				Target_Radiator_Start_Water_Temperature += (signed char) (Pointer_Records[Offset + 2] << 4) >> 4;
+			}
+			else if (Record_Size == 4)
+			{
+				Outside_Temperature = (signed char) Pointer_Records[Offset + 1];
+				Radiator_Start_Water_Temperature = (signed char) Pointer_Records[Offset + 2];
+				Target_Radiator_Start_Water_Temperature = (signed char) Pointer_Records[Offset + 3];
+			}
+			Offset += Record_Size;
+			
+			// Keep only the requested samples (the block can start before the cursor)
+			Sample_Number = First_Sample_Number + i;
+			if ((short) (Sample_Number - Cursor) < 0) continue; // The difference is right even when the sample number wraps around
+			Sample_Time = Last_Sample_Time - (unsigned short) (Next_Sample_Number - 1 - Sample_Number) * Sampling_Period;
+			if ((Sample_Time <= Start_Time) || (Samples_Count >= Maximum_Samples_Count)) continue;
+			
+			Pointer_Sample = &Pointer_Samples[Samples_Count];
+			Pointer_Sample->Time = Sample_Time;
+			Pointer_Sample->Outside_Temperature = Outside_Temperature;
+			Pointer_Sample->Radiator_Start_Water_Temperature = Radiator_Start_Water_Temperature;
+			Pointer_Sample->Target_Radiator_Start_Water_Temperature = Target_Radiator_Start_Water_Temperature;
+			Pointer_Sample->Mixing_Valve_Position = (Header & BOILER_TELEMETRY_RECORD_FLAGS_MIXING_VALVE_POSITION_MASK) >> BOILER_TELEMETRY_RECORD_FLAGS_MIXING_VALVE_POSITION_SHIFT;
+			Pointer_Sample->Is_Mixing_Valve_Left_Relay_On = (Header & BOILER_TELEMETRY_RECORD_FLAG_MIXING_VALVE_LEFT_RELAY_ON) ? 1 : 0;
+			Pointer_Sample->Is_Mixing_Valve_Right_Relay_On = (Header & BOILER_TELEMETRY_RECORD_FLAG_MIXING_VALVE_RIGHT_RELAY_ON) ? 1 : 0;
+			Pointer_Sample->Is_Pump_On = (Header & BOILER_TELEMETRY_RECORD_FLAG_PUMP_ON) ? 1 : 0;
+			Pointer_Sample->Is_Gas_Burner_On = (Header & BOILER_TELEMETRY_RECORD_FLAG_GAS_BURNER_ON) ? 1 : 0;
+			Samples_Count++;
+		}
+		
+		// Continue with the sample following the block, until the newest one has been downloaded
+		Cursor = First_Sample_Number + Block_Samples_Count;
+		if ((short) (Cursor - Next_Sample_Number) >= 0) break;
+	}
+	
+	return Samples_Count;
+}
+
+int BoilerGetTaskProfile(int Board_ID, int Section_ID, int Is_Reset_Requested, TBoilerTaskProfile *Pointer_Profile)
+{
+	unsigned char Payload[BOILER_TASK_PROFILE_PAYLOAD_SIZE];
+	unsigned long Cycles_Per_Count;
+	unsigned short Maximum_Counts;
+	
+	Payload[0] = (unsigned char) Section_ID;
+	Payload[1] = Is_Reset_Requested ? 1 : 0;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_TASK_PROFILE, 2, BOILER_TASK_PROFILE_PAYLOAD_SIZE, Payload) != 0) return -1;
+	
+	// The board measures time in timer counts, all multi-byte values are little endian
+	Pointer_Profile->Sections_Count = Payload[1];
+	Cycles_Per_Count = Payload[2];
+	Pointer_Profile->Calls_Count = Payload[3] | (Payload[4] << 8) | ((unsigned long) Payload[5] << 16) | ((unsigned long) Payload[6] << 24);
+	Pointer_Profile->Minimum_Cycles = (Payload[7] | (Payload[8] << 8)) * Cycles_Per_Count;
+	Maximum_Counts = Payload[9] | (Payload[10] << 8);
+	Pointer_Profile->Maximum_Cycles = Maximum_Counts * Cycles_Per_Count;
+	Pointer_Profile->Is_Maximum_Saturated = (Maximum_Counts == 0xFFFF);
+	Pointer_Profile->Total_Cycles = (Payload[11] | (Payload[12] << 8) | ((unsigned long long) Payload[13] << 16) | ((unsigned long long) Payload[14] << 24)) * Cycles_Per_Count;
 	
 	return 0;
 }
 
-int BoilerGetSensorsCelsiusTemperatures(int *Pointer_Outside_Temperature, int *Pointer_Radiator_Start_Water_Temperature)
+int BoilerGetSensorsCelsiusTemperatures(int Board_ID, int *Pointer_Outside_Temperature, int *Pointer_Radiator_Start_Water_Temperature)
 {
 	char Temperatures[2];
 	
-	if (BoilerSendCommand(BOILER_COMMAND_GET_SENSORS_CELSIUS_TEMPERATURES, 0, 2, Temperatures) != 0) return -1;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_SENSORS_CELSIUS_TEMPERATURES, 0, 2, Temperatures) != 0) return -1;
 	*Pointer_Outside_Temperature = Temperatures[0];
 	*Pointer_Radiator_Start_Water_Temperature = Temperatures[1];
 	
 	return 0;
 }
 
-int BoilerGetDesiredRoomTemperatures(int *Pointer_Day_Temperature, int *Pointer_Night_Temperature)
+int BoilerGetDesiredRoomTemperatures(int Board_ID, int *Pointer_Day_Temperature, int *Pointer_Night_Temperature)
 {
 	char Temperatures[2];
 	
-	if (BoilerSendCommand(BOILER_COMMAND_GET_DESIRED_ROOM_TEMPERATURES, 0, 2, Temperatures) != 0) return -1;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_DESIRED_ROOM_TEMPERATURES, 0, 2, Temperatures) != 0) return -1;
 	*Pointer_Day_Temperature = Temperatures[0];
 	*Pointer_Night_Temperature = Temperatures[1];
 	
 	return 0;
 }
 
-int BoilerSetDesiredRoomTemperatures(int Day_Temperature, int Night_Temperature)
+int BoilerSetDesiredRoomTemperatures(int Board_ID, int Day_Temperature, int Night_Temperature)
 {
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID); // Can't be NULL if the command succeeded
 	char Payload[2];
 	
 	Payload[0] = (char) Day_Temperature;
 	Payload[1] = (char) Night_Temperature;
-	if (BoilerSendCommand(BOILER_COMMAND_SET_DESIRED_ROOM_TEMPERATURES, 2, 0, Payload) != 0) return -1;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_SET_DESIRED_ROOM_TEMPERATURES, 2, 0, Payload) != 0) return -1;
+	
+	// Reflect the new values immediately instead of waiting for the next poll
+	pthread_mutex_lock(&Boiler_Mutex);
+	Pointer_Board->Status.Desired_Day_Temperature = Day_Temperature;
+	Pointer_Board->Status.Desired_Night_Temperature = Night_Temperature;
+	BoilerPublishStatusChange(Pointer_Board);
+	pthread_mutex_unlock(&Boiler_Mutex);
 	
 	return 0;
 }
 
-int BoilerGetBoilerRunningMode(int *Pointer_Is_Boiler_Running)
+int BoilerGetBoilerRunningMode(int Board_ID, int *Pointer_Is_Boiler_Running)
 {
 	unsigned char Is_Running;
 	
-	if (BoilerSendCommand(BOILER_COMMAND_GET_BOILER_RUNNING_MODE, 0, 1, &Is_Running) != 0) return -1;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_BOILER_RUNNING_MODE, 0, 1, &Is_Running) != 0) return -1;
 	if (Is_Running) *Pointer_Is_Boiler_Running = 1;
 	else *Pointer_Is_Boiler_Running = 0;
 	
 	return 0;
 }
 
-int BoilerSetBoilerRunningMode(int Is_Boiler_Running)
+int BoilerSetBoilerRunningMode(int Board_ID, int Is_Boiler_Running)
 {
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID); // Can't be NULL if the command succeeded
 	unsigned char Payload = (unsigned char) Is_Boiler_Running;
 	
-	if (BoilerSendCommand(BOILER_COMMAND_SET_BOILER_RUNNING_MODE, 1, 0, &Payload) != 0) return -1;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_SET_BOILER_RUNNING_MODE, 1, 0, &Payload) != 0) return -1;
+	
+	// Reflect the new value immediately instead of waiting for the next poll
+	pthread_mutex_lock(&Boiler_Mutex);
+	Pointer_Board->Status.Is_Boiler_Running = Is_Boiler_Running ? 1 : 0;
+	BoilerPublishStatusChange(Pointer_Board);
+	pthread_mutex_unlock(&Boiler_Mutex);
 	
 	return 0;
 }
 
-int BoilerGetTargetRadiatorStartWaterTemperature(int *Pointer_Temperature)
+int BoilerGetTargetRadiatorStartWaterTemperature(int Board_ID, int *Pointer_Temperature)
 {
 	unsigned char Temperature_Byte;
 	
-	if (BoilerSendCommand(BOILER_COMMAND_GET_TARGET_START_WATER_TEMPERATURE, 0, 1, &Temperature_Byte) != 0) return -1;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_TARGET_START_WATER_TEMPERATURE, 0, 1, &Temperature_Byte) != 0) return -1;
 	*Pointer_Temperature = Temperature_Byte;
 	
 	return 0;
 }
 
-int BoilerGetHeatingCurveParameters(int *Pointer_Coefficient, int *Pointer_Parallel_Shift)
+int BoilerGetHeatingCurveParameters(int Board_ID, int *Pointer_Coefficient, int *Pointer_Parallel_Shift)
 {
 	unsigned short Parameters[2];
 	
-	if (BoilerSendCommand(BOILER_COMMAND_GET_HEATING_CURVE_PARAMETERS, 0, 4, Parameters) != 0) return -1;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_GET_HEATING_CURVE_PARAMETERS, 0, 4, Parameters) != 0) return -1;
 	*Pointer_Coefficient = Parameters[0];
 	*Pointer_Parallel_Shift = Parameters[1];
 	
 	return 0;
 }
 
-int BoilerSetHeatingCurveParameters(int Coefficient, int Parallel_Shift)
+int BoilerSetHeatingCurveParameters(int Board_ID, int Coefficient, int Parallel_Shift)
 {
+	TBoilerBoard *Pointer_Board = BoilerGetBoard(Board_ID); // Can't be NULL if the command succeeded
 	unsigned short Parameters[2];
 	
 	Parameters[0] = (unsigned short) Coefficient;
 	Parameters[1] = (unsigned short) Parallel_Shift;
-	if (BoilerSendCommand(BOILER_COMMAND_SET_HEATING_CURVE_PARAMETERS, 4, 0, Parameters) != 0) return -1;
+	if (BoilerSendCommand(Board_ID, BOILER_COMMAND_SET_HEATING_CURVE_PARAMETERS, 4, 0, Parameters) != 0) return -1;
+	
+	// Reflect the new values immediately instead of waiting for the next poll
+	pthread_mutex_lock(&Boiler_Mutex);
+	Pointer_Board->Status.Heating_Curve_Coefficient = Coefficient;
+	Pointer_Board->Status.Heating_Curve_Parallel_Shift = Parallel_Shift;
+	BoilerPublishStatusChange(Pointer_Board);
+	pthread_mutex_unlock(&Boiler_Mutex);
 	
 	return 0;
 }
@@ -0,0 +1,334 @@
+/** @file Events.c
+ * See Events.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Api.h>
+#include <Boiler.h>
+#include <Configuration.h>
+#include <Events.h>
+#include <Json.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The biggest event size (the first event holds the whole status and is about 500 bytes long). */
+#define EVENTS_BLOCK_SIZE 1024
+
+/** Precede each status event data. */
+#define EVENTS_STATUS_EVENT_HEADER "event: status\ndata: "
+/** Terminate each event. */
+#define EVENTS_EVENT_TRAILER "\n\n"
+/** A comment line sent when nothing changed for a while, it keeps proxies from closing the connection and allows to detect the closed connections. */
+#define EVENTS_HEARTBEAT ": heartbeat\n\n"
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** An opened events stream. */
+typedef struct TEventsStream
+{
+	struct MHD_Connection *Pointer_Connection; //!< The client connection.
+	int Board_ID; //!< The board whose status is streamed.
+	TBoilerStatus Last_Sent_Status; //!< The status the client knows about.
+	int Is_Status_Sent; //!< Set to 1 when the first event has been sent.
+	int Is_Suspended; //!< Set to 1 when the connection is suspended, waiting for something to send.
+	int Is_Heartbeat_Needed; //!< Set to 1 when a heartbeat must be sent.
+	time_t Last_Sending_Time; //!< When the last event or heartbeat has been sent, used by the streams waiting in their own thread to send the heartbeats.
+	struct TEventsStream *Pointer_Previous_Stream; //!< The previous stream in the opened streams list.
+	struct TEventsStream *Pointer_Next_Stream; //!< The next stream in the opened streams list.
+} TEventsStream;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** Tell whether waiting streams suspend their connection or block their thread. */
+static int Events_Is_Suspend_Resume_Used;
+
+/** All opened streams. */
+static TEventsStream *Events_Pointer_Streams_List = NULL;
+/** Protect the streams list and the streams state. */
+static pthread_mutex_t Events_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** The thread resuming the suspended streams when the status changes. */
+static pthread_t Events_Notifier_Thread;
+/** Tell whether the notifier thread has been started. */
+static int Events_Is_Notifier_Thread_Started = 0;
+/** Set to 1 when the server is stopping, to end all streams and make the notifier thread exit. */
+static int Events_Is_Stop_Requested = 0;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Write an event describing what changed since the last event sent to a stream.
+ * @param Pointer_Stream The stream.
+ * @param Pointer_Status The current status.
+ * @param Pointer_Buffer On output, contain the event.
+ * @param Buffer_Size The buffer size in bytes.
+ * @return -1 if the buffer is too small,
+ * @return 0 if there is nothing to send,
+ * @return The event size on success.
+ */
+static int EventsWriteStatusEvent(TEventsStream *Pointer_Stream, TBoilerStatus *Pointer_Status, char *Pointer_Buffer, int Buffer_Size)
+{
+	TJsonWriter Writer;
+	int Length, Header_Length = sizeof(EVENTS_STATUS_EVENT_HEADER) - 1, Trailer_Length = sizeof(EVENTS_EVENT_TRAILER) - 1;
+	
+	if (Buffer_Size < Header_Length + Trailer_Length) return -1;
+	
+	// Write the JSON data after the event header, keeping room for the trailer
+	JsonWriterInitialize(&Writer, &Pointer_Buffer[Header_Length], Buffer_Size - Header_Length - Trailer_Length);
+	JsonWriterBeginObject(&Writer, NULL);
+	if (!Pointer_Status->Is_Valid)
+	{
+		if (Pointer_Stream->Is_Status_Sent && !Pointer_Stream->Last_Sent_Status.Is_Valid) return 0; // The client already knows
+		JsonWriterAddBoolean(&Writer, "is_valid", 0);
+	}
+	else
+	{
+		// Send all values if the client does not know about them yet
+		if (!Pointer_Stream->Is_Status_Sent || !Pointer_Stream->Last_Sent_Status.Is_Valid)
+		{
+			JsonWriterAddBoolean(&Writer, "is_valid", 1);
+			ApiWriteStatusMembers(&Writer, Pointer_Status, NULL);
+		}
+		else
+		{
+			ApiWriteStatusMembers(&Writer, Pointer_Status, &Pointer_Stream->Last_Sent_Status);
+			if (Writer.Length == 1) return 0; // Only the object start has been written, nothing visible changed
+		}
+	}
+	JsonWriterEndObject(&Writer);
+	Length = JsonWriterTerminate(&Writer);
+	if (Length < 0) return -1;
+	
+	// Frame the event
+	memcpy(Pointer_Buffer, EVENTS_STATUS_EVENT_HEADER, Header_Length);
+	memcpy(&Pointer_Buffer[Header_Length + Length], EVENTS_EVENT_TRAILER, Trailer_Length);
+	return Header_Length + Length + Trailer_Length;
+}
+
+/** Called by the web server each time it can send more data to a client.
+ * @param Pointer_Custom_Data The stream.
+ * @param Position How many bytes have been sent so far.
+ * @param Pointer_Buffer On output, contain the data to send.
+ * @param Maximum_Size The buffer size in bytes.
+ * @return MHD_CONTENT_READER_END_WITH_ERROR if the connection must be closed,
+ * @return 0 if there is nothing to send now (the connection has been suspended),
+ * @return How many bytes to send on success.
+ */
+static ssize_t EventsContentReaderCallback(void *Pointer_Custom_Data, uint64_t __attribute__((unused)) Position, char *Pointer_Buffer, size_t Maximum_Size)
+{
+	TEventsStream *Pointer_Stream = Pointer_Custom_Data;
+	TBoilerStatus Status;
+	ssize_t Size;
+	int Length;
+	
+	pthread_mutex_lock(&Events_Mutex);
+	while (1)
+	{
+		// End the stream when the server is stopping, the web server can't be stopped while connections are suspended
+		if (Events_Is_Stop_Requested)
+		{
+			Size = MHD_CONTENT_READER_END_OF_STREAM;
+			break;
+		}
+		
+		// Send the status changes first
+		BoilerGetStatusSnapshot(Pointer_Stream->Board_ID, &Status);
+		if (!Pointer_Stream->Is_Status_Sent || (Status.Version != Pointer_Stream->Last_Sent_Status.Version))
+		{
+			Length = EventsWriteStatusEvent(Pointer_Stream, &Status, Pointer_Buffer, Maximum_Size);
+			if (Length < 0)
+			{
+				syslog(LOG_ERR, "Events buffer is too small (%zu bytes) to hold a status event.", Maximum_Size);
+				Size = MHD_CONTENT_READER_END_WITH_ERROR;
+				break;
+			}
+			Pointer_Stream->Last_Sent_Status = Status;
+			Pointer_Stream->Is_Status_Sent = 1;
+			if (Length > 0)
+			{
+				Size = Length;
+				break;
+			}
+		}
+		
+		if (Pointer_Stream->Is_Heartbeat_Needed)
+		{
+			if (Maximum_Size < sizeof(EVENTS_HEARTBEAT) - 1)
+			{
+				Size = MHD_CONTENT_READER_END_WITH_ERROR;
+				break;
+			}
+			Pointer_Stream->Is_Heartbeat_Needed = 0;
+			memcpy(Pointer_Buffer, EVENTS_HEARTBEAT, sizeof(EVENTS_HEARTBEAT) - 1);
+			Size = sizeof(EVENTS_HEARTBEAT) - 1;
+			break;
+		}
+		
+		// Nothing to send, release the thread until the notifier resumes the connection
+		if (Events_Is_Suspend_Resume_Used)
+		{
+			Pointer_Stream->Is_Suspended = 1;
+			MHD_suspend_connection(Pointer_Stream->Pointer_Connection);
+			Size = 0;
+			break;
+		}
+		
+		// The connection has its own thread, it can wait here (a second at most, so the stop request is noticed quickly)
+		pthread_mutex_unlock(&Events_Mutex);
+		if (!BoilerWaitForStatusSnapshotChange(Pointer_Stream->Board_ID, Status.Version, 1000) && (time(NULL) - Pointer_Stream->Last_Sending_Time >= CONFIGURATION_EVENTS_HEARTBEAT_PERIOD)) Pointer_Stream->Is_Heartbeat_Needed = 1;
+		pthread_mutex_lock(&Events_Mutex);
+	}
+	if (Size > 0) Pointer_Stream->Last_Sending_Time = time(NULL);
+	pthread_mutex_unlock(&Events_Mutex);
+	
+	return Size;
+}
+
+/** Called by the web server when the stream response is destroyed, which happens when the client disconnected.
+ * @param Pointer_Custom_Data The stream.
+ */
+static void EventsContentReaderFreeCallback(void *Pointer_Custom_Data)
+{
+	TEventsStream *Pointer_Stream = Pointer_Custom_Data;
+	
+	pthread_mutex_lock(&Events_Mutex);
+	if (Pointer_Stream->Pointer_Previous_Stream == NULL) Events_Pointer_Streams_List = Pointer_Stream->Pointer_Next_Stream;
+	else Pointer_Stream->Pointer_Previous_Stream->Pointer_Next_Stream = Pointer_Stream->Pointer_Next_Stream;
+	if (Pointer_Stream->Pointer_Next_Stream != NULL) Pointer_Stream->Pointer_Next_Stream->Pointer_Previous_Stream = Pointer_Stream->Pointer_Previous_Stream;
+	pthread_mutex_unlock(&Events_Mutex);
+	
+	free(Pointer_Stream);
+}
+
+/** Resume the suspended streams each time a board status changes, and periodically to send heartbeats.
+ * @param Pointer_Parameters Unused.
+ * @return Always NULL.
+ */
+static void *EventsNotifierThread(void __attribute__((unused)) *Pointer_Parameters)
+{
+	TEventsStream *Pointer_Stream;
+	time_t Last_Heartbeat_Time = time(NULL);
+	unsigned int Status_Changes_Count, Known_Status_Changes_Count;
+	int Is_Status_Changed, Is_Heartbeat_Needed;
+	
+	Known_Status_Changes_Count = BoilerWaitForAnyStatusSnapshotChange(0, 0);
+	while (1)
+	{
+		// Wake up regularly to check for the stop request. The streams of the boards that did not change simply suspend again
+		Status_Changes_Count = BoilerWaitForAnyStatusSnapshotChange(Known_Status_Changes_Count, 1000);
+		Is_Status_Changed = (Status_Changes_Count != Known_Status_Changes_Count);
+		Known_Status_Changes_Count = Status_Changes_Count;
+		Is_Heartbeat_Needed = (time(NULL) - Last_Heartbeat_Time >= CONFIGURATION_EVENTS_HEARTBEAT_PERIOD);
+		if (Is_Heartbeat_Needed) Last_Heartbeat_Time = time(NULL);
+		
+		pthread_mutex_lock(&Events_Mutex);
+		if (Events_Is_Stop_Requested)
+		{
+			pthread_mutex_unlock(&Events_Mutex);
+			break;
+		}
+		
+		// Let the content reader find what to send
+		if (Is_Status_Changed || Is_Heartbeat_Needed)
+		{
+			for (Pointer_Stream = Events_Pointer_Streams_List; Pointer_Stream != NULL; Pointer_Stream = Pointer_Stream->Pointer_Next_Stream)
+			{
+				if (Is_Heartbeat_Needed) Pointer_Stream->Is_Heartbeat_Needed = 1;
+				if (Pointer_Stream->Is_Suspended)
+				{
+					Pointer_Stream->Is_Suspended = 0;
+					MHD_resume_connection(Pointer_Stream->Pointer_Connection);
+				}
+			}
+		}
+		pthread_mutex_unlock(&Events_Mutex);
+	}
+	
+	return NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int EventsInitialize(int Is_Suspend_Resume_Used)
+{
+	Events_Is_Suspend_Resume_Used = Is_Suspend_Resume_Used;
+	if (!Is_Suspend_Resume_Used) return 0; // Streams wait by themselves
+	
+	if (pthread_create(&Events_Notifier_Thread, NULL, EventsNotifierThread, NULL) != 0)
+	{
+		syslog(LOG_ERR, "Failed to create events notifier thread.");
+		return -1;
+	}
+	Events_Is_Notifier_Thread_Started = 1;
+	
+	return 0;
+}
+
+void EventsUninitialize(void)
+{
+	TEventsStream *Pointer_Stream;
+	
+	// Resume all suspended streams, so they end the next time the web server asks them for data. They can't suspend again from now on
+	pthread_mutex_lock(&Events_Mutex);
+	Events_Is_Stop_Requested = 1;
+	for (Pointer_Stream = Events_Pointer_Streams_List; Pointer_Stream != NULL; Pointer_Stream = Pointer_Stream->Pointer_Next_Stream)
+	{
+		if (Pointer_Stream->Is_Suspended)
+		{
+			Pointer_Stream->Is_Suspended = 0;
+			MHD_resume_connection(Pointer_Stream->Pointer_Connection);
+		}
+	}
+	pthread_mutex_unlock(&Events_Mutex);
+	
+	if (!Events_Is_Notifier_Thread_Started) return;
+	pthread_join(Events_Notifier_Thread, NULL);
+	Events_Is_Notifier_Thread_Started = 0;
+}
+
+struct MHD_Response *EventsCreateResponse(struct MHD_Connection *Pointer_Connection)
+{
+	TEventsStream *Pointer_Stream;
+	struct MHD_Response *Pointer_Response;
+	int Board_ID;
+	
+	Board_ID = BoilerParseBoardID(MHD_lookup_connection_value(Pointer_Connection, MHD_GET_ARGUMENT_KIND, "board"));
+	if (Board_ID < 0) return NULL;
+	
+	Pointer_Stream = calloc(1, sizeof(TEventsStream));
+	if (Pointer_Stream == NULL)
+	{
+		syslog(LOG_ERR, "Failed to allocate events stream.");
+		return NULL;
+	}
+	Pointer_Stream->Pointer_Connection = Pointer_Connection;
+	Pointer_Stream->Board_ID = Board_ID;
+	Pointer_Stream->Last_Sending_Time = time(NULL);
+	
+	// The response has no known size, so it lasts until the client disconnects
+	Pointer_Response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, EVENTS_BLOCK_SIZE, EventsContentReaderCallback, Pointer_Stream, EventsContentReaderFreeCallback);
+	if (Pointer_Response == NULL)
+	{
+		free(Pointer_Stream);
+		return NULL;
+	}
+	MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CONTENT_TYPE, "text/event-stream");
+	MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CACHE_CONTROL, "no-cache");
+	
+	// Make the stream known to the notifier
+	pthread_mutex_lock(&Events_Mutex);
+	Pointer_Stream->Pointer_Next_Stream = Events_Pointer_Streams_List;
+	if (Events_Pointer_Streams_List != NULL) Events_Pointer_Streams_List->Pointer_Previous_Stream = Pointer_Stream;
+	Events_Pointer_Streams_List = Pointer_Stream;
+	pthread_mutex_unlock(&Events_Mutex);
+	
+	return Pointer_Response;
+}
@@ -0,0 +1,295 @@
+/** @file History.c
+ * See History.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Boiler.h>
+#include <Configuration.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <History.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** Identify a history file ("BCHF" in little endian). */
+#define HISTORY_FILE_MAGIC_NUMBER 0x46484342
+/** Increment this value each time the file layout changes, so older files are discarded instead of being misinterpreted. */
+#define HISTORY_FILE_FORMAT_VERSION 1
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** The history file header, directly followed by the samples ring. */
+typedef struct __attribute__((packed))
+{
+	uint32_t Magic_Number; //!< Always HISTORY_FILE_MAGIC_NUMBER.
+	uint16_t Format_Version; //!< The HISTORY_FILE_FORMAT_VERSION value the file has been created with.
+	uint16_t Sample_Size; //!< Size in bytes of a sample.
+	uint32_t Samples_Capacity; //!< How many samples the ring can hold.
+	uint32_t Sampling_Period; //!< The sampling period in seconds used to record the most recent samples.
+	uint32_t Write_Index; //!< The ring index the next sample will be written to.
+	uint32_t Samples_Count; //!< How many valid samples the ring holds.
+} THistoryFileHeader;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The whole mapped history file. */
+static void *History_Pointer_File_Mapping = NULL;
+/** The mapped file size in bytes. */
+static size_t History_File_Size;
+/** The mapped file header. */
+static THistoryFileHeader *History_Pointer_File_Header;
+/** The mapped samples ring. */
+static THistorySample *History_Pointer_Samples;
+
+/** Protect the file header and the samples ring. */
+static pthread_mutex_t History_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** The sampling period in seconds. */
+static int History_Sampling_Period;
+/** The thread periodically appending samples. */
+static pthread_t History_Sampler_Thread;
+/** Set to 1 to make the sampler thread exit. */
+static int History_Is_Sampler_Thread_Stop_Requested = 0;
+/** Protect the stop request. */
+static pthread_mutex_t History_Sampler_Mutex = PTHREAD_MUTEX_INITIALIZER;
+/** Signaled to wake the sampler thread up before the end of a period. */
+static pthread_cond_t History_Sampler_Condition = PTHREAD_COND_INITIALIZER;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Convert a board status to a history sample.
+ * @param Pointer_Status The board status.
+ * @param Pointer_Sample On output, contain the sample.
+ */
+static void HistoryConvertStatusToSample(TBoilerStatus *Pointer_Status, THistorySample *Pointer_Sample)
+{
+	unsigned char Flags;
+	
+	Pointer_Sample->Time = (uint32_t) Pointer_Status->Update_Time;
+	Pointer_Sample->Outside_Temperature = (int8_t) Pointer_Status->Outside_Temperature;
+	Pointer_Sample->Radiator_Start_Water_Temperature = (int8_t) Pointer_Status->Radiator_Start_Water_Temperature;
+	Pointer_Sample->Target_Radiator_Start_Water_Temperature = (int8_t) Pointer_Status->Target_Radiator_Start_Water_Temperature;
+	
+	Flags = (Pointer_Status->Mixing_Valve_Position << HISTORY_SAMPLE_FLAGS_MIXING_VALVE_POSITION_SHIFT) & HISTORY_SAMPLE_FLAGS_MIXING_VALVE_POSITION_MASK;
+	if (Pointer_Status->Is_Gas_Burner_On) Flags |= HISTORY_SAMPLE_FLAG_GAS_BURNER_ON;
+	if (Pointer_Status->Is_Pump_On) Flags |= HISTORY_SAMPLE_FLAG_PUMP_ON;
+	if (Pointer_Status->Is_Mixing_Valve_Left_Relay_On) Flags |= HISTORY_SAMPLE_FLAG_MIXING_VALVE_LEFT_RELAY_ON;
+	if (Pointer_Status->Is_Mixing_Valve_Right_Relay_On) Flags |= HISTORY_SAMPLE_FLAG_MIXING_VALVE_RIGHT_RELAY_ON;
+	Pointer_Sample->Flags = Flags;
+}
+
+/** Convert a sample recorded by the board to a history sample.
+ * @param Pointer_Telemetry_Sample The board sample.
+ * @param Pointer_Sample On output, contain the history sample.
+ */
+static void HistoryConvertTelemetrySampleToSample(TBoilerTelemetrySample *Pointer_Telemetry_Sample, THistorySample *Pointer_Sample)
+{
+	TBoilerStatus Status;
+	
+	// Reuse the status conversion, the board sample holds all fields a history sample needs
+	Status.Update_Time = Pointer_Telemetry_Sample->Time;
+	Status.Outside_Temperature = Pointer_Telemetry_Sample->Outside_Temperature;
+	Status.Radiator_Start_Water_Temperature = Pointer_Telemetry_Sample->Radiator_Start_Water_Temperature;
+	Status.Target_Radiator_Start_Water_Temperature = Pointer_Telemetry_Sample->Target_Radiator_Start_Water_Temperature;
+	Status.Mixing_Valve_Position = Pointer_Telemetry_Sample->Mixing_Valve_Position;
+	Status.Is_Mixing_Valve_Left_Relay_On = Pointer_Telemetry_Sample->Is_Mixing_Valve_Left_Relay_On;
+	Status.Is_Mixing_Valve_Right_Relay_On = Pointer_Telemetry_Sample->Is_Mixing_Valve_Right_Relay_On;
+	Status.Is_Pump_On = Pointer_Telemetry_Sample->Is_Pump_On;
+	Status.Is_Gas_Burner_On = Pointer_Telemetry_Sample->Is_Gas_Burner_On;
+	HistoryConvertStatusToSample(&Status, Pointer_Sample);
+}
+
+/** Append a sample to the ring, overwriting the oldest sample when the ring is full. This is only a few stores into the mapped memory, the kernel writes the dirty pages back to the file on its own.
+ * @param Pointer_Sample The sample to append.
+ */
+static void HistoryAppendSample(THistorySample *Pointer_Sample)
+{
+	pthread_mutex_lock(&History_Mutex);
+	
+	History_Pointer_Samples[History_Pointer_File_Header->Write_Index] = *Pointer_Sample;
+	History_Pointer_File_Header->Write_Index = (History_Pointer_File_Header->Write_Index + 1) % CONFIGURATION_HISTORY_SAMPLES_CAPACITY;
+	if (History_Pointer_File_Header->Samples_Count < CONFIGURATION_HISTORY_SAMPLES_CAPACITY) History_Pointer_File_Header->Samples_Count++;
+	
+	pthread_mutex_unlock(&History_Mutex);
+}
+
+/** Tell when the newest sample has been taken.
+ * @return 0 if the history is empty,
+ * @return The newest sample time otherwise.
+ */
+static time_t HistoryGetNewestSampleTime(void)
+{
+	time_t Time = 0;
+	
+	pthread_mutex_lock(&History_Mutex);
+	if (History_Pointer_File_Header->Samples_Count > 0) Time = History_Pointer_Samples[(History_Pointer_File_Header->Write_Index + CONFIGURATION_HISTORY_SAMPLES_CAPACITY - 1) % CONFIGURATION_HISTORY_SAMPLES_CAPACITY].Time;
+	pthread_mutex_unlock(&History_Mutex);
+	
+	return Time;
+}
+
+/** Fill the hole left in the history by a server or board link outage with the samples the board recorded meanwhile.
+ * @param Current_Sample_Time The time of the sample about to be appended, only older board samples are appended so the ring stays ordered by time.
+ */
+static void HistoryBackfill(time_t Current_Sample_Time)
+{
+	static TBoilerTelemetrySample Telemetry_Samples[CONFIGURATION_HISTORY_BACKFILL_MAXIMUM_SAMPLES_COUNT]; // Only used by the sampler thread
+	time_t Newest_Sample_Time;
+	int Samples_Count, i;
+	THistorySample Sample;
+	
+	// Nothing is missing if the previous sample is one period old
+	Newest_Sample_Time = HistoryGetNewestSampleTime();
+	if (Current_Sample_Time - Newest_Sample_Time < 2 * History_Sampling_Period) return;
+	
+	// Board samples are not aligned on the history periods, ignore the ones too close to the surrounding samples
+	Samples_Count = BoilerGetTelemetrySamples(CONFIGURATION_BOILER_DEFAULT_BOARD_ID, Newest_Sample_Time + History_Sampling_Period / 2, Telemetry_Samples, CONFIGURATION_HISTORY_BACKFILL_MAXIMUM_SAMPLES_COUNT);
+	if (Samples_Count < 0)
+	{
+		syslog(LOG_WARNING, "Could not retrieve the samples recorded by the board, the history will have a hole.");
+		return;
+	}
+	
+	for (i = 0; i < Samples_Count; i++)
+	{
+		if (Telemetry_Samples[i].Time > Current_Sample_Time - History_Sampling_Period / 2) break;
+		HistoryConvertTelemetrySampleToSample(&Telemetry_Samples[i], &Sample);
+		HistoryAppendSample(&Sample);
+	}
+	if (i > 0) syslog(LOG_INFO, "Retrieved %d history samples recorded by the board.", i);
+}
+
+/** Take a sample of the board status snapshot at each period boundary.
+ * @param Pointer_Parameters Unused.
+ * @return Always NULL.
+ */
+static void *HistorySamplerThread(void __attribute__((unused)) *Pointer_Parameters)
+{
+	struct timespec Wake_Up_Time;
+	TBoilerStatus Status;
+	THistorySample Sample;
+	
+	pthread_mutex_lock(&History_Sampler_Mutex);
+	while (1)
+	{
+		// Wait for the next period boundary, so samples are aligned on round times whatever the server start time is (do not use time(), it relies on a coarse clock that can lag behind the condition clock)
+		clock_gettime(CLOCK_REALTIME, &Wake_Up_Time);
+		Wake_Up_Time.tv_sec = (Wake_Up_Time.tv_sec / History_Sampling_Period + 1) * History_Sampling_Period;
+		Wake_Up_Time.tv_nsec = 0;
+		while (!History_Is_Sampler_Thread_Stop_Requested && (pthread_cond_timedwait(&History_Sampler_Condition, &History_Sampler_Mutex, &Wake_Up_Time) != ETIMEDOUT));
+		if (History_Is_Sampler_Thread_Stop_Requested) break;
+		
+		// Record the board status only if it is recent enough, it is better to have a hole in the history than to repeat outdated values (the history file format has no room for a board ID, so only the default board is recorded)
+		BoilerGetStatusSnapshot(CONFIGURATION_BOILER_DEFAULT_BOARD_ID, &Status);
+		if (!Status.Is_Valid || (Wake_Up_Time.tv_sec - Status.Update_Time > 2 * CONFIGURATION_BOILER_STATUS_POLLING_PERIOD)) continue;
+		
+		HistoryBackfill(Status.Update_Time);
+		HistoryConvertStatusToSample(&Status, &Sample);
+		HistoryAppendSample(&Sample);
+	}
+	pthread_mutex_unlock(&History_Sampler_Mutex);
+	
+	return NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int HistoryInitialize(const char *String_File_Path, int Sampling_Period)
+{
+	int File_Descriptor;
+	struct stat File_Status;
+	
+	History_Sampling_Period = Sampling_Period;
+	History_File_Size = sizeof(THistoryFileHeader) + CONFIGURATION_HISTORY_SAMPLES_CAPACITY * sizeof(THistorySample);
+	
+	// Open the file, creating it if it does not exist
+	File_Descriptor = open(String_File_Path, O_RDWR | O_CREAT, 0644);
+	if (File_Descriptor == -1)
+	{
+		syslog(LOG_ERR, "Failed to open history file '%s' (%s).", String_File_Path, strerror(errno));
+		return -1;
+	}
+	if (fstat(File_Descriptor, &File_Status) != 0)
+	{
+		syslog(LOG_ERR, "Failed to get history file size (%s).", strerror(errno));
+		goto Exit_Error_Close_File;
+	}
+	
+	// Give the file its full size at once, so appending a sample never needs to grow it
+	if (((size_t) File_Status.st_size != History_File_Size) && (ftruncate(File_Descriptor, History_File_Size) != 0))
+	{
+		syslog(LOG_ERR, "Failed to set history file size (%s).", strerror(errno));
+		goto Exit_Error_Close_File;
+	}
+	
+	History_Pointer_File_Mapping = mmap(NULL, History_File_Size, PROT_READ | PROT_WRITE, MAP_SHARED, File_Descriptor, 0);
+	if (History_Pointer_File_Mapping == MAP_FAILED)
+	{
+		syslog(LOG_ERR, "Failed to map history file (%s).", strerror(errno));
+		History_Pointer_File_Mapping = NULL;
+		goto Exit_Error_Close_File;
+	}
+	close(File_Descriptor); // The mapping stays valid without the file descriptor
+	History_Pointer_File_Header = History_Pointer_File_Mapping;
+	History_Pointer_Samples = (THistorySample *) ((unsigned char *) History_Pointer_File_Mapping + sizeof(THistoryFileHeader));
+	
+	// Start a new history if the file has just been created or has been created with a different layout
+	if ((History_Pointer_File_Header->Magic_Number != HISTORY_FILE_MAGIC_NUMBER) || (History_Pointer_File_Header->Format_Version != HISTORY_FILE_FORMAT_VERSION) || (History_Pointer_File_Header->Sample_Size != sizeof(THistorySample)) || (History_Pointer_File_Header->Samples_Capacity != CONFIGURATION_HISTORY_SAMPLES_CAPACITY) || (History_Pointer_File_Header->Write_Index >= CONFIGURATION_HISTORY_SAMPLES_CAPACITY) || (History_Pointer_File_Header->Samples_Count > CONFIGURATION_HISTORY_SAMPLES_CAPACITY))
+	{
+		if (History_Pointer_File_Header->Magic_Number != 0) syslog(LOG_WARNING, "History file '%s' has an unknown layout, discarding its content.", String_File_Path);
+		History_Pointer_File_Header->Magic_Number = HISTORY_FILE_MAGIC_NUMBER;
+		History_Pointer_File_Header->Format_Version = HISTORY_FILE_FORMAT_VERSION;
+		History_Pointer_File_Header->Sample_Size = sizeof(THistorySample);
+		History_Pointer_File_Header->Samples_Capacity = CONFIGURATION_HISTORY_SAMPLES_CAPACITY;
+		History_Pointer_File_Header->Write_Index = 0;
+		History_Pointer_File_Header->Samples_Count = 0;
+	}
+	History_Pointer_File_Header->Sampling_Period = Sampling_Period; // Samples are timestamped, so changing the period does not invalidate previous samples
+	syslog(LOG_INFO, "History file '%s' mapped (samples count : %u, sampling period : %d s).", String_File_Path, History_Pointer_File_Header->Samples_Count, Sampling_Period);
+	
+	// Start sampling
+	History_Is_Sampler_Thread_Stop_Requested = 0;
+	if (pthread_create(&History_Sampler_Thread, NULL, HistorySamplerThread, NULL) != 0)
+	{
+		syslog(LOG_ERR, "Failed to create history sampler thread.");
+		munmap(History_Pointer_File_Mapping, History_File_Size);
+		History_Pointer_File_Mapping = NULL;
+		return -1;
+	}
+	
+	return 0;
+	
+Exit_Error_Close_File:
+	close(File_Descriptor);
+	return -1;
+}
+
+void HistoryUninitialize(void)
+{
+	if (History_Pointer_File_Mapping == NULL) return;
+	
+	// Stop sampler thread
+	pthread_mutex_lock(&History_Sampler_Mutex);
+	History_Is_Sampler_Thread_Stop_Requested = 1;
+	pthread_cond_signal(&History_Sampler_Condition);
+	pthread_mutex_unlock(&History_Sampler_Mutex);
+	pthread_join(History_Sampler_Thread, NULL);
+	
+	// Make sure everything reached the disk
+	pthread_mutex_lock(&History_Mutex);
+	msync(History_Pointer_File_Mapping, History_File_Size, MS_SYNC);
+	munmap(History_Pointer_File_Mapping, History_File_Size);
+	History_Pointer_File_Mapping = NULL;
+	pthread_mutex_unlock(&History_Mutex);
+}
@@ -0,0 +1,397 @@
+/** @file Json.c
+ * See Json.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Json.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Append characters to the output buffer, always keeping room for the terminating zero.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String The characters to append.
+ * @param Length How many characters to append.
+ */
+static void JsonWriterAppend(TJsonWriter *Pointer_Writer, const char *Pointer_String, int Length)
+{
+	if (Pointer_Writer->Length + Length >= Pointer_Writer->Buffer_Size)
+	{
+		Pointer_Writer->Is_Overflowed = 1;
+		return;
+	}
+	memcpy(&Pointer_Writer->Pointer_String_Buffer[Pointer_Writer->Length], Pointer_String, Length);
+	Pointer_Writer->Length += Length;
+}
+
+/** Append a single character to the output buffer.
+ * @param Pointer_Writer The writer.
+ * @param Character The character to append.
+ */
+static inline void JsonWriterAppendCharacter(TJsonWriter *Pointer_Writer, char Character)
+{
+	JsonWriterAppend(Pointer_Writer, &Character, 1);
+}
+
+/** Append a quoted and escaped string.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String The string to append.
+ */
+static void JsonWriterAppendEscapedString(TJsonWriter *Pointer_Writer, const char *Pointer_String)
+{
+	static const char Hexadecimal_Digits[] = "0123456789abcdef";
+	char String_Escape_Sequence[6] = {'\\', 'u', '0', '0'};
+	const char *Pointer_String_Unescaped_Characters;
+	unsigned char Character;
+	
+	JsonWriterAppendCharacter(Pointer_Writer, '"');
+	while (1)
+	{
+		// Copy all characters that do not need to be escaped at once
+		Pointer_String_Unescaped_Characters = Pointer_String;
+		while ((*Pointer_String != 0) && (*Pointer_String != '"') && (*Pointer_String != '\\') && ((unsigned char) *Pointer_String >= 0x20)) Pointer_String++;
+		JsonWriterAppend(Pointer_Writer, Pointer_String_Unescaped_Characters, Pointer_String - Pointer_String_Unescaped_Characters);
+		
+		Character = *Pointer_String;
+		if (Character == 0) break;
+		switch (Character)
+		{
+			case '"':
+				JsonWriterAppend(Pointer_Writer, "\\\"", 2);
+				break;
+				
+			case '\\':
+				JsonWriterAppend(Pointer_Writer, "\\\\", 2);
+				break;
+				
+			case '\n':
+				JsonWriterAppend(Pointer_Writer, "\\n", 2);
+				break;
+				
+			default:
+				String_Escape_Sequence[4] = Hexadecimal_Digits[Character >> 4];
+				String_Escape_Sequence[5] = Hexadecimal_Digits[Character & 0x0F];
+				JsonWriterAppend(Pointer_Writer, String_Escape_Sequence, sizeof(String_Escape_Sequence));
+				break;
+		}
+		Pointer_String++;
+	}
+	JsonWriterAppendCharacter(Pointer_Writer, '"');
+}
+
+/** Write the separator and the member name (if any) that precede a value.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String_Key The member name, or NULL if the value is not an object member.
+ */
+static void JsonWriterBeginValue(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key)
+{
+	unsigned int Level_Bit = 1U << Pointer_Writer->Nesting_Level;
+	
+	if (Pointer_Writer->Is_Separator_Needed_Bitmask & Level_Bit) JsonWriterAppendCharacter(Pointer_Writer, ',');
+	Pointer_Writer->Is_Separator_Needed_Bitmask |= Level_Bit;
+	
+	if (Pointer_String_Key != NULL)
+	{
+		JsonWriterAppendEscapedString(Pointer_Writer, Pointer_String_Key);
+		JsonWriterAppendCharacter(Pointer_Writer, ':');
+	}
+}
+
+/** Open an object or an array.
+ * @param Pointer_Writer The writer.
+ * @param Pointer_String_Key The member name, or NULL if the container is not an object member.
+ * @param Opening_Character The character starting the container.
+ */
+static void JsonWriterBeginContainer(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key, char Opening_Character)
+{
+	JsonWriterBeginValue(Pointer_Writer, Pointer_String_Key);
+	JsonWriterAppendCharacter(Pointer_Writer, Opening_Character);
+	
+	if (Pointer_Writer->Nesting_Level >= JSON_WRITER_MAXIMUM_NESTING_LEVEL - 1)
+	{
+		Pointer_Writer->Is_Overflowed = 1;
+		return;
+	}
+	Pointer_Writer->Nesting_Level++;
+	Pointer_Writer->Is_Separator_Needed_Bitmask &= ~(1U << Pointer_Writer->Nesting_Level); // The new container is empty
+}
+
+/** Close the last opened object or array.
+ * @param Pointer_Writer The writer.
+ * @param Closing_Character The character ending the container.
+ */
+static void JsonWriterEndContainer(TJsonWriter *Pointer_Writer, char Closing_Character)
+{
+	if (Pointer_Writer->Nesting_Level > 0) Pointer_Writer->Nesting_Level--;
+	JsonWriterAppendCharacter(Pointer_Writer, Closing_Character);
+}
+
+/** Skip blank characters.
+ * @param Pointer_String The text to parse.
+ * @param Pointer_Index On input, the first character to check. On output, the first non-blank character.
+ * @param Length The text length.
+ */
+static void JsonSkipBlanks(const char *Pointer_String, int *Pointer_Index, int Length)
+{
+	while ((*Pointer_Index < Length) && ((Pointer_String[*Pointer_Index] == ' ') || (Pointer_String[*Pointer_Index] == '\t') || (Pointer_String[*Pointer_Index] == '\r') || (Pointer_String[*Pointer_Index] == '\n'))) (*Pointer_Index)++;
+}
+
+/** Parse a string.
+ * @param Pointer_String The text to parse.
+ * @param Pointer_Index On input, the opening quote index. On output, the index following the closing quote.
+ * @param Length The text length.
+ * @param Pointer_Pointer_String_Content On output, point to the string first character.
+ * @param Pointer_Content_Length On output, contain the string length (escape sequences are kept as is).
+ * @return -1 if the string is malformed,
+ * @return 0 on success.
+ */
+static int JsonParseString(const char *Pointer_String, int *Pointer_Index, int Length, const char **Pointer_Pointer_String_Content, int *Pointer_Content_Length)
+{
+	int i = *Pointer_Index;
+	
+	if ((i >= Length) || (Pointer_String[i] != '"')) return -1;
+	i++;
+	*Pointer_Pointer_String_Content = &Pointer_String[i];
+	
+	while (1)
+	{
+		if (i >= Length) return -1;
+		if (Pointer_String[i] == '"') break;
+		if ((unsigned char) Pointer_String[i] < 0x20) return -1; // Control characters must be escaped
+		if (Pointer_String[i] == '\\') i++; // Skip the escaped character, so an escaped quote does not end the string
+		i++;
+	}
+	
+	*Pointer_Content_Length = &Pointer_String[i] - *Pointer_Pointer_String_Content;
+	*Pointer_Index = i + 1;
+	return 0;
+}
+
+/** Tell whether a keyword starts at the provided index.
+ * @param Pointer_String The text to parse.
+ * @param Index The index to compare from.
+ * @param Length The text length.
+ * @param Pointer_String_Keyword The keyword.
+ * @return 0 if the keyword is not present,
+ * @return The keyword length if it is present.
+ */
+static int JsonMatchKeyword(const char *Pointer_String, int Index, int Length, const char *Pointer_String_Keyword)
+{
+	int Keyword_Length = strlen(Pointer_String_Keyword);
+	
+	if (Length - Index < Keyword_Length) return 0;
+	if (memcmp(&Pointer_String[Index], Pointer_String_Keyword, Keyword_Length) != 0) return 0;
+	return Keyword_Length;
+}
+
+/** Parse a member value.
+ * @param Pointer_String The text to parse.
+ * @param Pointer_Index On input, the value first character. On output, the index following the value.
+ * @param Length The text length.
+ * @param Pointer_Member On output, contain the value type and content.
+ * @return -1 if the value is malformed or is not supported,
+ * @return 0 on success.
+ */
+static int JsonParseValue(const char *Pointer_String, int *Pointer_Index, int Length, TJsonMember *Pointer_Member)
+{
+	int i = *Pointer_Index, Keyword_Length, Is_Negative = 0, Digits_Count = 0;
+	long long Value = 0;
+	
+	if (i >= Length) return -1;
+	
+	// String
+	if (Pointer_String[i] == '"')
+	{
+		Pointer_Member->Value_Type = JSON_VALUE_TYPE_STRING;
+		return JsonParseString(Pointer_String, Pointer_Index, Length, &Pointer_Member->Pointer_String_Value, &Pointer_Member->String_Value_Length);
+	}
+	
+	// Keywords
+	if ((Keyword_Length = JsonMatchKeyword(Pointer_String, i, Length, "true")) != 0)
+	{
+		Pointer_Member->Value_Type = JSON_VALUE_TYPE_BOOLEAN;
+		Pointer_Member->Integer_Value = 1;
+		*Pointer_Index = i + Keyword_Length;
+		return 0;
+	}
+	if ((Keyword_Length = JsonMatchKeyword(Pointer_String, i, Length, "false")) != 0)
+	{
+		Pointer_Member->Value_Type = JSON_VALUE_TYPE_BOOLEAN;
+		Pointer_Member->Integer_Value = 0;
+		*Pointer_Index = i + Keyword_Length;
+		return 0;
+	}
+	if ((Keyword_Length = JsonMatchKeyword(Pointer_String, i, Length, "null")) != 0)
+	{
+		Pointer_Member->Value_Type = JSON_VALUE_TYPE_NULL;
+		*Pointer_Index = i + Keyword_Length;
+		return 0;
+	}
+	
+	// Integer (fractional numbers are not needed by the API, so they are rejected)
+	if (Pointer_String[i] == '-')
+	{
+		Is_Negative = 1;
+		i++;
+	}
+	while ((i < Length) && (Pointer_String[i] >= '0') && (Pointer_String[i] <= '9'))
+	{
+		if (Digits_Count >= 18) return -1; // Avoid overflowing
+		Value = Value * 10 + Pointer_String[i] - '0';
+		Digits_Count++;
+		i++;
+	}
+	if (Digits_Count == 0) return -1;
+	if ((i < Length) && ((Pointer_String[i] == '.') || (Pointer_String[i] == 'e') || (Pointer_String[i] == 'E'))) return -1;
+	
+	Pointer_Member->Value_Type = JSON_VALUE_TYPE_INTEGER;
+	Pointer_Member->Integer_Value = Is_Negative ? -Value : Value;
+	*Pointer_Index = i;
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void JsonWriterInitialize(TJsonWriter *Pointer_Writer, char *Pointer_String_Buffer, int Buffer_Size)
+{
+	Pointer_Writer->Pointer_String_Buffer = Pointer_String_Buffer;
+	Pointer_Writer->Buffer_Size = Buffer_Size;
+	Pointer_Writer->Length = 0;
+	Pointer_Writer->Is_Overflowed = 0;
+	Pointer_Writer->Nesting_Level = 0;
+	Pointer_Writer->Is_Separator_Needed_Bitmask = 0;
+}
+
+void JsonWriterBeginObject(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key)
+{
+	JsonWriterBeginContainer(Pointer_Writer, Pointer_String_Key, '{');
+}
+
+void JsonWriterEndObject(TJsonWriter *Pointer_Writer)
+{
+	JsonWriterEndContainer(Pointer_Writer, '}');
+}
+
+void JsonWriterBeginArray(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key)
+{
+	JsonWriterBeginContainer(Pointer_Writer, Pointer_String_Key, '[');
+}
+
+void JsonWriterEndArray(TJsonWriter *Pointer_Writer)
+{
+	JsonWriterEndContainer(Pointer_Writer, ']');
+}
+
+void JsonWriterAddInteger(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key, long long Value)
+{
+	char String_Digits[24];
+	int i = sizeof(String_Digits);
+	unsigned long long Absolute_Value;
+	
+	JsonWriterBeginValue(Pointer_Writer, Pointer_String_Key);
+	
+	// Convert digits from the least significant one
+	if (Value < 0) Absolute_Value = -((unsigned long long) Value);
+	else Absolute_Value = Value;
+	do
+	{
+		i--;
+		String_Digits[i] = '0' + (Absolute_Value % 10);
+		Absolute_Value /= 10;
+	} while (Absolute_Value > 0);
+	if (Value < 0)
+	{
+		i--;
+		String_Digits[i] = '-';
+	}
+	
+	JsonWriterAppend(Pointer_Writer, &String_Digits[i], sizeof(String_Digits) - i);
+}
+
+void JsonWriterAddBoolean(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key, int Value)
+{
+	JsonWriterBeginValue(Pointer_Writer, Pointer_String_Key);
+	if (Value) JsonWriterAppend(Pointer_Writer, "true", 4);
+	else JsonWriterAppend(Pointer_Writer, "false", 5);
+}
+
+void JsonWriterAddString(TJsonWriter *Pointer_Writer, const char *Pointer_String_Key, const char *Pointer_String_Value)
+{
+	JsonWriterBeginValue(Pointer_Writer, Pointer_String_Key);
+	JsonWriterAppendEscapedString(Pointer_Writer, Pointer_String_Value);
+}
+
+int JsonWriterTerminate(TJsonWriter *Pointer_Writer)
+{
+	if (Pointer_Writer->Buffer_Size <= 0) return -1;
+	
+	Pointer_Writer->Pointer_String_Buffer[Pointer_Writer->Length] = 0; // There is always room for the terminating zero
+	if (Pointer_Writer->Is_Overflowed) return -1;
+	return Pointer_Writer->Length;
+}
+
+int JsonParseFlatObject(const char *Pointer_String, int Length, TJsonMember *Pointer_Members, int Maximum_Members_Count)
+{
+	int i = 0, Members_Count = 0;
+	TJsonMember *Pointer_Member;
+	
+	// Object start
+	JsonSkipBlanks(Pointer_String, &i, Length);
+	if ((i >= Length) || (Pointer_String[i] != '{')) return -1;
+	i++;
+	
+	// Handle the empty object case
+	JsonSkipBlanks(Pointer_String, &i, Length);
+	if ((i < Length) && (Pointer_String[i] == '}')) i++;
+	else
+	{
+		while (1)
+		{
+			if (Members_Count >= Maximum_Members_Count) return -1;
+			Pointer_Member = &Pointer_Members[Members_Count];
+			
+			// Member name
+			JsonSkipBlanks(Pointer_String, &i, Length);
+			if (JsonParseString(Pointer_String, &i, Length, &Pointer_Member->Pointer_String_Key, &Pointer_Member->Key_Length) != 0) return -1;
+			
+			// Name separator
+			JsonSkipBlanks(Pointer_String, &i, Length);
+			if ((i >= Length) || (Pointer_String[i] != ':')) return -1;
+			i++;
+			
+			// Member value
+			JsonSkipBlanks(Pointer_String, &i, Length);
+			if (JsonParseValue(Pointer_String, &i, Length, Pointer_Member) != 0) return -1;
+			Members_Count++;
+			
+			// Next member or object end
+			JsonSkipBlanks(Pointer_String, &i, Length);
+			if (i >= Length) return -1;
+			if (Pointer_String[i] == '}')
+			{
+				i++;
+				break;
+			}
+			if (Pointer_String[i] != ',') return -1;
+			i++;
+		}
+	}
+	
+	// Nothing but blanks can follow the object
+	JsonSkipBlanks(Pointer_String, &i, Length);
+	if (i != Length) return -1;
+	
+	return Members_Count;
+}
+
+TJsonMember *JsonFindMember(TJsonMember *Pointer_Members, int Members_Count, const char *Pointer_String_Key)
+{
+	int i, Key_Length = strlen(Pointer_String_Key);
+	
+	for (i = 0; i < Members_Count; i++)
+	{
+		if ((Pointer_Members[i].Key_Length == Key_Length) && (memcmp(Pointer_Members[i].Pointer_String_Key, Pointer_String_Key, Key_Length) == 0)) return &Pointer_Members[i];
+	}
+	return NULL;
+}
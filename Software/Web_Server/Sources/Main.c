@@ -2,19 +2,28 @@
  * An HTTP front-end for the boiler controller board.
  * @author Adrien RICCIARDI
  */
+#include <Api.h>
+#include <Assets.h>
 #include <Boiler.h>
+#include <Configuration.h>
+#include <Events.h>
+#include <History.h>
+#include <Metrics.h>
 #include <microhttpd.h>
 #include <Pages.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
+#include <time.h>
+#include <unistd.h>
 
 //-------------------------------------------------------------------------------------------------
-// Private variables
+// Private constants
 //-------------------------------------------------------------------------------------------------
-/** Store the HTML page to send as response. */
-static char Main_String_Response[10 * 1024];
+/** The connection custom data value telling that a web page request headers have been processed. */
+#define MAIN_PAGE_REQUEST_CONTEXT ((void *) 1)
 
 //-------------------------------------------------------------------------------------------------
 // Private functions
@@ -31,10 +40,24 @@ static char Main_String_Response[10 * 1024];
  * @return MHD_NO to close the connection,
  * @return MHD_YES to continue servicing the client request.
  */
-static int MainWebServerAccessHandlerCallback(void __attribute__((unused)) *Pointer_Custom_Data, struct MHD_Connection *Pointer_Connection, const char *Pointer_String_URL, const char *Pointer_String_Method, const char __attribute__((unused)) *Pointer_String_Version, const char __attribute__((unused)) *Pointer_String_Upload_Data, size_t __attribute__((unused)) *Pointer_Upload_Data_Size, void __attribute__((unused)) **Pointer_Persistent_Connection_Custom_Data)
+static int MainWebServerAccessHandlerCallback(void __attribute__((unused)) *Pointer_Custom_Data, struct MHD_Connection *Pointer_Connection, const char *Pointer_String_URL, const char *Pointer_String_Method, const char __attribute__((unused)) *Pointer_String_Version, const char *Pointer_String_Upload_Data, size_t *Pointer_Upload_Data_Size, void **Pointer_Persistent_Connection_Custom_Data)
 {
 	struct MHD_Response *Pointer_Response;
-	int Return_Value;
+	int Return_Value, Is_Response_Built;
+	struct timespec Start_Time;
+	TMetricsHandler Handler;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Start_Time);
+	
+	// API requests have their own context and accept other methods than GET
+	if (strncmp(Pointer_String_URL, API_URL_PREFIX, sizeof(API_URL_PREFIX) - 1) == 0)
+	{
+		// The response is built by the last call, which comes once the context exists and the whole body has been received
+		Is_Response_Built = (*Pointer_Persistent_Connection_Custom_Data != NULL) && (*Pointer_Upload_Data_Size == 0);
+		Return_Value = ApiHandleRequest(Pointer_Connection, Pointer_String_URL, Pointer_String_Method, Pointer_String_Upload_Data, Pointer_Upload_Data_Size, Pointer_Persistent_Connection_Custom_Data);
+		if (Is_Response_Built) MetricsObserveHandlerDuration(METRICS_HANDLER_API, &Start_Time);
+		return Return_Value;
+	}
 	
 	// Handle only GET methods
 	if (strcmp(Pointer_String_Method, "GET") != 0) return MHD_NO;
@@ -42,37 +65,79 @@ static int MainWebServerAccessHandlerCallback(void __attribute__((unused)) *Poin
 	// Callback is called when a new connection header is received, and no response must be sent at this time
 	if (*Pointer_Persistent_Connection_Custom_Data == NULL) // This value is always NULL for a new connection
 	{
-		*Pointer_Persistent_Connection_Custom_Data = (void *) 1; // Set the value to something else to tell that connection first step has been processed
+		*Pointer_Persistent_Connection_Custom_Data = MAIN_PAGE_REQUEST_CONTEXT; // Set the value to something else to tell that connection first step has been processed
 		return MHD_YES; // Continue servicing request
 	}
 	
-	// Create the page to send as the response
+	// The events stream is not a page, its response lasts as long as the client stays connected
+	if (strcmp(Pointer_String_URL, EVENTS_URL) == 0)
+	{
+		Handler = METRICS_HANDLER_EVENTS;
+		Pointer_Response = EventsCreateResponse(Pointer_Connection);
+		goto Queue_Response;
+	}
+	
+	if (strcmp(Pointer_String_URL, METRICS_URL) == 0)
+	{
+		Handler = METRICS_HANDLER_METRICS;
+		Pointer_Response = MetricsCreateResponse();
+		goto Queue_Response;
+	}
+	
+	// Static files are served from the memory-mapped bundle
+	if (AssetsQueueResponse(Pointer_Connection, Pointer_String_URL, &Return_Value) == 0)
+	{
+		MetricsObserveHandlerDuration(METRICS_HANDLER_ASSETS, &Start_Time);
+		return Return_Value;
+	}
+	
+	// Create the page to send as the response (pages are rendered from the compiled templates, so concurrent requests can't overwrite each other's page)
 	if ((strcmp(Pointer_String_URL, "/") == 0) || (strncmp(Pointer_String_URL, "/index.html", 11) == 0))
 	{
-		if (PageIndex(Pointer_Connection, Main_String_Response) != 0) return MHD_NO;
+		Handler = METRICS_HANDLER_INDEX_PAGE;
+		Pointer_Response = PageIndex(Pointer_Connection);
 	}
 	else if (strncmp(Pointer_String_URL, "/settings.html", 14) == 0)
 	{
-		if (PageSettings(Pointer_Connection, Main_String_Response) != 0) return MHD_NO;
+		Handler = METRICS_HANDLER_SETTINGS_PAGE;
+		Pointer_Response = PageSettings(Pointer_Connection);
 	}
-	else if (strncmp(Pointer_String_URL, "/monitoring.html", 16) == 0)
+	else if (strncmp(Pointer_String_URL, "/diagnostics.html", 17) == 0)
 	{
-		if (PageMonitoring(Pointer_Connection, Main_String_Response) != 0) return MHD_NO;
+		Handler = METRICS_HANDLER_DIAGNOSTICS_PAGE;
+		Pointer_Response = PageDiagnostics(Pointer_Connection);
 	}
 	// Unknown page
-	else return MHD_NO;
+	else
+	{
+		Handler = METRICS_HANDLER_UNKNOWN;
+		Pointer_Response = NULL;
+	}
 	
-	// Create the response to send
-	Pointer_Response = MHD_create_response_from_buffer(strlen(Main_String_Response), Main_String_Response, MHD_RESPMEM_PERSISTENT);
+Queue_Response:
+	MetricsObserveHandlerDuration(Handler, &Start_Time);
 	if (Pointer_Response == NULL) return MHD_NO;
 	
 	// Send the response
-	Return_Value = MHD_queue_response(Pointer_Connection, MHD_HTTP_OK, Pointer_Response);
+	Return_Value = MetricsQueueResponse(Pointer_Connection, MHD_HTTP_OK, Pointer_Response);
 	MHD_destroy_response(Pointer_Response);
 	
 	return Return_Value;
 }
 
+/** Called when a request has been fully processed, successfully or not.
+ * @param Pointer_Custom_Data Custom data provided to MHD_start_daemon().
+ * @param Pointer_Connection The connection the request has been received from.
+ * @param Pointer_Persistent_Connection_Custom_Data The custom data pointer set by the access handler.
+ * @param Termination_Code Why the request ended.
+ */
+static void MainWebServerRequestCompletedCallback(void __attribute__((unused)) *Pointer_Custom_Data, struct MHD_Connection __attribute__((unused)) *Pointer_Connection, void **Pointer_Persistent_Connection_Custom_Data, enum MHD_RequestTerminationCode __attribute__((unused)) Termination_Code)
+{
+	// Only API requests allocate a context
+	if (*Pointer_Persistent_Connection_Custom_Data != MAIN_PAGE_REQUEST_CONTEXT) free(*Pointer_Persistent_Connection_Custom_Data);
+	*Pointer_Persistent_Connection_Custom_Data = NULL;
+}
+
 //-------------------------------------------------------------------------------------------------
 // Entry point
 //-------------------------------------------------------------------------------------------------
@@ -80,38 +145,120 @@ int main(int argc, char *argv[])
 {
 	unsigned short Web_Server_Port;
 	struct MHD_Daemon *Pointer_Web_Server;
+	int Option, Threads_Count = CONFIGURATION_WEB_SERVER_DEFAULT_THREADS_COUNT, Connections_Limit = CONFIGURATION_WEB_SERVER_DEFAULT_CONNECTIONS_LIMIT, History_Sampling_Period = CONFIGURATION_HISTORY_DEFAULT_SAMPLING_PERIOD, Is_Parameter_Bad = 0;
+	char *String_History_File_Path = CONFIGURATION_HISTORY_DEFAULT_FILE_PATH, *String_Assets_Bundle_File_Path = CONFIGURATION_ASSETS_DEFAULT_BUNDLE_FILE_PATH;
+	sigset_t Termination_Signals;
+	int Signal_Number;
 	
 	// Start logging system
 	openlog(argv[0], 0, LOG_DAEMON);
 	
 	// Check parameters
-	if (argc != 2)
+	while ((Option = getopt(argc, argv, "a:c:f:s:t:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'a':
+				String_Assets_Bundle_File_Path = optarg;
+				break;
+				
+			case 'c':
+				Connections_Limit = atoi(optarg);
+				if (Connections_Limit <= 0) Is_Parameter_Bad = 1;
+				break;
+				
+			case 'f':
+				String_History_File_Path = optarg;
+				break;
+				
+			case 's':
+				History_Sampling_Period = atoi(optarg);
+				if (History_Sampling_Period <= 0) Is_Parameter_Bad = 1;
+				break;
+				
+			case 't':
+				Threads_Count = atoi(optarg);
+				if (Threads_Count < 0) Is_Parameter_Bad = 1;
+				break;
+				
+			default:
+				Is_Parameter_Bad = 1;
+				break;
+		}
+	}
+	if (Is_Parameter_Bad || (optind != argc - 1))
+	{
+		syslog(LOG_ERR, "Bad parameters. Usage : %s [-t Threads_Count] [-c Connections_Limit] [-f History_File] [-s History_Sampling_Period] [-a Assets_Bundle_File] Web_Server_Port", argv[0]);
+		printf("Bad parameters. Usage : %s [-t Threads_Count] [-c Connections_Limit] [-f History_File] [-s History_Sampling_Period] [-a Assets_Bundle_File] Web_Server_Port\n"
+			"  -t : how many threads serve the web requests (default is %d). Set to 0 to create a thread per connection instead of using a threads pool.\n"
+			"  -c : how many simultaneous web connections are accepted (default is %d).\n"
+			"  -f : the file the board status history is stored to (default is %s).\n"
+			"  -s : how many seconds to wait between two history samples (default is %d).\n"
+			"  -a : the static files bundle built by the assets packer (default is %s).\n", argv[0], CONFIGURATION_WEB_SERVER_DEFAULT_THREADS_COUNT, CONFIGURATION_WEB_SERVER_DEFAULT_CONNECTIONS_LIMIT, CONFIGURATION_HISTORY_DEFAULT_FILE_PATH, CONFIGURATION_HISTORY_DEFAULT_SAMPLING_PERIOD, CONFIGURATION_ASSETS_DEFAULT_BUNDLE_FILE_PATH);
+		return EXIT_FAILURE;
+	}
+	Web_Server_Port = atoi(argv[optind]);
+	
+	// Termination signals are blocked before any thread is created, so all threads inherit the mask and only the main thread receives them
+	sigemptyset(&Termination_Signals);
+	sigaddset(&Termination_Signals, SIGINT);
+	sigaddset(&Termination_Signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &Termination_Signals, NULL);
+	
+	// Pages can't be displayed without their style sheets and scripts
+	if (AssetsInitialize(String_Assets_Bundle_File_Path) != 0)
 	{
-		syslog(LOG_ERR, "Bad parameters. Usage : %s Web_Server_Port", argv[0]);
-		printf("Bad parameters. Usage : %s Web_Server_Port\n", argv[0]);
+		syslog(LOG_ERR, "Failed to load assets bundle, exiting.");
 		return EXIT_FAILURE;
 	}
-	Web_Server_Port = atoi(argv[1]);
 	
 	// Start boiler server first, so board gets a chance to connect before the first web request comes
 	if (BoilerInitializeServer() != 0)
 	{
+		AssetsUninitialize();
 		syslog(LOG_ERR, "Failed to initialize boiler server, exiting.");
 		return EXIT_FAILURE;
 	}
 	
+	// Missing history is not worth stopping the server
+	if (HistoryInitialize(String_History_File_Path, History_Sampling_Period) != 0) syslog(LOG_WARNING, "Failed to initialize history, history won't be recorded.");
+	
+	// Events streams suspend their connection when the web server uses a threads pool, so they do not hold a pool thread
+	if (EventsInitialize(Threads_Count != 0) != 0)
+	{
+		HistoryUninitialize();
+		BoilerUninitializeServer();
+		AssetsUninitialize();
+		syslog(LOG_ERR, "Failed to initialize events, exiting.");
+		return EXIT_FAILURE;
+	}
+	
 	// Start web server
-	Pointer_Web_Server = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION, Web_Server_Port, NULL, NULL, MainWebServerAccessHandlerCallback, NULL, MHD_OPTION_END);
+	if (Threads_Count == 0) Pointer_Web_Server = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION, Web_Server_Port, NULL, NULL, MainWebServerAccessHandlerCallback, NULL, MHD_OPTION_CONNECTION_LIMIT, (unsigned int) Connections_Limit, MHD_OPTION_NOTIFY_COMPLETED, MainWebServerRequestCompletedCallback, NULL, MHD_OPTION_NOTIFY_CONNECTION, MetricsConnectionNotificationCallback, NULL, MHD_OPTION_END);
+	else Pointer_Web_Server = MHD_start_daemon(MHD_USE_EPOLL_INTERNAL_THREAD | MHD_ALLOW_SUSPEND_RESUME, Web_Server_Port, NULL, NULL, MainWebServerAccessHandlerCallback, NULL, MHD_OPTION_THREAD_POOL_SIZE, (unsigned int) Threads_Count, MHD_OPTION_CONNECTION_LIMIT, (unsigned int) Connections_Limit, MHD_OPTION_NOTIFY_COMPLETED, MainWebServerRequestCompletedCallback, NULL, MHD_OPTION_NOTIFY_CONNECTION, MetricsConnectionNotificationCallback, NULL, MHD_OPTION_END);
 	if (Pointer_Web_Server == NULL)
 	{
+		EventsUninitialize();
+		HistoryUninitialize();
 		BoilerUninitializeServer();
+		AssetsUninitialize();
 		syslog(LOG_ERR, "Failed to start web server daemon, exiting.");
 		return EXIT_FAILURE;
 	}
-	syslog(LOG_INFO, "Server started and ready.");
+	syslog(LOG_INFO, "Server started and ready (threads count : %d, connections limit : %d).", Threads_Count, Connections_Limit);
+	
+	// All the work is done by the web server threads and the board I/O thread
+	sigwait(&Termination_Signals, &Signal_Number);
+	syslog(LOG_INFO, "Received signal %d, exiting.", Signal_Number);
+	
+	// End the events streams, which are suspended most of the time, then stop serving requests, so no request handler uses a module being released
+	EventsUninitialize();
+	MHD_stop_daemon(Pointer_Web_Server);
 	
-	// Run board server
-	while (1) BoilerRunServer();
+	// Release the other modules in the reverse order of their initialization, making sure the history reached the disk and telling the board the connection is closed
+	HistoryUninitialize();
+	BoilerUninitializeServer();
+	AssetsUninitialize();
 	
-	return 0;
+	return EXIT_SUCCESS;
 }
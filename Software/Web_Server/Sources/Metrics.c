@@ -0,0 +1,414 @@
+/** @file Metrics.c
+ * See Metrics.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Boiler.h>
+#include <Configuration.h>
+#include <Metrics.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syslog.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many counters slots the web server threads share. Threads beyond this count share a slot with another thread, which is still correct because all updates are atomic, only slower. */
+#define METRICS_THREAD_SLOTS_COUNT 16
+
+/** How many buckets a handler duration histogram has. Bucket i counts the durations that lasted less than 2^i * 100 microseconds (and not less than the previous bucket limit), the last bucket counts all longer durations. */
+#define METRICS_DURATION_HISTOGRAM_BUCKETS_COUNT 13
+
+/** How many status codes are counted on their own. */
+#define METRICS_STATUS_CODES_COUNT 8
+
+/** The content type of the Prometheus text exposition format. */
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** The counters a web server thread updates. Each slot has its own cache lines, so threads do not slow each other down. */
+typedef struct __attribute__((aligned(64)))
+{
+	unsigned long long Handler_Requests_Count[METRICS_HANDLERS_COUNT]; //!< How many requests each handler served.
+	unsigned long long Handler_Total_Duration[METRICS_HANDLERS_COUNT]; //!< Cumulated handler durations in microseconds.
+	unsigned long long Handler_Duration_Histogram[METRICS_HANDLERS_COUNT][METRICS_DURATION_HISTOGRAM_BUCKETS_COUNT]; //!< How many requests fell in each duration bucket.
+	unsigned long long Status_Codes_Count[METRICS_STATUS_CODES_COUNT + 1]; //!< How many responses were sent with each known status code, the last entry counts the other codes.
+	unsigned long long Connections_Count; //!< How many connections have been opened minus how many have been closed. A connection can be closed by another thread than the one that opened it, so only the sum over all slots is meaningful.
+} TMetricsThreadCounters;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** The status codes counted on their own. */
+static const unsigned int Metrics_Status_Codes[METRICS_STATUS_CODES_COUNT] = {200, 304, 400, 404, 405, 413, 500, 503};
+
+/** All threads counters. */
+static TMetricsThreadCounters Metrics_Thread_Counters[METRICS_THREAD_SLOTS_COUNT];
+/** The slot the next thread will use. */
+static unsigned int Metrics_Next_Thread_Slot_Index = 0;
+/** The slot of the calling thread, assigned on the thread first update. */
+static __thread TMetricsThreadCounters *Metrics_Pointer_Thread_Counters = NULL;
+
+/** The handlers names as exported. */
+static const char *Metrics_Pointer_String_Handler_Names[METRICS_HANDLERS_COUNT] =
+{
+	"index_page",
+	"settings_page",
+	"diagnostics_page",
+	"api",
+	"events",
+	"assets",
+	"metrics",
+	"unknown"
+};
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Get the counters slot of the calling thread.
+ * @return The thread counters.
+ */
+static TMetricsThreadCounters *MetricsGetThreadCounters(void)
+{
+	unsigned int Slot_Index;
+	
+	if (Metrics_Pointer_Thread_Counters == NULL)
+	{
+		Slot_Index = __atomic_fetch_add(&Metrics_Next_Thread_Slot_Index, 1, __ATOMIC_RELAXED) % METRICS_THREAD_SLOTS_COUNT;
+		Metrics_Pointer_Thread_Counters = &Metrics_Thread_Counters[Slot_Index];
+	}
+	return Metrics_Pointer_Thread_Counters;
+}
+
+/** Increment a counter. The slot owner is usually the only writer, but slots can be shared, so the increment must be atomic anyway.
+ * @param Pointer_Counter The counter.
+ * @param Value The value to add.
+ */
+static inline void MetricsAddToCounter(unsigned long long *Pointer_Counter, unsigned long long Value)
+{
+	__atomic_fetch_add(Pointer_Counter, Value, __ATOMIC_RELAXED);
+}
+
+/** Sum a counter over all threads slots.
+ * @param Offset The counter offset in a slot.
+ * @return The counter total value.
+ */
+static unsigned long long MetricsSumCounter(size_t Offset)
+{
+	unsigned long long Sum = 0;
+	int i;
+	
+	for (i = 0; i < METRICS_THREAD_SLOTS_COUNT; i++) Sum += __atomic_load_n((unsigned long long *) ((char *) &Metrics_Thread_Counters[i] + Offset), __ATOMIC_RELAXED);
+	return Sum;
+}
+
+/** Write the web server metrics.
+ * @param Pointer_File The stream to write to.
+ */
+static void MetricsWriteWebServerMetrics(FILE *Pointer_File)
+{
+	int Handler, Bucket_Index;
+	unsigned int i;
+	unsigned long long Cumulative_Count;
+	
+	fprintf(Pointer_File, "# HELP boiler_http_requests_total Requests served by each handler.\n# TYPE boiler_http_requests_total counter\n");
+	for (Handler = 0; Handler < METRICS_HANDLERS_COUNT; Handler++) fprintf(Pointer_File, "boiler_http_requests_total{handler=\"%s\"} %llu\n", Metrics_Pointer_String_Handler_Names[Handler], MetricsSumCounter(offsetof(TMetricsThreadCounters, Handler_Requests_Count[Handler])));
+	
+	fprintf(Pointer_File, "# HELP boiler_http_render_duration_seconds Time spent building the responses, per handler.\n# TYPE boiler_http_render_duration_seconds histogram\n");
+	for (Handler = 0; Handler < METRICS_HANDLERS_COUNT; Handler++)
+	{
+		// Prometheus buckets are cumulative
+		Cumulative_Count = 0;
+		for (Bucket_Index = 0; Bucket_Index < METRICS_DURATION_HISTOGRAM_BUCKETS_COUNT - 1; Bucket_Index++)
+		{
+			Cumulative_Count += MetricsSumCounter(offsetof(TMetricsThreadCounters, Handler_Duration_Histogram[Handler][Bucket_Index]));
+			fprintf(Pointer_File, "boiler_http_render_duration_seconds_bucket{handler=\"%s\",le=\"%g\"} %llu\n", Metrics_Pointer_String_Handler_Names[Handler], (100ULL << Bucket_Index) / 1000000., Cumulative_Count);
+		}
+		Cumulative_Count += MetricsSumCounter(offsetof(TMetricsThreadCounters, Handler_Duration_Histogram[Handler][Bucket_Index]));
+		fprintf(Pointer_File, "boiler_http_render_duration_seconds_bucket{handler=\"%s\",le=\"+Inf\"} %llu\n", Metrics_Pointer_String_Handler_Names[Handler], Cumulative_Count);
+		fprintf(Pointer_File, "boiler_http_render_duration_seconds_sum{handler=\"%s\"} %.6f\n", Metrics_Pointer_String_Handler_Names[Handler], MetricsSumCounter(offsetof(TMetricsThreadCounters, Handler_Total_Duration[Handler])) / 1000000.);
+		fprintf(Pointer_File, "boiler_http_render_duration_seconds_count{handler=\"%s\"} %llu\n", Metrics_Pointer_String_Handler_Names[Handler], Cumulative_Count);
+	}
+	
+	fprintf(Pointer_File, "# HELP boiler_http_responses_total Responses sent, per status code.\n# TYPE boiler_http_responses_total counter\n");
+	for (i = 0; i < METRICS_STATUS_CODES_COUNT; i++) fprintf(Pointer_File, "boiler_http_responses_total{code=\"%u\"} %llu\n", Metrics_Status_Codes[i], MetricsSumCounter(offsetof(TMetricsThreadCounters, Status_Codes_Count[i])));
+	fprintf(Pointer_File, "boiler_http_responses_total{code=\"other\"} %llu\n", MetricsSumCounter(offsetof(TMetricsThreadCounters, Status_Codes_Count[i])));
+	
+	fprintf(Pointer_File, "# HELP boiler_http_connections_in_flight Web connections currently open.\n# TYPE boiler_http_connections_in_flight gauge\nboiler_http_connections_in_flight %lld\n", (long long) MetricsSumCounter(offsetof(TMetricsThreadCounters, Connections_Count)));
+}
+
+/** Write the board link metrics of all known boards, each board values being labeled with the board ID.
+ * @param Pointer_File The stream to write to.
+ * @param Pointer_Board_IDs The known boards.
+ * @param Boards_Count How many boards are known.
+ */
+static void MetricsWriteBoardLinkMetrics(FILE *Pointer_File, int *Pointer_Board_IDs, int Boards_Count)
+{
+	TBoilerCommandStatistics Statistics;
+	TBoilerCommandQueueStatistics Queue_Statistics;
+	TBoilerConnectionStatistics Connection_Statistics;
+	TBoilerCommand Command;
+	int Bucket_Index, i;
+	unsigned long long Cumulative_Count;
+	
+	// All samples of a family must be grouped, so each family loops on all boards (statistics may slightly move between families, which does not matter for counters)
+	fprintf(Pointer_File, "# HELP boiler_board_commands_sent_total Commands sent to the board.\n# TYPE boiler_board_commands_sent_total counter\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		for (Command = 0; Command < BOILER_COMMANDS_COUNT; Command++)
+		{
+			BoilerGetCommandStatistics(Pointer_Board_IDs[i], Command, &Statistics);
+			fprintf(Pointer_File, "boiler_board_commands_sent_total{board=\"%d\",command=\"%s\"} %llu\n", Pointer_Board_IDs[i], BoilerGetCommandName(Command), Statistics.Successful_Commands_Count + Statistics.Failed_Commands_Count);
+		}
+	}
+	fprintf(Pointer_File, "# HELP boiler_board_commands_failed_total Commands that did not get an answer.\n# TYPE boiler_board_commands_failed_total counter\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		for (Command = 0; Command < BOILER_COMMANDS_COUNT; Command++)
+		{
+			BoilerGetCommandStatistics(Pointer_Board_IDs[i], Command, &Statistics);
+			fprintf(Pointer_File, "boiler_board_commands_failed_total{board=\"%d\",command=\"%s\"} %llu\n", Pointer_Board_IDs[i], BoilerGetCommandName(Command), Statistics.Failed_Commands_Count);
+		}
+	}
+	fprintf(Pointer_File, "# HELP boiler_board_commands_timed_out_total Failed commands that did not get an answer in time.\n# TYPE boiler_board_commands_timed_out_total counter\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		for (Command = 0; Command < BOILER_COMMANDS_COUNT; Command++)
+		{
+			BoilerGetCommandStatistics(Pointer_Board_IDs[i], Command, &Statistics);
+			fprintf(Pointer_File, "boiler_board_commands_timed_out_total{board=\"%d\",command=\"%s\"} %llu\n", Pointer_Board_IDs[i], BoilerGetCommandName(Command), Statistics.Timed_Out_Commands_Count);
+		}
+	}
+	
+	fprintf(Pointer_File, "# HELP boiler_board_round_trip_time_seconds Time between a command sending and its answer reception.\n# TYPE boiler_board_round_trip_time_seconds histogram\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		for (Command = 0; Command < BOILER_COMMANDS_COUNT; Command++)
+		{
+			BoilerGetCommandStatistics(Pointer_Board_IDs[i], Command, &Statistics);
+			Cumulative_Count = 0;
+			for (Bucket_Index = 0; Bucket_Index < BOILER_ROUND_TRIP_TIME_HISTOGRAM_BUCKETS_COUNT - 1; Bucket_Index++)
+			{
+				Cumulative_Count += Statistics.Round_Trip_Time_Histogram[Bucket_Index];
+				fprintf(Pointer_File, "boiler_board_round_trip_time_seconds_bucket{board=\"%d\",command=\"%s\",le=\"%g\"} %llu\n", Pointer_Board_IDs[i], BoilerGetCommandName(Command), (1ULL << Bucket_Index) / 1000., Cumulative_Count);
+			}
+			fprintf(Pointer_File, "boiler_board_round_trip_time_seconds_bucket{board=\"%d\",command=\"%s\",le=\"+Inf\"} %llu\n", Pointer_Board_IDs[i], BoilerGetCommandName(Command), Statistics.Successful_Commands_Count);
+			fprintf(Pointer_File, "boiler_board_round_trip_time_seconds_sum{board=\"%d\",command=\"%s\"} %.6f\n", Pointer_Board_IDs[i], BoilerGetCommandName(Command), Statistics.Total_Round_Trip_Time / 1000000.);
+			fprintf(Pointer_File, "boiler_board_round_trip_time_seconds_count{board=\"%d\",command=\"%s\"} %llu\n", Pointer_Board_IDs[i], BoilerGetCommandName(Command), Statistics.Successful_Commands_Count);
+		}
+	}
+	
+	fprintf(Pointer_File, "# HELP boiler_board_command_queue_depth Commands waiting to be sent.\n# TYPE boiler_board_command_queue_depth gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetCommandQueueStatistics(Pointer_Board_IDs[i], &Queue_Statistics);
+		fprintf(Pointer_File, "boiler_board_command_queue_depth{board=\"%d\"} %u\n", Pointer_Board_IDs[i], Queue_Statistics.Current_Depth);
+	}
+	fprintf(Pointer_File, "# HELP boiler_board_command_queue_maximum_depth Highest queue depth since the server started.\n# TYPE boiler_board_command_queue_maximum_depth gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetCommandQueueStatistics(Pointer_Board_IDs[i], &Queue_Statistics);
+		fprintf(Pointer_File, "boiler_board_command_queue_maximum_depth{board=\"%d\"} %u\n", Pointer_Board_IDs[i], Queue_Statistics.Maximum_Depth);
+	}
+	fprintf(Pointer_File, "# HELP boiler_board_command_queue_rejected_total Commands dropped because the queue was full.\n# TYPE boiler_board_command_queue_rejected_total counter\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetCommandQueueStatistics(Pointer_Board_IDs[i], &Queue_Statistics);
+		fprintf(Pointer_File, "boiler_board_command_queue_rejected_total{board=\"%d\"} %llu\n", Pointer_Board_IDs[i], Queue_Statistics.Rejected_Commands_Count);
+	}
+	fprintf(Pointer_File, "# HELP boiler_board_command_queue_wait_seconds_total Cumulated time the processed commands spent in the queue.\n# TYPE boiler_board_command_queue_wait_seconds_total counter\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetCommandQueueStatistics(Pointer_Board_IDs[i], &Queue_Statistics);
+		fprintf(Pointer_File, "boiler_board_command_queue_wait_seconds_total{board=\"%d\"} %.6f\n", Pointer_Board_IDs[i], Queue_Statistics.Total_Wait_Time / 1000000.);
+	}
+	
+	fprintf(Pointer_File, "# HELP boiler_board_connected Whether the board is connected.\n# TYPE boiler_board_connected gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetConnectionStatistics(Pointer_Board_IDs[i], &Connection_Statistics);
+		fprintf(Pointer_File, "boiler_board_connected{board=\"%d\"} %d\n", Pointer_Board_IDs[i], Connection_Statistics.Is_Connected);
+	}
+	fprintf(Pointer_File, "# HELP boiler_board_connections_total Board connections since the server started.\n# TYPE boiler_board_connections_total counter\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetConnectionStatistics(Pointer_Board_IDs[i], &Connection_Statistics);
+		fprintf(Pointer_File, "boiler_board_connections_total{board=\"%d\"} %llu\n", Pointer_Board_IDs[i], Connection_Statistics.Connections_Count);
+	}
+	fprintf(Pointer_File, "# HELP boiler_board_lost_connections_total Board connections closed because the board could not be reached or reconnected.\n# TYPE boiler_board_lost_connections_total counter\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetConnectionStatistics(Pointer_Board_IDs[i], &Connection_Statistics);
+		fprintf(Pointer_File, "boiler_board_lost_connections_total{board=\"%d\"} %llu\n", Pointer_Board_IDs[i], Connection_Statistics.Lost_Connections_Count);
+	}
+	fprintf(Pointer_File, "# HELP boiler_board_connection_age_seconds How long the current board connection has lasted.\n# TYPE boiler_board_connection_age_seconds gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		BoilerGetConnectionStatistics(Pointer_Board_IDs[i], &Connection_Statistics);
+		if (Connection_Statistics.Is_Connected) fprintf(Pointer_File, "boiler_board_connection_age_seconds{board=\"%d\"} %llu\n", Pointer_Board_IDs[i], Connection_Statistics.Connection_Age);
+	}
+}
+
+/** Write the last status values of all known boards.
+ * @param Pointer_File The stream to write to.
+ * @param Pointer_Board_IDs The known boards.
+ * @param Boards_Count How many boards are known.
+ */
+static void MetricsWriteStatusMetrics(FILE *Pointer_File, int *Pointer_Board_IDs, int Boards_Count)
+{
+	TBoilerStatus Statuses[CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT], *Pointer_Status;
+	int i;
+	
+	// Take all snapshots once, so all families show the same values
+	for (i = 0; i < Boards_Count; i++) BoilerGetStatusSnapshot(Pointer_Board_IDs[i], &Statuses[i]);
+	
+	fprintf(Pointer_File, "# HELP boiler_status_valid Whether the last board poll succeeded.\n# TYPE boiler_status_valid gauge\n");
+	for (i = 0; i < Boards_Count; i++) fprintf(Pointer_File, "boiler_status_valid{board=\"%d\"} %d\n", Pointer_Board_IDs[i], Statuses[i].Is_Valid);
+	
+	// Do not export stale values, graphs must show a gap when the board is not reachable
+	fprintf(Pointer_File, "# HELP boiler_status_update_timestamp_seconds When the board was successfully polled for the last time.\n# TYPE boiler_status_update_timestamp_seconds gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		if (Statuses[i].Is_Valid) fprintf(Pointer_File, "boiler_status_update_timestamp_seconds{board=\"%d\"} %lld\n", Pointer_Board_IDs[i], (long long) Statuses[i].Update_Time);
+	}
+	fprintf(Pointer_File, "# HELP boiler_temperature_celsius Temperatures measured or computed by the board.\n# TYPE boiler_temperature_celsius gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		Pointer_Status = &Statuses[i];
+		if (!Pointer_Status->Is_Valid) continue;
+		fprintf(Pointer_File, "boiler_temperature_celsius{board=\"%d\",sensor=\"outside\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Outside_Temperature);
+		fprintf(Pointer_File, "boiler_temperature_celsius{board=\"%d\",sensor=\"radiator_start_water\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Radiator_Start_Water_Temperature);
+		fprintf(Pointer_File, "boiler_temperature_celsius{board=\"%d\",sensor=\"target_radiator_start_water\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Target_Radiator_Start_Water_Temperature);
+	}
+	fprintf(Pointer_File, "# HELP boiler_desired_room_temperature_celsius The desired room temperatures.\n# TYPE boiler_desired_room_temperature_celsius gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		Pointer_Status = &Statuses[i];
+		if (!Pointer_Status->Is_Valid) continue;
+		fprintf(Pointer_File, "boiler_desired_room_temperature_celsius{board=\"%d\",period=\"day\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Desired_Day_Temperature);
+		fprintf(Pointer_File, "boiler_desired_room_temperature_celsius{board=\"%d\",period=\"night\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Desired_Night_Temperature);
+	}
+	fprintf(Pointer_File, "# HELP boiler_running Whether the boiler is running or idle.\n# TYPE boiler_running gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		if (Statuses[i].Is_Valid) fprintf(Pointer_File, "boiler_running{board=\"%d\"} %d\n", Pointer_Board_IDs[i], Statuses[i].Is_Boiler_Running);
+	}
+	fprintf(Pointer_File, "# HELP boiler_night_mode Whether the night temperature is used.\n# TYPE boiler_night_mode gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		if (Statuses[i].Is_Valid) fprintf(Pointer_File, "boiler_night_mode{board=\"%d\"} %d\n", Pointer_Board_IDs[i], Statuses[i].Is_Night_Mode_Enabled);
+	}
+	fprintf(Pointer_File, "# HELP boiler_relay_on The relays states.\n# TYPE boiler_relay_on gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		Pointer_Status = &Statuses[i];
+		if (!Pointer_Status->Is_Valid) continue;
+		fprintf(Pointer_File, "boiler_relay_on{board=\"%d\",relay=\"gas_burner\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Is_Gas_Burner_On);
+		fprintf(Pointer_File, "boiler_relay_on{board=\"%d\",relay=\"pump\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Is_Pump_On);
+		fprintf(Pointer_File, "boiler_relay_on{board=\"%d\",relay=\"mixing_valve_left\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Is_Mixing_Valve_Left_Relay_On);
+		fprintf(Pointer_File, "boiler_relay_on{board=\"%d\",relay=\"mixing_valve_right\"} %d\n", Pointer_Board_IDs[i], Pointer_Status->Is_Mixing_Valve_Right_Relay_On);
+	}
+	fprintf(Pointer_File, "# HELP boiler_mixing_valve_position The last position reached by the mixing valve (0 is left, 1 is center, 2 is right).\n# TYPE boiler_mixing_valve_position gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		if (Statuses[i].Is_Valid) fprintf(Pointer_File, "boiler_mixing_valve_position{board=\"%d\"} %d\n", Pointer_Board_IDs[i], Statuses[i].Mixing_Valve_Position);
+	}
+	fprintf(Pointer_File, "# HELP boiler_heating_curve_coefficient The heating curve coefficient.\n# TYPE boiler_heating_curve_coefficient gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		if (Statuses[i].Is_Valid) fprintf(Pointer_File, "boiler_heating_curve_coefficient{board=\"%d\"} %.1f\n", Pointer_Board_IDs[i], Statuses[i].Heating_Curve_Coefficient / 10.);
+	}
+	fprintf(Pointer_File, "# HELP boiler_heating_curve_parallel_shift The heating curve parallel shift.\n# TYPE boiler_heating_curve_parallel_shift gauge\n");
+	for (i = 0; i < Boards_Count; i++)
+	{
+		if (Statuses[i].Is_Valid) fprintf(Pointer_File, "boiler_heating_curve_parallel_shift{board=\"%d\"} %.1f\n", Pointer_Board_IDs[i], Statuses[i].Heating_Curve_Parallel_Shift / 10.);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void MetricsObserveHandlerDuration(TMetricsHandler Handler, struct timespec *Pointer_Start_Time)
+{
+	TMetricsThreadCounters *Pointer_Counters = MetricsGetThreadCounters();
+	struct timespec Current_Time;
+	unsigned long long Duration;
+	int Bucket_Index;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Current_Time);
+	Duration = (Current_Time.tv_sec - Pointer_Start_Time->tv_sec) * 1000000LL + (Current_Time.tv_nsec - Pointer_Start_Time->tv_nsec) / 1000;
+	
+	// Find the histogram bucket the duration belongs to
+	for (Bucket_Index = 0; Bucket_Index < METRICS_DURATION_HISTOGRAM_BUCKETS_COUNT - 1; Bucket_Index++)
+	{
+		if (Duration < (100ULL << Bucket_Index)) break;
+	}
+	MetricsAddToCounter(&Pointer_Counters->Handler_Duration_Histogram[Handler][Bucket_Index], 1);
+	MetricsAddToCounter(&Pointer_Counters->Handler_Total_Duration[Handler], Duration);
+	MetricsAddToCounter(&Pointer_Counters->Handler_Requests_Count[Handler], 1);
+}
+
+int MetricsQueueResponse(struct MHD_Connection *Pointer_Connection, unsigned int Status_Code, struct MHD_Response *Pointer_Response)
+{
+	TMetricsThreadCounters *Pointer_Counters = MetricsGetThreadCounters();
+	unsigned int i;
+	
+	// Unknown codes are counted in the last entry
+	for (i = 0; i < METRICS_STATUS_CODES_COUNT; i++)
+	{
+		if (Metrics_Status_Codes[i] == Status_Code) break;
+	}
+	MetricsAddToCounter(&Pointer_Counters->Status_Codes_Count[i], 1);
+	
+	return MHD_queue_response(Pointer_Connection, Status_Code, Pointer_Response);
+}
+
+void MetricsConnectionNotificationCallback(void __attribute__((unused)) *Pointer_Custom_Data, struct MHD_Connection __attribute__((unused)) *Pointer_Connection, void __attribute__((unused)) **Pointer_Socket_Context, enum MHD_ConnectionNotificationCode Notification_Code)
+{
+	TMetricsThreadCounters *Pointer_Counters = MetricsGetThreadCounters();
+	
+	// Adding the two's complement of 1 decrements the unsigned counter
+	if (Notification_Code == MHD_CONNECTION_NOTIFY_STARTED) MetricsAddToCounter(&Pointer_Counters->Connections_Count, 1);
+	else if (Notification_Code == MHD_CONNECTION_NOTIFY_CLOSED) MetricsAddToCounter(&Pointer_Counters->Connections_Count, -1ULL);
+}
+
+struct MHD_Response *MetricsCreateResponse(void)
+{
+	FILE *Pointer_File;
+	char *Pointer_String_Metrics;
+	size_t Size;
+	struct MHD_Response *Pointer_Response;
+	int Board_IDs[CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT], Boards_Count;
+	
+	// The output size depends on the exported values, let the stream grow as needed
+	Pointer_File = open_memstream(&Pointer_String_Metrics, &Size);
+	if (Pointer_File == NULL)
+	{
+		syslog(LOG_ERR, "Failed to create metrics stream.");
+		return NULL;
+	}
+	MetricsWriteWebServerMetrics(Pointer_File);
+	Boards_Count = BoilerGetKnownBoards(Board_IDs);
+	MetricsWriteBoardLinkMetrics(Pointer_File, Board_IDs, Boards_Count);
+	MetricsWriteStatusMetrics(Pointer_File, Board_IDs, Boards_Count);
+	if (fclose(Pointer_File) != 0)
+	{
+		syslog(LOG_ERR, "Failed to write metrics.");
+		free(Pointer_String_Metrics);
+		return NULL;
+	}
+	
+	// The buffer will be freed by the web server when the response is destroyed
+	Pointer_Response = MHD_create_response_from_buffer(Size, Pointer_String_Metrics, MHD_RESPMEM_MUST_FREE);
+	if (Pointer_Response == NULL)
+	{
+		free(Pointer_String_Metrics);
+		return NULL;
+	}
+	MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CONTENT_TYPE, METRICS_CONTENT_TYPE);
+	MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CACHE_CONTROL, "no-store");
+	
+	return Pointer_Response;
+}
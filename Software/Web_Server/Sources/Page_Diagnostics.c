@@ -0,0 +1,162 @@
+/** @file Page_Diagnostics.c
+ * Generate the diagnostics page. See Pages.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Assets.h>
+#include <Boiler.h>
+#include <Pages.h>
+#include <stdio.h>
+#include <syslog.h>
+#include <Templates_Tables.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** The board CPU frequency in Hz, used to convert cycles to time. */
+#define PAGE_DIAGNOSTICS_BOARD_CPU_FREQUENCY 3686400ULL
+/** How many CPU cycles the board UART takes to receive a byte (10 bits at 115200bit/s). An interrupt handler lasting longer can make the board miss a received byte. */
+#define PAGE_DIAGNOSTICS_UART_BYTE_CYCLES (10 * PAGE_DIAGNOSTICS_BOARD_CPU_FREQUENCY / 115200)
+
+/** Size in bytes of the buffer holding the sections table HTML code. */
+#define PAGE_DIAGNOSTICS_TABLE_BUFFER_SIZE 3072
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A firmware section, in the order of the firmware section IDs (see the microcontroller firmware Profiler.h file). */
+typedef struct
+{
+	const char *Pointer_String_Name; //!< The name displayed in the table, it must be valid HTML.
+	int Is_Interrupt_Handler; //!< Set to 1 if the section is an interrupt handler, which must be shorter than a received UART byte.
+} TPageDiagnosticsSection;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** All sections measured by the current firmware. Sections added by a more recent firmware are displayed with their ID. */
+static const TPageDiagnosticsSection Page_Diagnostics_Sections[] =
+{
+	{ "T&acirc;che ADC", 0 },
+	{ "T&acirc;che liaison Wi-Fi", 0 },
+	{ "T&acirc;che temp&eacute;ratures", 0 },
+	{ "T&acirc;che r&eacute;gulation", 0 },
+	{ "T&acirc;che vanne m&eacute;langeuse", 0 },
+	{ "T&acirc;che t&eacute;l&eacute;m&eacute;trie", 0 },
+	{ "T&acirc;che param&egrave;tres", 0 },
+	{ "T&acirc;che protocole", 0 },
+	{ "Interruption ADC", 1 },
+	{ "Interruption EEPROM", 1 },
+	{ "Interruption r&eacute;ception UART", 1 },
+	{ "Interruption &eacute;mission UART", 1 }
+};
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Read all sections statistics from the board and format them as an HTML table.
+ * @param Board_ID The board ID.
+ * @param Is_Reset_Requested Set to 1 to clear the statistics on the board once they have been read.
+ * @param Pointer_String_Table On output, contain the table (or a message telling that the firmware does not measure anything).
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int PageDiagnosticsFormatSectionsTable(int Board_ID, int Is_Reset_Requested, char *Pointer_String_Table)
+{
+	TBoilerTaskProfile Profile;
+	int Section_ID = 0, Sections_Count, Length, Is_Too_Long;
+	char String_Name[32];
+	const char *Pointer_String_Name;
+	unsigned long long Average_Cycles, Maximum_Tenths_Of_Microsecond;
+	
+	// The first answer tells how many sections exist
+	if (BoilerGetTaskProfile(Board_ID, 0, Is_Reset_Requested, &Profile) != 0) return -1;
+	Sections_Count = Profile.Sections_Count;
+	if (Sections_Count == 0)
+	{
+		sprintf(Pointer_String_Table, "		<p>Le micrologiciel de la carte ne mesure pas ses temps d'ex&eacute;cution, il doit &ecirc;tre compil&eacute; avec la commande <code>make PROFILER=1</code>.</p>\n\n");
+		return 0;
+	}
+	
+	Length = sprintf(Pointer_String_Table, "		<table>\n			<tr><th>Section</th><th>Ex&eacute;cutions</th><th>Minimum (cycles)</th><th>Moyenne (cycles)</th><th>Maximum (cycles)</th><th>Maximum (&micro;s)</th></tr>\n");
+	while (1)
+	{
+		if (Section_ID < (int) (sizeof(Page_Diagnostics_Sections) / sizeof(Page_Diagnostics_Sections[0])))
+		{
+			Pointer_String_Name = Page_Diagnostics_Sections[Section_ID].Pointer_String_Name;
+			Is_Too_Long = Page_Diagnostics_Sections[Section_ID].Is_Interrupt_Handler && (Profile.Maximum_Cycles > PAGE_DIAGNOSTICS_UART_BYTE_CYCLES);
+		}
+		else
+		{
+			snprintf(String_Name, sizeof(String_Name), "Section %d", Section_ID);
+			Pointer_String_Name = String_Name;
+			Is_Too_Long = 0;
+		}
+		
+		// Display the longest execution time in red when it can make the board lose data
+		if (Profile.Calls_Count > 0) Average_Cycles = Profile.Total_Cycles / Profile.Calls_Count;
+		else Average_Cycles = 0;
+		Maximum_Tenths_Of_Microsecond = Profile.Maximum_Cycles * 10000000ULL / PAGE_DIAGNOSTICS_BOARD_CPU_FREQUENCY;
+		Length += snprintf(&Pointer_String_Table[Length], PAGE_DIAGNOSTICS_TABLE_BUFFER_SIZE - Length, "			<tr%s><td>%s</td><td>%lu</td><td>%lu</td><td>%llu</td><td>%s%lu</td><td>%llu.%llu</td></tr>\n", Is_Too_Long ? " class=\"error\"" : "",
+			Pointer_String_Name, Profile.Calls_Count, Profile.Minimum_Cycles, Average_Cycles, Profile.Is_Maximum_Saturated ? "&gt; " : "", Profile.Maximum_Cycles, Maximum_Tenths_Of_Microsecond / 10, Maximum_Tenths_Of_Microsecond % 10);
+		if (Length >= PAGE_DIAGNOSTICS_TABLE_BUFFER_SIZE)
+		{
+			syslog(LOG_ERR, "The board %d diagnostics table does not fit in the buffer.", Board_ID);
+			return -1;
+		}
+		
+		Section_ID++;
+		if (Section_ID >= Sections_Count) break;
+		if (BoilerGetTaskProfile(Board_ID, Section_ID, Is_Reset_Requested, &Profile) != 0) return -1;
+	}
+	
+	Length += snprintf(&Pointer_String_Table[Length], PAGE_DIAGNOSTICS_TABLE_BUFFER_SIZE - Length, "		</table>\n		<p>Les interruptions affich&eacute;es en rouge durent plus longtemps que la r&eacute;ception d'un octet par l'UART (%llu cycles).</p>\n\n", PAGE_DIAGNOSTICS_UART_BYTE_CYCLES);
+	if (Length >= PAGE_DIAGNOSTICS_TABLE_BUFFER_SIZE)
+	{
+		syslog(LOG_ERR, "The board %d diagnostics table does not fit in the buffer.", Board_ID);
+		return -1;
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+struct MHD_Response *PageDiagnostics(struct MHD_Connection *Pointer_Connection)
+{
+	int Board_ID, Is_Reset_Requested = 0;
+	const char *Pointer_String_Argument_Value;
+	char String_Sections_Table[PAGE_DIAGNOSTICS_TABLE_BUFFER_SIZE];
+	TTemplatesRendering *Pointer_Rendering;
+	
+	// Select the board, the default one is used when the argument is missing
+	Pointer_String_Argument_Value = MHD_lookup_connection_value(Pointer_Connection, MHD_GET_ARGUMENT_KIND, "board");
+	Board_ID = BoilerParseBoardID(Pointer_String_Argument_Value);
+	if (Board_ID < 0)
+	{
+		syslog(LOG_ERR, "Bad 'board' argument value (%s).", Pointer_String_Argument_Value);
+		return PageError("Chaudi&egrave;re - Diagnostic", "Temps d'ex&eacute;cution du micrologiciel");
+	}
+	
+	// The statistics are displayed one last time before being cleared
+	Pointer_String_Argument_Value = MHD_lookup_connection_value(Pointer_Connection, MHD_GET_ARGUMENT_KIND, "reset");
+	if ((Pointer_String_Argument_Value != NULL) && ((sscanf(Pointer_String_Argument_Value, "%d", &Is_Reset_Requested) != 1) || (Is_Reset_Requested < 0) || (Is_Reset_Requested > 1)))
+	{
+		syslog(LOG_ERR, "Bad 'reset' argument value (%s), the statistics will not be cleared.", Pointer_String_Argument_Value);
+		Is_Reset_Requested = 0;
+	}
+	
+	// The statistics are not part of the polled status, they are read from the board on each request
+	if (PageDiagnosticsFormatSectionsTable(Board_ID, Is_Reset_Requested, String_Sections_Table) != 0)
+	{
+		syslog(LOG_ERR, "Failed to read board %d execution time statistics.", Board_ID);
+		return PageError("Chaudi&egrave;re - Diagnostic", "Temps d'ex&eacute;cution du micrologiciel");
+	}
+	
+	Pointer_Rendering = TemplatesCreateRendering(&Templates_Diagnostics);
+	if (Pointer_Rendering == NULL) return NULL;
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_DIAGNOSTICS_SLOT_ASSETS_VERSION, AssetsGetVersion());
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_DIAGNOSTICS_SLOT_SECTIONS_TABLE, String_Sections_Table);
+	TemplatesSetInteger(Pointer_Rendering, TEMPLATES_DIAGNOSTICS_SLOT_BOARD_ID, Board_ID);
+	
+	return TemplatesCreateResponse(Pointer_Rendering);
+}
@@ -0,0 +1,21 @@
+/** @file Page_Error.c
+ * Generate the board communication error page. See Pages.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Pages.h>
+#include <Templates_Tables.h>
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+struct MHD_Response *PageError(const char *Pointer_String_Title, const char *Pointer_String_Heading)
+{
+	TTemplatesRendering *Pointer_Rendering;
+	
+	Pointer_Rendering = TemplatesCreateRendering(&Templates_Error);
+	if (Pointer_Rendering == NULL) return NULL;
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_ERROR_SLOT_TITLE, Pointer_String_Title);
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_ERROR_SLOT_HEADING, Pointer_String_Heading);
+	
+	return TemplatesCreateResponse(Pointer_Rendering);
+}
@@ -2,20 +2,35 @@
  * Generate the "index.html" page. See Pages.h for description.
  * @author Adrien RICCIARDI
  */
+#include <Assets.h>
 #include <Boiler.h>
 #include <Configuration.h>
 #include <Pages.h>
 #include <stdio.h>
 #include <string.h>
 #include <syslog.h>
+#include <Templates_Tables.h>
 
 //-------------------------------------------------------------------------------------------------
 // Public functions
 //-------------------------------------------------------------------------------------------------
-int PageIndex(struct MHD_Connection *Pointer_Connection, char *Pointer_String_Response)
+struct MHD_Response *PageIndex(struct MHD_Connection *Pointer_Connection)
 {
-	int Day_Temperature, Night_Temperature, Has_Error_Occurred = 0, Is_Boiler_Running;
+	int Day_Temperature, Night_Temperature, Has_Error_Occurred = 0, Is_Boiler_Running, Board_ID, Board_IDs[CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT], Boards_Count, Length, i;
 	const char *Pointer_String_Argument_Value;
+	char String_Boards_Selector[CONFIGURATION_BOILER_MAXIMUM_BOARDS_COUNT * 64];
+	TBoilerStatus Status;
+	TBoilerSettings Settings;
+	TTemplatesRendering *Pointer_Rendering;
+	
+	// Select the board, the default one is used when the argument is missing
+	Pointer_String_Argument_Value = MHD_lookup_connection_value(Pointer_Connection, MHD_GET_ARGUMENT_KIND, "board");
+	Board_ID = BoilerParseBoardID(Pointer_String_Argument_Value);
+	if (Board_ID < 0)
+	{
+		syslog(LOG_ERR, "Bad 'board' argument value (%s).", Pointer_String_Argument_Value);
+		goto Read_Board_Values; // The status of an invalid board is never valid, so the error page will be displayed
+	}
 	
 	// Extract values from the URL (all values must always be present)
 	// Power state
@@ -45,106 +60,49 @@ int PageIndex(struct MHD_Connection *Pointer_Connection, char *Pointer_String_Re
 		goto Read_Board_Values;
 	}
 	
-	// Set new values
-	// Power mode
-	if (BoilerSetBoilerRunningMode(Is_Boiler_Running) != 0)
-	{
-		syslog(LOG_ERR, "Failed to set boiler running mode.");
-		Has_Error_Occurred = 1;
-	}
-	// Desired temperatures
-	if (BoilerSetDesiredRoomTemperatures(Day_Temperature, Night_Temperature) != 0)
+	// Set new values in a single command, so the board can't end up with only a part of them
+	memset(&Settings, 0, sizeof(Settings));
+	Settings.Is_Boiler_Running_Mode_Present = 1;
+	Settings.Is_Boiler_Running = Is_Boiler_Running;
+	Settings.Are_Desired_Room_Temperatures_Present = 1;
+	Settings.Desired_Day_Temperature = Day_Temperature;
+	Settings.Desired_Night_Temperature = Night_Temperature;
+	if (BoilerApplySettings(Board_ID, &Settings) != 0)
 	{
-		syslog(LOG_ERR, "Failed to set desired room temperatures.");
+		syslog(LOG_ERR, "Failed to apply board %d boiler running mode and desired room temperatures.", Board_ID);
 		Has_Error_Occurred = 1;
 	}
 	
 Read_Board_Values:
-	// Read all needed values from the board
-	// Power mode
-	if (BoilerGetBoilerRunningMode(&Is_Boiler_Running) != 0)
-	{
-		syslog(LOG_ERR, "Failed to read boiler running mode from board.");
-		Has_Error_Occurred = 1;
-	}
-	// Desired temperatures
-	if (BoilerGetDesiredRoomTemperatures(&Day_Temperature, &Night_Temperature) != 0)
+	// Get the values last retrieved from the board (they already take into account the settings that have just been sent)
+	BoilerGetStatusSnapshot(Board_ID, &Status);
+	if (!Status.Is_Valid) Has_Error_Occurred = 1;
+	
+	// Allow to switch to the other boards when there are several of them
+	String_Boards_Selector[0] = 0;
+	Boards_Count = BoilerGetKnownBoards(Board_IDs);
+	if (Boards_Count > 1)
 	{
-		syslog(LOG_ERR, "Failed to read desired temperatures from board.");
-		Has_Error_Occurred = 1;
+		Length = sprintf(String_Boards_Selector, "		<p>\n			Carte :");
+		for (i = 0; i < Boards_Count; i++)
+		{
+			if (Board_IDs[i] == Board_ID) Length += sprintf(&String_Boards_Selector[Length], " <b>%d</b>", Board_IDs[i]);
+			else Length += sprintf(&String_Boards_Selector[Length], " <a href=\"/index.html?board=%d\">%d</a>", Board_IDs[i], Board_IDs[i]);
+		}
+		strcpy(&String_Boards_Selector[Length], "\n		</p>\n\n");
 	}
 	
 	// Generate the right page
-	if (Has_Error_Occurred) strcpy(Pointer_String_Response,
-		"<html>\n"
-		"	<head>\n"
-		"		<title>Chaudi&egrave;re</title>\n"
-		"		<meta charset=\"utf-8\" />\n"
-		"	</head>\n"
-		"\n"
-		"	<body>\n"
-		"		<center>\n"
-		"		<h1>Chaudi&egrave;re</h1>\n"
-		"\n"
-		"		<p><b>Erreur de communication avec la carte. Veuillez recharger la page.</b></p>\n"
-		"	</body>\n"
-		"</html>\n");
-	else sprintf(Pointer_String_Response,
-		"<html>\n"
-		"	<head>\n"
-		"		<title>Chaudi&egrave;re</title>\n"
-		"		<meta charset=\"utf-8\" />\n"
-		"	</head>\n"
-		"\n"
-		"	<body>\n"
-		"		<center>\n"
-		"		<h1>Chaudi&egrave;re</h1>\n"
-		"\n"
-		"		<form action=\"index.html\">\n"
-		"			<p>\n"
-		"				<input type=\"radio\" name=\"power_state\" value=\"1\" %s> Activ&eacute;e <input type=\"radio\" name=\"power_state\" value=\"0\" %s> Veille\n"
-		"			</p>\n"
-		"			<table>\n"
-		"			<tr>\n"
-		"				<td>Jour</td>\n"
-		"				<td><input type=\"range\" min=\"" PAGES_CONVERT_MACRO_VALUE_TO_STRING(CONFIGURATION_TEMPERATURE_MINIMUM_VALUE) "\" max=\"" PAGES_CONVERT_MACRO_VALUE_TO_STRING(CONFIGURATION_TEMPERATURE_MAXIMUM_VALUE) "\" step=\"1\" name=\"day_temperature\" onchange=\"updateDesiredDayTemperature()\" id=\"id_day_temperature\" value=\"%d\"></td>\n"
-		"				<td id=\"id_desired_day_temperature\">%d&deg;C</td>\n"
-		"			</tr>\n"
-		"			<tr>\n"
-		"				<td>Nuit</td>\n"
-		"				<td><input type=\"range\" min=\"" PAGES_CONVERT_MACRO_VALUE_TO_STRING(CONFIGURATION_TEMPERATURE_MINIMUM_VALUE) "\" max=\"" PAGES_CONVERT_MACRO_VALUE_TO_STRING(CONFIGURATION_TEMPERATURE_MAXIMUM_VALUE) "\" step=\"1\" name=\"night_temperature\" onchange=\"updateDesiredNightTemperature()\" id=\"id_night_temperature\" value=\"%d\"></td>\n"
-		"				<td id=\"id_desired_night_temperature\">%d&deg;C</td>\n"
-		"			</tr>\n"
-		"			</table>\n"
-		"\n"
-		"			<p>\n"
-		"				<input type=\"submit\" value=\"Valider\" />\n"
-		"			</p>\n"
-		"		</form>\n"
-		"\n"
-		"		<p>\n"
-		"			<br />\n"
-		"			<a href=\"/settings.html\">Configuration</a> - <a href=\"/monitoring.html\">Monitoring</a>\n"
-		"		</p>\n"
-		"		</center>\n"
-		"\n"
-		"		<script>\n"
-		"			function updateDesiredDayTemperature()\n"
-		"			{\n"
-		"				var temperature = document.getElementById(\"id_day_temperature\").value;\n"
-		"				temperature = temperature.concat(\"&deg;C\");\n"
-		"				document.getElementById(\"id_desired_day_temperature\").innerHTML = temperature;\n"
-		"			}\n"
-		"\n"
-		"			function updateDesiredNightTemperature()\n"
-		"			{\n"
-		"				var temperature = document.getElementById(\"id_night_temperature\").value;\n"
-		"				temperature = temperature.concat(\"&deg;C\");\n"
-		"				document.getElementById(\"id_desired_night_temperature\").innerHTML = temperature;\n"
-		"			}\n"
-		"		</script>\n"
-		"	</body>\n"
-		"</html>\n", Is_Boiler_Running ? "checked" : "", Is_Boiler_Running ? "" : "checked", Day_Temperature, Day_Temperature, Night_Temperature, Night_Temperature);
+	if (Has_Error_Occurred) return PageError("Chaudi&egrave;re", "Chaudi&egrave;re");
+	Pointer_Rendering = TemplatesCreateRendering(&Templates_Index);
+	if (Pointer_Rendering == NULL) return NULL;
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_INDEX_SLOT_ASSETS_VERSION, AssetsGetVersion());
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_INDEX_SLOT_BOARDS_SELECTOR, String_Boards_Selector);
+	TemplatesSetInteger(Pointer_Rendering, TEMPLATES_INDEX_SLOT_BOARD_ID, Board_ID);
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_INDEX_SLOT_RUNNING_CHECKED, Status.Is_Boiler_Running ? "checked" : "");
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_INDEX_SLOT_STANDBY_CHECKED, Status.Is_Boiler_Running ? "" : "checked");
+	TemplatesSetInteger(Pointer_Rendering, TEMPLATES_INDEX_SLOT_DAY_TEMPERATURE, Status.Desired_Day_Temperature);
+	TemplatesSetInteger(Pointer_Rendering, TEMPLATES_INDEX_SLOT_NIGHT_TEMPERATURE, Status.Desired_Night_Temperature);
 	
-	return 0;
+	return TemplatesCreateResponse(Pointer_Rendering);
 }
@@ -2,20 +2,32 @@
  * Generate the settings page. See Pages.h for description.
  * @author Adrien RICCIARDI
  */
+#include <Assets.h>
 #include <Boiler.h>
 #include <Configuration.h>
 #include <Pages.h>
 #include <stdio.h>
-#include <string.h>
 #include <syslog.h>
+#include <Templates_Tables.h>
 
 //-------------------------------------------------------------------------------------------------
 // Public functions
 //-------------------------------------------------------------------------------------------------
-int PageSettings(struct MHD_Connection *Pointer_Connection, char *Pointer_String_Response)
+struct MHD_Response *PageSettings(struct MHD_Connection *Pointer_Connection)
 {
-	int Has_Error_Occurred = 0, Heating_Curve_Coefficient, Heating_Curve_Parallel_Shift, Heating_Curve_ID;
+	int Has_Error_Occurred = 0, Heating_Curve_Coefficient, Heating_Curve_Parallel_Shift, Heating_Curve_ID, Board_ID;
 	const char *Pointer_String_Argument_Value;
+	TBoilerStatus Status;
+	TTemplatesRendering *Pointer_Rendering;
+	
+	// Select the board, the default one is used when the argument is missing
+	Pointer_String_Argument_Value = MHD_lookup_connection_value(Pointer_Connection, MHD_GET_ARGUMENT_KIND, "board");
+	Board_ID = BoilerParseBoardID(Pointer_String_Argument_Value);
+	if (Board_ID < 0)
+	{
+		syslog(LOG_ERR, "Bad 'board' argument value (%s).", Pointer_String_Argument_Value);
+		goto Read_Board_Values; // The status of an invalid board is never valid, so the error page will be displayed
+	}
 	
 	// Extract selected heating curve ID from the URL
 	Pointer_String_Argument_Value = MHD_lookup_connection_value(Pointer_Connection, MHD_GET_ARGUMENT_KIND, "heating_curve");
@@ -46,77 +58,25 @@ int PageSettings(struct MHD_Connection *Pointer_Connection, char *Pointer_String
 	}
 	
 	// Set new heating curve
-	if (BoilerSetHeatingCurveParameters(Heating_Curve_Coefficient, Heating_Curve_Parallel_Shift) != 0)
+	if (BoilerSetHeatingCurveParameters(Board_ID, Heating_Curve_Coefficient, Heating_Curve_Parallel_Shift) != 0)
 	{
-		syslog(LOG_ERR, "Failed to set new heating curve with coefficient = %d and parallel shift = %d.", Heating_Curve_Coefficient, Heating_Curve_Parallel_Shift);
+		syslog(LOG_ERR, "Failed to set board %d new heating curve with coefficient = %d and parallel shift = %d.", Board_ID, Heating_Curve_Coefficient, Heating_Curve_Parallel_Shift);
 		Has_Error_Occurred = 1;
 	}
 	
 Read_Board_Values:
-	// Read heating curve current parameters
-	if (BoilerGetHeatingCurveParameters(&Heating_Curve_Coefficient, &Heating_Curve_Parallel_Shift) != 0)
-	{
-		syslog(LOG_ERR, "Failed to read heating curve parameters from board in settings page.");
-		Has_Error_Occurred = 1;
-	}
+	// Get heating curve current parameters (they already take into account a new heating curve that has just been sent)
+	BoilerGetStatusSnapshot(Board_ID, &Status);
+	if (!Status.Is_Valid) Has_Error_Occurred = 1;
 	
 	// Generate the right page
-	if (Has_Error_Occurred) strcpy(Pointer_String_Response,
-		"<html>\n"
-		"	<head>\n"
-		"		<title>Chaudi&egrave;re - Configuration</title>\n"
-		"		<meta charset=\"utf-8\" />\n"
-		"	</head>\n"
-		"\n"
-		"	<body>\n"
-		"		<center>\n"
-		"		<h1>Configuration de la courbe de chauffe</h1>\n"
-		"\n"
-		"		<p><b>Erreur de communication avec la carte. Veuillez recharger la page.</b></p>\n"
-		"	</body>\n"
-		"</html>\n");
-	else sprintf(Pointer_String_Response,
-		"<html>\n"
-		"	<head>\n"
-		"		<title>Chaudi&egrave;re - Configuration</title>\n"
-		"		<meta charset=\"utf-8\" />\n"
-		"	</head>\n"
-		"\n"
-		"	<body>\n"
-		"		<h1>Configuration de la courbe de chauffe</h1>\n"
-		"\n"
-		"		<h3>Param&egrave;tres de la courbe actuellement utilis&eacute;e</h2>\n"
-		"		<p>\n"
-		"			Coefficient : %0.1f<br />\n"
-		"			D&eacute;placement parall&egrave;le : %d\n"
-		"		</p>\n"
-		"\n"
-		"		<h3>D&eacute;finir une nouvelle courbe</h3>\n"
-		"		<form action=\"settings.html\">\n"
-		"			<input type=\"radio\" id=\"0\" name=\"heating_curve\" value=\"0\" onClick=\"enableSubmitButton()\">\n"
-		"			<label for=\"0\">Mi-saison (coefficient : 1.4, d&eacute;placement parall&egrave;le : 15)</label><br>\n"
-		"			<input type=\"radio\" id=\"1\" name=\"heating_curve\" value=\"1\" onClick=\"enableSubmitButton()\">\n"
-		"			<label for=\"0\">Hiver (coefficient : 1.8, d&eacute;placement parall&egrave;le : 20)</label><br>\n"
-		"\n"
-		"			<p>\n"
-		"				<input id=\"id_submit_button\" type=\"submit\" value=\"Valider\" disabled/>\n"
-		"			</p>\n"
-		"		</form>\n"
-		"\n"
-		"		<center>\n"
-		"			<p>\n"
-		"				<a href=\"/index.html\">Retour</a>\n"
-		"			</p>\n"
-		"		</center>\n"
-		"\n"
-		"		<script>\n"
-		"			function enableSubmitButton()\n"
-		"			{\n"
-		"				document.getElementById(\"id_submit_button\").disabled = false;\n"
-		"			}\n"
-		"		</script>\n"
-		"	</body>\n"
-		"</html>\n", Heating_Curve_Coefficient / 10.f, Heating_Curve_Parallel_Shift / 10);
+	if (Has_Error_Occurred) return PageError("Chaudi&egrave;re - Configuration", "Configuration de la courbe de chauffe");
+	Pointer_Rendering = TemplatesCreateRendering(&Templates_Settings);
+	if (Pointer_Rendering == NULL) return NULL;
+	TemplatesSetString(Pointer_Rendering, TEMPLATES_SETTINGS_SLOT_ASSETS_VERSION, AssetsGetVersion());
+	TemplatesSetDecimal(Pointer_Rendering, TEMPLATES_SETTINGS_SLOT_HEATING_CURVE_COEFFICIENT, Status.Heating_Curve_Coefficient);
+	TemplatesSetInteger(Pointer_Rendering, TEMPLATES_SETTINGS_SLOT_HEATING_CURVE_PARALLEL_SHIFT, Status.Heating_Curve_Parallel_Shift / 10);
+	TemplatesSetInteger(Pointer_Rendering, TEMPLATES_SETTINGS_SLOT_BOARD_ID, Board_ID);
 	
-	return 0;
+	return TemplatesCreateResponse(Pointer_Rendering);
 }
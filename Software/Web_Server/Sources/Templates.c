@@ -0,0 +1,195 @@
+/** @file Templates.c
+ * See Templates.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <Templates.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A formatted slot value. */
+typedef struct
+{
+	const char *Pointer_String_Data; //!< The value, stored in the rendering values buffer (it is not terminated).
+	unsigned int Size; //!< The value size in bytes, 0 if the slot has not been set.
+} TTemplatesValue;
+
+/** A template filled with a request values. */
+struct TTemplatesRendering
+{
+	const TTemplatesTemplate *Pointer_Template; //!< The rendered template.
+	TTemplatesValue Values[TEMPLATES_MAXIMUM_SLOTS_COUNT]; //!< Each slot value.
+	char Values_Buffer[TEMPLATES_VALUES_BUFFER_SIZE]; //!< Hold all formatted values.
+	unsigned int Values_Buffer_Used_Size; //!< How many bytes of the values buffer are used.
+	int Has_Error_Occurred; //!< Set to 1 when a value could not be set, the page must not be sent.
+};
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Check that a slot can receive a value of a given type.
+ * @param Pointer_Rendering The rendering.
+ * @param Slot_Index The slot.
+ * @param Type The value type.
+ * @return 0 if the slot can't receive the value (the rendering is marked as failed),
+ * @return 1 if the slot can receive the value.
+ */
+static int TemplatesIsSlotTypeValid(TTemplatesRendering *Pointer_Rendering, int Slot_Index, TTemplatesSlotType Type)
+{
+	if ((Slot_Index < 0) || (Slot_Index >= Pointer_Rendering->Pointer_Template->Slots_Count) || (Pointer_Rendering->Pointer_Template->Pointer_Slot_Types[Slot_Index] != Type))
+	{
+		syslog(LOG_ERR, "Template \"%s\" slot %d does not exist or does not have type %d.", Pointer_Rendering->Pointer_Template->Pointer_String_Name, Slot_Index, Type);
+		Pointer_Rendering->Has_Error_Occurred = 1;
+		return 0;
+	}
+	return 1;
+}
+
+/** Store a slot value in the values buffer.
+ * @param Pointer_Rendering The rendering.
+ * @param Slot_Index The slot, its type must have been checked.
+ * @param Pointer_String_Format The value format, like printf().
+ * @param ... The format arguments.
+ */
+static void __attribute__((format(printf, 3, 4))) TemplatesStoreValue(TTemplatesRendering *Pointer_Rendering, int Slot_Index, const char *Pointer_String_Format, ...)
+{
+	va_list Arguments;
+	unsigned int Available_Size = TEMPLATES_VALUES_BUFFER_SIZE - Pointer_Rendering->Values_Buffer_Used_Size;
+	char *Pointer_String_Value = &Pointer_Rendering->Values_Buffer[Pointer_Rendering->Values_Buffer_Used_Size];
+	int Length;
+	
+	va_start(Arguments, Pointer_String_Format);
+	Length = vsnprintf(Pointer_String_Value, Available_Size, Pointer_String_Format, Arguments);
+	va_end(Arguments);
+	if ((Length < 0) || ((unsigned int) Length >= Available_Size))
+	{
+		syslog(LOG_ERR, "Template \"%s\" values do not fit in %d bytes.", Pointer_Rendering->Pointer_Template->Pointer_String_Name, TEMPLATES_VALUES_BUFFER_SIZE);
+		Pointer_Rendering->Has_Error_Occurred = 1;
+		return;
+	}
+	
+	// Values are not terminated, the response knows their sizes
+	Pointer_Rendering->Values[Slot_Index].Pointer_String_Data = Pointer_String_Value;
+	Pointer_Rendering->Values[Slot_Index].Size = Length;
+	Pointer_Rendering->Values_Buffer_Used_Size += Length;
+}
+
+/** Get a part of a rendered page.
+ * @param Pointer_Rendering The rendering.
+ * @param Part_Index The part, even parts are segments and odd parts are slots.
+ * @param Pointer_Size On output, contain the part size in bytes.
+ * @return The part content.
+ */
+static const char *TemplatesGetPart(TTemplatesRendering *Pointer_Rendering, int Part_Index, unsigned int *Pointer_Size)
+{
+	const TTemplatesTemplate *Pointer_Template = Pointer_Rendering->Pointer_Template;
+	TTemplatesValue *Pointer_Value;
+	
+	if ((Part_Index % 2) == 0)
+	{
+		*Pointer_Size = Pointer_Template->Pointer_Segments[Part_Index / 2].Size;
+		return Pointer_Template->Pointer_Segments[Part_Index / 2].Pointer_String_Data;
+	}
+	
+	Pointer_Value = &Pointer_Rendering->Values[Pointer_Template->Pointer_Segment_Slot_Indexes[Part_Index / 2]];
+	*Pointer_Size = Pointer_Value->Size;
+	return Pointer_Value->Pointer_String_Data;
+}
+
+/** Called by the web server when the page response is destroyed.
+ * @param Pointer_Custom_Data The rendering.
+ */
+static void TemplatesResponseFreeCallback(void *Pointer_Custom_Data)
+{
+	free(Pointer_Custom_Data);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+TTemplatesRendering *TemplatesCreateRendering(const TTemplatesTemplate *Pointer_Template)
+{
+	TTemplatesRendering *Pointer_Rendering;
+	
+	// Do not clear the values buffer, only the slots need to be empty
+	Pointer_Rendering = malloc(sizeof(TTemplatesRendering));
+	if (Pointer_Rendering == NULL)
+	{
+		syslog(LOG_ERR, "Failed to allocate template \"%s\" rendering.", Pointer_Template->Pointer_String_Name);
+		return NULL;
+	}
+	Pointer_Rendering->Pointer_Template = Pointer_Template;
+	memset(Pointer_Rendering->Values, 0, sizeof(Pointer_Rendering->Values));
+	Pointer_Rendering->Values_Buffer_Used_Size = 0;
+	Pointer_Rendering->Has_Error_Occurred = 0;
+	
+	return Pointer_Rendering;
+}
+
+void TemplatesSetInteger(TTemplatesRendering *Pointer_Rendering, int Slot_Index, int Value)
+{
+	if (TemplatesIsSlotTypeValid(Pointer_Rendering, Slot_Index, TEMPLATES_SLOT_TYPE_INTEGER)) TemplatesStoreValue(Pointer_Rendering, Slot_Index, "%d", Value);
+}
+
+void TemplatesSetDecimal(TTemplatesRendering *Pointer_Rendering, int Slot_Index, int Tenths)
+{
+	if (!TemplatesIsSlotTypeValid(Pointer_Rendering, Slot_Index, TEMPLATES_SLOT_TYPE_DECIMAL)) return;
+	
+	// Avoid floating point, and do not lose the sign of values between -1 and 0
+	if (Tenths < 0) TemplatesStoreValue(Pointer_Rendering, Slot_Index, "-%d.%d", -Tenths / 10, -Tenths % 10);
+	else TemplatesStoreValue(Pointer_Rendering, Slot_Index, "%d.%d", Tenths / 10, Tenths % 10);
+}
+
+void TemplatesSetString(TTemplatesRendering *Pointer_Rendering, int Slot_Index, const char *Pointer_String_Value)
+{
+	if (TemplatesIsSlotTypeValid(Pointer_Rendering, Slot_Index, TEMPLATES_SLOT_TYPE_STRING)) TemplatesStoreValue(Pointer_Rendering, Slot_Index, "%s", Pointer_String_Value);
+}
+
+struct MHD_Response *TemplatesCreateResponse(TTemplatesRendering *Pointer_Rendering)
+{
+	struct MHD_Response *Pointer_Response;
+	struct MHD_IoVec *Pointer_Parts;
+	int Parts_Count = Pointer_Rendering->Pointer_Template->Segments_Count * 2 - 1, Used_Parts_Count = 0, i;
+	unsigned int Part_Size;
+	const char *Pointer_Part;
+	
+	if (Pointer_Rendering->Has_Error_Occurred)
+	{
+		free(Pointer_Rendering);
+		return NULL;
+	}
+	
+	// Point to the segments and to the values in place, the web server gives them to the socket without copying them
+	Pointer_Parts = malloc(Parts_Count * sizeof(struct MHD_IoVec));
+	if (Pointer_Parts == NULL)
+	{
+		syslog(LOG_ERR, "Failed to allocate template \"%s\" response parts.", Pointer_Rendering->Pointer_Template->Pointer_String_Name);
+		free(Pointer_Rendering);
+		return NULL;
+	}
+	for (i = 0; i < Parts_Count; i++)
+	{
+		Pointer_Part = TemplatesGetPart(Pointer_Rendering, i, &Part_Size);
+		if (Part_Size == 0) continue; // Empty segments and slots that have not been set have no data
+		Pointer_Parts[Used_Parts_Count].iov_base = Pointer_Part;
+		Pointer_Parts[Used_Parts_Count].iov_len = Part_Size;
+		Used_Parts_Count++;
+	}
+	
+	// The web server copies the parts table (not the data), the rendering holding the values is freed with the response
+	Pointer_Response = MHD_create_response_from_iovec(Pointer_Parts, Used_Parts_Count, TemplatesResponseFreeCallback, Pointer_Rendering);
+	free(Pointer_Parts);
+	if (Pointer_Response == NULL)
+	{
+		free(Pointer_Rendering);
+		return NULL;
+	}
+	MHD_add_response_header(Pointer_Response, MHD_HTTP_HEADER_CONTENT_TYPE, "text/html; charset=utf-8");
+	
+	return Pointer_Response;
+}
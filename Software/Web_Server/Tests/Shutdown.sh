@@ -0,0 +1,70 @@
+#!/bin/sh
+# Check that the server exits cleanly on SIGTERM while an idle events stream is opened, with both threading models.
+# Run "make test" rather than calling this script directly. Usage : Tests/Shutdown.sh
+# Author : Adrien RICCIARDI
+
+PORT=8890
+SIMULATOR=../Microcontroller_Firmware/boiler-controller-board-simulator
+
+if [ ! -x ./boiler-controller-web-server ] || [ ! -x $SIMULATOR ]
+then
+	printf "\033[31mBuild the server and the board simulator first (make test).\033[0m\n"
+	exit 1
+fi
+
+# Keep the test files away from the installed server ones
+WORK_DIRECTORY=$(mktemp -d)
+trap 'kill $CLIENT_PID $SIMULATOR_PID $SERVER_PID 2> /dev/null; wait 2> /dev/null; rm -rf $WORK_DIRECTORY' EXIT INT TERM
+
+# Kill the processes a test started, so the next test can use the port
+stop_processes()
+{
+	kill -KILL $CLIENT_PID $SIMULATOR_PID $SERVER_PID 2> /dev/null
+	wait $CLIENT_PID $SIMULATOR_PID $SERVER_PID 2> /dev/null
+}
+
+# Start the server, open an events stream and let it become idle, then stop the server
+# $1 : the server threads count (0 selects the thread-per-connection model)
+# $2 : a human-readable description of the model
+# Return 0 if the server exited successfully and in time, return 1 otherwise (a server aborted by a crash or killed by the watchdog exits with a code above 128).
+run_test()
+{
+	./boiler-controller-web-server -t $1 -a Assets.bin -f $WORK_DIRECTORY/History.bin $PORT &
+	SERVER_PID=$!
+	$SIMULATOR > /dev/null &
+	SIMULATOR_PID=$!
+
+	# Give the board the time to connect, then let the stream send the first status and wait for changes (the stream is suspended when a threads pool is used)
+	sleep 2
+	curl -s -N http://localhost:$PORT/events > $WORK_DIRECTORY/Events.txt &
+	CLIENT_PID=$!
+	sleep 2
+	if ! grep -q "event: status" $WORK_DIRECTORY/Events.txt
+	then
+		printf "\033[31m[FAIL] %s : the events stream did not send the status.\033[0m\n" "$2"
+		stop_processes
+		return 1
+	fi
+
+	# The server must exit by itself, a watchdog kills it if it hangs (the exit code then tells that it has been killed)
+	kill -TERM $SERVER_PID
+	( sleep 10; kill -KILL $SERVER_PID 2> /dev/null ) &
+	WATCHDOG_PID=$!
+	wait $SERVER_PID
+	EXIT_CODE=$?
+	kill $WATCHDOG_PID 2> /dev/null
+	stop_processes
+	if [ $EXIT_CODE -ne 0 ]
+	then
+		printf "\033[31m[FAIL] %s : the server exited with code %d.\033[0m\n" "$2" $EXIT_CODE
+		return 1
+	fi
+
+	printf "\033[32m[ OK ] %s\033[0m\n" "$2"
+	return 0
+}
+
+FAILED_TESTS_COUNT=0
+run_test 0 "Shutdown with an idle events stream, thread per connection" || FAILED_TESTS_COUNT=$((FAILED_TESTS_COUNT + 1))
+run_test 2 "Shutdown with an idle events stream, epoll threads pool" || FAILED_TESTS_COUNT=$((FAILED_TESTS_COUNT + 1))
+[ $FAILED_TESTS_COUNT -eq 0 ]
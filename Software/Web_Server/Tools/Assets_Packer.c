@@ -0,0 +1,409 @@
+/** @file Assets_Packer.c
+ * Pack the web server static files into a single bundle, storing each file uncompressed, gzip-compressed and brotli-compressed, so the web server can send the best representation without compressing anything at run time.
+ * HTML files are served from the site root and must be revalidated by browsers. Other files are served from "/assets/" and can be cached forever, because the pages request them with the bundle version in the URL.
+ * @author Adrien RICCIARDI
+ */
+#include <Assets_Bundle.h>
+#include <brotli/encode.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many files can be packed. */
+#define ASSETS_PACKER_MAXIMUM_FILES_COUNT 64
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** Associate a file extension to the MIME type it is served with. */
+typedef struct
+{
+	const char *Pointer_String_Extension; //!< The file extension, dot included.
+	const char *Pointer_String_Content_Type; //!< The corresponding MIME type.
+	int Is_Text; //!< Set to 1 when the bundle version placeholder must be replaced in the file content.
+} TAssetsPackerContentType;
+
+/** A file to pack. */
+typedef struct
+{
+	const char *Pointer_String_Path; //!< The file path on the build machine.
+	unsigned char *Pointer_Representations_Data[ASSETS_BUNDLE_ENCODINGS_COUNT]; //!< The file content with each encoding, NULL when the encoding is not worth it.
+	TAssetsBundleEntry Entry; //!< The entry to store in the bundle.
+} TAssetsPackerFile;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** All supported file types. */
+static const TAssetsPackerContentType Assets_Packer_Content_Types[] =
+{
+	{ ".css", "text/css; charset=utf-8", 1 },
+	{ ".html", "text/html; charset=utf-8", 1 },
+	{ ".ico", "image/x-icon", 0 },
+	{ ".js", "text/javascript; charset=utf-8", 1 },
+	{ ".png", "image/png", 0 },
+	{ ".svg", "image/svg+xml", 1 }
+};
+
+/** The files to pack. */
+static TAssetsPackerFile Assets_Packer_Files[ASSETS_PACKER_MAXIMUM_FILES_COUNT];
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Continue a 64-bit FNV-1a hash.
+ * @param Hash The hash of the previous data, use 14695981039346656037 to start a new hash.
+ * @param Pointer_Data The data to hash.
+ * @param Size The data size in bytes.
+ * @return The updated hash.
+ */
+static unsigned long long AssetsPackerHash(unsigned long long Hash, const void *Pointer_Data, size_t Size)
+{
+	const unsigned char *Pointer_Bytes = Pointer_Data;
+	
+	while (Size > 0)
+	{
+		Hash ^= *Pointer_Bytes;
+		Hash *= 1099511628211ULL;
+		Pointer_Bytes++;
+		Size--;
+	}
+	return Hash;
+}
+
+/** Load a whole file to memory.
+ * @param Pointer_String_Path The file to load.
+ * @param Pointer_Size On output, contain the file size in bytes.
+ * @return NULL if an error occurred,
+ * @return The file content on success, free it with free().
+ */
+static unsigned char *AssetsPackerLoadFile(const char *Pointer_String_Path, size_t *Pointer_Size)
+{
+	FILE *Pointer_File;
+	unsigned char *Pointer_Data = NULL;
+	long Size;
+	
+	Pointer_File = fopen(Pointer_String_Path, "rb");
+	if (Pointer_File == NULL)
+	{
+		fprintf(stderr, "Error : could not open file \"%s\".\n", Pointer_String_Path);
+		return NULL;
+	}
+	
+	// Get the file size
+	if ((fseek(Pointer_File, 0, SEEK_END) != 0) || ((Size = ftell(Pointer_File)) < 0) || (fseek(Pointer_File, 0, SEEK_SET) != 0))
+	{
+		fprintf(stderr, "Error : could not get file \"%s\" size.\n", Pointer_String_Path);
+		goto Exit;
+	}
+	
+	// Read the whole content (allocate at least one byte so an empty file is not mistaken for an error)
+	Pointer_Data = malloc(Size + 1);
+	if (Pointer_Data == NULL)
+	{
+		fprintf(stderr, "Error : could not allocate memory to load file \"%s\".\n", Pointer_String_Path);
+		goto Exit;
+	}
+	if (fread(Pointer_Data, 1, Size, Pointer_File) != (size_t) Size)
+	{
+		fprintf(stderr, "Error : could not read file \"%s\".\n", Pointer_String_Path);
+		free(Pointer_Data);
+		Pointer_Data = NULL;
+		goto Exit;
+	}
+	*Pointer_Size = Size;
+	
+Exit:
+	fclose(Pointer_File);
+	return Pointer_Data;
+}
+
+/** Replace all occurrences of the version placeholder by the bundle version.
+ * @param Pointer_Data The text to modify, it must have been allocated with malloc().
+ * @param Pointer_Size On input, contain the text size. On output, contain the modified text size.
+ * @param Pointer_String_Version The bundle version.
+ * @return NULL if an error occurred,
+ * @return The modified text on success (the original buffer has been freed).
+ */
+static unsigned char *AssetsPackerReplaceVersionPlaceholder(unsigned char *Pointer_Data, size_t *Pointer_Size, const char *Pointer_String_Version)
+{
+	unsigned char *Pointer_Modified_Data;
+	size_t Placeholder_Length = sizeof(ASSETS_BUNDLE_VERSION_PLACEHOLDER) - 1, Version_Length = strlen(Pointer_String_Version), Read_Index = 0, Write_Index = 0;
+	
+	// The version is never longer than the placeholder, so the modified text always fits in the original size
+	Pointer_Modified_Data = malloc(*Pointer_Size + 1);
+	if (Pointer_Modified_Data == NULL) return NULL;
+	
+	while (Read_Index < *Pointer_Size)
+	{
+		if ((*Pointer_Size - Read_Index >= Placeholder_Length) && (memcmp(&Pointer_Data[Read_Index], ASSETS_BUNDLE_VERSION_PLACEHOLDER, Placeholder_Length) == 0))
+		{
+			memcpy(&Pointer_Modified_Data[Write_Index], Pointer_String_Version, Version_Length);
+			Write_Index += Version_Length;
+			Read_Index += Placeholder_Length;
+		}
+		else
+		{
+			Pointer_Modified_Data[Write_Index] = Pointer_Data[Read_Index];
+			Write_Index++;
+			Read_Index++;
+		}
+	}
+	
+	free(Pointer_Data);
+	*Pointer_Size = Write_Index;
+	return Pointer_Modified_Data;
+}
+
+/** Compress data with gzip.
+ * @param Pointer_Data The data to compress.
+ * @param Size The data size in bytes.
+ * @param Pointer_Compressed_Size On output, contain the compressed data size.
+ * @return NULL if an error occurred,
+ * @return The compressed data on success, free them with free().
+ */
+static unsigned char *AssetsPackerCompressGzip(const unsigned char *Pointer_Data, size_t Size, size_t *Pointer_Compressed_Size)
+{
+	z_stream Stream;
+	unsigned char *Pointer_Compressed_Data;
+	uLong Maximum_Size;
+	
+	// Use the highest compression level, the data are compressed only once
+	memset(&Stream, 0, sizeof(Stream));
+	if (deflateInit2(&Stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) return NULL; // Adding 16 to the window bits selects the gzip format
+	
+	Maximum_Size = deflateBound(&Stream, Size);
+	Pointer_Compressed_Data = malloc(Maximum_Size);
+	if (Pointer_Compressed_Data == NULL)
+	{
+		deflateEnd(&Stream);
+		return NULL;
+	}
+	
+	// Compress everything in one call
+	Stream.next_in = (unsigned char *) Pointer_Data;
+	Stream.avail_in = Size;
+	Stream.next_out = Pointer_Compressed_Data;
+	Stream.avail_out = Maximum_Size;
+	if (deflate(&Stream, Z_FINISH) != Z_STREAM_END)
+	{
+		deflateEnd(&Stream);
+		free(Pointer_Compressed_Data);
+		return NULL;
+	}
+	*Pointer_Compressed_Size = Stream.total_out;
+	
+	deflateEnd(&Stream);
+	return Pointer_Compressed_Data;
+}
+
+/** Compress data with brotli.
+ * @param Pointer_Data The data to compress.
+ * @param Size The data size in bytes.
+ * @param Is_Text Set to 1 to tune the compressor for UTF-8 text.
+ * @param Pointer_Compressed_Size On output, contain the compressed data size.
+ * @return NULL if an error occurred,
+ * @return The compressed data on success, free them with free().
+ */
+static unsigned char *AssetsPackerCompressBrotli(const unsigned char *Pointer_Data, size_t Size, int Is_Text, size_t *Pointer_Compressed_Size)
+{
+	unsigned char *Pointer_Compressed_Data;
+	
+	*Pointer_Compressed_Size = BrotliEncoderMaxCompressedSize(Size);
+	if (*Pointer_Compressed_Size == 0) return NULL;
+	Pointer_Compressed_Data = malloc(*Pointer_Compressed_Size);
+	if (Pointer_Compressed_Data == NULL) return NULL;
+	
+	if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, Is_Text ? BROTLI_MODE_TEXT : BROTLI_MODE_GENERIC, Size, Pointer_Data, Pointer_Compressed_Size, Pointer_Compressed_Data))
+	{
+		free(Pointer_Compressed_Data);
+		return NULL;
+	}
+	return Pointer_Compressed_Data;
+}
+
+/** Find the content type of a file.
+ * @param Pointer_String_Path The file path.
+ * @return NULL if the file type is not supported,
+ * @return The content type on success.
+ */
+static const TAssetsPackerContentType *AssetsPackerGetContentType(const char *Pointer_String_Path)
+{
+	const char *Pointer_String_Extension;
+	unsigned int i;
+	
+	Pointer_String_Extension = strrchr(Pointer_String_Path, '.');
+	if (Pointer_String_Extension == NULL) return NULL;
+	
+	for (i = 0; i < sizeof(Assets_Packer_Content_Types) / sizeof(Assets_Packer_Content_Types[0]); i++)
+	{
+		if (strcmp(Pointer_String_Extension, Assets_Packer_Content_Types[i].Pointer_String_Extension) == 0) return &Assets_Packer_Content_Types[i];
+	}
+	return NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	static const char *Pointer_String_Encoding_Names[ASSETS_BUNDLE_ENCODINGS_COUNT] = { "identity", "gzip", "br" };
+	int Files_Count, i, j, Return_Value = EXIT_FAILURE;
+	TAssetsBundleHeader Header;
+	TAssetsPackerFile *Pointer_File;
+	const TAssetsPackerContentType *Pointer_Content_Type;
+	const char *Pointer_String_File_Name;
+	size_t Sizes[ASSETS_BUNDLE_ENCODINGS_COUNT];
+	unsigned long long Hash;
+	uint32_t Offset;
+	FILE *Pointer_Bundle_File = NULL;
+	
+	// Check parameters
+	if (argc < 3)
+	{
+		printf("Usage : %s Bundle_File Asset_File_1 [Asset_File_2 ...]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	Files_Count = argc - 2;
+	if (Files_Count > ASSETS_PACKER_MAXIMUM_FILES_COUNT)
+	{
+		fprintf(stderr, "Error : too many files, at most %d files can be packed.\n", ASSETS_PACKER_MAXIMUM_FILES_COUNT);
+		return EXIT_FAILURE;
+	}
+	
+	// Load all files and compute the bundle version from their names and contents
+	Hash = 14695981039346656037ULL;
+	for (i = 0; i < Files_Count; i++)
+	{
+		Pointer_File = &Assets_Packer_Files[i];
+		Pointer_File->Pointer_String_Path = argv[i + 2];
+		Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_IDENTITY] = AssetsPackerLoadFile(Pointer_File->Pointer_String_Path, &Sizes[ASSETS_BUNDLE_ENCODING_IDENTITY]);
+		if (Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_IDENTITY] == NULL) goto Exit;
+		Pointer_File->Entry.Representations[ASSETS_BUNDLE_ENCODING_IDENTITY].Size = Sizes[ASSETS_BUNDLE_ENCODING_IDENTITY];
+		
+		Hash = AssetsPackerHash(Hash, Pointer_File->Pointer_String_Path, strlen(Pointer_File->Pointer_String_Path) + 1);
+		Hash = AssetsPackerHash(Hash, Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_IDENTITY], Sizes[ASSETS_BUNDLE_ENCODING_IDENTITY]);
+	}
+	memset(&Header, 0, sizeof(Header));
+	Header.Magic_Number = ASSETS_BUNDLE_MAGIC_NUMBER;
+	Header.Format_Version = ASSETS_BUNDLE_FORMAT_VERSION;
+	Header.Entries_Count = Files_Count;
+	snprintf(Header.String_Version, sizeof(Header.String_Version), "%016llx", Hash);
+	
+	// Build all representations
+	Offset = sizeof(TAssetsBundleHeader) + Files_Count * sizeof(TAssetsBundleEntry);
+	for (i = 0; i < Files_Count; i++)
+	{
+		Pointer_File = &Assets_Packer_Files[i];
+		
+		// Find the file type
+		Pointer_Content_Type = AssetsPackerGetContentType(Pointer_File->Pointer_String_Path);
+		if (Pointer_Content_Type == NULL)
+		{
+			fprintf(stderr, "Error : the type of file \"%s\" is not supported.\n", Pointer_File->Pointer_String_Path);
+			goto Exit;
+		}
+		strcpy(Pointer_File->Entry.String_Content_Type, Pointer_Content_Type->Pointer_String_Content_Type);
+		
+		// Pages are served from the site root, other files are only referenced by pages with the bundle version in their URL
+		Pointer_String_File_Name = strrchr(Pointer_File->Pointer_String_Path, '/');
+		if (Pointer_String_File_Name == NULL) Pointer_String_File_Name = Pointer_File->Pointer_String_Path;
+		else Pointer_String_File_Name++;
+		Pointer_File->Entry.Is_Immutable = strcmp(Pointer_Content_Type->Pointer_String_Extension, ".html") != 0;
+		if ((size_t) snprintf(Pointer_File->Entry.String_URL, sizeof(Pointer_File->Entry.String_URL), "%s%s", Pointer_File->Entry.Is_Immutable ? "/assets/" : "/", Pointer_String_File_Name) >= sizeof(Pointer_File->Entry.String_URL))
+		{
+			fprintf(stderr, "Error : the name of file \"%s\" is too long.\n", Pointer_File->Pointer_String_Path);
+			goto Exit;
+		}
+		
+		// Let pages and style sheets reference other assets with the bundle version
+		Sizes[ASSETS_BUNDLE_ENCODING_IDENTITY] = Pointer_File->Entry.Representations[ASSETS_BUNDLE_ENCODING_IDENTITY].Size;
+		if (Pointer_Content_Type->Is_Text)
+		{
+			Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_IDENTITY] = AssetsPackerReplaceVersionPlaceholder(Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_IDENTITY], &Sizes[ASSETS_BUNDLE_ENCODING_IDENTITY], Header.String_Version);
+			if (Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_IDENTITY] == NULL)
+			{
+				fprintf(stderr, "Error : could not allocate memory to process file \"%s\".\n", Pointer_File->Pointer_String_Path);
+				goto Exit;
+			}
+		}
+		
+		// Compress the file
+		Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_GZIP] = AssetsPackerCompressGzip(Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_IDENTITY], Sizes[ASSETS_BUNDLE_ENCODING_IDENTITY], &Sizes[ASSETS_BUNDLE_ENCODING_GZIP]);
+		Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_BROTLI] = AssetsPackerCompressBrotli(Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_IDENTITY], Sizes[ASSETS_BUNDLE_ENCODING_IDENTITY], Pointer_Content_Type->Is_Text, &Sizes[ASSETS_BUNDLE_ENCODING_BROTLI]);
+		if ((Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_GZIP] == NULL) || (Pointer_File->Pointer_Representations_Data[ASSETS_BUNDLE_ENCODING_BROTLI] == NULL))
+		{
+			fprintf(stderr, "Error : could not compress file \"%s\".\n", Pointer_File->Pointer_String_Path);
+			goto Exit;
+		}
+		
+		// Keep only the representations that are worth it, and give each one its own entity tag as their contents differ
+		printf("%-40s", Pointer_File->Entry.String_URL);
+		for (j = 0; j < ASSETS_BUNDLE_ENCODINGS_COUNT; j++)
+		{
+			if ((j != ASSETS_BUNDLE_ENCODING_IDENTITY) && (Sizes[j] >= Sizes[ASSETS_BUNDLE_ENCODING_IDENTITY]))
+			{
+				Pointer_File->Entry.Representations[j].Size = 0;
+				continue;
+			}
+			
+			Pointer_File->Entry.Representations[j].Offset = Offset;
+			Pointer_File->Entry.Representations[j].Size = Sizes[j];
+			Offset += Sizes[j];
+			snprintf(Pointer_File->Entry.Representations[j].String_ETag, sizeof(Pointer_File->Entry.Representations[j].String_ETag), "\"%016llx\"", AssetsPackerHash(14695981039346656037ULL, Pointer_File->Pointer_Representations_Data[j], Sizes[j]));
+			printf(" %s : %6zu bytes", Pointer_String_Encoding_Names[j], Sizes[j]);
+		}
+		printf("\n");
+	}
+	
+	// Write the bundle
+	Pointer_Bundle_File = fopen(argv[1], "wb");
+	if (Pointer_Bundle_File == NULL)
+	{
+		fprintf(stderr, "Error : could not create bundle file \"%s\".\n", argv[1]);
+		goto Exit;
+	}
+	if (fwrite(&Header, sizeof(Header), 1, Pointer_Bundle_File) != 1) goto Exit_Write_Error;
+	for (i = 0; i < Files_Count; i++)
+	{
+		if (fwrite(&Assets_Packer_Files[i].Entry, sizeof(TAssetsBundleEntry), 1, Pointer_Bundle_File) != 1) goto Exit_Write_Error;
+	}
+	for (i = 0; i < Files_Count; i++)
+	{
+		for (j = 0; j < ASSETS_BUNDLE_ENCODINGS_COUNT; j++)
+		{
+			if (Assets_Packer_Files[i].Entry.Representations[j].Size == 0) continue;
+			if (fwrite(Assets_Packer_Files[i].Pointer_Representations_Data[j], Assets_Packer_Files[i].Entry.Representations[j].Size, 1, Pointer_Bundle_File) != 1) goto Exit_Write_Error;
+		}
+	}
+	if (fclose(Pointer_Bundle_File) != 0)
+	{
+		Pointer_Bundle_File = NULL;
+		goto Exit_Write_Error;
+	}
+	Pointer_Bundle_File = NULL;
+	printf("Bundle version %s, %d files, %u bytes.\n", Header.String_Version, Files_Count, Offset);
+	Return_Value = EXIT_SUCCESS;
+	goto Exit;
+	
+Exit_Write_Error:
+	fprintf(stderr, "Error : could not write bundle file \"%s\".\n", argv[1]);
+	if (Pointer_Bundle_File != NULL)
+	{
+		fclose(Pointer_Bundle_File);
+		Pointer_Bundle_File = NULL;
+	}
+	remove(argv[1]); // Do not let a truncated bundle look up to date
+	
+Exit:
+	if (Pointer_Bundle_File != NULL) fclose(Pointer_Bundle_File);
+	for (i = 0; i < Files_Count; i++)
+	{
+		for (j = 0; j < ASSETS_BUNDLE_ENCODINGS_COUNT; j++) free(Assets_Packer_Files[i].Pointer_Representations_Data[j]);
+	}
+	return Return_Value;
+}
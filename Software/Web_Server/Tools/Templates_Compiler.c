@@ -0,0 +1,472 @@
+/** @file Templates_Compiler.c
+ * Compile the HTML page templates to C tables, so pages are not formatted at run time (see Templates.h).
+ * A template is a HTML file with placeholders written "@type:Name@" :
+ * - "@integer:Name@", "@decimal:Name@" and "@string:Name@" are slots filled by the page code on each request. A name used several times refers to the same slot.
+ * - "@constant:MACRO@" is replaced at compile time by the value of a Configuration.h macro.
+ * - "@@" is a literal '@'.
+ * @author Adrien RICCIARDI
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many different slots a template can have (the web server has its own limit, which is checked when the tables are compiled). */
+#define TEMPLATES_COMPILER_MAXIMUM_SLOTS_COUNT 255
+/** How many slot occurrences a template can have. */
+#define TEMPLATES_COMPILER_MAXIMUM_SLOT_OCCURRENCES_COUNT 1024
+/** The maximum length of a placeholder, "@" characters excluded. */
+#define TEMPLATES_COMPILER_MAXIMUM_PLACEHOLDER_LENGTH 127
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** Tell what was last written to a segment literal. */
+typedef enum
+{
+	TEMPLATES_COMPILER_OUTPUT_STATE_EMPTY, //!< Nothing has been written to the segment yet.
+	TEMPLATES_COMPILER_OUTPUT_STATE_LINE_START, //!< A line ended, the next character starts a new string literal on a new line.
+	TEMPLATES_COMPILER_OUTPUT_STATE_STRING, //!< A string literal is open.
+	TEMPLATES_COMPILER_OUTPUT_STATE_CONSTANT //!< A constant has been written, the next character starts a new string literal on the same line.
+} TTemplatesCompilerOutputState;
+
+/** A slot type. */
+typedef struct
+{
+	const char *Pointer_String_Placeholder_Type; //!< The type name in placeholders.
+	const char *Pointer_String_Enumeration_Value; //!< The TTemplatesSlotType value.
+} TTemplatesCompilerSlotType;
+
+/** A template slot. */
+typedef struct
+{
+	char String_Name[TEMPLATES_COMPILER_MAXIMUM_PLACEHOLDER_LENGTH + 1]; //!< The slot name.
+	const TTemplatesCompilerSlotType *Pointer_Type; //!< The slot type.
+} TTemplatesCompilerSlot;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** All slot types. */
+static const TTemplatesCompilerSlotType Templates_Compiler_Slot_Types[] =
+{
+	{ "integer", "TEMPLATES_SLOT_TYPE_INTEGER" },
+	{ "decimal", "TEMPLATES_SLOT_TYPE_DECIMAL" },
+	{ "string", "TEMPLATES_SLOT_TYPE_STRING" }
+};
+
+/** The slots of the template being compiled. */
+static TTemplatesCompilerSlot Templates_Compiler_Slots[TEMPLATES_COMPILER_MAXIMUM_SLOTS_COUNT];
+/** The slot following each segment of the template being compiled. */
+static int Templates_Compiler_Segment_Slot_Indexes[TEMPLATES_COMPILER_MAXIMUM_SLOT_OCCURRENCES_COUNT];
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Load a whole file to memory.
+ * @param Pointer_String_Path The file to load.
+ * @param Pointer_Size On output, contain the file size in bytes.
+ * @return NULL if an error occurred,
+ * @return The file content on success, free it with free().
+ */
+static unsigned char *TemplatesCompilerLoadFile(const char *Pointer_String_Path, size_t *Pointer_Size)
+{
+	FILE *Pointer_File;
+	unsigned char *Pointer_Data = NULL;
+	long Size;
+	
+	Pointer_File = fopen(Pointer_String_Path, "rb");
+	if (Pointer_File == NULL)
+	{
+		fprintf(stderr, "Error : could not open file \"%s\".\n", Pointer_String_Path);
+		return NULL;
+	}
+	
+	// Get the file size
+	if ((fseek(Pointer_File, 0, SEEK_END) != 0) || ((Size = ftell(Pointer_File)) < 0) || (fseek(Pointer_File, 0, SEEK_SET) != 0))
+	{
+		fprintf(stderr, "Error : could not get file \"%s\" size.\n", Pointer_String_Path);
+		goto Exit;
+	}
+	
+	// Read the whole content (allocate at least one byte so an empty file is not mistaken for an error)
+	Pointer_Data = malloc(Size + 1);
+	if (Pointer_Data == NULL)
+	{
+		fprintf(stderr, "Error : could not allocate memory to load file \"%s\".\n", Pointer_String_Path);
+		goto Exit;
+	}
+	if (fread(Pointer_Data, 1, Size, Pointer_File) != (size_t) Size)
+	{
+		fprintf(stderr, "Error : could not read file \"%s\".\n", Pointer_String_Path);
+		free(Pointer_Data);
+		Pointer_Data = NULL;
+		goto Exit;
+	}
+	*Pointer_Size = Size;
+	
+Exit:
+	fclose(Pointer_File);
+	return Pointer_Data;
+}
+
+/** Tell whether a string is a valid C identifier.
+ * @param Pointer_String The string.
+ * @return 0 if the string is not an identifier,
+ * @return 1 if the string is an identifier.
+ */
+static int TemplatesCompilerIsIdentifier(const char *Pointer_String)
+{
+	if ((*Pointer_String == 0) || isdigit((unsigned char) *Pointer_String)) return 0;
+	
+	while (*Pointer_String != 0)
+	{
+		if (!isalnum((unsigned char) *Pointer_String) && (*Pointer_String != '_')) return 0;
+		Pointer_String++;
+	}
+	return 1;
+}
+
+/** Write an identifier in upper case.
+ * @param Pointer_File The output file.
+ * @param Pointer_String_Identifier The identifier.
+ */
+static void TemplatesCompilerWriteUpperCaseIdentifier(FILE *Pointer_File, const char *Pointer_String_Identifier)
+{
+	while (*Pointer_String_Identifier != 0)
+	{
+		fputc(toupper((unsigned char) *Pointer_String_Identifier), Pointer_File);
+		Pointer_String_Identifier++;
+	}
+}
+
+/** Append a template character to the segment being written.
+ * @param Pointer_File The output source file.
+ * @param Pointer_State The segment output state, it is updated.
+ * @param Character The character to write.
+ * @param Next_Character The following template character (or 0), needed to avoid writing trigraphs.
+ */
+static void TemplatesCompilerWriteSegmentCharacter(FILE *Pointer_File, TTemplatesCompilerOutputState *Pointer_State, unsigned char Character, unsigned char Next_Character)
+{
+	// Open a string literal if needed, each template line gets its own literal so the generated code stays readable
+	if (*Pointer_State == TEMPLATES_COMPILER_OUTPUT_STATE_CONSTANT) fputs(" \"", Pointer_File);
+	else if (*Pointer_State != TEMPLATES_COMPILER_OUTPUT_STATE_STRING) fputs("\n\t\"", Pointer_File);
+	*Pointer_State = TEMPLATES_COMPILER_OUTPUT_STATE_STRING;
+	
+	switch (Character)
+	{
+		case '\n':
+			fputs("\\n\"", Pointer_File);
+			*Pointer_State = TEMPLATES_COMPILER_OUTPUT_STATE_LINE_START;
+			break;
+			
+		case '"':
+		case '\\':
+			fprintf(Pointer_File, "\\%c", Character);
+			break;
+			
+		case '?':
+			if (Next_Character == '?') fputs("\\?", Pointer_File);
+			else fputc(Character, Pointer_File);
+			break;
+			
+		default:
+			// Keep tabulations as is like the rest of the code, and use octal escapes (always 3 digits so the next character can't be mistaken for a digit) for other non-printable or non-ASCII characters
+			if ((Character == '\t') || ((Character >= 0x20) && (Character < 0x7F))) fputc(Character, Pointer_File);
+			else fprintf(Pointer_File, "\\%03o", Character);
+			break;
+	}
+}
+
+/** Append a configuration constant to the segment being written.
+ * @param Pointer_File The output source file.
+ * @param Pointer_State The segment output state, it is updated.
+ * @param Pointer_String_Macro_Name The macro giving the constant value.
+ */
+static void TemplatesCompilerWriteSegmentConstant(FILE *Pointer_File, TTemplatesCompilerOutputState *Pointer_State, const char *Pointer_String_Macro_Name)
+{
+	if (*Pointer_State == TEMPLATES_COMPILER_OUTPUT_STATE_STRING) fputs("\" ", Pointer_File);
+	else if (*Pointer_State == TEMPLATES_COMPILER_OUTPUT_STATE_CONSTANT) fputc(' ', Pointer_File);
+	else fputs("\n\t", Pointer_File);
+	fprintf(Pointer_File, "TEMPLATES_TABLES_CONVERT_MACRO_VALUE_TO_STRING(%s)", Pointer_String_Macro_Name);
+	*Pointer_State = TEMPLATES_COMPILER_OUTPUT_STATE_CONSTANT;
+}
+
+/** Start writing a segment.
+ * @param Pointer_File The output source file.
+ * @param Pointer_String_Template_Name The template name.
+ * @param Segment_Index The segment index.
+ * @param Pointer_State On output, contain the initialized segment output state.
+ */
+static void TemplatesCompilerBeginSegment(FILE *Pointer_File, const char *Pointer_String_Template_Name, int Segment_Index, TTemplatesCompilerOutputState *Pointer_State)
+{
+	fprintf(Pointer_File, "static const char Templates_%s_Segment_%d[] =", Pointer_String_Template_Name, Segment_Index);
+	*Pointer_State = TEMPLATES_COMPILER_OUTPUT_STATE_EMPTY;
+}
+
+/** Terminate the segment being written.
+ * @param Pointer_File The output source file.
+ * @param State The segment output state.
+ */
+static void TemplatesCompilerEndSegment(FILE *Pointer_File, TTemplatesCompilerOutputState State)
+{
+	if (State == TEMPLATES_COMPILER_OUTPUT_STATE_EMPTY) fputs(" \"\"", Pointer_File);
+	else if (State == TEMPLATES_COMPILER_OUTPUT_STATE_STRING) fputc('"', Pointer_File);
+	fputs(";\n", Pointer_File);
+}
+
+/** Compile a template and write its tables.
+ * @param Pointer_String_Path The template file.
+ * @param Pointer_Source_File The output source file.
+ * @param Pointer_Header_File The output header file.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+static int TemplatesCompilerCompileTemplate(const char *Pointer_String_Path, FILE *Pointer_Source_File, FILE *Pointer_Header_File)
+{
+	char String_Template_Name[TEMPLATES_COMPILER_MAXIMUM_PLACEHOLDER_LENGTH + 1], String_Placeholder[TEMPLATES_COMPILER_MAXIMUM_PLACEHOLDER_LENGTH + 1], *Pointer_String_Name;
+	const char *Pointer_String_File_Name, *Pointer_String_Extension;
+	const TTemplatesCompilerSlotType *Pointer_Slot_Type;
+	unsigned char *Pointer_Data;
+	size_t Size, Read_Index, Length;
+	int Line = 1, Segments_Count = 1, Slots_Count = 0, Slot_Index, Return_Value = -1;
+	unsigned int i;
+	TTemplatesCompilerOutputState State;
+	
+	// The template name is the file name without extension
+	Pointer_String_File_Name = strrchr(Pointer_String_Path, '/');
+	if (Pointer_String_File_Name == NULL) Pointer_String_File_Name = Pointer_String_Path;
+	else Pointer_String_File_Name++;
+	Pointer_String_Extension = strrchr(Pointer_String_File_Name, '.');
+	if (Pointer_String_Extension == NULL) Length = strlen(Pointer_String_File_Name);
+	else Length = Pointer_String_Extension - Pointer_String_File_Name;
+	if (Length >= sizeof(String_Template_Name)) Length = sizeof(String_Template_Name) - 1; // The name is rejected below
+	memcpy(String_Template_Name, Pointer_String_File_Name, Length);
+	String_Template_Name[Length] = 0;
+	if (!TemplatesCompilerIsIdentifier(String_Template_Name))
+	{
+		fprintf(stderr, "Error : template file \"%s\" name must be a valid C identifier.\n", Pointer_String_Path);
+		return -1;
+	}
+	
+	Pointer_Data = TemplatesCompilerLoadFile(Pointer_String_Path, &Size);
+	if (Pointer_Data == NULL) return -1;
+	
+	// Write the segments while parsing the template, slots are written when all of them are known
+	fprintf(Pointer_Source_File, "//-------------------------------------------------------------------------------------------------\n// %s\n//-------------------------------------------------------------------------------------------------\n", Pointer_String_File_Name);
+	TemplatesCompilerBeginSegment(Pointer_Source_File, String_Template_Name, 0, &State);
+	Read_Index = 0;
+	while (Read_Index < Size)
+	{
+		// Copy constant text
+		if (Pointer_Data[Read_Index] != '@')
+		{
+			if (Pointer_Data[Read_Index] == '\n') Line++;
+			TemplatesCompilerWriteSegmentCharacter(Pointer_Source_File, &State, Pointer_Data[Read_Index], Read_Index + 1 < Size ? Pointer_Data[Read_Index + 1] : 0);
+			Read_Index++;
+			continue;
+		}
+		
+		// Handle the escaped '@'
+		if ((Read_Index + 1 < Size) && (Pointer_Data[Read_Index + 1] == '@'))
+		{
+			TemplatesCompilerWriteSegmentCharacter(Pointer_Source_File, &State, '@', Read_Index + 2 < Size ? Pointer_Data[Read_Index + 2] : 0);
+			Read_Index += 2;
+			continue;
+		}
+		
+		// Extract the placeholder
+		Read_Index++;
+		Length = 0;
+		while ((Read_Index < Size) && (Pointer_Data[Read_Index] != '@') && (Pointer_Data[Read_Index] != '\n') && (Length < sizeof(String_Placeholder) - 1))
+		{
+			String_Placeholder[Length] = Pointer_Data[Read_Index];
+			Length++;
+			Read_Index++;
+		}
+		String_Placeholder[Length] = 0;
+		if ((Read_Index >= Size) || (Pointer_Data[Read_Index] != '@'))
+		{
+			fprintf(stderr, "Error : %s:%d : unterminated placeholder (use \"@@\" to write a '@' character).\n", Pointer_String_Path, Line);
+			goto Exit;
+		}
+		Read_Index++;
+		
+		// Split the placeholder type and name
+		Pointer_String_Name = strchr(String_Placeholder, ':');
+		if ((Pointer_String_Name == NULL) || !TemplatesCompilerIsIdentifier(Pointer_String_Name + 1))
+		{
+			fprintf(stderr, "Error : %s:%d : placeholder \"@%s@\" must be written \"@type:Name@\" with a valid C identifier as name.\n", Pointer_String_Path, Line, String_Placeholder);
+			goto Exit;
+		}
+		*Pointer_String_Name = 0;
+		Pointer_String_Name++;
+		
+		// Constants are part of the segment
+		if (strcmp(String_Placeholder, "constant") == 0)
+		{
+			TemplatesCompilerWriteSegmentConstant(Pointer_Source_File, &State, Pointer_String_Name);
+			continue;
+		}
+		
+		// Find the slot type
+		Pointer_Slot_Type = NULL;
+		for (i = 0; i < sizeof(Templates_Compiler_Slot_Types) / sizeof(Templates_Compiler_Slot_Types[0]); i++)
+		{
+			if (strcmp(String_Placeholder, Templates_Compiler_Slot_Types[i].Pointer_String_Placeholder_Type) == 0)
+			{
+				Pointer_Slot_Type = &Templates_Compiler_Slot_Types[i];
+				break;
+			}
+		}
+		if (Pointer_Slot_Type == NULL)
+		{
+			fprintf(stderr, "Error : %s:%d : unknown placeholder type \"%s\".\n", Pointer_String_Path, Line, String_Placeholder);
+			goto Exit;
+		}
+		
+		// Find the slot, or create it the first time it is used
+		for (Slot_Index = 0; Slot_Index < Slots_Count; Slot_Index++)
+		{
+			if (strcmp(Templates_Compiler_Slots[Slot_Index].String_Name, Pointer_String_Name) == 0) break;
+		}
+		if (Slot_Index == Slots_Count)
+		{
+			if (Slots_Count >= TEMPLATES_COMPILER_MAXIMUM_SLOTS_COUNT)
+			{
+				fprintf(stderr, "Error : %s:%d : too many slots, at most %d slots are supported.\n", Pointer_String_Path, Line, TEMPLATES_COMPILER_MAXIMUM_SLOTS_COUNT);
+				goto Exit;
+			}
+			strcpy(Templates_Compiler_Slots[Slot_Index].String_Name, Pointer_String_Name);
+			Templates_Compiler_Slots[Slot_Index].Pointer_Type = Pointer_Slot_Type;
+			Slots_Count++;
+		}
+		else if (Templates_Compiler_Slots[Slot_Index].Pointer_Type != Pointer_Slot_Type)
+		{
+			fprintf(stderr, "Error : %s:%d : slot \"%s\" is used with types \"%s\" and \"%s\".\n", Pointer_String_Path, Line, Pointer_String_Name, Templates_Compiler_Slots[Slot_Index].Pointer_Type->Pointer_String_Placeholder_Type, Pointer_Slot_Type->Pointer_String_Placeholder_Type);
+			goto Exit;
+		}
+		
+		// The slot ends the current segment
+		if (Segments_Count >= TEMPLATES_COMPILER_MAXIMUM_SLOT_OCCURRENCES_COUNT)
+		{
+			fprintf(stderr, "Error : %s:%d : too many placeholders, at most %d placeholders are supported.\n", Pointer_String_Path, Line, TEMPLATES_COMPILER_MAXIMUM_SLOT_OCCURRENCES_COUNT - 1);
+			goto Exit;
+		}
+		Templates_Compiler_Segment_Slot_Indexes[Segments_Count - 1] = Slot_Index;
+		TemplatesCompilerEndSegment(Pointer_Source_File, State);
+		TemplatesCompilerBeginSegment(Pointer_Source_File, String_Template_Name, Segments_Count, &State);
+		Segments_Count++;
+	}
+	TemplatesCompilerEndSegment(Pointer_Source_File, State);
+	
+	// Write the segments table
+	fprintf(Pointer_Source_File, "\nstatic const TTemplatesSegment Templates_%s_Segments[] =\n{\n", String_Template_Name);
+	for (i = 0; i < (unsigned int) Segments_Count; i++) fprintf(Pointer_Source_File, "\t{ Templates_%s_Segment_%u, sizeof(Templates_%s_Segment_%u) - 1 }%s\n", String_Template_Name, i, String_Template_Name, i, i + 1 < (unsigned int) Segments_Count ? "," : "");
+	fputs("};\n", Pointer_Source_File);
+	
+	// Write the slots enumeration
+	fprintf(Pointer_Header_File, "/** \"%s\" slots. */\nenum\n{\n", Pointer_String_File_Name);
+	for (i = 0; i < (unsigned int) Slots_Count; i++)
+	{
+		fputs("\tTEMPLATES_", Pointer_Header_File);
+		TemplatesCompilerWriteUpperCaseIdentifier(Pointer_Header_File, String_Template_Name);
+		fputs("_SLOT_", Pointer_Header_File);
+		TemplatesCompilerWriteUpperCaseIdentifier(Pointer_Header_File, Templates_Compiler_Slots[i].String_Name);
+		fprintf(Pointer_Header_File, ", //!< Type : %s.\n", Templates_Compiler_Slots[i].Pointer_Type->Pointer_String_Placeholder_Type);
+	}
+	fputs("\tTEMPLATES_", Pointer_Header_File);
+	TemplatesCompilerWriteUpperCaseIdentifier(Pointer_Header_File, String_Template_Name);
+	fprintf(Pointer_Header_File, "_SLOTS_COUNT\n};\n\n/** The compiled \"%s\" template. */\nextern const TTemplatesTemplate Templates_%s;\n\n", Pointer_String_File_Name, String_Template_Name);
+	
+	// Write the slots tables (a template without slots has empty tables)
+	if (Slots_Count > 0)
+	{
+		fprintf(Pointer_Source_File, "\nstatic const unsigned char Templates_%s_Segment_Slot_Indexes[] = {", String_Template_Name);
+		for (i = 0; i < (unsigned int) Segments_Count - 1; i++) fprintf(Pointer_Source_File, " %d%s", Templates_Compiler_Segment_Slot_Indexes[i], i + 2 < (unsigned int) Segments_Count ? "," : "");
+		fprintf(Pointer_Source_File, " };\n\nstatic const TTemplatesSlotType Templates_%s_Slot_Types[] = {", String_Template_Name);
+		for (i = 0; i < (unsigned int) Slots_Count; i++) fprintf(Pointer_Source_File, " %s%s", Templates_Compiler_Slots[i].Pointer_Type->Pointer_String_Enumeration_Value, i + 1 < (unsigned int) Slots_Count ? "," : "");
+		fputs(" };\n", Pointer_Source_File);
+	}
+	
+	// Write the template, and make sure the web server can render it
+	fprintf(Pointer_Source_File, "\nconst TTemplatesTemplate Templates_%s =\n{\n\t\"%s\",\n\t%d,\n\tTemplates_%s_Segments,\n", String_Template_Name, Pointer_String_File_Name, Segments_Count, String_Template_Name);
+	if (Slots_Count > 0) fprintf(Pointer_Source_File, "\tTemplates_%s_Segment_Slot_Indexes,\n\t%d,\n\tTemplates_%s_Slot_Types\n};\n", String_Template_Name, Slots_Count, String_Template_Name);
+	else fputs("\tNULL,\n\t0,\n\tNULL\n};\n", Pointer_Source_File);
+	fprintf(Pointer_Source_File, "_Static_assert(%d <= TEMPLATES_MAXIMUM_SLOTS_COUNT, \"Template \\\"%s\\\" has too many slots.\");\n\n", Slots_Count, Pointer_String_File_Name);
+	
+	printf("%-40s %d segments, %d slots\n", Pointer_String_File_Name, Segments_Count, Slots_Count);
+	Return_Value = 0;
+	
+Exit:
+	free(Pointer_Data);
+	return Return_Value;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Entry point
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	FILE *Pointer_Source_File = NULL, *Pointer_Header_File = NULL;
+	int i, Return_Value = EXIT_FAILURE;
+	
+	// Check parameters
+	if (argc < 4)
+	{
+		printf("Usage : %s Output_Source_File Output_Header_File Template_File_1 [Template_File_2 ...]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	
+	// Create the output files
+	Pointer_Source_File = fopen(argv[1], "w");
+	if (Pointer_Source_File == NULL)
+	{
+		fprintf(stderr, "Error : could not create source file \"%s\".\n", argv[1]);
+		goto Exit;
+	}
+	Pointer_Header_File = fopen(argv[2], "w");
+	if (Pointer_Header_File == NULL)
+	{
+		fprintf(stderr, "Error : could not create header file \"%s\".\n", argv[2]);
+		goto Exit;
+	}
+	
+	// Write the files beginning
+	fputs("/** @file Templates_Tables.c\n * The compiled page templates. This file is generated by the templates compiler, do not edit it.\n */\n"
+		"#include <Configuration.h>\n#include <stddef.h>\n#include <Templates_Tables.h>\n\n"
+		"/** Convert the macro identifier to a C string. */\n#define TEMPLATES_TABLES_CONVERT_MACRO_NAME_TO_STRING(X) #X\n"
+		"/** Convert the macro value to a C string. The preprocessor needs two passes to do the conversion, so the TEMPLATES_TABLES_CONVERT_MACRO_NAME_TO_STRING() is needed. */\n#define TEMPLATES_TABLES_CONVERT_MACRO_VALUE_TO_STRING(X) TEMPLATES_TABLES_CONVERT_MACRO_NAME_TO_STRING(X)\n\n", Pointer_Source_File);
+	fputs("/** @file Templates_Tables.h\n * The compiled page templates. This file is generated by the templates compiler, do not edit it.\n */\n"
+		"#ifndef H_TEMPLATES_TABLES_H\n#define H_TEMPLATES_TABLES_H\n\n#include <Templates.h>\n\n", Pointer_Header_File);
+	
+	// Compile all templates
+	for (i = 3; i < argc; i++)
+	{
+		if (TemplatesCompilerCompileTemplate(argv[i], Pointer_Source_File, Pointer_Header_File) != 0) goto Exit;
+	}
+	fputs("#endif\n", Pointer_Header_File);
+	
+	// Make sure everything has been written
+	if (ferror(Pointer_Source_File) || ferror(Pointer_Header_File))
+	{
+		fprintf(stderr, "Error : could not write the output files.\n");
+		goto Exit;
+	}
+	Return_Value = EXIT_SUCCESS;
+	
+Exit:
+	if ((Pointer_Source_File != NULL) && (fclose(Pointer_Source_File) != 0)) Return_Value = EXIT_FAILURE;
+	if ((Pointer_Header_File != NULL) && (fclose(Pointer_Header_File) != 0)) Return_Value = EXIT_FAILURE;
+	
+	// Do not let truncated files look up to date
+	if (Return_Value != EXIT_SUCCESS)
+	{
+		remove(argv[1]);
+		remove(argv[2]);
+	}
+	return Return_Value;
+}